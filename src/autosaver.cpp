@@ -0,0 +1,208 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "autosaver.h"
+#include "document.h"
+#include "translators/tellicosnapshot.h"
+#include "utils/tellico_utils.h"
+#include "config/tellico_config.h"
+#include "tellico_debug.h"
+
+#include <QTimer>
+#include <QUrl>
+#include <QFile>
+#include <QDir>
+#include <QLockFile>
+#include <QDateTime>
+#include <QDataStream>
+#include <QtConcurrentRun>
+
+namespace {
+  static const char* RECOVERY_SUFFIX = ".snapshot";
+  static const char* LOCK_SUFFIX = ".lock";
+}
+
+using Tellico::AutoSaver;
+
+AutoSaver::AutoSaver(QObject* parent_) : QObject(parent_), m_timer(new QTimer(this)),
+    m_changed(false), m_removeWhenFinished(false) {
+  connect(m_timer, &QTimer::timeout, this, &AutoSaver::slotAutoSave);
+  connect(&m_watcher, &QFutureWatcherBase::finished, this, &AutoSaver::slotFinished);
+  readConfig();
+}
+
+AutoSaver::~AutoSaver() {
+  // the snapshot has to outlive the write
+  m_watcher.waitForFinished();
+  if(m_removeWhenFinished) {
+    releaseRecovery();
+  }
+  // otherwise the recovery file is left for the next start, the lock goes away with this instance
+}
+
+void AutoSaver::readConfig() {
+  // the interval is in minutes, zero turns off the autosave
+  const int interval = Config::autoSaveInterval();
+  if(interval > 0) {
+    m_timer->start(interval * 60 * 1000);
+  } else {
+    m_timer->stop();
+  }
+}
+
+QString AutoSaver::recoveryFileName(const QUrl& url_) {
+  return Tellico::saveLocation(QStringLiteral("recovery/")) + Tellico::documentKey(url_) + QLatin1String(RECOVERY_SUFFIX);
+}
+
+QStringList AutoSaver::recoveryFiles() {
+  QDir dir(Tellico::saveLocation(QStringLiteral("recovery/")));
+  const QFileInfoList list = dir.entryInfoList(QStringList() << QLatin1Char('*') + QLatin1String(RECOVERY_SUFFIX),
+                                               QDir::Files, QDir::Time);
+  QStringList files;
+  foreach(const QFileInfo& info, list) {
+    // a file which is still locked belongs to a running instance
+    // the lock of an instance which didn't close normally is stale and gets taken over
+    QLockFile lock(info.absoluteFilePath() + QLatin1String(LOCK_SUFFIX));
+    lock.setStaleLockTime(0);
+    if(lock.tryLock(0)) {
+      files += info.absoluteFilePath();
+    }
+  }
+  return files;
+}
+
+Tellico::Data::CollPtr AutoSaver::readRecovery(const QString& fileName_, QUrl* url_, QDateTime* time_, int* format_) {
+  QByteArray header;
+  Import::TellicoImporter::Format format;
+  Data::CollPtr coll = TellicoSnapshot::readFile(fileName_, &header, &format);
+  if(!coll) {
+    return coll;
+  }
+  QDataStream in(header);
+  in.setVersion(QDataStream::Qt_5_6);
+  QUrl url;
+  QDateTime time;
+  in >> url >> time;
+  if(url_) {
+    *url_ = url;
+  }
+  if(time_) {
+    *time_ = time;
+  }
+  if(format_) {
+    *format_ = format;
+  }
+  return coll;
+}
+
+void AutoSaver::removeRecovery(const QString& fileName_) {
+  QFile::remove(fileName_);
+}
+
+bool AutoSaver::lockRecovery(const QString& fileName_) {
+  if(m_lock && m_recoveryFile == fileName_) {
+    return true;
+  }
+  // the document changed, the old recovery file isn't needed anymore
+  releaseRecovery();
+  QScopedPointer<QLockFile> lock(new QLockFile(fileName_ + QLatin1String(LOCK_SUFFIX)));
+  // the lock is held as long as the document is open, so only a dead process makes it stale
+  lock->setStaleLockTime(0);
+  if(!lock->tryLock(0)) {
+    myLog() << "Recovery file is in use by another instance:" << fileName_;
+    return false;
+  }
+  m_lock.swap(lock);
+  m_recoveryFile = fileName_;
+  return true;
+}
+
+void AutoSaver::releaseRecovery() {
+  if(m_recoveryFile.isEmpty()) {
+    return;
+  }
+  removeRecovery(m_recoveryFile);
+  m_recoveryFile.clear();
+  // unlocking removes the lock file
+  m_lock.reset();
+}
+
+void AutoSaver::slotChanged() {
+  m_changed = true;
+}
+
+void AutoSaver::slotDocumentModified(bool modified_) {
+  if(modified_) {
+    m_changed = true;
+    return;
+  }
+  // the document was saved or the changes were discarded
+  m_changed = false;
+  if(m_watcher.isRunning()) {
+    m_removeWhenFinished = true;
+  } else {
+    releaseRecovery();
+  }
+}
+
+void AutoSaver::slotAutoSave() {
+  if(!m_changed || m_watcher.isRunning()) {
+    return;
+  }
+  Data::Document* doc = Data::Document::self();
+  // images inside the document file aren't in the snapshot, so they couldn't be restored
+  if(!doc->isModified() || !doc->allImagesOnDisk() || !doc->collection()) {
+    return;
+  }
+  // a document open in more than one instance is only autosaved by the first one
+  if(!lockRecovery(recoveryFileName(doc->URL()))) {
+    return;
+  }
+  m_changed = false;
+  m_removeWhenFinished = false;
+
+  QByteArray header;
+  QDataStream out(&header, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_6);
+  out << doc->URL() << QDateTime::currentDateTime();
+
+  m_snapshot.reset(new TellicoSnapshot(doc->collection(),
+                                       static_cast<Import::TellicoImporter::Format>(doc->fileFormat())));
+  m_watcher.setFuture(QtConcurrent::run(m_snapshot.data(), &TellicoSnapshot::writeFile,
+                                        m_recoveryFile, header));
+}
+
+void AutoSaver::slotFinished() {
+  if(!m_watcher.result()) {
+    myDebug() << "Failed to write recovery file:" << m_recoveryFile;
+    // try again next time
+    m_changed = true;
+  }
+  // the entry copies hold a reference to the collection, so release them on the GUI thread
+  m_snapshot.reset();
+  if(m_removeWhenFinished) {
+    m_removeWhenFinished = false;
+    releaseRecovery();
+  }
+}
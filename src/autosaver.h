@@ -0,0 +1,128 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_AUTOSAVER_H
+#define TELLICO_AUTOSAVER_H
+
+#include "datavectors.h"
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QScopedPointer>
+
+class QTimer;
+class QUrl;
+class QDateTime;
+class QLockFile;
+
+namespace Tellico {
+  class TellicoSnapshot;
+
+/**
+ * The AutoSaver periodically writes a copy of the modified document to a recovery file, so
+ * the changes can be restored if Tellico doesn't close normally. The collection is captured
+ * on the GUI thread, which is cheap since the entries are copy-on-write, and then written
+ * on a worker thread, so editing is never blocked.
+ *
+ * Nothing is written unless the document changed since the last write, and the recovery file
+ * is removed whenever the document is saved or the changes are discarded. Each document has its
+ * own recovery file, keyed by its url, and the instance writing it holds a lock on it, so that
+ * other instances neither overwrite it nor offer to restore it while it is still in use.
+ *
+ * @author agent
+ */
+class AutoSaver : public QObject {
+Q_OBJECT
+
+public:
+  explicit AutoSaver(QObject* parent = nullptr);
+  ~AutoSaver();
+
+  /**
+   * Restarts the timer, using the interval from the configuration.
+   */
+  void readConfig();
+
+  /**
+   * Returns the name of the recovery file for a document.
+   */
+  static QString recoveryFileName(const QUrl& url);
+  /**
+   * Returns the recovery files left behind by instances which are no longer running,
+   * the most recent first.
+   */
+  static QStringList recoveryFiles();
+  /**
+   * Reads a recovery file.
+   *
+   * @param fileName The recovery file
+   * @param url Set to the url of the document
+   * @param time Set to the time the recovery file was written
+   * @param format Set to the file format of the document
+   * @return The collection, or null if the recovery file could not be read
+   */
+  static Data::CollPtr readRecovery(const QString& fileName, QUrl* url, QDateTime* time, int* format);
+  /**
+   * Removes a recovery file, if it exists.
+   */
+  static void removeRecovery(const QString& fileName);
+  /**
+   * Takes over a recovery file, so it is kept until the document is saved or the changes are
+   * discarded. Any recovery file held before is removed.
+   *
+   * @return false if the file is locked by another instance
+   */
+  bool lockRecovery(const QString& fileName);
+
+public Q_SLOTS:
+  /**
+   * Marks the document as changed since the last write.
+   */
+  void slotChanged();
+  void slotDocumentModified(bool modified);
+  /**
+   * Starts writing the recovery file, unless a write is already running
+   * or there are no unsaved changes.
+   */
+  void slotAutoSave();
+
+private Q_SLOTS:
+  void slotFinished();
+
+private:
+  // removes the recovery file and releases the lock
+  void releaseRecovery();
+
+  QTimer* m_timer;
+  bool m_changed;
+  // the document was saved while the recovery file was being written
+  bool m_removeWhenFinished;
+  QScopedPointer<TellicoSnapshot> m_snapshot;
+  QFutureWatcher<bool> m_watcher;
+  QString m_recoveryFile;
+  QScopedPointer<QLockFile> m_lock;
+};
+
+} // end namespace
+#endif
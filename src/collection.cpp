@@ -30,6 +30,7 @@
 #include "fieldformat.h"
 #include "utils/string_utils.h"
 #include "utils/stringset.h"
+#include "utils/phasetimer.h"
 #include "entrycomparison.h"
 #include "tellico_debug.h"
 
@@ -639,6 +640,8 @@ Tellico::Data::EntryGroupDict* Collection::entryGroupDictByName(const QString& n
   }
   EntryGroupDict* dict = m_entryGroupDicts.value(name_);
   if(dict && dict->isEmpty()) {
+    PhaseTimer timer("Build groups");
+    timer.setCount(m_entries.count());
     const bool b = signalsBlocked();
     // block signals so all the group created/modified signals don't fire
     blockSignals(true);
@@ -686,6 +689,8 @@ void Collection::populateCurrentDicts(const Tellico::Data::EntryList& entries_,
   if(m_entryGroupDicts.isEmpty()) {
     return;
   }
+  PhaseTimer timer("Populate groups");
+  timer.setCount(entries_.count());
 
   // special case when adding an entry to a new empty collection
   // there are no existing non-empty groups
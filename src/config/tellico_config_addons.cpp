@@ -223,6 +223,19 @@ void Config::setTemplateHighlightedTextColor(int type_, const QColor& color_) {
   }
 }
 
+int Config::maxIngestImageSize(int type_) {
+  switch(type_) {
+    ALL_GET(maxIngestImageSize)
+  }
+  return 0;
+}
+
+void Config::setMaxIngestImageSize(int type_, int size_) {
+  switch(type_) {
+    ALL_SET(setMaxIngestImageSize,size_)
+  }
+}
+
 #undef COLL
 #undef CLASS
 #undef P1
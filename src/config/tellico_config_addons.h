@@ -48,6 +48,9 @@ public:
   static void setTemplateHighlightedBaseColor(int type, const QColor& color);
   static void setTemplateHighlightedTextColor(int type, const QColor& color);
 
+  static int maxIngestImageSize(int type);
+  static void setMaxIngestImageSize(int type, int size);
+
 private:
   static QRegExp commaSplit();
   static void checkArticleList();
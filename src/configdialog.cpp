@@ -228,6 +228,41 @@ void ConfigDialog::initGeneralPage(QFrame* frame) {
   l->addWidget(m_cbEnableWebcam);
   connect(m_cbEnableWebcam, &QAbstractButton::clicked, this, &ConfigDialog::slotModified);
 
+  m_cbDocumentSnapshots = new QCheckBox(i18n("&Keep a quick-loading copy of local data files"), frame);
+  m_cbDocumentSnapshots->setWhatsThis(i18n("If checked, a copy of each local data file without images "
+                                           "inside it is kept in the application directory, so the file "
+                                           "opens faster the next time, as long as it has not changed."));
+  l->addWidget(m_cbDocumentSnapshots);
+  connect(m_cbDocumentSnapshots, &QAbstractButton::clicked, this, &ConfigDialog::slotModified);
+
+  m_cbJournalSaving = new QCheckBox(i18n("Save only the &changes to the data file"), frame);
+  m_cbJournalSaving->setWhatsThis(i18n("If checked, saving a local file only records the changes since "
+                                       "the last save, rather than writing the whole file again. This "
+                                       "does not apply when images are stored in the data file."));
+  l->addWidget(m_cbJournalSaving);
+  connect(m_cbJournalSaving, &QAbstractButton::clicked, this, &ConfigDialog::slotModified);
+
+  QHBoxLayout* compactionLayout = new QHBoxLayout();
+  l->addLayout(compactionLayout);
+  QLabel* compactionLabel = new QLabel(i18n("Rewrite the whole file when the changes reach:"), frame);
+  compactionLayout->addWidget(compactionLabel);
+  m_compactionBox = new QSpinBox(frame);
+  m_compactionBox->setMinimum(1);
+  m_compactionBox->setMaximum(100);
+  m_compactionBox->setSuffix(QStringLiteral("%"));
+  compactionLayout->addWidget(m_compactionBox);
+  compactionLayout->addStretch(1);
+  compactionLabel->setBuddy(m_compactionBox);
+  QString compactionWhats = i18n("Once the recorded changes grow larger than this share of the size of "
+                                 "the data file, the whole file is written again. The file can also be "
+                                 "rewritten at any time with Compact File in the File menu.");
+  compactionLabel->setWhatsThis(compactionWhats);
+  m_compactionBox->setWhatsThis(compactionWhats);
+  void (QSpinBox::* compactionChanged)(int) = &QSpinBox::valueChanged;
+  connect(m_compactionBox, compactionChanged, this, &ConfigDialog::slotModified);
+  connect(m_cbJournalSaving, &QAbstractButton::toggled, m_compactionBox, &QWidget::setEnabled);
+  connect(m_cbJournalSaving, &QAbstractButton::toggled, compactionLabel, &QWidget::setEnabled);
+
   QGroupBox* imageGroupBox = new QGroupBox(i18n("Image Storage Options"), frame);
   l->addWidget(imageGroupBox);
   m_rbImageInFile = new QRadioButton(i18n("Store images in data file"), imageGroupBox);
@@ -243,6 +278,33 @@ void ConfigDialog::initGeneralPage(QFrame* frame) {
   imageGroupLayout->addWidget(m_rbImageInLocalDir);
   imageGroupBox->setLayout(imageGroupLayout);
 
+  QHBoxLayout* imageSizeLayout = new QHBoxLayout();
+  imageGroupLayout->addLayout(imageSizeLayout);
+  QLabel* imageSizeLabel = new QLabel(i18n("Maximum size of new images:"), imageGroupBox);
+  imageSizeLayout->addWidget(imageSizeLabel);
+  m_imageSizeBox = new QSpinBox(imageGroupBox);
+  m_imageSizeBox->setMaximum(9999);
+  m_imageSizeBox->setMinimum(0);
+  m_imageSizeBox->setSingleStep(100);
+  m_imageSizeBox->setSuffix(QStringLiteral(" px"));
+  m_imageSizeBox->setSpecialValueText(i18n("No limit"));
+  imageSizeLayout->addWidget(m_imageSizeBox);
+  imageSizeLayout->addStretch(1);
+  imageSizeLabel->setBuddy(m_imageSizeBox);
+  QString imageSizeWhats = i18n("New images which are wider or taller than the maximum size are scaled down "
+                                "when they are added. The aspect ratio is preserved. The size is set separately "
+                                "for each collection type.");
+  imageSizeLabel->setWhatsThis(imageSizeWhats);
+  m_imageSizeBox->setWhatsThis(imageSizeWhats);
+  void (QSpinBox::* imageSizeChanged)(int) = &QSpinBox::valueChanged;
+  connect(m_imageSizeBox, imageSizeChanged, this, &ConfigDialog::slotModified);
+
+  m_cbKeepOriginalImages = new QCheckBox(i18n("&Keep the original of scaled images"), imageGroupBox);
+  m_cbKeepOriginalImages->setWhatsThis(i18n("If checked, the original file of any image which is scaled "
+                                            "down is saved in the Tellico application directory."));
+  imageGroupLayout->addWidget(m_cbKeepOriginalImages);
+  connect(m_cbKeepOriginalImages, &QAbstractButton::clicked, this, &ConfigDialog::slotModified);
+
   QButtonGroup* imageGroup = new QButtonGroup(frame);
   imageGroup->addButton(m_rbImageInFile);
   imageGroup->addButton(m_rbImageInAppDir);
@@ -694,6 +756,12 @@ void ConfigDialog::readGeneralConfig() {
     case Config::ImagesInAppDir: m_rbImageInAppDir->setChecked(true); break;
     case Config::ImagesInLocalDir: m_rbImageInLocalDir->setChecked(true); break;
   }
+  m_imageSizeBox->setValue(Config::maxIngestImageSize(Kernel::self()->collectionType()));
+  m_cbKeepOriginalImages->setChecked(Config::keepOriginalImages());
+  m_cbDocumentSnapshots->setChecked(Config::documentSnapshots());
+  m_cbJournalSaving->setChecked(Config::journalSaving());
+  m_compactionBox->setValue(Config::journalCompactionPercent());
+  m_compactionBox->setEnabled(Config::journalSaving());
 
   bool autoCapitals = Config::autoCapitalization();
   m_cbCapitalize->setChecked(autoCapitals);
@@ -790,6 +858,11 @@ void ConfigDialog::saveGeneralConfig() {
     imageLocation = Config::ImagesInLocalDir;
   }
   Config::setImageLocation(imageLocation);
+  Config::setMaxIngestImageSize(Kernel::self()->collectionType(), m_imageSizeBox->value());
+  Config::setKeepOriginalImages(m_cbKeepOriginalImages->isChecked());
+  Config::setDocumentSnapshots(m_cbDocumentSnapshots->isChecked());
+  Config::setJournalSaving(m_cbJournalSaving->isChecked());
+  Config::setJournalCompactionPercent(m_compactionBox->value());
   Config::setReopenLastFile(m_cbOpenLastFile->isChecked());
 
   Config::setAutoCapitalization(m_cbCapitalize->isChecked());
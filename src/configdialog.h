@@ -170,9 +170,14 @@ private:
   QRadioButton* m_rbImageInFile;
   QRadioButton* m_rbImageInAppDir;
   QRadioButton* m_rbImageInLocalDir;
+  QSpinBox* m_imageSizeBox;
+  QCheckBox* m_cbKeepOriginalImages;
   QCheckBox* m_cbOpenLastFile;
   QCheckBox* m_cbShowTipDay;
   QCheckBox* m_cbEnableWebcam;
+  QCheckBox* m_cbDocumentSnapshots;
+  QCheckBox* m_cbJournalSaving;
+  QSpinBox* m_compactionBox;
   QCheckBox* m_cbCapitalize;
   QCheckBox* m_cbFormat;
   QLineEdit* m_leCapitals;
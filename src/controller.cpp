@@ -43,6 +43,7 @@
 #include "entryupdater.h"
 #include "entrymerger.h"
 #include "utils/cursorsaver.h"
+#include "utils/phasetimer.h"
 #include "gui/lineedit.h"
 #include "gui/tabwidget.h"
 #include "tellico_debug.h"
@@ -118,6 +119,8 @@ void Controller::slotCollectionAdded(Tellico::Data::CollPtr coll_) {
   if(!coll_ || !m_mainWindow->m_groupView) {
     return;
   }
+  PhaseTimer timer("Add collection to views");
+  timer.setCount(coll_->entryCount());
 
   // do this first because the group view will need it later
   m_mainWindow->readCollectionOptions(coll_);
@@ -126,8 +129,14 @@ void Controller::slotCollectionAdded(Tellico::Data::CollPtr coll_) {
   // calls in the widgets since they may want menu updates
 
 //  blockAllSignals(true);
-  m_mainWindow->m_detailedView->addCollection(coll_);
-  m_mainWindow->m_groupView->addCollection(coll_);
+  {
+    PhaseTimer viewTimer("Column view");
+    m_mainWindow->m_detailedView->addCollection(coll_);
+  }
+  {
+    PhaseTimer viewTimer("Group view");
+    m_mainWindow->m_groupView->addCollection(coll_);
+  }
   m_mainWindow->m_editDialog->resetLayout(coll_);
   if(!coll_->filters().isEmpty()) {
     m_mainWindow->addFilterView();
@@ -42,6 +42,7 @@
 #include <QDomDocument>
 #include <QFile>
 #include <QTextStream>
+#include <QTextCodec>
 #include <QTemporaryFile>
 #include <QSaveFile>
 
@@ -76,6 +77,8 @@ FileHandler::FileRef::~FileRef() {
   if(!m_filename.isEmpty()) {
     Tellico::NetAccess::removeTempFile(m_filename);
   }
+  // the data refers to the map, which goes away with the file
+  m_data.clear();
   if(m_device) {
     m_device->close();
   }
@@ -101,6 +104,28 @@ bool FileHandler::FileRef::open(bool quiet_) {
   return true;
 }
 
+QByteArray FileHandler::FileRef::data() {
+  if(!m_device || !m_device->isOpen()) {
+    return QByteArray();
+  }
+  // the file is only mapped once, later calls share the same view
+  if(!m_data.isNull()) {
+    return m_data;
+  }
+  QFile* file = static_cast<QFile*>(m_device);
+  const qint64 size = file->size();
+  // a QByteArray can't refer to more than INT_MAX bytes, larger files are read instead
+  // the map is released when the file is deleted
+  uchar* map = size > 0 && size <= INT_MAX ? file->map(0, size) : nullptr;
+  if(map) {
+    m_data = QByteArray::fromRawData(reinterpret_cast<const char*>(map), static_cast<int>(size));
+  } else {
+    file->reset();
+    m_data = file->readAll();
+  }
+  return m_data;
+}
+
 FileHandler::FileRef* FileHandler::fileRef(const QUrl& url_, bool quiet_) {
   return new FileRef(url_, quiet_);
 }
@@ -112,11 +137,13 @@ QString FileHandler::readTextFile(const QUrl& url_, bool quiet_/*=false*/, bool
   }
 
   if(f.open(quiet_)) {
-    QTextStream stream(f.file());
-    if(useUTF8_) {
-      stream.setCodec("UTF-8");
-    }
-    return stream.readAll();
+    // decode the mapped file in one step, rather than reading it through a text stream
+    // the whole text still ends up in the string, the parsers all work on a QString
+    const QByteArray data = f.data();
+    QTextCodec* codec = useUTF8_ ? QTextCodec::codecForName("UTF-8") : QTextCodec::codecForLocale();
+    // a byte order mark overrides the encoding, same as QTextStream
+    codec = QTextCodec::codecForUtfText(data, codec);
+    return codec->toUnicode(data);
   }
   return QString();
 }
@@ -128,7 +155,7 @@ QString FileHandler::readXMLFile(const QUrl& url_, bool quiet_/*=false*/) {
   }
 
   if(f.open(quiet_)) {
-    return XMLHandler::readXMLData(f.file()->readAll());
+    return XMLHandler::readXMLData(f.data());
   }
   return QString();
 }
@@ -248,12 +275,7 @@ bool FileHandler::writeTextURL(const QUrl& url_, const QString& text_, bool enco
 
   bool success = FileHandler::writeTextFile(f, text_, encodeUTF8_);
   if(success) {
-    KIO::Job* job = KIO::file_copy(QUrl::fromLocalFile(tempfile.fileName()), url_, -1, KIO::Overwrite);
-    KJobWidgets::setWindow(job, GUI::Proxy::widget());
-    success = job->exec();
-    if(!success && !quiet_) {
-      GUI::Proxy::sorry(i18n(errorUpload, url_.fileName()));
-    }
+    success = uploadFile(tempfile.fileName(), url_, quiet_);
   }
   tempfile.remove();
 
@@ -310,18 +332,40 @@ bool FileHandler::writeDataURL(const QUrl& url_, const QByteArray& data_, bool f
 
   bool success = FileHandler::writeDataFile(f, data_);
   if(success) {
-    KIO::Job* job = KIO::file_copy(QUrl::fromLocalFile(tempfile.fileName()), url_, -1, KIO::Overwrite);
-    KJobWidgets::setWindow(job, GUI::Proxy::widget());
-    success = job->exec();
-    if(!success && !quiet_) {
-      GUI::Proxy::sorry(i18n(errorUpload, url_.fileName()));
-    }
+    success = uploadFile(tempfile.fileName(), url_, quiet_);
   }
   tempfile.remove();
 
   return success;
 }
 
+bool FileHandler::uploadFile(const QString& fileName_, const QUrl& url_, bool quiet_) {
+  KIO::Job* job = KIO::file_copy(QUrl::fromLocalFile(fileName_), url_, -1, KIO::Overwrite);
+  KJobWidgets::setWindow(job, GUI::Proxy::widget());
+  const bool success = job->exec();
+  if(!success && !quiet_) {
+    GUI::Proxy::sorry(i18n(errorUpload, url_.fileName()));
+  }
+  return success;
+}
+
+QSaveFile* FileHandler::openSaveFile(const QUrl& url_, bool force_, bool quiet_) {
+  Q_ASSERT(url_.isLocalFile());
+  if(!url_.isLocalFile() || (!force_ && !queryExists(url_))) {
+    return nullptr;
+  }
+
+  QSaveFile* f = new QSaveFile(url_.toLocalFile());
+  if(!f->open(QIODevice::WriteOnly)) {
+    if(!quiet_) {
+      GUI::Proxy::sorry(i18n(errorWrite, url_.fileName()));
+    }
+    delete f;
+    return nullptr;
+  }
+  return f;
+}
+
 bool FileHandler::writeDataFile(QSaveFile& file_, const QByteArray& data_) {
 //  myDebug() << "Writing to" << file_.fileName();
   QDataStream s(&file_);
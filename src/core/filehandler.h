@@ -64,6 +64,14 @@ public:
   public:
     bool open(bool quiet=false);
     QIODevice* file() const { return m_device; }
+    /**
+     * Returns the contents of the file, which must already be open. Remote files are
+     * downloaded to a local file first, so the file is mapped into memory rather than read,
+     * and the returned array does not own its data. It is only valid as long as the
+     * FileRef exists. Anything kept longer must be copied. The file is only mapped once. If
+     * it can't be mapped, or is too large for a QByteArray to refer to, it is read instead.
+     */
+    QByteArray data();
     const QString& fileName() const { return m_filename; }
     bool isValid() const { return m_isValid; }
     ~FileRef();
@@ -73,6 +81,7 @@ public:
     explicit FileRef(const QUrl& url, bool quiet=false);
     QIODevice* m_device;
     QString m_filename;
+    QByteArray m_data;
     bool m_isValid;
   };
   friend class FileRef;
@@ -87,7 +96,8 @@ public:
    */
   static FileRef* fileRef(const QUrl& url, bool quiet=false);
   /**
-   * Read contents of a file into a string.
+   * Read contents of a file into a string. The file is mapped rather than read, but the
+   * decoded text is still a full copy.
    *
    * @param url The URL of the file
    * @param quiet whether the importer should report errors or not
@@ -143,6 +153,24 @@ public:
    * @return A boolean indicating success
    */
   static bool writeDataURL(const QUrl& url, const QByteArray& data, bool force=false, bool quiet=false);
+  /**
+   * Opens a local file for writing, so large output can be written directly rather than
+   * held in memory first. Nothing is visible at the url until the file is committed.
+   * The pointer should be deleted by the calling function.
+   *
+   * @param url The url, which must be a local file
+   * @param force Whether to force the write
+   * @return A pointer to the open file, or null on failure
+   */
+  static QSaveFile* openSaveFile(const QUrl& url, bool force=false, bool quiet=false);
+  /**
+   * Copies a local file to a remote url, overwriting any existing file.
+   *
+   * @param fileName The local file name
+   * @param url The target url
+   * @return A boolean indicating success
+   */
+  static bool uploadFile(const QString& fileName, const QUrl& url, bool quiet=false);
   /**
    * Checks to see if a URL exists already, and if so, queries the user.
    *
@@ -125,8 +125,32 @@ QPixmap NetAccess::filePreview(const KFileItem& item, int size) {
   return netaccess.m_preview;
 }
 
-void NetAccess::slotPreview(const KFileItem&, const QPixmap& pix_) {
+QHash<QUrl, QPixmap> NetAccess::filePreviews(const KFileItemList& items_, int size_) {
+  NetAccess netaccess;
+  if(items_.isEmpty()) {
+    return netaccess.m_previews;
+  }
+
+  const QStringList plugins = KIO::PreviewJob::defaultPlugins();
+  KIO::PreviewJob* previewJob = KIO::filePreview(items_, QSize(size_, size_), &plugins);
+  connect(previewJob, &KIO::PreviewJob::gotPreview,
+          &netaccess, &Tellico::NetAccess::slotPreview);
+
+  if(GUI::Proxy::widget()) {
+    KJobWidgets::setWindow(previewJob, GUI::Proxy::widget());
+  }
+  if(!previewJob->exec()) {
+    myDebug() << "Preview job did not succeed";
+  }
+  if(previewJob->error() != 0) {
+    myDebug() << previewJob->errorString();
+  }
+  return netaccess.m_previews;
+}
+
+void NetAccess::slotPreview(const KFileItem& item_, const QPixmap& pix_) {
   m_preview = pix_;
+  m_previews.insert(item_.url(), pix_);
 }
 
 void NetAccess::removeTempFile(const QString& name) {
@@ -25,12 +25,12 @@
 #ifndef TELLICO_NETACCESS_H
 #define TELLICO_NETACCESS_H
 
+#include <KFileItem>
+
 #include <QObject>
 #include <QPixmap>
-
-class QUrl;
-
-class KFileItem;
+#include <QHash>
+#include <QUrl>
 
 namespace Tellico {
 
@@ -41,6 +41,11 @@ public:
   static bool download(const QUrl& u, QString& target, QWidget* window, bool quiet=false);
   static QPixmap filePreview(const QUrl& fileName, int size=196);
   static QPixmap filePreview(const KFileItem& item, int size=196);
+  /**
+   * Generates the previews for several files with a single job, which is much faster
+   * than a job for each file. Files without a preview are not included.
+   */
+  static QHash<QUrl, QPixmap> filePreviews(const KFileItemList& items, int size=196);
   static void removeTempFile(const QString& name);
   static bool exists(const QUrl& url, bool sourceSide, QWidget* window);
 
@@ -51,6 +56,7 @@ private Q_SLOTS:
 
 private:
   QPixmap m_preview;
+  QHash<QUrl, QPixmap> m_previews;
   static QString s_lastErrorMessage;
 };
 
@@ -45,12 +45,18 @@
 #include <QMouseEvent>
 #include <QHeaderView>
 #include <QContextMenuEvent>
+#include <QTimer>
+
+namespace {
+  // large collections are added in batches, so the first entries show up right away
+  static const int ENTRY_BATCH_SIZE = 2000;
+}
 
 using namespace Tellico;
 using Tellico::DetailedListView;
 
 DetailedListView::DetailedListView(QWidget* parent_) : GUI::TreeView(parent_)
-    , m_loadingCollection(false), m_currentContextColumn(-1) {
+    , m_loadingCollection(false), m_currentContextColumn(-1), m_pendingPos(0) {
   setHeaderHidden(false);
   setSelectionMode(QAbstractItemView::ExtendedSelection);
   setAlternatingRowColors(true);
@@ -173,16 +179,48 @@ void DetailedListView::addCollection(Tellico::Data::CollPtr coll_) {
   const int order = config.readEntry(QLatin1String("SortOrder") + configN, static_cast<int>(Qt::AscendingOrder));
   sortModel()->setSortOrder(static_cast<Qt::SortOrder>(order));
 
-  setUpdatesEnabled(false);
-  m_loadingCollection = true;
-  addEntries(coll_->entries());
-  m_loadingCollection = false;
-  setUpdatesEnabled(true);
+  m_pendingEntries = coll_->entries();
+  m_pendingPos = 0;
+  slotAddEntryBatch();
 
   header()->setSortIndicator(sortModel()->sortColumn(), sortModel()->sortOrder());
 }
 
+void DetailedListView::slotAddEntryBatch() {
+  if(m_pendingEntries.isEmpty()) {
+    return;
+  }
+
+  if(m_pendingPos < m_pendingEntries.count()) {
+    setUpdatesEnabled(false);
+    m_loadingCollection = true;
+    addEntries(m_pendingEntries.mid(m_pendingPos, ENTRY_BATCH_SIZE));
+    m_loadingCollection = false;
+    setUpdatesEnabled(true);
+    m_pendingPos += ENTRY_BATCH_SIZE;
+  }
+
+  if(m_pendingPos >= m_pendingEntries.count()) {
+    m_pendingEntries.clear();
+    m_pendingPos = 0;
+  } else {
+    // let the event loop paint the view before adding the next batch
+    QTimer::singleShot(0, this, &DetailedListView::slotAddEntryBatch);
+  }
+  emit signalEntriesLoading();
+}
+
+bool DetailedListView::isLoading() const {
+  return !m_pendingEntries.isEmpty();
+}
+
+int DetailedListView::loadedCount() const {
+  return isLoading() ? qMin(m_pendingPos, m_pendingEntries.count()) : sourceModel()->rowCount();
+}
+
 void DetailedListView::slotReset() {
+  m_pendingEntries.clear();
+  m_pendingPos = 0;
   //clear() does not remove columns
   sourceModel()->clear();
 }
@@ -212,6 +250,12 @@ void DetailedListView::removeEntries(Tellico::Data::EntryList entries_) {
   if(entries_.isEmpty()) {
     return;
   }
+  // entries which have not been added yet only need to be dropped from the pending list
+  for(int i = m_pendingEntries.count() - 1; i >= m_pendingPos; --i) {
+    if(entries_.contains(m_pendingEntries.at(i))) {
+      m_pendingEntries.removeAt(i);
+    }
+  }
   sourceModel()->removeEntries(entries_);
 }
 
@@ -232,6 +276,8 @@ void DetailedListView::removeCollection(Tellico::Data::CollPtr coll_) {
     return;
   }
 
+  m_pendingEntries.clear();
+  m_pendingPos = 0;
   sourceModel()->clear();
 }
 
@@ -123,6 +123,14 @@ public:
   void selectAllVisible();
   int visibleItems() const;
   void resetEntryStatus();
+  /**
+   * Returns true while the entries of a newly added collection are still being added.
+   */
+  bool isLoading() const;
+  /**
+   * Returns the number of entries of a newly added collection which have been added so far.
+   */
+  int loadedCount() const;
 
 public Q_SLOTS:
   /**
@@ -146,6 +154,14 @@ private Q_SLOTS:
   void hideNewColumn(const QModelIndex& index, int start, int end);
 //  void slotCacheColumnWidth(int section, int oldSize, int newSize);
   void updateColumnDelegates();
+  void slotAddEntryBatch();
+
+Q_SIGNALS:
+  /**
+   * Signals that another batch of entries from a newly added collection was added
+   * to the view. When the last batch is added, isLoading() returns false.
+   */
+  void signalEntriesLoading();
 
 private:
   void contextMenuEvent(QContextMenuEvent* event) Q_DECL_OVERRIDE;
@@ -167,6 +183,9 @@ private:
   QMenu* m_columnMenu;
   bool m_loadingCollection;
   int m_currentContextColumn;
+  // the entries of a new collection which still have to be added
+  Data::EntryList m_pendingEntries;
+  int m_pendingPos;
 };
 
 } // end namespace;
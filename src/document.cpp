@@ -27,6 +27,8 @@
 #include "translators/tellicoimporter.h"
 #include "translators/tellicozipexporter.h"
 #include "translators/tellicoxmlexporter.h"
+#include "translators/tellicosnapshot.h"
+#include "translators/tellicojournal.h"
 #include "collection.h"
 #include "core/filehandler.h"
 #include "borrower.h"
@@ -36,11 +38,15 @@
 #include "images/imagedirectory.h"
 #include "images/image.h"
 #include "images/imageinfo.h"
+#include "images/imagewritequeue.h"
+#include "images/imagepreloader.h"
+#include "images/imageingestpolicy.h"
 #include "utils/stringset.h"
 #include "progressmanager.h"
 #include "config/tellico_config.h"
 #include "entrycomparison.h"
 #include "utils/guiproxy.h"
+#include "utils/phasetimer.h"
 #include "tellico_debug.h"
 
 #include <KMessageBox>
@@ -49,6 +55,8 @@
 #include <QRegExp>
 #include <QTimer>
 #include <QApplication>
+#include <QFileInfo>
+#include <QtConcurrentRun>
 
 #include <unistd.h>
 
@@ -57,15 +65,24 @@ using Tellico::Data::Document;
 Document* Document::s_self = nullptr;
 
 Document::Document() : QObject(), m_coll(nullptr), m_isModified(false),
-    m_loadAllImages(false), m_validFile(false), m_importer(nullptr), m_cancelImageWriting(true),
-    m_fileFormat(Import::TellicoImporter::Unknown) {
+    m_loadAllImages(false), m_validFile(false), m_importer(nullptr), m_imagePreloader(nullptr),
+    m_cancelImageWriting(true),
+    m_fileFormat(Import::TellicoImporter::Unknown), m_journal(new TellicoJournal()) {
   m_allImagesOnDisk = Config::imageLocation() != Config::ImagesInFile;
+  m_imageLocation = Config::imageLocation();
+  connect(&m_snapshotWatcher, &QFutureWatcherBase::finished, this, &Document::slotSnapshotWritten);
   newDocument(Collection::Book);
 }
 
 Document::~Document() {
+  waitForSnapshot();
+  // the preloader cancels and waits for its threads, no signals from here
+  delete m_imagePreloader;
+  m_imagePreloader = nullptr;
   delete m_importer;
   m_importer = nullptr;
+  delete m_journal;
+  m_journal = nullptr;
 }
 
 Tellico::Data::CollPtr Document::collection() const {
@@ -108,21 +125,24 @@ bool Document::newDocument(int type_) {
 
   m_coll = CollectionFactory::collection(type_, true);
   m_coll->setTrackGroups(true);
+  // the URL is set first since the slots for a new collection use it
+  QUrl url = QUrl::fromLocalFile(i18n(Tellico::untitledFilename));
+  setURL(url);
 
   emit signalCollectionAdded(m_coll);
   emit signalCollectionImagesLoaded(m_coll);
 
   setModified(false);
-  QUrl url = QUrl::fromLocalFile(i18n(Tellico::untitledFilename));
-  setURL(url);
   m_validFile = false;
   m_fileFormat = Import::TellicoImporter::Unknown;
+  m_journal->setCollection(m_coll, m_url);
 
   return true;
 }
 
 bool Document::openDocument(const QUrl& url_) {
   MARK;
+  PhaseTimer timer("Open document", PhaseTimer::Operation);
   m_loadAllImages = false;
   // delayed image loading only works for local files
   if(!url_.isLocalFile()) {
@@ -131,7 +151,36 @@ bool Document::openDocument(const QUrl& url_) {
 
   if(m_importer) {
     m_importer->deleteLater();
+    m_importer = nullptr;
+  }
+
+  // reading the snapshot is much faster than parsing the file again
+  Import::TellicoImporter::Format snapshotFormat;
+  CollPtr snapshot;
+  if(Config::documentSnapshots()) {
+    PhaseTimer snapshotTimer("Read snapshot");
+    // the last one might still be written for the same file
+    waitForSnapshot();
+    snapshot = TellicoSnapshot::read(url_, &snapshotFormat);
   }
+  if(snapshot) {
+    m_fileFormat = snapshotFormat;
+    m_allImagesOnDisk = true;
+    m_loadAllImages = true;
+    ImageFactory::setZipArchive(nullptr);
+    deleteContents();
+    m_coll = snapshot;
+    replayJournal(url_);
+    m_imageLocation = Config::imageLocation();
+    m_coll->setTrackGroups(true);
+    setURL(url_);
+    m_validFile = true;
+    emit signalCollectionAdded(m_coll);
+    setModified(false);
+    emit signalCollectionImagesLoaded(m_coll);
+    return true;
+  }
+
   m_importer = new Import::TellicoImporter(url_, m_loadAllImages);
 
   ProgressItem& item = ProgressManager::self()->newProgressItem(m_importer, m_importer->progressLabel(), true);
@@ -165,14 +214,27 @@ bool Document::openDocument(const QUrl& url_) {
   }
   deleteContents();
   m_coll = coll;
+
+  const bool modified = m_importer->modifiedOriginal();
+  // images inside the file still have to be read from it, so no snapshot for those
+  // the snapshot has to match the file, so it gets captured before the journal is replayed
+  if(!modified && !m_importer->hasImages()) {
+    writeSnapshot(url_);
+  }
+  replayJournal(url_);
+  if(modified) {
+    // the changes made while reading the file aren't in the journal
+    m_journal->invalidate();
+  }
+  m_imageLocation = Config::imageLocation();
+
   m_coll->setTrackGroups(true);
   setURL(url_);
   m_validFile = true;
 
   emit signalCollectionAdded(m_coll);
 
-  // m_importer might have been deleted?
-  setModified(m_importer && m_importer->modifiedOriginal());
+  setModified(modified);
 //  if(pruneImages()) {
 //    slotSetModified(true);
 //  }
@@ -189,7 +251,84 @@ bool Document::openDocument(const QUrl& url_) {
   return true;
 }
 
+void Document::restoreDocument(Tellico::Data::CollPtr coll_, const QUrl& url_, int format_) {
+  if(!coll_) {
+    return;
+  }
+  if(m_importer) {
+    m_importer->deleteLater();
+    m_importer = nullptr;
+  }
+  deleteContents();
+  m_coll = coll_;
+  m_coll->setTrackGroups(true);
+  setURL(url_);
+  m_validFile = url_.fileName() != i18n(Tellico::untitledFilename);
+  m_fileFormat = format_;
+  // the autosave is only written when all the images are on disk
+  m_allImagesOnDisk = true;
+  m_loadAllImages = true;
+  ImageFactory::setZipArchive(nullptr);
+  // the restored changes aren't in the file, so the journal can't be used until it's written again
+  m_journal->setCollection(m_coll, m_url);
+  m_journal->invalidate();
+
+  emit signalCollectionAdded(m_coll);
+  setModified(true);
+  emit signalCollectionImagesLoaded(m_coll);
+}
+
+void Document::replayJournal(const QUrl& url_) {
+  PhaseTimer timer("Replay journal");
+  timer.setCount(m_journal->replay(m_coll, url_));
+}
+
 bool Document::saveDocument(const QUrl& url_, bool force_) {
+  PhaseTimer timer("Save document", PhaseTimer::Operation);
+  if(saveJournal(url_)) {
+    return true;
+  }
+  return writeDocument(url_, force_);
+}
+
+bool Document::compactDocument() {
+  if(!m_validFile) {
+    return false;
+  }
+  PhaseTimer timer("Compact document", PhaseTimer::Operation);
+  return writeDocument(m_url, true /* force */);
+}
+
+bool Document::saveJournal(const QUrl& url_) {
+  // images inside the file can only be added by writing the whole file
+  // and if the image location changed, all the images have to be written again
+  if(!Config::journalSaving() || !m_allImagesOnDisk ||
+     Config::imageLocation() == Config::ImagesInFile ||
+     Config::imageLocation() != m_imageLocation ||
+     !m_journal->canSave(m_coll, url_)) {
+    return false;
+  }
+  // once the journal grows too large, the whole file gets written again
+  const qint64 fileSize = QFileInfo(url_.toLocalFile()).size();
+  if(m_journal->size() > fileSize * Config::journalCompactionPercent() / 100) {
+    return false;
+  }
+
+  // only the images in the modified entries might not be written yet
+  m_cancelImageWriting = false;
+  writeImages(m_journal->modifiedEntries(),
+              m_imageLocation == Config::ImagesInAppDir ? ImageFactory::DataDir : ImageFactory::LocalDir, url_);
+  PhaseTimer timer("Write journal");
+  if(!m_journal->save()) {
+    myDebug() << "Failed to save journal for" << url_.toLocalFile();
+    return false;
+  }
+  setModified(false);
+  pruneOriginalImages(url_);
+  return true;
+}
+
+bool Document::writeDocument(const QUrl& url_, bool force_) {
   // FileHandler::queryExists calls FileHandler::writeBackupFile
   // so the only reason to check queryExists() is if the url to write to is different than the current one
   if(url_ == m_url) {
@@ -202,9 +341,9 @@ bool Document::saveDocument(const QUrl& url_, bool force_) {
     }
   }
 
-  // in case we're still loading images, give that a chance to cancel
+  // in case we're still loading images, cancel that and wait, since the file might be overwritten
   m_cancelImageWriting = true;
-  qApp->processEvents();
+  stopImagePreloading();
 
   ProgressItem& item = ProgressManager::self()->newProgressItem(this, i18n("Saving file..."), false);
   ProgressItem::Done done(this);
@@ -243,13 +382,26 @@ bool Document::saveDocument(const QUrl& url_, bool force_) {
   // only write the image sizes if they're known already
   opt &= ~Export::ExportImageSize;
   exporter->setOptions(opt);
-  const bool success = exporter->exec();
+  bool success;
+  {
+    PhaseTimer exportTimer("Write file");
+    success = exporter->exec();
+  }
   item.setProgress(int(0.9*totalSteps));
 
   if(success) {
+    const QUrl oldUrl = m_url;
     setURL(url_);
     // if successful, doc is no longer modified
     setModified(false);
+    if(!includeImages) {
+      writeSnapshot(url_);
+    }
+    // the file has everything now, so the journal starts over
+    TellicoJournal::remove(url_);
+    m_journal->setCollection(m_coll, url_);
+    m_imageLocation = imageLocation;
+    pruneOriginalImages(oldUrl);
   } else {
     myDebug() << "Document::saveDocument() - not successful saving to" << url_.url();
   }
@@ -278,10 +430,13 @@ void Document::deleteContents() {
     m_coll->clear();
   }
   m_coll = nullptr; // old collection gets deleted as refcount goes to 0
+  m_journal->setCollection(Data::CollPtr(), QUrl());
   m_cancelImageWriting = true;
+  stopImagePreloading();
 }
 
 void Document::appendCollection(Tellico::Data::CollPtr coll_) {
+  m_journal->invalidate();
   appendCollection(m_coll, coll_);
 }
 
@@ -308,6 +463,7 @@ void Document::appendCollection(Tellico::Data::CollPtr coll1_, Tellico::Data::Co
 }
 
 Tellico::Data::MergePair Document::mergeCollection(Tellico::Data::CollPtr coll_) {
+  m_journal->invalidate();
   return mergeCollection(m_coll, coll_);
 }
 
@@ -390,7 +546,9 @@ void Document::replaceCollection(Tellico::Data::CollPtr coll_) {
 
   m_coll = coll_;
   m_coll->setTrackGroups(true);
+  m_journal->setCollection(m_coll, m_url);
   m_cancelImageWriting = true;
+  stopImagePreloading();
   // CollectionCommand takes care of calling Controller signals
 }
 
@@ -398,6 +556,7 @@ void Document::unAppendCollection(Tellico::Data::CollPtr coll_, Tellico::Data::F
   if(!coll_) {
     return;
   }
+  m_journal->invalidate();
 
   m_coll->blockSignals(true);
 
@@ -429,6 +588,7 @@ void Document::unMergeCollection(Tellico::Data::CollPtr coll_, Tellico::Data::Fi
   if(!coll_) {
     return;
   }
+  m_journal->invalidate();
 
   m_coll->blockSignals(true);
 
@@ -530,39 +690,79 @@ void Document::renameCollection(const QString& newTitle_) {
 // by loading every image, it gets pulled out of the zip file and
 // copied to disk. Then the zip file can be closed and not retained in memory
 void Document::slotLoadAllImages() {
+  if(!m_coll || m_cancelImageWriting) {
+    finishImagePreloading();
+    return;
+  }
+
   QString id;
   StringSet images;
+  QStringList ids;
   foreach(EntryPtr entry, m_coll->entries()) {
     foreach(FieldPtr field, m_coll->imageFields()) {
       id = entry->field(field);
       if(id.isEmpty() || images.has(id)) {
         continue;
       }
-      // this is the early loading, so just by calling imageById()
-      // the image gets sucked from the zip file and written to disk
-      // by ImageFactory::imageById()
-      // TODO:: does this need to check against images with link only?
-      if(ImageFactory::imageById(id).isNull()) {
-        myDebug() << "Null image for entry:" << entry->title() << id;
-      }
       images.add(id);
-      if(m_cancelImageWriting) {
-        break;
+      // link-only images are never in the zip file
+      if(!QUrl(id).isRelative()) {
+        continue;
       }
+      ids << id;
     }
-    if(m_cancelImageWriting) {
-      break;
-    }
-    // stay responsive, do this in the background
-    qApp->processEvents();
   }
 
+  // a remote file is read from the copy the importer downloaded
+  const QString zipFileName = m_importer ? m_importer->zipFileName() : QString();
+  if(zipFileName.isEmpty()) {
+    // anything left will still be read from the zip archive when needed
+    finishImagePreloading();
+    return;
+  }
+
+  // the images are extracted and verified by worker threads, each with its own handle
+  // to the zip file, so the GUI thread only gets the completion notifications
+  delete m_imagePreloader;
+  m_imagePreloader = new ImagePreloader(zipFileName, this);
+  m_imagePreloader->setMaxThreadCount(Config::imageLoadThreads());
+  connect(m_imagePreloader, &ImagePreloader::finished, this, &Document::slotImagesPreloaded);
+  m_imagePreloader->load(ids);
+}
+
+void Document::slotImagesPreloaded() {
+  if(m_imagePreloader) {
+    // the preloader sent the signal
+    m_imagePreloader->deleteLater();
+    m_imagePreloader = nullptr;
+  }
+  finishImagePreloading();
+}
+
+void Document::cancelImageWriting() {
+  m_cancelImageWriting = true;
+  stopImagePreloading();
+}
+
+void Document::stopImagePreloading() {
+  if(!m_imagePreloader) {
+    return;
+  }
+  m_imagePreloader->cancel();
+  delete m_imagePreloader;
+  m_imagePreloader = nullptr;
+  finishImagePreloading();
+}
+
+// the images are all loaded, or the loading was stopped, either way the importer isn't needed
+void Document::finishImagePreloading() {
   if(m_cancelImageWriting) {
     myLog() << "slotLoadAllImages() - cancel image writing";
-  } else {
+  }
+  // anything that wasn't preloaded is still read from the zip file when needed
+  if(m_coll) {
     emit signalCollectionImagesLoaded(m_coll);
   }
-
   m_cancelImageWriting = false;
   if(m_importer) {
     m_importer->deleteLater();
@@ -573,21 +773,30 @@ void Document::slotLoadAllImages() {
 // cacheDir_ is the location dir to write the images
 // localDir_ provide the new file location which is only needed if cacheDir == LocalDir
 void Document::writeAllImages(int cacheDir_, const QUrl& localDir_) {
+  writeImages(m_coll->entries(), cacheDir_, localDir_);
+}
+
+void Document::writeImages(const Tellico::Data::EntryList& entries_, int cacheDir_, const QUrl& localDir_) {
+  PhaseTimer timer("Write images");
   // images get 80 steps in saveDocument()
-  const uint stepSize = 1 + qMax(1, m_coll->entryCount()/80); // add 1 since it could round off
+  const uint stepSize = 1 + qMax(1, entries_.count()/80); // add 1 since it could round off
   uint j = 1;
 
   ImageFactory::CacheDir cacheDir = static_cast<ImageFactory::CacheDir>(cacheDir_);
   QScopedPointer<ImageDirectory> imgDir;
+  QScopedPointer<ImageWriteQueue> writeQueue;
+  // careful here, if we're writing to LocalDir, need to read from the old LocalDir and write to new
   if(cacheDir == ImageFactory::LocalDir) {
     imgDir.reset(new ImageDirectory(ImageFactory::localDirectory(localDir_)));
+    writeQueue.reset(new ImageWriteQueue(imgDir.data()));
+  } else {
+    writeQueue.reset(new ImageWriteQueue(cacheDir));
   }
 
   QString id;
   StringSet images;
-  EntryList entries = m_coll->entries();
   FieldList imageFields = m_coll->imageFields();
-  foreach(EntryPtr entry, entries) {
+  foreach(EntryPtr entry, entries_) {
     foreach(FieldPtr field, imageFields) {
       id = entry->field(field);
       if(id.isEmpty() || images.has(id)) {
@@ -597,16 +806,11 @@ void Document::writeAllImages(int cacheDir_, const QUrl& localDir_) {
       if(ImageFactory::imageInfo(id).linkOnly) {
         continue;
       }
-      // careful here, if we're writing to LocalDir, need to read from the old LocalDir and write to new
-      bool success;
-      if(cacheDir == ImageFactory::LocalDir) {
-        success = ImageFactory::writeCachedImage(id, imgDir.data());
-      } else {
-        success = ImageFactory::writeCachedImage(id, cacheDir);
-      }
-      if(!success) {
+      // the images are encoded and written in the background, the queue only blocks when it is full
+      if(!writeQueue->enqueue(id)) {
         myDebug() << "did not write image for entry title:" << entry->title();
       }
+      timer.addCount();
       if(m_cancelImageWriting) {
         break;
       }
@@ -620,6 +824,8 @@ void Document::writeAllImages(int cacheDir_, const QUrl& localDir_) {
       break;
     }
   }
+  // anything already queued still gets written, even if cancelled
+  writeQueue->finish();
 
   if(m_cancelImageWriting) {
     myDebug() << "Document::writeAllImages() - cancel image writing";
@@ -653,6 +859,71 @@ bool Document::pruneImages() {
   return found;
 }
 
+void Document::writeSnapshot(const QUrl& url_) {
+  if(!Config::documentSnapshots()) {
+    return;
+  }
+  const QByteArray header = TellicoSnapshot::documentHeader(url_);
+  if(header.isEmpty()) {
+    return;
+  }
+  // only one snapshot is written at a time
+  waitForSnapshot();
+  PhaseTimer timer("Capture snapshot");
+  m_snapshot.reset(new TellicoSnapshot(m_coll, static_cast<Import::TellicoImporter::Format>(m_fileFormat)));
+  m_snapshotWatcher.setFuture(QtConcurrent::run(m_snapshot.data(), &TellicoSnapshot::writeFile,
+                                                TellicoSnapshot::snapshotFileName(url_), header));
+}
+
+void Document::waitForSnapshot() {
+  m_snapshotWatcher.waitForFinished();
+  finishSnapshot();
+}
+
+void Document::finishSnapshot() {
+  if(!m_snapshot) {
+    return;
+  }
+  if(!m_snapshotWatcher.result()) {
+    myDebug() << "Failed to write snapshot";
+  }
+  // the entry copies hold a reference to the collection, so release them on the GUI thread
+  m_snapshot.reset();
+  TellicoSnapshot::prune();
+}
+
+void Document::slotSnapshotWritten() {
+  // a later snapshot might have been started already, after waiting for this one
+  if(!m_snapshotWatcher.isRunning()) {
+    finishSnapshot();
+  }
+}
+
+void Document::pruneOriginalImages(const QUrl& oldUrl_) {
+  const QString dir = ImageIngestPolicy::documentOriginalDirectory(m_url);
+  if(oldUrl_ != m_url) {
+    ImageIngestPolicy::moveOriginals(ImageIngestPolicy::documentOriginalDirectory(oldUrl_), dir);
+    // any image reduced from now on belongs with the new name
+    ImageIngestPolicy policy = ImageFactory::ingestPolicy();
+    if(!policy.originalDirectory().isEmpty()) {
+      policy.setOriginalDirectory(dir);
+      ImageFactory::setIngestPolicy(policy);
+    }
+  }
+
+  QSet<QString> imageIds;
+  const FieldList imageFields = m_coll->imageFields();
+  foreach(EntryPtr entry, m_coll->entries()) {
+    foreach(FieldPtr field, imageFields) {
+      const QString id = entry->field(field);
+      if(!id.isEmpty()) {
+        imageIds.insert(id);
+      }
+    }
+  }
+  ImageIngestPolicy::pruneOriginals(dir, imageIds);
+}
+
 int Document::imageCount() const {
   if(!m_coll) {
     return 0;
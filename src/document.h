@@ -31,8 +31,13 @@
 #include <QObject>
 #include <QPointer>
 #include <QUrl>
+#include <QFutureWatcher>
+#include <QScopedPointer>
 
 namespace Tellico {
+  class ImagePreloader;
+  class TellicoJournal;
+  class TellicoSnapshot;
   namespace Import {
     class TellicoImporter;
     class TellicoSaxImporter;
@@ -90,6 +95,10 @@ public:
    * @return The url
    */
   const QUrl& URL() const { return m_url; }
+  /**
+   * Returns the file format of the document, one of Import::TellicoImporter::Format
+   */
+  int fileFormat() const { return m_fileFormat; }
   /**
    * Initializes a new document. The signalNewDoc() signal is emitted. The return
    * value is currently always true, but should indicate whether or not a new document
@@ -108,6 +117,15 @@ public:
    * @return A boolean indicating success
    */
   bool openDocument(const QUrl& url);
+  /**
+   * Replaces the document with a collection restored from an autosave. The document is
+   * marked as modified, since the changes were never saved.
+   *
+   * @param coll The restored collection
+   * @param url The location of the document the changes were made to
+   * @param format The file format of the document
+   */
+  void restoreDocument(CollPtr coll, const QUrl& url, int format);
   /**
    * Saves the document contents to a file.
    *
@@ -116,6 +134,18 @@ public:
    * @return A boolean indicating success
    */
   bool saveDocument(const QUrl& url, bool force = false);
+  /**
+   * Writes the whole document to its current file. If journal saving is enabled, the
+   * journal of changes is folded into the file and removed.
+   *
+   * @return A boolean indicating success
+   */
+  bool compactDocument();
+  /**
+   * Returns the journal tracking the changes to the document, which needs to be added
+   * as an observer to the Controller.
+   */
+  TellicoJournal* journal() const { return m_journal; }
   /**
    * Closes the document, deleting the contents. The return value is presently always true.
    *
@@ -181,7 +211,7 @@ public:
    * in addition to those already in the collection
    */
   void removeImagesNotInCollection(EntryList entries, EntryList entriesToKeep);
-  void cancelImageWriting() { m_cancelImageWriting = true; }
+  void cancelImageWriting();
 
   static bool mergeEntry(EntryPtr entry1, EntryPtr entry2, MergeConflictResolver* resolver=nullptr);
   // adds new fields into collection if any values in entries are not empty
@@ -223,6 +253,8 @@ private Q_SLOTS:
    * images to temp dir initially
    */
   void slotLoadAllImages();
+  void slotImagesPreloaded();
+  void slotSnapshotWritten();
 
 private:
   static Document* s_self;
@@ -232,7 +264,33 @@ private:
    * if cacheDir = LocalDir, then url will be used and must not be empty
    */
   void writeAllImages(int cacheDir, const QUrl& url=QUrl());
+  void writeImages(const EntryList& entries, int cacheDir, const QUrl& url=QUrl());
+  /**
+   * Appends the changes to the journal rather than writing the whole file, if possible
+   */
+  bool saveJournal(const QUrl& url);
+  void replayJournal(const QUrl& url);
+  bool writeDocument(const QUrl& url, bool force);
   bool pruneImages();
+  /**
+   * Moves the kept originals of any reduced images along with the document, if it was saved
+   * under a new name, and removes the ones no longer used by the collection
+   */
+  void pruneOriginalImages(const QUrl& oldUrl);
+  /**
+   * Captures the collection and writes the snapshot for a local file in a worker thread
+   */
+  void writeSnapshot(const QUrl& url);
+  /**
+   * Waits for any snapshot still being written
+   */
+  void waitForSnapshot();
+  void finishSnapshot();
+  /**
+   * Stops any background image loading, waiting for the worker threads to finish
+   */
+  void stopImagePreloading();
+  void finishImagePreloading();
 
   // make all constructors private
   Document();
@@ -246,9 +304,15 @@ private:
   QUrl m_url;
   bool m_validFile;
   QPointer<Import::TellicoImporter> m_importer;
+  ImagePreloader* m_imagePreloader;
   bool m_cancelImageWriting;
   int m_fileFormat;
   bool m_allImagesOnDisk;
+  TellicoJournal* m_journal;
+  QScopedPointer<TellicoSnapshot> m_snapshot;
+  QFutureWatcher<bool> m_snapshotWatcher;
+  // the image location when the file was last written
+  int m_imageLocation;
 };
 
   } // end namespace
@@ -47,7 +47,6 @@
 #include <QFile>
 #include <QTextStream>
 #include <QClipboard>
-#include <QDomDocument>
 #include <QTemporaryFile>
 #include <QApplication>
 #include <QDesktopServices>
@@ -155,20 +154,14 @@ void EntryView::showEntry(Tellico::Data::EntryPtr entry_) {
     opt |= Export::ExportClean;
   }
   exporter.setOptions(opt);
-  QDomDocument dom = exporter.exportXML();
+  xmlDocPtr doc = exporter.exportXMLDoc();
 
-//  myDebug() << dom.toString();
 #if 0
   myWarning() << "turn me off!";
-  QFile f1(QLatin1String("/tmp/test.xml"));
-  if(f1.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f1);
-    t << dom.toString();
-  }
-  f1.close();
+  xmlSaveFormatFile("/tmp/test.xml", doc, 1);
 #endif
 
-  QString html = m_handler->applyStylesheet(dom.toString());
+  QString html = m_handler->process(doc);
   // write out image files
   Data::FieldList fields = entry_->collection()->imageFields();
   foreach(Data::FieldPtr field, fields) {
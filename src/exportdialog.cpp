@@ -26,6 +26,7 @@
 #include "collection.h"
 #include "core/filehandler.h"
 #include "controller.h"
+#include "utils/phasetimer.h"
 #include "tellico_debug.h"
 
 #include "translators/exporter.h"
@@ -271,6 +272,8 @@ bool ExportDialog::exportURL(const QUrl& url_/*=QUrl()*/) const {
 
   m_exporter->setOptions(opt);
 
+  PhaseTimer timer("Export", PhaseTimer::Operation);
+  timer.setCount(m_exporter->entries().count());
   return m_exporter->exec();
 }
 
@@ -302,5 +305,7 @@ bool ExportDialog::exportCollection(Data::CollPtr coll_, Data::EntryList entries
   }
   exp->setOptions(options | Export::ExportForce);
 
+  PhaseTimer timer("Export", PhaseTimer::Operation);
+  timer.setCount(entries_.count());
   return exp->exec();
 }
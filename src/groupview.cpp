@@ -45,11 +45,17 @@
 #include <QRegExp>
 #include <QHeaderView>
 #include <QContextMenuEvent>
+#include <QTimer>
+
+namespace {
+  // grouping a collection larger than this is put off until the entries are shown
+  static const int GROUP_POPULATE_DEFER_COUNT = 2000;
+}
 
 using Tellico::GroupView;
 
 GroupView::GroupView(QWidget* parent_)
-    : GUI::TreeView(parent_), m_notSortedYet(true) {
+    : GUI::TreeView(parent_), m_notSortedYet(true), m_populatePending(false) {
   header()->setSectionResizeMode(QHeaderView::Stretch);
   setHeaderHidden(false);
   setSelectionMode(QAbstractItemView::ExtendedSelection);
@@ -94,10 +100,28 @@ void GroupView::addCollection(Tellico::Data::CollPtr coll_) {
     m_groupClosedIconName = QStringLiteral(":/icons/person");
   }
 
+  // building the groups of a large collection takes a while, so let the entries
+  // get shown first and add the groups when the main window is idle
+  if(m_coll->entryCount() > GROUP_POPULATE_DEFER_COUNT) {
+    m_populatePending = true;
+    sourceModel()->clear();
+    updateHeader();
+    QTimer::singleShot(0, this, &GroupView::slotPopulatePending);
+    return;
+  }
+
   updateHeader();
   populateCollection();
 }
 
+void GroupView::slotPopulatePending() {
+  if(!m_populatePending) {
+    return;
+  }
+  populateCollection();
+  updateHeader();
+}
+
 void GroupView::removeCollection(Tellico::Data::CollPtr coll_) {
   if(!coll_) {
     myWarning() << "null coll pointer!";
@@ -110,6 +134,7 @@ void GroupView::removeCollection(Tellico::Data::CollPtr coll_) {
 }
 
 void GroupView::populateCollection() {
+  m_populatePending = false;
   if(!m_coll) {
     return;
   }
@@ -208,6 +233,7 @@ void GroupView::modifyField(Tellico::Data::CollPtr, Tellico::Data::FieldPtr, Tel
 }
 
 void GroupView::slotReset() {
+  m_populatePending = false;
   sourceModel()->clear();
 }
 
@@ -216,6 +242,10 @@ void GroupView::slotModifyGroups(Tellico::Data::CollPtr coll_, QList<Tellico::Da
     myWarning() << "null coll or group pointer!";
     return;
   }
+  // the groups all get added once the collection is populated
+  if(m_populatePending) {
+    return;
+  }
 
   /* for each group
      - remove existing empty ones
@@ -378,7 +408,9 @@ void GroupView::slotSortingChanged(int col_, Qt::SortOrder order_) {
 
 void GroupView::updateHeader(Tellico::Data::FieldPtr field_/*=0*/) {
   QString t = field_ ? field_->title() : groupTitle();
-  if(sortModel()->sortRole() == Qt::DisplayRole) {
+  if(m_populatePending) {
+    model()->setHeaderData(0, Qt::Horizontal, i18n("%1 (Loading...)", t));
+  } else if(sortModel()->sortRole() == Qt::DisplayRole) {
     model()->setHeaderData(0, Qt::Horizontal, t);
   } else {
     model()->setHeaderData(0, Qt::Horizontal, i18n("%1 (Sort by Count)", t));
@@ -112,6 +112,10 @@ public Q_SLOTS:
    * @param groups A vector of pointers to the modified groups
    */
   void slotModifyGroups(Tellico::Data::CollPtr coll, QList<Tellico::Data::EntryGroup*> groups);
+  /**
+   * Adds the groups of a large collection, if that was put off when the collection was added.
+   */
+  void slotPopulatePending();
 
 private:
   void contextMenuEvent(QContextMenuEvent* event) Q_DECL_OVERRIDE;
@@ -155,6 +159,7 @@ private:
   friend class GroupIterator;
 
   bool m_notSortedYet;
+  bool m_populatePending;
   Data::CollPtr m_coll;
   QString m_groupBy;
 
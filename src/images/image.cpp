@@ -27,6 +27,7 @@
 #include "../tellico_debug.h"
 
 #include <QBuffer>
+#include <QFile>
 #include <QRegExp>
 #include <QImageReader>
 #include <QImageWriter>
@@ -58,7 +59,8 @@ Image& Image::operator=(const Image& other) {
 
 // I'm using the MD5 hash as the id. I consider it rather unlikely that two images in one
 // collection could ever have the same hash, and this lets me do a fast comparison of two images
-// simply by comparing their ids.
+// simply by comparing their ids. The hash is of the original file contents, so the same file
+// always gets the same id, regardless of how Qt encodes the image.
 Image::Image(const QString& filename_, const QString& id_) : QImage(filename_), m_id(idClean(id_)), m_linkOnly(false) {
   m_format = QImageReader::imageFormat(filename_);
   if(isNull()) {
@@ -70,8 +72,13 @@ Image::Image(const QString& filename_, const QString& id_) : QImage(filename_),
       m_format = "PNG";
     }
   }
-  if(m_id.isEmpty()) {
-    calculateID();
+  if(m_id.isEmpty() && !isNull()) {
+    QFile file(filename_);
+    if(file.open(QIODevice::ReadOnly)) {
+      m_id = calculateID(file.readAll(), QLatin1String(m_format));
+    } else {
+      calculateID();
+    }
   }
 }
 
@@ -157,6 +164,7 @@ void Image::setID(const QString& id_) {
 }
 
 void Image::calculateID() {
+  // only used when there is no original data to hash
   // the id will eventually be used as a filename
   if(!isNull()) {
     m_id = calculateID(byteArray(), QLatin1String(m_format));
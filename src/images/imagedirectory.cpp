@@ -93,6 +93,13 @@ Tellico::Data::Image* ImageDirectory::imageById(const QString& id_) {
 }
 
 bool ImageDirectory::writeImage(const Data::Image& img_) {
+  const QString path = writePath();
+  QUrl target = QUrl::fromLocalFile(path);
+  target.setPath(target.path() + img_.id());
+  return FileHandler::writeDataURL(target, img_.byteArray(), true /* force */);
+}
+
+QString ImageDirectory::writePath() {
   const QString path = this->path(); // virtual function, so don't assume m_path is correct
   if(!m_pathExists) {
     if(path.isEmpty()) {
@@ -101,7 +108,7 @@ bool ImageDirectory::writeImage(const Data::Image& img_) {
         m_dir = new QTemporaryDir(); // default is to auto-delete, aka autoRemove()
         ImageDirectory::setPath(m_dir->path());
       }
-      return writeImage(img_);
+      return writePath();
     }
     QDir dir(path);
     if(dir.mkdir(path)) {
@@ -111,9 +118,7 @@ bool ImageDirectory::writeImage(const Data::Image& img_) {
     }
     m_pathExists = true;
   }
-  QUrl target = QUrl::fromLocalFile(path);
-  target.setPath(target.path() + img_.id());
-  return FileHandler::writeDataURL(target, img_.byteArray(), true /* force */);
+  return path;
 }
 
 bool ImageDirectory::removeImage(const QString& id_) {
@@ -192,12 +197,7 @@ Tellico::Data::Image* ImageZipArchive::imageById(const QString& id_) {
   }
   // might be unexpected behavior, but in order to delete the zip object after
   // all images are read, we need to consider the image gone now
-  m_images.remove(id_);
-  if(m_images.isEmpty()) {
-    delete m_zip;
-    m_zip = nullptr;
-    m_imgDir = nullptr;
-  }
+  removeImage(id_);
   if(!img) {
     myLog() << "image not found:" << id_;
     return nullptr;
@@ -209,3 +209,15 @@ Tellico::Data::Image* ImageZipArchive::imageById(const QString& id_) {
   }
   return img;
 }
+
+void ImageZipArchive::removeImage(const QString& id_) {
+  if(!m_zip || !m_images.has(id_)) {
+    return;
+  }
+  m_images.remove(id_);
+  if(m_images.isEmpty()) {
+    delete m_zip;
+    m_zip = nullptr;
+    m_imgDir = nullptr;
+  }
+}
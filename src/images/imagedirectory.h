@@ -64,6 +64,10 @@ public:
   Data::Image* imageById(const QString& id) Q_DECL_OVERRIDE;
   bool writeImage(const Data::Image& image);
   bool removeImage(const QString& id);
+  /**
+   * Returns the directory path, creating the directory if it doesn't exist yet
+   */
+  QString writePath();
 
 private:
   Q_DISABLE_COPY(ImageDirectory)
@@ -97,6 +101,10 @@ public:
 
   bool hasImage(const QString& id) Q_DECL_OVERRIDE;
   Data::Image* imageById(const QString& id) Q_DECL_OVERRIDE;
+  /**
+   * Marks an image as no longer needed, the zip is closed once all images are gone
+   */
+  void removeImage(const QString& id);
 
 private:
   Q_DISABLE_COPY(ImageZipArchive)
@@ -30,6 +30,7 @@
 #include "../config/tellico_config.h"
 #include "../utils/tellico_utils.h"
 #include "../utils/gradient.h"
+#include "../utils/phasetimer.h"
 #include "../tellico_debug.h"
 
 #include <KColorUtils>
@@ -51,7 +52,7 @@ Tellico::ImageFactory* ImageFactory::factory = nullptr;
 
 class ImageFactory::Private {
 public:
-  Private() {}
+  Private() : jobScheduler(nullptr) {}
 
   QHash<QString, Data::Image*> imageDict;
   QCache<QString, Data::Image> imageCache;
@@ -61,9 +62,14 @@ public:
   TemporaryImageDirectory tempImageDir; // kept in tmp directory
   ImageZipArchive imageZipArchive;
   StringSet nullImages;
+  ImageJobScheduler* jobScheduler;
+  ImageIngestPolicy ingestPolicy;
 };
 
 ImageFactory::ImageFactory() : QObject(), d(new Private()) {
+  d->jobScheduler = new ImageJobScheduler(this);
+  connect(d->jobScheduler, &ImageJobScheduler::jobFinished,
+          this, &ImageFactory::slotImageJobResult);
 }
 
 ImageFactory::~ImageFactory() {
@@ -130,6 +136,7 @@ const Tellico::Data::Image& ImageFactory::addImageImpl(const QUrl& url_, bool qu
   ImageJob* job = new ImageJob(url_, QString(), quiet_);
   job->setLinkOnly(link_);
   job->setReferrer(refer_);
+  job->setIngestPolicy(d->ingestPolicy);
 
   if(!job->exec()) {
 //    myDebug() << "ImageJob failed to exec:" << job->errorString();
@@ -163,7 +170,7 @@ QString ImageFactory::addImage(const QPixmap& pix_, const QString& format_) {
 }
 
 const Tellico::Data::Image& ImageFactory::addImageImpl(const QImage& image_, const QString& format_) {
-  Data::Image* img = new Data::Image(image_, format_);
+  Data::Image* img = new Data::Image(d->ingestPolicy.scaleImage(image_), format_);
   if(hasImageInMemory(img->id())) {
     const Data::Image& img2 = imageById(img->id());
     if(!img2.isNull()) {
@@ -204,6 +211,7 @@ const Tellico::Data::Image& ImageFactory::addImageImpl(const QByteArray& data_,
     return *img;
   }
 
+  PhaseTimer timer("Decode image");
   img = new Data::Image(data_, format_, id_);
   if(img->isNull()) {
     myDebug() << "NULL IMAGE!!!!!";
@@ -270,27 +278,52 @@ bool ImageFactory::writeCachedImage(const QString& id_, CacheDir dir_, bool forc
     return false;
   }
 //  myLog() << "dir =" << (dir_ == DataDir ? "DataDir" : "TmpDir" ) << "; id =" << id_;
-  ImageDirectory* imgDir = dir_ == DataDir ? &factory->d->dataImageDir :
-                          (dir_ == TempDir ? &factory->d->tempImageDir :
-                                             &factory->d->localImageDir);
+  ImageDirectory* imgDir = imageDirectory(dir_);
   Q_ASSERT(imgDir);
   bool success = writeCachedImage(id_, imgDir, force_);
 
   if(success) {
-    // remove from dict and add to cache
-    // it might not be in dict though
-    if(factory->d->imageDict.contains(id_)) {
-      Data::Image* img = factory->d->imageDict.take(id_);
-      Q_ASSERT(img);
-      // imageCache.insert will delete the image by itself if the cost exceeds the cache size
-      if(factory->d->imageCache.insert(img->id(), img, img->byteSize())) {
-        s_imageInfoMap.remove(id_);
-      }
-    }
+    imageWritten(id_);
   }
   return success;
 }
 
+Tellico::ImageDirectory* ImageFactory::imageDirectory(CacheDir dir_) {
+  return dir_ == DataDir ? &factory->d->dataImageDir :
+        (dir_ == TempDir ? &factory->d->tempImageDir :
+                           &factory->d->localImageDir);
+}
+
+QString ImageFactory::imageFileName(const QString& id_) {
+  if(id_.isEmpty()) {
+    return QString();
+  }
+  // the image files are always written with Image::byteArray() so they can be copied directly
+  if(factory->d->tempImageDir.hasImage(id_)) {
+    return factory->d->tempImageDir.path() + id_;
+  }
+  if(factory->d->dataImageDir.hasImage(id_)) {
+    return factory->d->dataImageDir.path() + id_;
+  }
+  if(factory->d->localImageDir.hasImage(id_)) {
+    return factory->d->localImageDir.path() + id_;
+  }
+  return QString();
+}
+
+void ImageFactory::imageWritten(const QString& id_) {
+  // remove from dict and add to cache
+  // it might not be in dict though
+  if(factory->d->imageDict.contains(id_)) {
+    Data::Image* img = factory->d->imageDict.take(id_);
+    Q_ASSERT(img);
+    // imageCache.insert will delete the image by itself if the cost exceeds the cache size
+    if(factory->d->imageCache.insert(img->id(), img, img->byteSize())) {
+      s_imageInfoMap.remove(id_);
+    }
+  }
+}
+
 bool ImageFactory::writeCachedImage(const QString& id_, ImageDirectory* imgDir_, bool force_ /*=false*/) {
   if(id_.isEmpty() || !imgDir_) {
     return false;
@@ -309,6 +342,11 @@ bool ImageFactory::writeCachedImage(const QString& id_, ImageDirectory* imgDir_,
   return success;
 }
 
+void ImageFactory::imagePreloaded(const Data::ImageInfo& info_) {
+  s_imageInfoMap.insert(info_.id, info_);
+  factory->d->imageZipArchive.removeImage(info_.id);
+}
+
 const Tellico::Data::Image& ImageFactory::imageById(const QString& id_) {
   Q_ASSERT(factory && "ImageFactory is not initialized!");
   if(id_.isEmpty() || !factory || factory->d->nullImages.contains(id_)) {
@@ -468,7 +506,7 @@ bool ImageFactory::hasLocalImage(const QString& id_) {
                                      factory->d->dataImageDir.hasImage(id_));
 }
 
-void ImageFactory::requestImageById(const QString& id_) {
+void ImageFactory::requestImageById(const QString& id_, ImageJobScheduler::Priority priority_) {
   Q_ASSERT(factory && "ImageFactory is not initialized!");
   if(hasLocalImage(id_)) {
     emit factory->imageAvailable(id_);
@@ -484,7 +522,7 @@ void ImageFactory::requestImageById(const QString& id_) {
   const bool linkOnly = (s_imageInfoMap.contains(id_) && s_imageInfoMap[id_].linkOnly);
   if(linkOnly || !u.isRelative()) {
     if(u.isValid()) {
-      factory->requestImageByUrlImpl(u, true /* quiet */, QUrl() /* referrer */, linkOnly);
+      factory->requestImageByUrlImpl(u, priority_, QUrl() /* referrer */, linkOnly);
       if(!linkOnly) {
         myDebug() << "Loading an image url that is not link only. The image id will get updated.";
       }
@@ -492,12 +530,10 @@ void ImageFactory::requestImageById(const QString& id_) {
   }
 }
 
-void ImageFactory::requestImageByUrlImpl(const QUrl& url_, bool quiet_, const QUrl& refer_, bool link_) {
-  ImageJob* job = new ImageJob(url_, QString() /* id, use calculated one */, quiet_);
-  job->setLinkOnly(link_);
-  job->setReferrer(refer_);
-  connect(job, &ImageJob::result,
-          this, &ImageFactory::slotImageJobResult);
+void ImageFactory::requestImageByUrlImpl(const QUrl& url_, ImageJobScheduler::Priority priority_,
+                                         const QUrl& refer_, bool link_) {
+  // the scheduler merges multiple requests for the same url
+  d->jobScheduler->request(url_, priority_, link_, refer_);
 }
 
 Tellico::Data::ImageInfo ImageFactory::imageInfo(const QString& id_) {
@@ -712,6 +748,17 @@ void ImageFactory::setZipArchive(KZip* zip_) {
   factory->d->imageZipArchive.setZip(zip_);
 }
 
+void ImageFactory::setIngestPolicy(const ImageIngestPolicy& policy_) {
+  Q_ASSERT(factory && "ImageFactory is not initialized!");
+  factory->d->ingestPolicy = policy_;
+  factory->d->jobScheduler->setIngestPolicy(policy_);
+}
+
+const Tellico::ImageIngestPolicy& ImageFactory::ingestPolicy() {
+  Q_ASSERT(factory && "ImageFactory is not initialized!");
+  return factory->d->ingestPolicy;
+}
+
 void ImageFactory::slotImageJobResult(KJob* job_) {
   ImageJob* imageJob = qobject_cast<ImageJob*>(job_);
   Q_ASSERT(imageJob);
@@ -25,6 +25,8 @@
 #ifndef TELLICO_IMAGEFACTORY_H
 #define TELLICO_IMAGEFACTORY_H
 
+#include "imagejobscheduler.h"
+#include "imageingestpolicy.h"
 #include "../utils/stringset.h"
 
 #include <QUrl>
@@ -137,10 +139,13 @@ public:
    * Requests an image to be made available. Images already in the cache or available locally are
    * considered to be instantly available. Otherwise, the id is assumed to be a URL and is downloaded
    * The imageAvailable() signal is used to indicate completion and availability of the image.
+   * Downloads are queued by priority, and limited by the number of simultaneous jobs per host.
    *
    * @param id The image id
+   * @param priority The download priority, images shown in the views use the highest priority
    */
-  static void requestImageById(const QString& id);
+  static void requestImageById(const QString& id,
+                               ImageJobScheduler::Priority priority = ImageJobScheduler::NormalPriority);
   static Data::ImageInfo imageInfo(const QString& id);
   static void cacheImageInfo(const Data::ImageInfo& info);
   static bool hasImageInfo(const QString& id);
@@ -165,6 +170,32 @@ public:
   static QString localDirectory(const QUrl& url);
   static void setLocalDirectory(const QUrl& url);
   static void setZipArchive(KZip* zip);
+  /**
+   * Sets the policy for reducing new images, which are added from a URL or a QImage.
+   * Images loaded from a data file are never changed.
+   */
+  static void setIngestPolicy(const ImageIngestPolicy& policy);
+  static const ImageIngestPolicy& ingestPolicy();
+
+  /**
+   * Returns the image directory for a cache location, for writing images to it directly
+   */
+  static ImageDirectory* imageDirectory(CacheDir dir);
+  /**
+   * Returns the file name of an image which has already been written to one of the
+   * image directories, or an empty string if none has it. The file can be read in any thread.
+   */
+  static QString imageFileName(const QString& id);
+  /**
+   * Tells the factory that an image was written to a cache directory outside of
+   * writeCachedImage(). It no longer needs to be held in the dict, so it moves to the cache.
+   */
+  static void imageWritten(const QString& id);
+  /**
+   * Tells the factory that an image was extracted from the zip archive into the temp dir,
+   * so the archive no longer needs to keep it.
+   */
+  static void imagePreloaded(const Data::ImageInfo& info);
 
   static ImageFactory* self();
 
@@ -186,7 +217,7 @@ private:
    */
   const Data::Image& addImageImpl(const QUrl& url, bool quiet=false,
                                   const QUrl& referrer = QUrl(), bool linkOnly = false);
-  void requestImageByUrlImpl(const QUrl& url, bool quiet=false,
+  void requestImageByUrlImpl(const QUrl& url, ImageJobScheduler::Priority priority,
                              const QUrl& referrer = QUrl(), bool linkOnly = false);
   /**
    * Add an image, reading it from a regular QImage, which is the case when dragging and dropping
@@ -211,7 +242,6 @@ private:
   const Data::Image& addImageImpl(const QByteArray& data, const QString& format, const QString& id);
 
   const Data::Image& addCachedImageImpl(const QString& id, CacheDir dir);
-
   static ImageFactory* factory;
 
   static QHash<QString, Data::ImageInfo> s_imageInfoMap;
@@ -0,0 +1,214 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "imagehashindex.h"
+#include "imagefactory.h"
+#include "image.h"
+#include "../tellico_debug.h"
+
+#include <QtConcurrentMap>
+#include <QVector>
+#include <QSet>
+
+#include <algorithm>
+
+using Tellico::ImageHashIndex;
+
+ImageHashIndex::ImageHashIndex() {
+}
+
+quint64 ImageHashIndex::perceptualHash(const QImage& image_) {
+  if(image_.isNull()) {
+    return 0;
+  }
+  // each bit compares the brightness of two neighboring pixels in a 9x8 thumbnail
+  const QImage thumb = image_.scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                             .convertToFormat(QImage::Format_RGB32);
+  quint64 hash = 0;
+  for(int y = 0; y < 8; ++y) {
+    const QRgb* line = reinterpret_cast<const QRgb*>(thumb.constScanLine(y));
+    for(int x = 0; x < 8; ++x) {
+      hash <<= 1;
+      if(qGray(line[x]) > qGray(line[x+1])) {
+        hash |= 1;
+      }
+    }
+  }
+  return hash;
+}
+
+int ImageHashIndex::hashDistance(quint64 hash1_, quint64 hash2_) {
+  return qPopulationCount(hash1_ ^ hash2_);
+}
+
+void ImageHashIndex::addImage(const QString& id_, const QImage& image_) {
+  if(id_.isEmpty() || image_.isNull()) {
+    return;
+  }
+  m_images.append(hashImage(id_, image_));
+}
+
+void ImageHashIndex::addImages(const QStringList& ids_) {
+  QList<Source> sources;
+  foreach(const QString& id, ids_) {
+    Source source;
+    source.id = id;
+    // images already written to disk can be decoded in the worker
+    source.fileName = ImageFactory::imageFileName(id);
+    if(source.fileName.isEmpty()) {
+      const Data::Image& img = ImageFactory::imageById(id);
+      if(img.isNull()) {
+        continue;
+      }
+      // the QImage copy is implicitly shared, so it stays valid even if the cache deletes the image
+      source.image = img;
+    }
+    sources.append(source);
+  }
+
+  const QList<HashedImage> hashed = QtConcurrent::blockingMapped(sources, &ImageHashIndex::hashSource);
+  foreach(const HashedImage& img, hashed) {
+    if(!img.id.isEmpty()) {
+      m_images.append(img);
+    }
+  }
+}
+
+ImageHashIndex::HashedImage ImageHashIndex::hashSource(const Source& source_) {
+  if(source_.fileName.isEmpty()) {
+    return hashImage(source_.id, source_.image);
+  }
+  const QImage img(source_.fileName);
+  if(img.isNull()) {
+    myDebug() << "unable to read" << source_.fileName;
+    return HashedImage();
+  }
+  return hashImage(source_.id, img);
+}
+
+ImageHashIndex::HashedImage ImageHashIndex::hashImage(const QString& id_, const QImage& image_) {
+  HashedImage img;
+  img.id = id_;
+  img.hash = perceptualHash(image_);
+  img.width = image_.width();
+  img.height = image_.height();
+  return img;
+}
+
+bool ImageHashIndex::sameShape(const HashedImage& img1_, const HashedImage& img2_) {
+  // the hash ignores the aspect ratio, so require it to be within 10%
+  const qint64 a1 = qint64(img1_.width) * img2_.height;
+  const qint64 a2 = qint64(img2_.width) * img1_.height;
+  return 10 * qAbs(a1 - a2) <= qMax(a1, a2);
+}
+
+bool ImageHashIndex::keepBefore(const HashedImage& img1_, const HashedImage& img2_) {
+  // the larger image is kept, and the lowest id for a tie so the result is stable
+  const qint64 size1 = qint64(img1_.width) * img1_.height;
+  const qint64 size2 = qint64(img2_.width) * img2_.height;
+  return size1 > size2 || (size1 == size2 && img1_.id < img2_.id);
+}
+
+QHash<QString, QString> ImageHashIndex::duplicates(int maxDistance_) const {
+  QHash<QString, QString> replacements;
+  const int n = m_images.count();
+  if(n < 2) {
+    return replacements;
+  }
+  maxDistance_ = qBound(0, maxDistance_, 15);
+
+  // the images are sorted so the first one in each group is the one to keep
+  QList<HashedImage> images = m_images;
+  std::sort(images.begin(), images.end(), keepBefore);
+
+  // split the hash into one more block than the maximum distance. Two hashes within the distance
+  // must match exactly in at least one block, so only the images sharing a block get compared
+  QVector<QSet<int> > near(n);
+  const int blocks = maxDistance_ + 1;
+  const int blockBits = (64 + blocks - 1) / blocks;
+  const quint64 mask = blockBits < 64 ? (Q_UINT64_C(1) << blockBits) - 1 : ~Q_UINT64_C(0);
+  for(int b = 0; b < blocks && b*blockBits < 64; ++b) {
+    QHash<quint64, QVector<int> > buckets;
+    for(int i = 0; i < n; ++i) {
+      buckets[(images.at(i).hash >> (b*blockBits)) & mask].append(i);
+    }
+    foreach(const QVector<int>& bucket, buckets) {
+      for(int i = 0; i < bucket.count(); ++i) {
+        for(int j = i+1; j < bucket.count(); ++j) {
+          const int i1 = bucket.at(i);
+          const int i2 = bucket.at(j);
+          if(near.at(i1).contains(i2)) {
+            continue;
+          }
+          if(hashDistance(images.at(i1).hash, images.at(i2).hash) <= maxDistance_ &&
+             sameShape(images.at(i1), images.at(i2))) {
+            near[i1].insert(i2);
+            near[i2].insert(i1);
+          }
+        }
+      }
+    }
+  }
+
+  // every image in a group has to be within the distance of all the others, so a chain of
+  // similar images doesn't join two which are too far apart. Each image joins the earliest
+  // group it fits in
+  QVector<int> group(n, -1);
+  QVector<QVector<int> > groups;
+  for(int i = 0; i < n; ++i) {
+    QList<int> candidates;
+    foreach(int j, near.at(i)) {
+      if(group.at(j) > -1 && !candidates.contains(group.at(j))) {
+        candidates.append(group.at(j));
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    foreach(int g, candidates) {
+      bool fits = true;
+      foreach(int member, groups.at(g)) {
+        if(!near.at(i).contains(member)) {
+          fits = false;
+          break;
+        }
+      }
+      if(fits) {
+        group[i] = g;
+        groups[g].append(i);
+        break;
+      }
+    }
+    if(group.at(i) == -1) {
+      group[i] = groups.count();
+      groups.append(QVector<int>() << i);
+    }
+  }
+
+  foreach(const QVector<int>& members, groups) {
+    const QString& keptId = images.at(members.first()).id;
+    for(int i = 1; i < members.count(); ++i) {
+      replacements.insert(images.at(members.at(i)).id, keptId);
+    }
+  }
+  return replacements;
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_IMAGEHASHINDEX_H
+#define TELLICO_IMAGEHASHINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QImage>
+#include <QHash>
+#include <QList>
+
+namespace Tellico {
+
+/**
+ * The ImageHashIndex finds images which look the same, even though the files differ,
+ * such as the same cover saved at a different size or JPEG quality.
+ *
+ * Each image gets a 64-bit difference hash, computed from a 9x8 grayscale thumbnail, so
+ * rescaling and re-compressing an image only flips a few bits. Images within a small
+ * Hamming distance of each other and with the same aspect ratio are grouped together.
+ * Every image in a group is within the distance of every other one, so a chain of
+ * slightly different images never groups the two ends of it.
+ *
+ * @author agent
+ */
+class ImageHashIndex {
+public:
+  ImageHashIndex();
+
+  /**
+   * Returns the difference hash of an image, or 0 for a null image
+   */
+  static quint64 perceptualHash(const QImage& image);
+  /**
+   * Returns the number of bits which differ between two hashes
+   */
+  static int hashDistance(quint64 hash1, quint64 hash2);
+
+  void addImage(const QString& id, const QImage& image);
+  /**
+   * Adds a list of images from the image factory, decoding and hashing them in worker threads.
+   * Must be called from the GUI thread.
+   */
+  void addImages(const QStringList& ids);
+  int count() const { return m_images.count(); }
+
+  /**
+   * Groups the near-duplicate images. The image with the most pixels is kept from each group.
+   * An image close to more than one group joins the one with the largest image.
+   *
+   * @param maxDistance The maximum number of differing bits for two images to be duplicates
+   * @return A map from the id of each duplicate image to the id of the image to keep
+   */
+  QHash<QString, QString> duplicates(int maxDistance = 4) const;
+
+private:
+  struct HashedImage {
+    HashedImage() : hash(0), width(0), height(0) {}
+    QString id;
+    quint64 hash;
+    int width;
+    int height;
+  };
+  struct Source {
+    QString id;
+    QString fileName;
+    QImage image;
+  };
+
+  // runs in a worker thread, so nothing in here can touch the ImageFactory
+  static HashedImage hashSource(const Source& source);
+  static HashedImage hashImage(const QString& id, const QImage& image);
+  static bool sameShape(const HashedImage& img1, const HashedImage& img2);
+  static bool keepBefore(const HashedImage& img1, const HashedImage& img2);
+
+  QList<HashedImage> m_images;
+};
+
+} // end namespace
+
+#endif
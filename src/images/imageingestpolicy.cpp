@@ -0,0 +1,180 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "imageingestpolicy.h"
+#include "image.h"
+#include "../config/tellico_config.h"
+#include "../core/filehandler.h"
+#include "../utils/tellico_utils.h"
+#include "../tellico_debug.h"
+
+#include <QBuffer>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QUrl>
+#include <QDir>
+#include <QFile>
+
+using Tellico::ImageIngestPolicy;
+
+ImageIngestPolicy::ImageIngestPolicy() : m_maxSize(0), m_quality(-1) {
+}
+
+ImageIngestPolicy ImageIngestPolicy::fromConfig(int collectionType_, const QUrl& documentUrl_) {
+  ImageIngestPolicy policy;
+  policy.setMaxSize(Config::maxIngestImageSize(collectionType_));
+  policy.setFormat(Config::imageIngestFormat().toLatin1());
+  policy.setQuality(Config::imageIngestQuality());
+  if(Config::keepOriginalImages()) {
+    policy.setOriginalDirectory(documentOriginalDirectory(documentUrl_));
+  }
+  return policy;
+}
+
+QString ImageIngestPolicy::documentOriginalDirectory(const QUrl& documentUrl_) {
+  return Tellico::saveLocation(QStringLiteral("originals/")) + Tellico::documentKey(documentUrl_) + QLatin1Char('/');
+}
+
+void ImageIngestPolicy::moveOriginals(const QString& fromDir_, const QString& toDir_) {
+  QDir fromDir(fromDir_);
+  if(fromDir_ == toDir_ || !fromDir.exists()) {
+    return;
+  }
+  if(!QDir().mkpath(toDir_)) {
+    myDebug() << "unable to create directory for original images:" << toDir_;
+    return;
+  }
+  const QDir toDir(toDir_);
+  foreach(const QString& fileName, fromDir.entryList(QDir::Files)) {
+    // an original already kept for the other document is the same image
+    const QString target = toDir.filePath(fileName);
+    if(QFile::exists(target) || !QFile::rename(fromDir.filePath(fileName), target)) {
+      QFile::remove(fromDir.filePath(fileName));
+    }
+  }
+  fromDir.rmdir(fromDir.absolutePath());
+}
+
+void ImageIngestPolicy::pruneOriginals(const QString& dir_, const QSet<QString>& imageIds_) {
+  QDir dir(dir_);
+  if(!dir.exists()) {
+    return;
+  }
+  int count = 0;
+  foreach(const QString& fileName, dir.entryList(QDir::Files)) {
+    if(!imageIds_.contains(fileName) && dir.remove(fileName)) {
+      ++count;
+    }
+  }
+  if(count > 0) {
+    myLog() << "Removed" << count << "unused original images";
+  }
+  // nothing left to keep
+  dir.rmdir(dir.absolutePath());
+}
+
+bool ImageIngestPolicy::isActive() const {
+  return m_maxSize > 0 || !m_format.isEmpty();
+}
+
+void ImageIngestPolicy::setMaxSize(int size_) {
+  m_maxSize = qMax(0, size_);
+}
+
+void ImageIngestPolicy::setFormat(const QByteArray& format_) {
+  // Image::outputFormat() falls back to PNG for a format that can't be written
+  m_format = format_.isEmpty() ? QByteArray() : Data::Image::outputFormat(format_).toLower();
+}
+
+void ImageIngestPolicy::setQuality(int quality_) {
+  m_quality = qBound(-1, quality_, 100);
+}
+
+void ImageIngestPolicy::setOriginalDirectory(const QString& dir_) {
+  m_originalDir = dir_;
+  if(!m_originalDir.isEmpty() && !m_originalDir.endsWith(QLatin1Char('/'))) {
+    m_originalDir += QLatin1Char('/');
+  }
+}
+
+ImageIngestPolicy::Result ImageIngestPolicy::apply(const QByteArray& data_) const {
+  Result result;
+  if(!isActive() || data_.isEmpty()) {
+    return result;
+  }
+
+  QByteArray data = data_;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  QImageReader reader(&buffer);
+  const QByteArray inputFormat = reader.format().toLower();
+  const QSize size = reader.size();
+  const bool scale = m_maxSize > 0 && size.isValid() && (size.width() > m_maxSize || size.height() > m_maxSize);
+  const QByteArray outputFormat = m_format.isEmpty() ? inputFormat : m_format;
+  if(!scale && outputFormat == inputFormat) {
+    // nothing to do, keep the original bytes rather than re-compressing
+    return result;
+  }
+
+  if(scale) {
+    // most readers decode straight to the smaller size, JPEG in particular
+    reader.setScaledSize(size.scaled(m_maxSize, m_maxSize, Qt::KeepAspectRatio));
+  }
+  const QImage img = reader.read();
+  if(img.isNull()) {
+    myDebug() << "unable to read image:" << reader.errorString();
+    return result;
+  }
+
+  QBuffer outBuffer(&result.data);
+  outBuffer.open(QIODevice::WriteOnly);
+  QImageWriter writer(&outBuffer, outputFormat);
+  writer.setQuality(m_quality);
+  if(!writer.write(img)) {
+    myDebug() << "unable to write image:" << writer.errorString();
+    result.data.clear();
+    return result;
+  }
+  outBuffer.close();
+
+  result.changed = true;
+  result.format = outputFormat;
+  result.id = Data::Image::calculateID(result.data, QLatin1String(outputFormat));
+
+  // the directory is removed again whenever it's pruned down to nothing
+  if(!m_originalDir.isEmpty() &&
+     (!QDir().mkpath(m_originalDir) ||
+      !FileHandler::writeDataURL(QUrl::fromLocalFile(m_originalDir + result.id), data_,
+                                 true /* force */, true /* quiet */))) {
+    myDebug() << "unable to save original image for" << result.id;
+  }
+  return result;
+}
+
+QImage ImageIngestPolicy::scaleImage(const QImage& image_) const {
+  if(m_maxSize < 1 || (image_.width() <= m_maxSize && image_.height() <= m_maxSize)) {
+    return image_;
+  }
+  return image_.scaled(m_maxSize, m_maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
@@ -0,0 +1,122 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_IMAGEINGESTPOLICY_H
+#define TELLICO_IMAGEINGESTPOLICY_H
+
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+#include <QSet>
+
+class QUrl;
+
+namespace Tellico {
+
+/**
+ * The ImageIngestPolicy describes how new images are reduced before being added to a collection.
+ *
+ * Images larger than the maximum size are scaled down, keeping the aspect ratio, and saved
+ * in the target format with the target quality. Images which are already small enough and in
+ * the target format are left untouched, so they are never re-compressed. Optionally, the
+ * original data of a reduced image is saved in a separate directory, named with the id
+ * of the working copy. Each document has its own directory of originals, and any original
+ * whose working copy is no longer used is removed when the document is saved.
+ *
+ * @ref apply() only uses its own arguments, so it can run in a worker thread.
+ *
+ * @author agent
+ */
+class ImageIngestPolicy {
+public:
+  struct Result {
+    Result() : changed(false) {}
+    bool changed;
+    QByteArray data;
+    QByteArray format;
+    QString id;
+  };
+
+  ImageIngestPolicy();
+
+  /**
+   * Returns the configured policy for a collection type, keeping any originals in the directory
+   * for the document. Must be called from the GUI thread.
+   */
+  static ImageIngestPolicy fromConfig(int collectionType, const QUrl& documentUrl);
+  /**
+   * Returns the directory where the originals of the images in a document are kept
+   */
+  static QString documentOriginalDirectory(const QUrl& documentUrl);
+  /**
+   * Moves the originals kept for one document to the directory of another, for when
+   * a document is saved under a new name.
+   */
+  static void moveOriginals(const QString& fromDir, const QString& toDir);
+  /**
+   * Removes any original in the directory whose working copy is not in the list of image ids
+   */
+  static void pruneOriginals(const QString& dir, const QSet<QString>& imageIds);
+
+  /**
+   * Returns true if the policy can change any image
+   */
+  bool isActive() const;
+  int maxSize() const { return m_maxSize; }
+  void setMaxSize(int size);
+  const QByteArray& format() const { return m_format; }
+  /**
+   * Sets the format for reduced images, or an empty format to keep the original one.
+   * Formats which Qt can't write are ignored.
+   */
+  void setFormat(const QByteArray& format);
+  int quality() const { return m_quality; }
+  void setQuality(int quality);
+  const QString& originalDirectory() const { return m_originalDir; }
+  /**
+   * Sets the directory where the original data is saved for any reduced image,
+   * or an empty string to discard the original data
+   */
+  void setOriginalDirectory(const QString& dir);
+
+  /**
+   * Reduces the image data according to the policy. If nothing needs to be done, or the image
+   * can't be read, the returned result is unchanged, and the data should be used as is.
+   */
+  Result apply(const QByteArray& data) const;
+  /**
+   * Scales down an image which is larger than the maximum size
+   */
+  QImage scaleImage(const QImage& image) const;
+
+private:
+  int m_maxSize;
+  QByteArray m_format;
+  int m_quality;
+  QString m_originalDir;
+};
+
+} // end namespace
+
+#endif
@@ -27,7 +27,9 @@
 
 #include <KLocalizedString>
 
+#include <QtConcurrentRun>
 #include <QTimer>
+#include <QFile>
 #include <QFileInfo>
 #include <QBuffer>
 #include <QImageReader>
@@ -35,11 +37,14 @@
 using Tellico::ImageJob;
 
 ImageJob::ImageJob(const QUrl& url_, const QString& id_, bool quiet_) : KIO::Job()
-    , m_url(url_), m_id(id_), m_linkOnly(false), m_quiet(quiet_) {
+    , m_url(url_), m_id(id_), m_linkOnly(false), m_quiet(quiet_), m_ingestWatcher(nullptr) {
   QTimer::singleShot(0, this, &ImageJob::slotStart);
 }
 
 ImageJob::~ImageJob() {
+  if(m_ingestWatcher) {
+    m_ingestWatcher->waitForFinished();
+  }
 }
 
 QString ImageJob::errorString() const {
@@ -52,6 +57,10 @@ const Tellico::Data::Image& ImageJob::image() const {
   return m_image;
 }
 
+qint64 ImageJob::bufferedSize() const {
+  return m_getJob ? m_getJob->data().size() : m_data.size();
+}
+
 void ImageJob::setLinkOnly(bool linkOnly_) {
   m_linkOnly = linkOnly_;
 }
@@ -60,6 +69,10 @@ void ImageJob::setReferrer(const QUrl& referrer_) {
   m_referrer = referrer_;
 }
 
+void ImageJob::setIngestPolicy(const ImageIngestPolicy& policy_) {
+  m_policy = policy_;
+}
+
 void ImageJob::slotStart() {
   if(!m_url.isValid()) {
     setError(KIO::ERR_MALFORMED_URL);
@@ -69,6 +82,13 @@ void ImageJob::slotStart() {
     if(!QFileInfo(fileName).isReadable()) {
       setError(KIO::ERR_CANNOT_OPEN_FOR_READING);
       setErrorText(i18n("Tellico is unable to load the image - %1.", fileName));
+    } else if(m_id.isEmpty() && !m_linkOnly && m_policy.isActive()) {
+      QFile file(fileName);
+      if(file.open(QIODevice::ReadOnly) && startIngest(file.readAll())) {
+        return;
+      }
+      setError(KIO::ERR_CANNOT_OPEN_FOR_READING);
+      setErrorText(i18n("Tellico is unable to load the image - %1.", fileName));
     } else {
       m_image = Data::Image(fileName, m_id);
       if(m_image.isNull()) {
@@ -94,6 +114,7 @@ void ImageJob::slotStart() {
       getJob->addMetaData(QStringLiteral("referrer"), m_referrer.url());
     }
     addSubjob(getJob);
+    m_getJob = getJob;
     // don't emit result, it will be taken care of by the subjob handling
   }
 }
@@ -109,6 +130,9 @@ void ImageJob::getJobResult(KJob* job_) {
   // If we used the Image() c'tor that take a bytearray of data, I'm not sure how to
   // figure out the image format directly. Instead, write into a buffer and use QImageReader
   QByteArray data = getJob->data();
+  if(m_id.isEmpty() && !m_linkOnly && startIngest(data)) {
+    return;
+  }
   QBuffer buffer(&data);
   buffer.open(QIODevice::ReadOnly);
   m_image = Data::Image(data, QString::fromLatin1(QImageReader::imageFormat(&buffer)), m_id);
@@ -119,7 +143,8 @@ void ImageJob::getJobResult(KJob* job_) {
     // if we can't write the input format, then change to one we can
     m_image.setFormat(Data::Image::outputFormat(m_image.format()));
     if(m_id.isEmpty()) {
-      m_image.calculateID();
+      // hash the downloaded data, so the id doesn't depend on re-encoding the image
+      m_image.setID(Data::Image::calculateID(data, QLatin1String(m_image.format())));
     }
     if(m_linkOnly) {
       m_image.setLinkOnly(true);
@@ -128,3 +153,36 @@ void ImageJob::getJobResult(KJob* job_) {
   }
   emitResult();
 }
+
+bool ImageJob::startIngest(const QByteArray& data_) {
+  if(!m_policy.isActive() || data_.isEmpty()) {
+    return false;
+  }
+  // decoding and scaling a large image is slow, so keep it out of the GUI thread
+  m_ingestWatcher = new QFutureWatcher<ImageIngestPolicy::Result>(this);
+  connect(m_ingestWatcher, &QFutureWatcherBase::finished, this, &ImageJob::slotIngestFinished);
+  m_ingestWatcher->setFuture(QtConcurrent::run(m_policy, &ImageIngestPolicy::apply, data_));
+  m_getJob = nullptr;
+  m_data = data_;
+  return true;
+}
+
+void ImageJob::slotIngestFinished() {
+  const ImageIngestPolicy::Result result = m_ingestWatcher->result();
+  QByteArray data = result.changed ? result.data : m_data;
+  m_data.clear();
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  const QString format = QString::fromLatin1(QImageReader::imageFormat(&buffer));
+  m_image = Data::Image(data, format, result.changed ? result.id : QString());
+  if(m_image.isNull()) {
+    setError(KIO::ERR_UNKNOWN);
+    m_image = Data::Image::null;
+  } else {
+    m_image.setFormat(Data::Image::outputFormat(m_image.format()));
+    if(!result.changed) {
+      m_image.setID(Data::Image::calculateID(data, QLatin1String(m_image.format())));
+    }
+  }
+  emitResult();
+}
@@ -28,6 +28,10 @@
 #include <KIO/Job>
 
 #include "image.h"
+#include "imageingestpolicy.h"
+
+#include <QPointer>
+#include <QFutureWatcher>
 
 namespace Tellico {
 
@@ -45,21 +49,39 @@ public:
   QUrl url() const { return m_url; }
   bool linkOnly() const { return m_linkOnly; }
   const Data::Image& image() const;
+  /**
+   * Returns the number of bytes downloaded so far and held in memory
+   */
+  qint64 bufferedSize() const;
 
   void setLinkOnly(bool linkOnly);
   void setReferrer(const QUrl& referrer);
+  /**
+   * Sets the policy for reducing the image. The policy is only used for new images,
+   * when there is no id and the image is not link only.
+   */
+  void setIngestPolicy(const ImageIngestPolicy& policy);
 
 private Q_SLOTS:
   void slotStart();
   void getJobResult(KJob* job);
+  void slotIngestFinished();
 
 private:
+  // returns true if the image is being reduced in a worker thread
+  bool startIngest(const QByteArray& data);
+
   QUrl m_url;
   QString m_id;
   bool m_linkOnly;
   bool m_quiet;
   QUrl m_referrer;
   Data::Image m_image;
+  QPointer<KIO::StoredTransferJob> m_getJob;
+  ImageIngestPolicy m_policy;
+  // the original image data, held while the image is reduced
+  QByteArray m_data;
+  QFutureWatcher<ImageIngestPolicy::Result>* m_ingestWatcher;
 };
 
 } // end namespace
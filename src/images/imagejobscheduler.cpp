@@ -0,0 +1,171 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "imagejobscheduler.h"
+#include "imagejob.h"
+#include "../tellico_debug.h"
+
+#include <QTimer>
+
+namespace {
+  static const int IMAGE_MAX_JOBS = 8;
+  static const int IMAGE_MAX_JOBS_PER_HOST = 2;
+  static const qint64 IMAGE_MAX_BUFFER_SIZE = 32 * 1024 * 1024;
+}
+
+using Tellico::ImageJobScheduler;
+
+ImageJobScheduler::ImageJobScheduler(QObject* parent_) : QObject(parent_)
+    , m_maxJobs(IMAGE_MAX_JOBS)
+    , m_maxJobsPerHost(IMAGE_MAX_JOBS_PER_HOST)
+    , m_maxBufferSize(IMAGE_MAX_BUFFER_SIZE)
+    , m_startPending(false) {
+}
+
+ImageJobScheduler::~ImageJobScheduler() {
+  foreach(ImageJob* job, m_running) {
+    job->disconnect(this);
+    job->kill();
+  }
+}
+
+void ImageJobScheduler::setMaxJobs(int max_) {
+  m_maxJobs = qMax(1, max_);
+}
+
+void ImageJobScheduler::setMaxJobsPerHost(int max_) {
+  m_maxJobsPerHost = qMax(1, max_);
+}
+
+void ImageJobScheduler::setMaxBufferSize(qint64 bytes_) {
+  m_maxBufferSize = bytes_;
+}
+
+void ImageJobScheduler::setIngestPolicy(const ImageIngestPolicy& policy_) {
+  m_ingestPolicy = policy_;
+}
+
+void ImageJobScheduler::request(const QUrl& url_, Priority priority_, bool linkOnly_, const QUrl& referrer_) {
+  if(!url_.isValid() || m_running.contains(url_)) {
+    return;
+  }
+
+  Request request;
+  request.url = url_;
+  request.referrer = referrer_;
+  request.linkOnly = linkOnly_;
+  request.priority = priority_;
+
+  for(int i = 0; i < m_queue.count(); ++i) {
+    if(m_queue.at(i).url == url_) {
+      if(m_queue.at(i).priority >= priority_) {
+        return;
+      }
+      // move it up in the queue
+      request = m_queue.takeAt(i);
+      request.priority = priority_;
+      break;
+    }
+  }
+  enqueue(request);
+
+  // start the jobs after returning to the event loop, so a batch of requests gets sorted first
+  if(!m_startPending) {
+    m_startPending = true;
+    QTimer::singleShot(0, this, &ImageJobScheduler::slotStartJobs);
+  }
+}
+
+bool ImageJobScheduler::isPending(const QUrl& url_) const {
+  if(m_running.contains(url_)) {
+    return true;
+  }
+  foreach(const Request& request, m_queue) {
+    if(request.url == url_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ImageJobScheduler::enqueue(const Request& request_) {
+  // insert after every request with the same or higher priority
+  int i = 0;
+  while(i < m_queue.count() && m_queue.at(i).priority >= request_.priority) {
+    ++i;
+  }
+  m_queue.insert(i, request_);
+}
+
+qint64 ImageJobScheduler::bufferedSize() const {
+  qint64 size = 0;
+  foreach(ImageJob* job, m_running) {
+    size += job->bufferedSize();
+  }
+  return size;
+}
+
+void ImageJobScheduler::slotStartJobs() {
+  m_startPending = false;
+  int i = 0;
+  while(i < m_queue.count() && m_running.count() < m_maxJobs) {
+    if(bufferedSize() >= m_maxBufferSize) {
+      // wait for some of the running jobs to finish
+      break;
+    }
+    const QString host = m_queue.at(i).url.host();
+    if(m_hostJobCount.value(host) >= m_maxJobsPerHost) {
+      // try the next request, it may be for a different host
+      ++i;
+      continue;
+    }
+
+    const Request request = m_queue.takeAt(i);
+    ImageJob* job = new ImageJob(request.url, QString() /* id, use calculated one */, true /* quiet */);
+    job->setLinkOnly(request.linkOnly);
+    job->setReferrer(request.referrer);
+    job->setIngestPolicy(m_ingestPolicy);
+    connect(job, &KJob::result, this, &ImageJobScheduler::slotJobResult);
+    m_running.insert(request.url, job);
+    m_hostJobCount[host] += 1;
+  }
+}
+
+void ImageJobScheduler::slotJobResult(KJob* job_) {
+  ImageJob* imageJob = qobject_cast<ImageJob*>(job_);
+  Q_ASSERT(imageJob);
+  if(!imageJob) {
+    myWarning() << "No image job";
+    return;
+  }
+
+  m_running.remove(imageJob->url());
+  const QString host = imageJob->url().host();
+  if(--m_hostJobCount[host] < 1) {
+    m_hostJobCount.remove(host);
+  }
+
+  emit jobFinished(imageJob);
+  slotStartJobs();
+}
@@ -0,0 +1,117 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_IMAGEJOBSCHEDULER_H
+#define TELLICO_IMAGEJOBSCHEDULER_H
+
+#include "imageingestpolicy.h"
+
+#include <QObject>
+#include <QUrl>
+#include <QHash>
+#include <QList>
+
+class KJob;
+
+namespace Tellico {
+  class ImageJob;
+
+/**
+ * The ImageJobScheduler coordinates the asynchronous image downloads.
+ *
+ * Requests for the same url are merged, so only a single @ref ImageJob is ever running
+ * or queued for an image. Jobs are started in priority order, with a limit on the total
+ * number of running jobs and on the number of jobs for any one host. Keeping the per-host
+ * count low lets KIO reuse its idle workers for the host rather than opening new connections.
+ * No new job is started while the data already downloaded by the running jobs exceeds
+ * the buffer limit.
+ *
+ * @author agent
+ */
+class ImageJobScheduler : public QObject {
+Q_OBJECT
+
+public:
+  enum Priority {
+    LowPriority,
+    NormalPriority,
+    HighPriority // used for images in visible entries
+  };
+
+  explicit ImageJobScheduler(QObject* parent = nullptr);
+  ~ImageJobScheduler();
+
+  void setMaxJobs(int max);
+  void setMaxJobsPerHost(int max);
+  void setMaxBufferSize(qint64 bytes);
+  void setIngestPolicy(const ImageIngestPolicy& policy);
+
+  /**
+   * Requests an image download. If the url is already queued, the request is merged with the
+   * existing one, raising its priority if necessary. Nothing is done if the url is already
+   * being downloaded.
+   */
+  void request(const QUrl& url, Priority priority = NormalPriority,
+               bool linkOnly = false, const QUrl& referrer = QUrl());
+  bool isPending(const QUrl& url) const;
+  int queuedCount() const { return m_queue.count(); }
+  int runningCount() const { return m_running.count(); }
+
+Q_SIGNALS:
+  /**
+   * Emitted when an image job is finished, before it is deleted.
+   */
+  void jobFinished(KJob* job);
+
+private Q_SLOTS:
+  void slotJobResult(KJob* job);
+  void slotStartJobs();
+
+private:
+  Q_DISABLE_COPY(ImageJobScheduler)
+
+  struct Request {
+    QUrl url;
+    QUrl referrer;
+    bool linkOnly;
+    Priority priority;
+  };
+
+  void enqueue(const Request& request);
+  qint64 bufferedSize() const;
+
+  // sorted by priority, and in request order for the same priority
+  QList<Request> m_queue;
+  QHash<QUrl, ImageJob*> m_running;
+  QHash<QString, int> m_hostJobCount;
+  int m_maxJobs;
+  int m_maxJobsPerHost;
+  qint64 m_maxBufferSize;
+  bool m_startPending;
+  ImageIngestPolicy m_ingestPolicy;
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,163 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "imagepreloader.h"
+#include "imagefactory.h"
+#include "imageinfo.h"
+#include "../core/filehandler.h"
+#include "../tellico_debug.h"
+
+#include <KZip>
+
+#include <QtConcurrentRun>
+#include <QAtomicInt>
+#include <QImage>
+#include <QUrl>
+#include <QThread>
+
+using namespace Tellico;
+using Tellico::ImagePreloader;
+
+struct ImagePreloader::State {
+  QStringList ids;
+  QAtomicInt next;
+  QAtomicInt cancelled;
+  QString zipFileName;
+  QString imageDir;
+  ImagePreloader* preloader;
+};
+
+ImagePreloader::ImagePreloader(const QString& zipFileName_, QObject* parent_) : QObject(parent_)
+    , m_zipFileName(zipFileName_), m_runningWorkers(0), m_failures(0) {
+  m_pool.setMaxThreadCount(qMin(4, QThread::idealThreadCount()));
+}
+
+ImagePreloader::~ImagePreloader() {
+  cancel();
+}
+
+void ImagePreloader::setMaxThreadCount(int count_) {
+  m_pool.setMaxThreadCount(qMax(1, count_));
+}
+
+bool ImagePreloader::isRunning() const {
+  return m_runningWorkers > 0;
+}
+
+void ImagePreloader::load(const QStringList& ids_) {
+  // the preloader is only meant to be used once
+  Q_ASSERT(!m_state);
+  if(m_state) {
+    return;
+  }
+  m_state = QSharedPointer<State>(new State);
+  m_state->ids = ids_;
+  m_state->zipFileName = m_zipFileName;
+  // resolve the temp dir here, since the image factory can only be used in the GUI thread
+  m_state->imageDir = ImageFactory::tempDir();
+  m_state->preloader = this;
+
+  if(ids_.isEmpty()) {
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+    return;
+  }
+
+  m_runningWorkers = qMin(ids_.count(), m_pool.maxThreadCount());
+  for(int i = 0; i < m_runningWorkers; ++i) {
+    QtConcurrent::run(&m_pool, preloadImages, m_state);
+  }
+}
+
+void ImagePreloader::cancel() {
+  if(!m_state) {
+    return;
+  }
+  m_state->cancelled.storeRelease(1);
+  m_pool.waitForDone();
+  m_runningWorkers = 0;
+}
+
+void ImagePreloader::slotImageLoaded(const QString& id_, const QByteArray& format_, int width_, int height_) {
+  if(!m_state || m_state->cancelled.loadAcquire()) {
+    return;
+  }
+  ImageFactory::imagePreloaded(Data::ImageInfo(id_, format_, width_, height_, false));
+  emit imageLoaded(id_);
+}
+
+void ImagePreloader::slotImageFailed(const QString& id_) {
+  myDebug() << "unable to preload image:" << id_;
+  ++m_failures;
+}
+
+void ImagePreloader::slotWorkerDone() {
+  if(!m_state || m_state->cancelled.loadAcquire()) {
+    return;
+  }
+  if(--m_runningWorkers == 0) {
+    emit finished();
+  }
+}
+
+void ImagePreloader::preloadImages(QSharedPointer<State> state_) {
+  // each worker uses its own zip handle, KArchive is not thread-safe
+  KZip zip(state_->zipFileName);
+  const KArchiveDirectory* imgDir = nullptr;
+  if(zip.open(QIODevice::ReadOnly) && zip.directory()) {
+    const KArchiveEntry* dirEntry = zip.directory()->entry(QStringLiteral("images"));
+    if(dirEntry && dirEntry->isDirectory()) {
+      imgDir = static_cast<const KArchiveDirectory*>(dirEntry);
+    }
+  }
+
+  int i;
+  while(!state_->cancelled.loadAcquire() && (i = state_->next.fetchAndAddOrdered(1)) < state_->ids.count()) {
+    const QString& id = state_->ids.at(i);
+    const KArchiveEntry* file = imgDir ? imgDir->entry(id) : nullptr;
+    QByteArray data;
+    if(file && file->isFile()) {
+      data = static_cast<const KArchiveFile*>(file)->data();
+    }
+    // decode to verify the image, 1x1 images are considered null, same as Data::Image::isNull()
+    const QImage img = QImage::fromData(data);
+    if(img.isNull() || (img.width() < 2 && img.height() < 2)) {
+      QMetaObject::invokeMethod(state_->preloader, "slotImageFailed", Qt::QueuedConnection,
+                                Q_ARG(QString, id));
+      continue;
+    }
+    // the zip holds the same bytes the image directories use, so write them unchanged
+    if(!FileHandler::writeDataURL(QUrl::fromLocalFile(state_->imageDir + id), data,
+                                  true /* force */, true /* quiet */)) {
+      QMetaObject::invokeMethod(state_->preloader, "slotImageFailed", Qt::QueuedConnection,
+                                Q_ARG(QString, id));
+      continue;
+    }
+    QMetaObject::invokeMethod(state_->preloader, "slotImageLoaded", Qt::QueuedConnection,
+                              Q_ARG(QString, id),
+                              Q_ARG(QByteArray, id.section(QLatin1Char('.'), -1).toUpper().toLatin1()),
+                              Q_ARG(int, img.width()),
+                              Q_ARG(int, img.height()));
+  }
+  QMetaObject::invokeMethod(state_->preloader, "slotWorkerDone", Qt::QueuedConnection);
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_IMAGEPRELOADER_H
+#define TELLICO_IMAGEPRELOADER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+namespace Tellico {
+
+/**
+ * The ImagePreloader extracts images from a Tellico zip file in the background.
+ *
+ * Each worker thread opens its own handle to the zip file, so no archive state is shared
+ * between threads. The workers pull image ids from a common list, verify that each image can
+ * be decoded, and write the original bytes to the temporary image directory. Only the
+ * completion notifications are sent back to the GUI thread, where the image info is cached.
+ * Each worker holds a single image at a time, so memory use is bounded by the thread count.
+ *
+ * @author agent
+ */
+class ImagePreloader : public QObject {
+Q_OBJECT
+
+public:
+  /**
+   * @param zipFileName The local zip file containing the images
+   */
+  explicit ImagePreloader(const QString& zipFileName, QObject* parent = nullptr);
+  /**
+   * Cancels any loading and waits for the worker threads to finish
+   */
+  ~ImagePreloader();
+
+  /**
+   * Sets the maximum number of threads reading the zip file at once
+   */
+  void setMaxThreadCount(int count);
+  /**
+   * Starts loading the images in the background. The finished() signal is emitted
+   * once all images are done.
+   *
+   * @param ids The image ids to load
+   */
+  void load(const QStringList& ids);
+  /**
+   * Stops loading images and waits for the worker threads to finish any current image.
+   * The finished() signal is not emitted.
+   */
+  void cancel();
+  bool isRunning() const;
+  int failureCount() const { return m_failures; }
+
+Q_SIGNALS:
+  void imageLoaded(const QString& id);
+  void finished();
+
+private Q_SLOTS:
+  void slotImageLoaded(const QString& id, const QByteArray& format, int width, int height);
+  void slotImageFailed(const QString& id);
+  void slotWorkerDone();
+
+private:
+  Q_DISABLE_COPY(ImagePreloader)
+
+  struct State;
+  // runs in a worker thread, so nothing in here can touch the ImageFactory
+  static void preloadImages(QSharedPointer<State> state);
+
+  QString m_zipFileName;
+  QSharedPointer<State> m_state;
+  QThreadPool m_pool;
+  int m_runningWorkers;
+  int m_failures;
+};
+
+} // end namespace
+
+#endif
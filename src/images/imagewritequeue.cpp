@@ -0,0 +1,142 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "imagewritequeue.h"
+#include "image.h"
+#include "imagedirectory.h"
+#include "../core/filehandler.h"
+#include "../tellico_debug.h"
+
+#include <QtConcurrentRun>
+#include <QFile>
+#include <QUrl>
+#include <QThread>
+
+using Tellico::ImageWriteQueue;
+
+namespace {
+  // these all run outside the GUI thread, so they can't touch the ImageFactory
+  QByteArray encodeImage(const QImage& image_, const QByteArray& format_) {
+    return Tellico::Data::Image::byteArray(image_, format_);
+  }
+
+  QByteArray readImageFile(const QString& fileName_) {
+    QFile file(fileName_);
+    if(!file.open(QIODevice::ReadOnly)) {
+      myDebug() << "unable to read" << fileName_;
+      return QByteArray();
+    }
+    return file.readAll();
+  }
+
+  bool writeImageFile(QFuture<QByteArray> data_, const QString& fileName_) {
+    const QByteArray data = data_.result();
+    if(data.isEmpty()) {
+      return false;
+    }
+    // always local, and quiet so no message box is shown from a non-GUI thread
+    return Tellico::FileHandler::writeDataURL(QUrl::fromLocalFile(fileName_), data,
+                                              true /* force */, true /* quiet */);
+  }
+}
+
+ImageWriteQueue::ImageWriteQueue(ImageFactory::CacheDir dir_) : m_dir(ImageFactory::imageDirectory(dir_))
+    , m_isCacheDir(true) {
+  init();
+}
+
+ImageWriteQueue::ImageWriteQueue(ImageDirectory* dir_) : m_dir(dir_), m_isCacheDir(false) {
+  init();
+}
+
+ImageWriteQueue::~ImageWriteQueue() {
+  finish();
+}
+
+void ImageWriteQueue::init() {
+  Q_ASSERT(m_dir);
+  m_failures = 0;
+  // bound the number of encoded images held in memory at once
+  m_maxPending = qMax(4, 2*QThread::idealThreadCount());
+  m_writerPool.setMaxThreadCount(1);
+}
+
+bool ImageWriteQueue::enqueue(const QString& id_) {
+  if(id_.isEmpty() || !m_dir) {
+    return false;
+  }
+  // only write if it doesn't exist
+  if(m_dir->hasImage(id_)) {
+    if(m_isCacheDir) {
+      ImageFactory::imageWritten(id_);
+    }
+    return true;
+  }
+
+  while(m_pending.count() >= m_maxPending) {
+    completeOldest();
+  }
+
+  QFuture<QByteArray> data;
+  // if the image was already written somewhere else, the file can be copied without decoding
+  const QString sourceFile = ImageFactory::imageFileName(id_);
+  if(!sourceFile.isEmpty()) {
+    data = QtConcurrent::run(readImageFile, sourceFile);
+  } else {
+    const Data::Image& img = ImageFactory::imageById(id_);
+    if(img.isNull()) {
+      ++m_failures;
+      return false;
+    }
+    // the QImage copy is implicitly shared, so it stays valid even if the cache deletes the image
+    data = QtConcurrent::run(encodeImage, QImage(img), Data::Image::outputFormat(img.format()));
+  }
+
+  if(m_path.isEmpty()) {
+    m_path = m_dir->writePath();
+  }
+  PendingImage pending;
+  pending.id = id_;
+  pending.written = QtConcurrent::run(&m_writerPool, writeImageFile, data, m_path + id_);
+  m_pending.enqueue(pending);
+  return true;
+}
+
+void ImageWriteQueue::finish() {
+  while(!m_pending.isEmpty()) {
+    completeOldest();
+  }
+}
+
+void ImageWriteQueue::completeOldest() {
+  PendingImage pending = m_pending.dequeue();
+  if(pending.written.result()) {
+    if(m_isCacheDir) {
+      ImageFactory::imageWritten(pending.id);
+    }
+  } else {
+    myDebug() << "did not write image:" << pending.id;
+    ++m_failures;
+  }
+}
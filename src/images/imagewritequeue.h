@@ -0,0 +1,100 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_IMAGEWRITEQUEUE_H
+#define TELLICO_IMAGEWRITEQUEUE_H
+
+#include "imagefactory.h"
+
+#include <QString>
+#include <QQueue>
+#include <QFuture>
+#include <QThreadPool>
+
+namespace Tellico {
+  class ImageDirectory;
+
+/**
+ * The ImageWriteQueue writes a batch of images into an image directory.
+ *
+ * Images are read on the calling thread, since the ImageFactory is not thread-safe. Images
+ * which already exist as a file in another image directory are copied as-is, otherwise
+ * the image is encoded on the global thread pool. A single writer thread then writes the files
+ * in the same order as they were queued. The number of images in flight is bounded, so
+ * @ref enqueue() blocks when the pipeline is full.
+ *
+ * @author agent
+ */
+class ImageWriteQueue {
+public:
+  /**
+   * Writes images to one of the image factory cache directories
+   */
+  explicit ImageWriteQueue(ImageFactory::CacheDir dir);
+  /**
+   * Writes images to an arbitrary image directory, which must outlive the queue
+   */
+  explicit ImageWriteQueue(ImageDirectory* dir);
+  /**
+   * Waits for any pending images to be written
+   */
+  ~ImageWriteQueue();
+
+  /**
+   * Queues an image for writing. Nothing is done if the image already exists in the directory.
+   *
+   * @param id The image id
+   * @return false if the image could not be loaded
+   */
+  bool enqueue(const QString& id);
+  /**
+   * Waits until all queued images are written.
+   */
+  void finish();
+  int failureCount() const { return m_failures; }
+
+private:
+  Q_DISABLE_COPY(ImageWriteQueue)
+
+  struct PendingImage {
+    QString id;
+    QFuture<bool> written;
+  };
+
+  void init();
+  void completeOldest();
+
+  ImageDirectory* m_dir;
+  bool m_isCacheDir;
+  int m_maxPending;
+  int m_failures;
+  QString m_path;
+  QQueue<PendingImage> m_pending;
+  // the writer pool has a single thread so that files are written in order
+  QThreadPool m_writerPool;
+};
+
+} // end namespace
+
+#endif
@@ -26,6 +26,7 @@
 #include "mainwindow.h"
 #include "tellico_kernel.h"
 #include "document.h"
+#include "autosaver.h"
 #include "detailedlistview.h"
 #include "entryeditdialog.h"
 #include "groupview.h"
@@ -42,9 +43,12 @@
 #include "exportdialog.h"
 #include "core/filehandler.h" // needed so static mainWindow variable can be set
 #include "translators/htmlexporter.h" // for printing
+#include "translators/tellicojournal.h"
 #include "entryview.h"
 #include "entryiconview.h"
 #include "images/imagefactory.h" // needed so tmp files can get cleaned
+#include "images/imagehashindex.h"
+#include "images/imageingestpolicy.h"
 #include "collections/collectioninitializer.h"
 #include "collections/bibtexcollection.h" // needed for bibtex string macro dialog
 #include "utils/bibtexhandler.h" // needed for bibtex options
@@ -73,6 +77,7 @@
 #include "gui/dockwidget.h"
 #include "utils/cursorsaver.h"
 #include "utils/guiproxy.h"
+#include "utils/phasetimer.h"
 #include "tellico_debug.h"
 
 #include <KComboBox>
@@ -109,6 +114,9 @@
 #include <QMenuBar>
 #include <QFileDialog>
 #include <QMetaMethod>
+#include <QSet>
+#include <QDateTime>
+#include <QLocale>
 
 #include <unistd.h>
 
@@ -156,6 +164,7 @@ MainWindow::MainWindow(QWidget* parent_/*=0*/) : KXmlGuiWindow(parent_),
     m_bibtexKeyDlg(nullptr),
     m_fetchDlg(nullptr),
     m_reportDlg(nullptr),
+    m_autoSaver(nullptr),
     m_queuedFilters(0),
     m_initialized(false),
     m_newDocument(true),
@@ -218,6 +227,13 @@ void MainWindow::slotInit() {
 
   m_editDialog = new EntryEditDialog(this);
   Controller::self()->addObserver(m_editDialog);
+  Controller::self()->addObserver(Data::Document::self()->journal());
+
+  m_autoSaver = new AutoSaver(this);
+  connect(Kernel::self()->commandHistory(), &QUndoStack::indexChanged,
+          m_autoSaver, &AutoSaver::slotChanged);
+  connect(Data::Document::self(), &Data::Document::signalModified,
+          m_autoSaver, &AutoSaver::slotDocumentModified);
 
   m_toggleEntryEditor->setChecked(Config::showEditWidget());
   slotToggleEntryEditor();
@@ -319,6 +335,12 @@ void MainWindow::initActions() {
   m_fileSave->setToolTip(i18n("Save the document"));
   action = KStandardAction::saveAs(this, SLOT(slotFileSaveAs()), actionCollection());
   action->setToolTip(i18n("Save the document as a different file..."));
+  m_fileCompact = actionCollection()->addAction(QStringLiteral("file_compact"), this, SLOT(slotFileCompact()));
+  m_fileCompact->setText(i18n("&Compact File"));
+  m_fileCompact->setIcon(QIcon::fromTheme(QStringLiteral("document-save-all")));
+  m_fileCompact->setToolTip(i18n("Write the whole document to its file, folding in the saved changes"));
+  // only saving the changes leaves anything to compact
+  m_fileCompact->setEnabled(Config::journalSaving());
   action = KStandardAction::print(this, SLOT(slotFilePrint()), actionCollection());
   {
     KHTMLPart w;
@@ -591,6 +613,11 @@ void MainWindow::initActions() {
   action->setIcon(QIcon::fromTheme(QStringLiteral("text-rdf")));
   action->setToolTip(i18n("Generate collection reports"));
 
+  action = actionCollection()->addAction(QStringLiteral("coll_merge_images"), this, SLOT(slotMergeDuplicateImages()));
+  action->setText(i18n("&Merge Duplicate Images"));
+  action->setIcon(QIcon::fromTheme(QStringLiteral("edit-copy")));
+  action->setToolTip(i18n("Replace images which look the same with a single image"));
+
   action = actionCollection()->addAction(QStringLiteral("coll_convert_bibliography"), this, SLOT(slotConvertToBibliography()));
   action->setText(i18n("Convert to &Bibliography"));
   action->setIcon(QIcon(QLatin1String(":/icons/bibtex")));
@@ -671,6 +698,11 @@ void MainWindow::initActions() {
    *************************************************/
   KStandardAction::tipOfDay(this, SLOT(slotShowTipOfDay()), actionCollection());
 
+  action = actionCollection()->addAction(QStringLiteral("save_timing_trace"), this, SLOT(slotSaveTimingTrace()));
+  action->setText(i18n("Save &Timing Trace..."));
+  action->setIcon(QIcon::fromTheme(QStringLiteral("chronometer")));
+  action->setToolTip(i18n("Save the timing of recent load and save operations for analysis"));
+
   /*************************************************
    * Short cuts
    *************************************************/
@@ -773,6 +805,8 @@ void MainWindow::initView() {
                                        "for each entry.</qt>"));
   connect(Data::Document::self(), &Data::Document::signalCollectionImagesLoaded,
           m_detailedView, &DetailedListView::slotRefreshImages);
+  connect(m_detailedView, &DetailedListView::signalEntriesLoading,
+          this, &MainWindow::slotEntryCount);
 
   m_iconView = m_viewStack->iconView();
   EntryIconModel* iconModel = new EntryIconModel(m_iconView);
@@ -839,7 +873,13 @@ void MainWindow::initFileOpen(bool nofile_) {
   slotInit();
   // check to see if most recent file should be opened
   bool happyStart = false;
-  if(!nofile_ && Config::reopenLastFile()) {
+  // the autosave is only left behind if Tellico didn't close normally
+  // only the most recent one is offered, any others are kept for the next start
+  const QStringList recoveryFiles = AutoSaver::recoveryFiles();
+  if(!recoveryFiles.isEmpty()) {
+    happyStart = restoreAutoSave(recoveryFiles.first());
+  }
+  if(!happyStart && !nofile_ && Config::reopenLastFile()) {
     // Config::lastOpenFile() is the full URL, protocol included
     QUrl lastFile(Config::lastOpenFile()); // empty string is actually ok, it gets handled
     if(!lastFile.isEmpty() && lastFile.isValid()) {
@@ -967,6 +1007,8 @@ void MainWindow::readCollectionOptions(Tellico::Data::CollPtr coll_) {
   }
   m_entryView->setXSLTFile(entryXSLTFile + QLatin1String(".xsl"));
 
+  ImageFactory::setIngestPolicy(ImageIngestPolicy::fromConfig(coll_->type(), Data::Document::self()->URL()));
+
   // make sure the right combo element is selected
   slotUpdateCollectionToolBar(coll_);
 }
@@ -1070,6 +1112,36 @@ bool MainWindow::querySaveModified() {
   return completed;
 }
 
+bool MainWindow::restoreAutoSave(const QString& fileName_) {
+  QUrl url;
+  QDateTime time;
+  int format;
+  Data::CollPtr coll = AutoSaver::readRecovery(fileName_, &url, &time, &format);
+  if(!coll) {
+    AutoSaver::removeRecovery(fileName_);
+    return false;
+  }
+
+  QString str = i18n("Tellico did not close normally, but the unsaved changes to %1 were saved "
+                     "at %2.\nDo you want to restore them?",
+                     url.fileName(), QLocale().toString(time, QLocale::ShortFormat));
+  int want_restore = KMessageBox::questionYesNo(this, str, i18n("Restore Unsaved Changes"),
+                                                KGuiItem(i18n("Restore")), KStandardGuiItem::discard());
+  if(want_restore != KMessageBox::Yes) {
+    AutoSaver::removeRecovery(fileName_);
+    return false;
+  }
+
+  // the recovery file is kept until the restored document is saved or discarded
+  Kernel::self()->resetHistory();
+  Data::Document::self()->restoreDocument(coll, url, format);
+  m_autoSaver->lockRecovery(fileName_);
+  slotEnableOpenedActions();
+  m_newDocument = url.fileName() == i18n(Tellico::untitledFilename);
+  slotEnableModifiedActions(true);
+  return true;
+}
+
 bool MainWindow::queryClose() {
   // in case we're still loading the images, cancel that
   Data::Document::self()->cancelImageWriting();
@@ -1283,6 +1355,24 @@ void MainWindow::slotFileSaveAs() {
   fileSaveAs();
 }
 
+void MainWindow::slotFileCompact() {
+  if(isNewDocument() || !m_editDialog->queryModified()) {
+    return;
+  }
+  slotStatusMsg(i18n("Saving file..."));
+
+  GUI::CursorSaver cs(Qt::WaitCursor);
+  // any unsaved changes are written along with the rest of the file
+  if(Data::Document::self()->compactDocument()) {
+    Kernel::self()->resetHistory();
+    updateCaption(false);
+    m_fileSave->setEnabled(false);
+    m_detailedView->resetEntryStatus();
+  }
+
+  StatusBar::self()->clearStatus();
+}
+
 bool MainWindow::fileSaveAs() {
   if(!m_editDialog->queryModified()) {
     return false;
@@ -1467,6 +1557,19 @@ void MainWindow::slotShowTipOfDay(bool force_/*=true*/) {
   KTipDialog::showTip(this, QStringLiteral("tellico/tellico.tips"), force_);
 }
 
+void MainWindow::slotSaveTimingTrace() {
+  // the trace event format can be opened in chrome://tracing or https://ui.perfetto.dev
+  const QString filter = i18n("Trace Files") + QLatin1String(" (*.json)");
+  const QString fileName = QFileDialog::getSaveFileName(this, i18n("Save Timing Trace"),
+                                                        QStringLiteral("tellico-trace.json"), filter);
+  if(fileName.isEmpty()) {
+    return;
+  }
+  if(!PhaseLog::self()->writeChromeTrace(fileName)) {
+    KMessageBox::sorry(this, i18n(errorWrite, fileName));
+  }
+}
+
 void MainWindow::slotStatusMsg(const QString& text_) {
   m_statusBar->setStatus(text_);
 }
@@ -1482,6 +1585,11 @@ void MainWindow::slotEntryCount() {
   }
 
   int count = coll->entryCount();
+  // a large collection is still being added to the views
+  if(m_detailedView->isLoading()) {
+    m_statusBar->setCount(i18n("Loading entries: %1 of %2", m_detailedView->loadedCount(), count));
+    return;
+  }
   QString text = i18n("Total entries: %1", count);
 
   int selectCount = Controller::self()->selectedEntries().count();
@@ -1527,6 +1635,10 @@ void MainWindow::slotHandleConfigChange() {
   const QStringList prefixes = Config::surnamePrefixList();
 
   m_configDlg->saveConfiguration();
+  if(m_autoSaver) {
+    m_autoSaver->readConfig();
+  }
+  m_fileCompact->setEnabled(Config::journalSaving());
 
   // only modified if there are entries and image location is changed
   if(imageLocation != Config::imageLocation() && !Data::Document::self()->isEmpty()) {
@@ -1547,6 +1659,8 @@ void MainWindow::slotHandleConfigChange() {
 
   QString entryXSLTFile = Config::templateName(Kernel::self()->collectionType());
   m_entryView->setXSLTFile(entryXSLTFile + QLatin1String(".xsl"));
+
+  ImageFactory::setIngestPolicy(ImageIngestPolicy::fromConfig(Kernel::self()->collectionType(), Data::Document::self()->URL()));
 }
 
 void MainWindow::slotUpdateCollectionToolBar(Tellico::Data::CollPtr coll_) {
@@ -1973,6 +2087,63 @@ void MainWindow::slotConvertToBibliography() {
   }
 }
 
+void MainWindow::slotMergeDuplicateImages() {
+  Data::CollPtr coll = Data::Document::self()->collection();
+  if(!coll || !coll->hasImages()) {
+    return;
+  }
+
+  GUI::CursorSaver cs;
+  StatusBar::self()->setStatus(i18n("Checking for duplicate images..."));
+
+  QStringList fieldNames;
+  foreach(Data::FieldPtr field, coll->imageFields()) {
+    fieldNames << field->name();
+  }
+  QSet<QString> ids;
+  foreach(Data::EntryPtr entry, coll->entries()) {
+    foreach(const QString& fieldName, fieldNames) {
+      const QString id = entry->field(fieldName);
+      // linked images are not stored, so there's nothing to gain from merging them
+      if(!id.isEmpty() && QUrl(id).isRelative()) {
+        ids.insert(id);
+      }
+    }
+  }
+
+  ImageHashIndex index;
+  index.addImages(ids.values());
+  const QHash<QString, QString> duplicates = index.duplicates();
+  StatusBar::self()->clearStatus();
+  if(duplicates.isEmpty()) {
+    KMessageBox::information(this, i18n("No duplicate images were found."));
+    return;
+  }
+
+  // modify the entries as a single command, so the merge can be undone
+  Data::EntryList oldEntries, newEntries;
+  foreach(Data::EntryPtr entry, coll->entries()) {
+    Data::EntryPtr oldEntry;
+    foreach(const QString& fieldName, fieldNames) {
+      const QString id = entry->field(fieldName);
+      if(!duplicates.contains(id)) {
+        continue;
+      }
+      if(!oldEntry) {
+        oldEntry = Data::EntryPtr(new Data::Entry(*entry));
+      }
+      entry->setField(fieldName, duplicates.value(id));
+    }
+    if(oldEntry) {
+      oldEntries << oldEntry;
+      newEntries << entry;
+    }
+  }
+  Kernel::self()->modifyEntries(oldEntries, newEntries, fieldNames);
+  StatusBar::self()->setStatus(i18np("1 duplicate image was merged.",
+                                     "%1 duplicate images were merged.", duplicates.count()));
+}
+
 void MainWindow::slotCiteEntry(int action_) {
   StatusBar::self()->setStatus(i18n("Creating citations..."));
   Cite::ActionManager* man = Cite::ActionManager::self();
@@ -72,6 +72,7 @@ namespace Tellico {
   class EntryItem;
   class FetchDialog;
   class ReportDialog;
+  class AutoSaver;
   class StatusBar;
   class DropHandler;
 
@@ -174,6 +175,10 @@ public Q_SLOTS:
    * Saves a document by a new filename
    */
   void slotFileSaveAs();
+  /**
+   * Writes the whole document to its file, folding in the journal of saved changes
+   */
+  void slotFileCompact();
   /**
    * Prints the current document.
    */
@@ -279,6 +284,10 @@ public Q_SLOTS:
    * @param force Whether the configuration setting should be ignored
    */
   void slotShowTipOfDay(bool force=true);
+  /**
+   * Saves the timing of the most recent load and save operations as a trace file.
+   */
+  void slotSaveTimingTrace();
   /**
    * Shows the string macro editor dialog for the application.
    */
@@ -329,6 +338,12 @@ private:
   void initConnections();
 
   bool querySaveModified();
+  /**
+   * Offers to restore the changes from the autosave left behind when Tellico didn't close normally.
+   *
+   * @return Whether the document was restored
+   */
+  bool restoreAutoSave(const QString& fileName);
 
   /**
    * Called before the window is closed, either by the user or indirectly by the
@@ -425,6 +440,10 @@ private Q_SLOTS:
    * Convert current collection to a bibliography.
    */
   void slotConvertToBibliography();
+  /**
+   * Replace near-duplicate images in the current collection with a single image.
+   */
+  void slotMergeDuplicateImages();
   /**
    * Send a citation for the selected entries
    */
@@ -471,6 +490,7 @@ private:
   // is because they get plugged into menus later in Controller
   KRecentFilesAction* m_fileOpenRecent;
   QAction* m_fileSave;
+  QAction* m_fileCompact;
   QAction* m_newEntry;
   QAction* m_editEntry;
   QAction* m_copyEntry;
@@ -510,6 +530,7 @@ private:
   BibtexKeyDialog* m_bibtexKeyDlg;
   FetchDialog* m_fetchDlg;
   ReportDialog* m_reportDlg;
+  AutoSaver* m_autoSaver;
 
   QList<QAction*> m_fetchActions;
 
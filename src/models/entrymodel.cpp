@@ -390,7 +390,8 @@ QVariant EntryModel::requestImage(Data::EntryPtr entry_, const QString& id_) con
     }
   } else if(!m_requestedImages.contains(id_, entry_)) {
     m_requestedImages.insert(id_, entry_);
-    ImageFactory::requestImageById(id_);
+    // the model only gets asked for data of visible entries
+    ImageFactory::requestImageById(id_, ImageJobScheduler::HighPriority);
   }
   return QVariant();
 }
@@ -31,9 +31,15 @@
 #include "../fieldformat.h"
 
 #include <QTest>
+#include <QStandardPaths>
 
 QTEST_APPLESS_MAIN( AudioFileTest )
 
+void AudioFileTest::initTestCase() {
+  // the importer keeps a record of the scanned files in the data directory
+  QStandardPaths::setTestModeEnabled(true);
+}
+
 void AudioFileTest::testDirectory() {
   QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("data/test.ogg"));
   url = url.adjusted(QUrl::RemoveFilename);
@@ -79,3 +85,39 @@ void AudioFileTest::testOgg() {
   QCOMPARE(entry->field("year"), QStringLiteral("2020"));
   QCOMPARE(entry->field("genre"), QStringLiteral("The Genre"));
 }
+
+void AudioFileTest::testSkipUnchanged() {
+  QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("data/test.ogg"));
+  url = url.adjusted(QUrl::RemoveFilename);
+  QVERIFY(!url.isEmpty());
+
+  Tellico::Import::AudioFileImporter importer(url);
+  importer.setOptions(importer.options() ^ Tellico::Import::ImportProgress);
+  importer.setRecursive(true);
+  importer.setAddFilePath(true);
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+  QCOMPARE(coll->entryCount(), 1);
+
+  // nothing changed, so scanning again finds nothing new
+  Tellico::Import::AudioFileImporter importer2(url);
+  importer2.setOptions(importer2.options() ^ Tellico::Import::ImportProgress);
+  importer2.setRecursive(true);
+  importer2.setAddFilePath(true);
+  importer2.setSkipUnchanged(true);
+  importer2.setCurrentCollection(coll);
+  Tellico::Data::CollPtr coll2 = importer2.collection();
+  QVERIFY(coll2);
+  QCOMPARE(coll2->entryCount(), 0);
+
+  // files which are not in the current collection are always read
+  Tellico::Import::AudioFileImporter importer3(url);
+  importer3.setOptions(importer3.options() ^ Tellico::Import::ImportProgress);
+  importer3.setRecursive(true);
+  importer3.setAddFilePath(true);
+  importer3.setSkipUnchanged(true);
+  importer3.setCurrentCollection(Tellico::Data::CollPtr(new Tellico::Data::MusicCollection(true)));
+  Tellico::Data::CollPtr coll3 = importer3.collection();
+  QVERIFY(coll3);
+  QCOMPARE(coll3->entryCount(), 1);
+}
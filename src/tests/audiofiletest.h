@@ -31,8 +31,10 @@ class AudioFileTest : public QObject {
 Q_OBJECT
 
 private Q_SLOTS:
+  void initTestCase();
   void testDirectory();
   void testOgg();
+  void testSkipUnchanged();
 };
 
 #endif
@@ -140,3 +140,39 @@ void BibtexTest::testMapping() {
   QCOMPARE(Tellico::BibtexHandler::exportText(QString::fromUtf8("…"), QStringList()), QStringLiteral("{{\\ldots}}"));
   QCOMPARE(Tellico::BibtexHandler::exportText(QString::fromUtf8("°"), QStringList()), QStringLiteral("{$^{\\circ}$}"));
 }
+
+void BibtexTest::testImportBenchmark() {
+  QFETCH(int, count);
+
+  QString text;
+  text.reserve(count * 300);
+  text += QL1("@string{jacm = \"Journal of the ACM\"}\n\n");
+  for(int i = 0; i < count; ++i) {
+    text += QStringLiteral("@article{key%1,\n"
+                           "  author = {Author, First and M{\\\"u}ller, Second %2},\n"
+                           "  title = {Title {NUMBER} %1},\n"
+                           "  journal = jacm,\n"
+                           "  year = %3,\n"
+                           "  pages = {1--%2}\n"
+                           "}\n\n").arg(i).arg(i % 100).arg(1900 + i % 120);
+  }
+
+  QBENCHMARK {
+    Tellico::Import::BibtexImporter importer(text);
+    importer.setOptions(importer.options() ^ Tellico::Import::ImportProgress);
+    importer.setCurrentCollection(Tellico::Data::CollPtr(new Tellico::Data::BibtexCollection(true)));
+    Tellico::Data::CollPtr coll = importer.collection();
+    QVERIFY(coll);
+    QCOMPARE(coll->entryCount(), count);
+  }
+}
+
+void BibtexTest::testImportBenchmark_data() {
+  QTest::addColumn<int>("count");
+
+  QTest::newRow("10k") << 10000;
+  // the larger files take a while, only run them when asked to
+  if(!qEnvironmentVariableIsEmpty("TELLICO_LARGE_BENCHMARK")) {
+    QTest::newRow("100k") << 100000;
+  }
+}
@@ -35,6 +35,8 @@ private Q_SLOTS:
   void testImport();
   void testDuplicateKeys();
   void testMapping();
+  void testImportBenchmark();
+  void testImportBenchmark_data();
 };
 
 #endif
@@ -28,6 +28,8 @@
 #include "../translators/csvexporter.h"
 
 #include <QTest>
+#include <QBuffer>
+#include <QTextCodec>
 
 QTEST_MAIN( CsvTest )
 
@@ -70,6 +72,67 @@ void CsvTest::testAll_data() {
     << (QStringList() << QL1("robby") << QL1("stephenson\n,is,cool"));
 }
 
+void CsvTest::testDevice() {
+  // starts with a UTF-8 byte order mark, and the last row has no line end
+  QByteArray data("\xEF\xBB\xBFtitle,author\n"
+                  "\"robby,\nstephenson\",\xC3\xA9l\xC3\xA8ve\n"
+                  "\n"
+                  "last,row");
+  QBuffer buffer(&data);
+  QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+  Tellico::CSVParser p(QString());
+  p.setDelimiter(QStringLiteral(","));
+  p.reset(&buffer);
+  QVERIFY(p.hasNext());
+  // skipLine() skips a whole row when reading a device
+  p.skipLine();
+  QCOMPARE(p.nextTokens(), QStringList() << QL1("robby,\nstephenson") << QString::fromUtf8("\xC3\xA9l\xC3\xA8ve"));
+  QCOMPARE(p.nextTokens(), QStringList() << QL1("last") << QL1("row"));
+  QVERIFY(!p.hasNext());
+
+  // reading the device again starts over
+  p.reset(&buffer);
+  QCOMPARE(p.nextTokens(), QStringList() << QL1("title") << QL1("author"));
+
+  // other encodings get converted
+  QByteArray latin1("caf\xE9;cr\xE8me\n");
+  QBuffer buffer2(&latin1);
+  QVERIFY(buffer2.open(QIODevice::ReadOnly));
+  p.setDelimiter(QStringLiteral(";"));
+  p.reset(&buffer2, QTextCodec::codecForName("ISO-8859-1"));
+  QCOMPARE(p.nextTokens(), QStringList() << QString::fromUtf8("caf\xC3\xA9") << QString::fromUtf8("cr\xC3\xA8me"));
+  QVERIFY(!p.hasNext() || p.nextTokens().isEmpty());
+}
+
+void CsvTest::testDeviceChunks() {
+  // enough rows that the data is read in several chunks, with rows and values split across them
+  QByteArray data;
+  const int rowCount = 20000;
+  for(int i = 0; i < rowCount; ++i) {
+    data += "row " + QByteArray::number(i) + ",\"quoted, value\nwith \xC3\xA9 line\"," + QByteArray::number(i * 2) + "\n";
+  }
+  QBuffer buffer(&data);
+  QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+  Tellico::CSVParser p(QString());
+  p.setDelimiter(QStringLiteral(","));
+  p.reset(&buffer);
+  int count = 0;
+  while(p.hasNext()) {
+    const QStringList tokens = p.nextTokens();
+    if(tokens.isEmpty()) {
+      continue;
+    }
+    QCOMPARE(tokens.count(), 3);
+    QCOMPARE(tokens.at(0), QL1("row ") + QString::number(count));
+    QCOMPARE(tokens.at(1), QString::fromUtf8("quoted, value\nwith \xC3\xA9 line"));
+    QCOMPARE(tokens.at(2).toInt(), count * 2);
+    ++count;
+  }
+  QCOMPARE(count, rowCount);
+}
+
 void CsvTest::testEntry() {
   Tellico::Data::CollPtr coll(new Tellico::Data::Collection(true));
   Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
@@ -36,6 +36,8 @@ private Q_SLOTS:
 
   void testAll();
   void testAll_data();
+  void testDevice();
+  void testDeviceChunks();
   void testEntry();
 };
 
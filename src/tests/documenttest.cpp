@@ -31,13 +31,21 @@
 #include "../config/tellico_config.h"
 #include "../collections/bookcollection.h"
 #include "../collectionfactory.h"
+#include "../translators/tellicosnapshot.h"
+#include "../translators/tellicojournal.h"
+#include "../entry.h"
+#include "../field.h"
+#include "../filter.h"
 
 #include <QTest>
 #include <QTemporaryDir>
 #include <QFile>
+#include <QtConcurrentRun>
 
 QTEST_GUILESS_MAIN( DocumentTest )
 
+#define QSL(x) QStringLiteral(x)
+
 void DocumentTest::initTestCase() {
   Tellico::ImageFactory::init();
   // test case is a book file
@@ -139,3 +147,210 @@ void DocumentTest::testImageLocalDirectory() {
   tempDir.remove();
   QVERIFY(!QDir(tempDirName).exists());
 }
+
+void DocumentTest::testSnapshot() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  const QString fileName = tempDir.path() + "/tabletest.tc";
+  QVERIFY(QFile::copy(QFINDTESTDATA("data/tabletest.tc"), fileName));
+  const QUrl url = QUrl::fromLocalFile(fileName);
+  Tellico::TellicoSnapshot::remove(url);
+
+  // opening the document writes the snapshot
+  Tellico::Data::Document* doc = Tellico::Data::Document::self();
+  QVERIFY(doc->openDocument(url));
+  // in a worker thread
+  QTRY_VERIFY(QFile::exists(Tellico::TellicoSnapshot::snapshotFileName(url)));
+  Tellico::Data::CollPtr coll = doc->collection();
+  QVERIFY(coll);
+
+  Tellico::Import::TellicoImporter::Format format = Tellico::Import::TellicoImporter::Unknown;
+  Tellico::Data::CollPtr coll2 = Tellico::TellicoSnapshot::read(url, &format);
+  QVERIFY(coll2);
+  QCOMPARE(int(format), int(Tellico::Import::TellicoImporter::XML));
+  QCOMPARE(coll2->type(), coll->type());
+  QCOMPARE(coll2->title(), coll->title());
+  QCOMPARE(coll2->fields().count(), coll->fields().count());
+  QCOMPARE(coll2->entryCount(), coll->entryCount());
+  foreach(Tellico::Data::FieldPtr f1, coll->fields()) {
+    Tellico::Data::FieldPtr f2 = coll2->fieldByName(f1->name());
+    QVERIFY(f2);
+    QCOMPARE(f2->title(), f1->title());
+    QCOMPARE(int(f2->type()), int(f1->type()));
+    QCOMPARE(f2->flags(), f1->flags());
+    QCOMPARE(f2->propertyList(), f1->propertyList());
+  }
+  foreach(Tellico::Data::EntryPtr e1, coll->entries()) {
+    Tellico::Data::EntryPtr e2 = coll2->entryById(e1->id());
+    QVERIFY(e2);
+    foreach(Tellico::Data::FieldPtr f, coll->fields()) {
+      QCOMPARE(f->name() + e2->field(f->name()), f->name() + e1->field(f));
+    }
+  }
+
+  // reopening uses the snapshot
+  QVERIFY(doc->openDocument(url));
+  QCOMPARE(doc->collection()->entryCount(), coll->entryCount());
+  QVERIFY(!doc->isModified());
+
+  // any change to the file invalidates the snapshot
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::Append));
+  file.write("\n");
+  file.close();
+  QVERIFY(!Tellico::TellicoSnapshot::read(url));
+
+  Tellico::TellicoSnapshot::remove(url);
+  QVERIFY(!QFile::exists(Tellico::TellicoSnapshot::snapshotFileName(url)));
+
+  // no snapshot at all when turned off
+  Tellico::Config::setDocumentSnapshots(false);
+  QVERIFY(doc->openDocument(url));
+  QVERIFY(!QFile::exists(Tellico::TellicoSnapshot::snapshotFileName(url)));
+  Tellico::Config::setDocumentSnapshots(true);
+}
+
+void DocumentTest::testJournal() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  const QString fileName = tempDir.path() + "/tabletest.tc";
+  QVERIFY(QFile::copy(QFINDTESTDATA("data/tabletest.tc"), fileName));
+  const QUrl url = QUrl::fromLocalFile(fileName);
+  Tellico::TellicoSnapshot::remove(url);
+  Tellico::Config::setJournalSaving(true);
+
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray original = file.readAll();
+  file.close();
+
+  Tellico::Data::Document* doc = Tellico::Data::Document::self();
+  Tellico::TellicoJournal* journal = doc->journal();
+  QVERIFY(journal);
+  QVERIFY(doc->openDocument(url));
+  Tellico::Data::CollPtr coll = doc->collection();
+  QVERIFY(coll);
+  QCOMPARE(coll->entryCount(), 3);
+
+  // there's no controller in the test, so pass the changes to the journal directly
+  Tellico::Data::EntryPtr entry1 = coll->entries().at(0);
+  entry1->setField(QSL("title"), QSL("Journal Title"));
+  journal->modifyEntries(Tellico::Data::EntryList() << entry1);
+
+  Tellico::Data::EntryPtr entry2 = coll->entries().at(2);
+  const Tellico::Data::ID removedId = entry2->id();
+  coll->removeEntries(Tellico::Data::EntryList() << entry2);
+  journal->removeEntries(Tellico::Data::EntryList() << entry2);
+
+  Tellico::Data::FieldPtr field(new Tellico::Data::Field(QSL("journal"), QSL("Journal"), Tellico::Data::Field::Line));
+  coll->addField(field);
+  journal->addField(coll, field);
+
+  Tellico::Data::EntryPtr entry3(new Tellico::Data::Entry(coll));
+  entry3->setField(QSL("title"), QSL("New Entry"));
+  entry3->setField(QSL("journal"), QSL("value"));
+  coll->addEntries(entry3);
+  journal->addEntries(Tellico::Data::EntryList() << entry3);
+
+  Tellico::FilterPtr filter(new Tellico::Filter(Tellico::Filter::MatchAny));
+  filter->setName(QSL("Journal Filter"));
+  filter->append(new Tellico::FilterRule(QSL("title"), QSL("Journal"), Tellico::FilterRule::FuncContains));
+  coll->addFilter(filter);
+  journal->addFilter(filter);
+
+  coll->setTitle(QSL("Journal Collection"));
+
+  // saving only writes the journal, the file is untouched
+  QVERIFY(doc->saveDocument(url));
+  QVERIFY(!doc->isModified());
+  QVERIFY(QFile::exists(Tellico::TellicoJournal::journalFileName(url)));
+  QVERIFY(journal->size() > 0);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QCOMPARE(file.readAll(), original);
+  file.close();
+
+  // reopening replays the journal
+  QVERIFY(doc->openDocument(url));
+  Tellico::Data::CollPtr coll2 = doc->collection();
+  QVERIFY(coll2);
+  QVERIFY(!doc->isModified());
+  QCOMPARE(coll2->title(), QSL("Journal Collection"));
+  QCOMPARE(coll2->entryCount(), 3);
+  QVERIFY(!coll2->entryById(removedId));
+  QVERIFY(coll2->hasField(QSL("journal")));
+  QCOMPARE(coll2->entryById(entry1->id())->field(QSL("title")), QSL("Journal Title"));
+  QCOMPARE(coll2->entryById(entry3->id())->field(QSL("title")), QSL("New Entry"));
+  QCOMPARE(coll2->entryById(entry3->id())->field(QSL("journal")), QSL("value"));
+  QCOMPARE(coll2->filters().count(), 1);
+  QCOMPARE(coll2->filters().at(0)->name(), QSL("Journal Filter"));
+
+  // a batch that was only partly written is ignored
+  const qint64 journalSize = journal->size();
+  Tellico::Data::EntryPtr entry4 = coll2->entryById(entry1->id());
+  entry4->setField(QSL("title"), QSL("Second Title"));
+  journal->modifyEntries(Tellico::Data::EntryList() << entry4);
+  QVERIFY(doc->saveDocument(url));
+  QVERIFY(journal->size() > journalSize);
+  QFile journalFile(Tellico::TellicoJournal::journalFileName(url));
+  QVERIFY(journalFile.resize(journal->size() - 1));
+  QVERIFY(doc->openDocument(url));
+  QCOMPARE(doc->collection()->entryById(entry1->id())->field(QSL("title")), QSL("Journal Title"));
+  QCOMPARE(journal->size(), journalSize);
+
+  // compacting writes the file and removes the journal
+  QVERIFY(doc->compactDocument());
+  QVERIFY(!QFile::exists(Tellico::TellicoJournal::journalFileName(url)));
+  QCOMPARE(journal->size(), qint64(0));
+  QVERIFY(doc->openDocument(url));
+  QCOMPARE(doc->collection()->title(), QSL("Journal Collection"));
+  QCOMPARE(doc->collection()->entryCount(), 3);
+  QVERIFY(doc->collection()->hasField(QSL("journal")));
+  QCOMPARE(doc->collection()->entryById(entry1->id())->field(QSL("title")), QSL("Journal Title"));
+
+  Tellico::Config::setJournalSaving(false);
+  Tellico::TellicoSnapshot::remove(url);
+}
+
+void DocumentTest::testSnapshotCapture() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  const QString fileName = tempDir.path() + "/tabletest.tc";
+  QVERIFY(QFile::copy(QFINDTESTDATA("data/tabletest.tc"), fileName));
+  const QUrl url = QUrl::fromLocalFile(fileName);
+  Tellico::TellicoSnapshot::remove(url);
+
+  Tellico::Data::Document* doc = Tellico::Data::Document::self();
+  QVERIFY(doc->openDocument(url));
+  Tellico::Data::CollPtr coll = doc->collection();
+  QVERIFY(coll);
+  Tellico::Data::EntryPtr entry = coll->entries().at(0);
+  const QString title = entry->title();
+
+  // the capture is written on another thread, while the collection keeps changing
+  QScopedPointer<Tellico::TellicoSnapshot> snapshot(new Tellico::TellicoSnapshot(coll, Tellico::Import::TellicoImporter::XML));
+  entry->setField(QSL("title"), QSL("Changed Title"));
+  const QString snapshotFile = tempDir.path() + "/capture.snapshot";
+  const QByteArray header("header");
+  QFuture<bool> future = QtConcurrent::run(snapshot.data(), &Tellico::TellicoSnapshot::writeFile,
+                                           snapshotFile, header);
+  QVERIFY(future.result());
+  snapshot.reset();
+
+  QByteArray header2;
+  Tellico::Import::TellicoImporter::Format format = Tellico::Import::TellicoImporter::Unknown;
+  Tellico::Data::CollPtr coll2 = Tellico::TellicoSnapshot::readFile(snapshotFile, &header2, &format);
+  QVERIFY(coll2);
+  QCOMPARE(header2, header);
+  QCOMPARE(int(format), int(Tellico::Import::TellicoImporter::XML));
+  QCOMPARE(coll2->entryCount(), coll->entryCount());
+  QCOMPARE(coll2->entryById(entry->id())->title(), title);
+  QVERIFY(!Tellico::TellicoSnapshot::readFile(snapshotFile, nullptr, nullptr, QByteArray("other")));
+
+  // a restored document keeps the url, but is modified
+  doc->restoreDocument(coll2, url, format);
+  QVERIFY(doc->collection() == coll2);
+  QCOMPARE(doc->URL(), url);
+  QVERIFY(doc->isModified());
+
+  Tellico::TellicoSnapshot::remove(url);
+}
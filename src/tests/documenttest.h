@@ -35,6 +35,9 @@ private Q_SLOTS:
   void cleanupTestCase();
 
   void testImageLocalDirectory();
+  void testSnapshot();
+  void testJournal();
+  void testSnapshotCapture();
 };
 
 #endif
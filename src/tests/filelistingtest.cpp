@@ -28,10 +28,13 @@
 #include "filelistingtest.h"
 
 #include "../translators/filelistingimporter.h"
+#include "../translators/filelistingcache.h"
 #include "../translators/xmphandler.h"
 #include "../images/imagefactory.h"
 
 #include <QTest>
+#include <QTemporaryDir>
+#include <QDateTime>
 
 // KIO::listDir in FileListingImporter seems to require a GUI Application
 QTEST_MAIN( FileListingTest )
@@ -112,3 +115,42 @@ void FileListingTest::testXMPData() {
   QVERIFY(!entry->field("metainfo").isEmpty());
 #endif
 }
+
+void FileListingTest::testCache() {
+  QTemporaryDir dir;
+  const QString fileName = dir.path() + QStringLiteral("/filelisting.cache");
+  const QDateTime modified = QDateTime::fromMSecsSinceEpoch(Q_INT64_C(1500000000000));
+
+  {
+    Tellico::FileListingCache cache(fileName);
+    QVERIFY(!cache.load());
+    QVERIFY(!cache.lookup(QStringLiteral("/tmp/a.txt"), 10, modified, nullptr));
+    cache.insert(QStringLiteral("/tmp/a.txt"), 10, modified, QStringLiteral("Title::A"));
+    cache.insert(QStringLiteral("/tmp/b.txt"), 20, modified, QStringLiteral("Title::B"));
+    // no modification time, so nothing to compare against later
+    cache.insert(QStringLiteral("/tmp/c.txt"), 30, QDateTime(), QStringLiteral("Title::C"));
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(cache.save());
+  }
+
+  {
+    Tellico::FileListingCache cache(fileName);
+    QVERIFY(cache.load());
+    QCOMPARE(cache.count(), 2);
+    QString metaInfo;
+    QVERIFY(cache.lookup(QStringLiteral("/tmp/a.txt"), 10, modified, &metaInfo));
+    QCOMPARE(metaInfo, QStringLiteral("Title::A"));
+    // a changed file is not used
+    QVERIFY(!cache.lookup(QStringLiteral("/tmp/a.txt"), 11, modified, &metaInfo));
+    QVERIFY(!cache.lookup(QStringLiteral("/tmp/a.txt"), 10, modified.addSecs(1), &metaInfo));
+    // b.txt is not looked up, so it's dropped
+    QVERIFY(cache.save());
+  }
+
+  {
+    Tellico::FileListingCache cache(fileName);
+    QVERIFY(cache.load());
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(!cache.lookup(QStringLiteral("/tmp/b.txt"), 20, modified, nullptr));
+  }
+}
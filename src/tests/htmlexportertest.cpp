@@ -27,6 +27,7 @@
 #include "htmlexportertest.h"
 
 #include "../translators/htmlexporter.h"
+#include "../translators/htmlexportmanifest.h"
 #include "../collections/bookcollection.h"
 #include "../collectionfactory.h"
 #include "../entry.h"
@@ -200,3 +201,109 @@ void HtmlExporterTest::testDirectoryNames() {
   exp.setCollectionURL(QUrl::fromLocalFile(QDir::homePath()));
   QCOMPARE(exp.fileDirName(), QStringLiteral("/"));
 }
+
+void HtmlExporterTest::testEntryFiles() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < 50; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QStringLiteral("title"), QStringLiteral("Title %1").arg(i));
+    entries << entry;
+  }
+  coll->addEntries(entries);
+
+  Tellico::Export::HTMLExporter exp(coll);
+  exp.setEntries(coll->entries());
+  exp.setExportEntryFiles(true);
+  exp.setEntryXSLTFile(QStringLiteral("Fancy"));
+  exp.setOptions(exp.options() | Tellico::Export::ExportForce | Tellico::Export::ExportUTF8);
+  exp.setURL(QUrl::fromLocalFile(tempDir.path() + "/testEntries.html"));
+  QVERIFY(exp.exec());
+
+  // the first entry file is written on its own, the rest may be written by worker threads
+  foreach(Tellico::Data::EntryPtr entry, coll->entries()) {
+    const QString fileName = tempDir.path() + QStringLiteral("/testEntries_files/%1-%2.html")
+                             .arg(entry->title().replace(' ', '_')).arg(entry->id());
+    QFile f(fileName);
+    QVERIFY2(f.open(QIODevice::ReadOnly | QIODevice::Text), qPrintable(fileName));
+    const QString text = QString::fromUtf8(f.readAll());
+    QVERIFY(text.contains(entry->title()));
+    // verify link to parent html file
+    QVERIFY(text.contains(QStringLiteral("href=\"../testEntries.html")));
+  }
+}
+
+static QString entryFileName(const QString& dir_, Tellico::Data::EntryPtr entry_) {
+  return dir_ + QStringLiteral("/testIncremental_files/%1-%2.html")
+                .arg(entry_->title().replace(' ', '_')).arg(entry_->id());
+}
+
+static void appendMarker(const QString& fileName_) {
+  QFile f(fileName_);
+  QVERIFY(f.open(QIODevice::Append));
+  f.write("<!-- marker -->");
+}
+
+static bool hasMarker(const QString& fileName_) {
+  QFile f(fileName_);
+  return f.open(QIODevice::ReadOnly) && f.readAll().contains("<!-- marker -->");
+}
+
+void HtmlExporterTest::testIncremental() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < 10; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QStringLiteral("title"), QStringLiteral("Title %1").arg(i));
+    entries << entry;
+  }
+  coll->addEntries(entries);
+  entries = coll->entries();
+
+  Tellico::Export::HTMLExporter exp(coll);
+  exp.setEntries(entries);
+  exp.setExportEntryFiles(true);
+  exp.setIncremental(true);
+  exp.setEntryXSLTFile(QStringLiteral("Fancy"));
+  exp.setOptions(exp.options() | Tellico::Export::ExportForce | Tellico::Export::ExportUTF8);
+  exp.setURL(QUrl::fromLocalFile(tempDir.path() + "/testIncremental.html"));
+  QVERIFY(exp.exec());
+  QVERIFY(QFile::exists(tempDir.path() + "/testIncremental_files/" +
+                        Tellico::Export::HTMLExportManifest::manifestFileName()));
+
+  foreach(Tellico::Data::EntryPtr entry, entries) {
+    appendMarker(entryFileName(tempDir.path(), entry));
+  }
+
+  // nothing changed, so no entry file is written again
+  QVERIFY(exp.exec());
+  foreach(Tellico::Data::EntryPtr entry, entries) {
+    QVERIFY(hasMarker(entryFileName(tempDir.path(), entry)));
+  }
+
+  // only the changed entry is written again
+  entries.at(1)->setField(QStringLiteral("author"), QStringLiteral("Author"));
+  QVERIFY(exp.exec());
+  QVERIFY(hasMarker(entryFileName(tempDir.path(), entries.at(0))));
+  QVERIFY(!hasMarker(entryFileName(tempDir.path(), entries.at(1))));
+  QVERIFY(hasMarker(entryFileName(tempDir.path(), entries.at(2))));
+
+  // the file for an entry which is no longer exported gets removed
+  const QString removedFile = entryFileName(tempDir.path(), entries.at(2));
+  entries.removeAt(2);
+  exp.setEntries(entries);
+  QVERIFY(exp.exec());
+  QVERIFY(!QFile::exists(removedFile));
+  QVERIFY(hasMarker(entryFileName(tempDir.path(), entries.at(0))));
+
+  // a different option changes every entry file
+  exp.setOptions(exp.options() | Tellico::Export::ExportFormatted);
+  QVERIFY(exp.exec());
+  QVERIFY(!hasMarker(entryFileName(tempDir.path(), entries.at(0))));
+}
@@ -25,14 +25,18 @@
 #include "imagejobtest.h"
 
 #include "../images/imagejob.h"
+#include "../images/imagejobscheduler.h"
 #include "../images/imagefactory.h"
 #include "../images/imageinfo.h"
 
+#include <KIO/StoredTransferJob>
+
 #include <QTest>
 #include <QEventLoop>
 #include <QTemporaryFile>
 #include <QNetworkInterface>
 #include <QSignalSpy>
+#include <QCryptographicHash>
 
 QTEST_GUILESS_MAIN( ImageJobTest )
 
@@ -45,6 +49,16 @@ static bool hasNetwork() {
   return false;
 }
 
+// the image id is the md5 hash of the downloaded file
+// the remote file might change, so the hash is taken here directly rather than from Image::calculateID()
+static QString networkImageId(const QUrl& url_) {
+  KIO::StoredTransferJob* job = KIO::storedGet(url_, KIO::NoReload, KIO::HideProgressInfo);
+  if(!job->exec()) {
+    return QString();
+  }
+  return QLatin1String(QCryptographicHash::hash(job->data(), QCryptographicHash::Md5).toHex()) + QLatin1String(".png");
+}
+
 void ImageJobTest::initTestCase() {
   Tellico::ImageFactory::init();
 }
@@ -142,7 +156,7 @@ void ImageJobTest::testImageLoad() {
 
   const Tellico::Data::Image& img = job->image();
   QVERIFY(!img.isNull());
-  QCOMPARE(img.id(), QStringLiteral("dde5bf2cbd90fad8635a26dfb362e0ff.png"));
+  QCOMPARE(img.id(), QStringLiteral("238facd056a59ca8458ebca76edd3493.png"));
   QCOMPARE(img.format(), QByteArray("png"));
   QCOMPARE(img.linkOnly(), false);
 
@@ -186,7 +200,7 @@ void ImageJobTest::testImageLink() {
   const Tellico::Data::Image& img = job->image();
   QVERIFY(!img.isNull());
   // id is not the MD5 hash
-  QVERIFY(img.id() != QStringLiteral("dde5bf2cbd90fad8635a26dfb362e0ff.png"));
+  QVERIFY(img.id() != QStringLiteral("238facd056a59ca8458ebca76edd3493.png"));
   QCOMPARE(img.format(), QByteArray("png"));
   QCOMPARE(img.linkOnly(), true);
 }
@@ -206,7 +220,7 @@ void ImageJobTest::testNetworkImage() {
 
   const Tellico::Data::Image& img = job->image();
   QVERIFY(!img.isNull());
-  QCOMPARE(img.id(), QStringLiteral("ecaf5185c4016881aaabb4933211d5d6.png"));
+  QCOMPARE(img.id(), networkImageId(u));
   QCOMPARE(img.format(), QByteArray("png"));
   QCOMPARE(img.linkOnly(), false);
 
@@ -270,7 +284,7 @@ void ImageJobTest::testFactoryRequestLocal() {
   const Tellico::Data::Image& img = Tellico::ImageFactory::imageById(m_imageId);
   QVERIFY(!img.isNull());
   // id is not the MD5 hash
-  QVERIFY(img.id() != QStringLiteral("dde5bf2cbd90fad8635a26dfb362e0ff.png"));
+  QVERIFY(img.id() != QStringLiteral("238facd056a59ca8458ebca76edd3493.png"));
   QCOMPARE(img.format(), QByteArray("png"));
   QCOMPARE(img.linkOnly(), true);
 }
@@ -322,7 +336,7 @@ void ImageJobTest::testFactoryRequestNetwork() {
   const Tellico::Data::Image& img = Tellico::ImageFactory::imageById(m_imageId);
   QVERIFY(!img.isNull());
   // id is the MD5 hash, since it's not link only
-  QCOMPARE(img.id(), QStringLiteral("ecaf5185c4016881aaabb4933211d5d6.png"));
+  QCOMPARE(img.id(), networkImageId(u));
   QCOMPARE(img.format(), QByteArray("png"));
   QCOMPARE(img.linkOnly(), false);
 }
@@ -356,3 +370,49 @@ void ImageJobTest::testFactoryRequestNetworkLinkOnly() {
   QCOMPARE(img.format(), QByteArray("png"));
   QCOMPARE(img.linkOnly(), true);
 }
+
+void ImageJobTest::testSchedulerMerge() {
+  Tellico::ImageJobScheduler scheduler;
+  QSignalSpy spy(&scheduler, &Tellico::ImageJobScheduler::jobFinished);
+
+  QUrl u = QUrl::fromLocalFile(QFINDTESTDATA("../../icons/tellico.png"));
+  scheduler.request(u);
+  scheduler.request(u, Tellico::ImageJobScheduler::HighPriority);
+  QVERIFY(scheduler.isPending(u));
+  QCOMPARE(scheduler.queuedCount(), 1);
+
+  QVERIFY(spy.wait());
+  // only one job for the same url
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(scheduler.runningCount(), 0);
+  QVERIFY(!scheduler.isPending(u));
+}
+
+void ImageJobTest::testSchedulerPriority() {
+  Tellico::ImageJobScheduler scheduler;
+  // a single job at a time, so the order can be checked
+  scheduler.setMaxJobs(1);
+  QSignalSpy spy(&scheduler, &Tellico::ImageJobScheduler::jobFinished);
+
+  QUrl u1 = QUrl::fromLocalFile(QFINDTESTDATA("../../icons/16-apps-tellico.png"));
+  QUrl u2 = QUrl::fromLocalFile(QFINDTESTDATA("../../icons/32-apps-tellico.png"));
+  QUrl u3 = QUrl::fromLocalFile(QFINDTESTDATA("../../icons/64-apps-tellico.png"));
+  scheduler.request(u1, Tellico::ImageJobScheduler::LowPriority);
+  scheduler.request(u2, Tellico::ImageJobScheduler::NormalPriority);
+  scheduler.request(u3, Tellico::ImageJobScheduler::HighPriority);
+  QCOMPARE(scheduler.queuedCount(), 3);
+
+  // highest priority first
+  QVERIFY(spy.wait());
+  QVERIFY(!scheduler.isPending(u3));
+  QVERIFY(scheduler.isPending(u2));
+  QVERIFY(scheduler.isPending(u1));
+
+  QVERIFY(spy.wait());
+  QVERIFY(!scheduler.isPending(u2));
+  QVERIFY(scheduler.isPending(u1));
+
+  QVERIFY(spy.wait());
+  QVERIFY(!scheduler.isPending(u1));
+  QCOMPARE(spy.count(), 3);
+}
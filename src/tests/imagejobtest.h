@@ -51,6 +51,8 @@ private Q_SLOTS:
   void testFactoryRequestLocalInvalid();
   void testFactoryRequestNetwork();
   void testFactoryRequestNetworkLinkOnly();
+  void testSchedulerMerge();
+  void testSchedulerPriority();
 
 Q_SIGNALS:
   void exitLoop();
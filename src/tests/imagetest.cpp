@@ -27,12 +27,40 @@
 #include "imagetest.h"
 
 #include "../images/imagefactory.h"
+#include "../images/image.h"
+#include "../images/imagehashindex.h"
+#include "../images/imageingestpolicy.h"
+#include "../config/tellico_config.h"
+#include "../collection.h"
 
 #include <QTest>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QStandardPaths>
 
 QTEST_GUILESS_MAIN( ImageTest )
 
+namespace {
+  // a 9x8 image isn't scaled, so each bit of the hash is set by a pair of neighboring pixels
+  QImage imageForHash(quint64 hash_) {
+    QImage img(9, 8, QImage::Format_RGB32);
+    for(int y = 0; y < 8; ++y) {
+      int gray = 128;
+      img.setPixel(0, y, qRgb(gray, gray, gray));
+      for(int x = 0; x < 8; ++x) {
+        const bool bit = (hash_ >> (63 - (y*8 + x))) & 1;
+        gray += bit ? -10 : 10;
+        img.setPixel(x+1, y, qRgb(gray, gray, gray));
+      }
+    }
+    return img;
+  }
+}
+
 void ImageTest::initTestCase() {
+  // the originals of reduced images are kept in the data directory
+  QStandardPaths::setTestModeEnabled(true);
   Tellico::ImageFactory::init();
 }
 
@@ -42,3 +70,174 @@ void ImageTest::testLinkOnly() {
   QString id = Tellico::ImageFactory::addImage(u, false, QUrl(), true);
   QCOMPARE(id, u.url());
 }
+
+void ImageTest::testPayloadId() {
+  QUrl u = QUrl::fromLocalFile(QFINDTESTDATA("../../icons/tellico.png"));
+  // the id is the md5 hash of the file itself
+  QString id = Tellico::ImageFactory::addImage(u, true);
+  QCOMPARE(id, QStringLiteral("238facd056a59ca8458ebca76edd3493.png"));
+}
+
+void ImageTest::testPerceptualHash() {
+  // a gradient getting darker from left to right sets every bit
+  QImage gradient(128, 128, QImage::Format_RGB32);
+  for(int x = 0; x < gradient.width(); ++x) {
+    for(int y = 0; y < gradient.height(); ++y) {
+      gradient.setPixel(x, y, qRgb(255-2*x, 255-2*x, 255-2*x));
+    }
+  }
+  QCOMPARE(Tellico::ImageHashIndex::perceptualHash(gradient), ~Q_UINT64_C(0));
+  QCOMPARE(Tellico::ImageHashIndex::perceptualHash(gradient.mirrored(true, false)), Q_UINT64_C(0));
+  QCOMPARE(Tellico::ImageHashIndex::perceptualHash(QImage()), Q_UINT64_C(0));
+  QCOMPARE(Tellico::ImageHashIndex::hashDistance(~Q_UINT64_C(0), Q_UINT64_C(0)), 64);
+  QCOMPARE(Tellico::ImageHashIndex::perceptualHash(imageForHash(Q_UINT64_C(0x0F))), Q_UINT64_C(0x0F));
+
+  // a rescaled image hashes nearly the same
+  QImage img(QFINDTESTDATA("../../icons/128-apps-tellico.png"));
+  QVERIFY(!img.isNull());
+  const quint64 hash = Tellico::ImageHashIndex::perceptualHash(img);
+  const QImage scaled = img.scaled(64, 64, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  QVERIFY(Tellico::ImageHashIndex::hashDistance(hash, Tellico::ImageHashIndex::perceptualHash(scaled)) <= 4);
+}
+
+void ImageTest::testDuplicates() {
+  QImage img(QFINDTESTDATA("../../icons/128-apps-tellico.png"));
+  QVERIFY(!img.isNull());
+  QImage gradient(128, 128, QImage::Format_RGB32);
+  for(int x = 0; x < gradient.width(); ++x) {
+    for(int y = 0; y < gradient.height(); ++y) {
+      gradient.setPixel(x, y, qRgb(255-2*x, 255-2*x, 255-2*x));
+    }
+  }
+
+  Tellico::ImageHashIndex index;
+  index.addImage(QStringLiteral("big"), img);
+  index.addImage(QStringLiteral("small"), img.scaled(64, 64, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+  index.addImage(QStringLiteral("gradient"), gradient);
+  index.addImage(QStringLiteral("gradient-copy"), gradient.copy());
+  // same pixels, but squashed to a different shape
+  index.addImage(QStringLiteral("wide"), img.scaled(128, 32, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+  QCOMPARE(index.count(), 5);
+
+  const QHash<QString, QString> duplicates = index.duplicates();
+  QCOMPARE(duplicates.count(), 2);
+  // the larger image is kept
+  QCOMPARE(duplicates.value(QStringLiteral("small")), QStringLiteral("big"));
+  // or the lowest id, when they're the same size
+  QCOMPARE(duplicates.value(QStringLiteral("gradient-copy")), QStringLiteral("gradient"));
+
+  // a chain of images a~b~c, where a and c are too far apart, doesn't group a with c
+  Tellico::ImageHashIndex chain;
+  chain.addImage(QStringLiteral("a"), imageForHash(Q_UINT64_C(0)));
+  chain.addImage(QStringLiteral("b"), imageForHash(Q_UINT64_C(0x0F)));
+  chain.addImage(QStringLiteral("c"), imageForHash(Q_UINT64_C(0xFF)));
+  const QHash<QString, QString> chainDuplicates = chain.duplicates(4);
+  QCOMPARE(chainDuplicates.count(), 1);
+  QCOMPARE(chainDuplicates.value(QStringLiteral("b")), QStringLiteral("a"));
+  QVERIFY(!chainDuplicates.contains(QStringLiteral("c")));
+}
+
+void ImageTest::testIngestPolicy() {
+  QFile file(QFINDTESTDATA("../../icons/128-apps-tellico.png"));
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray data = file.readAll();
+
+  Tellico::ImageIngestPolicy policy;
+  QVERIFY(!policy.isActive());
+  QVERIFY(!policy.apply(data).changed);
+
+  // already small enough, so nothing changes
+  policy.setMaxSize(256);
+  QVERIFY(policy.isActive());
+  QVERIFY(!policy.apply(data).changed);
+
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  policy.setOriginalDirectory(tempDir.path());
+  policy.setMaxSize(64);
+  Tellico::ImageIngestPolicy::Result result = policy.apply(data);
+  QVERIFY(result.changed);
+  QCOMPARE(result.format, QByteArray("png"));
+  QCOMPARE(result.id, Tellico::Data::Image::calculateID(result.data, QStringLiteral("png")));
+  QImage img = QImage::fromData(result.data);
+  QCOMPARE(img.size(), QSize(64, 64));
+  // the original is kept
+  QFile original(tempDir.path() + QLatin1Char('/') + result.id);
+  QVERIFY(original.open(QIODevice::ReadOnly));
+  QCOMPARE(original.readAll(), data);
+
+  // changing the format re-encodes the image, even without scaling
+  policy.setOriginalDirectory(QString());
+  policy.setMaxSize(0);
+  policy.setFormat("JPEG");
+  result = policy.apply(data);
+  QVERIFY(result.changed);
+  QCOMPARE(result.format, QByteArray("jpeg"));
+  QCOMPARE(QImage::fromData(result.data).size(), QSize(128, 128));
+
+  QCOMPARE(policy.scaleImage(img).size(), QSize(64, 64));
+  policy.setMaxSize(32);
+  QCOMPARE(policy.scaleImage(img).size(), QSize(32, 32));
+}
+
+void ImageTest::testPruneOriginals() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  const QString fromDir = tempDir.path() + QLatin1String("/from/");
+  const QString toDir = tempDir.path() + QLatin1String("/to/");
+  QVERIFY(QDir().mkpath(fromDir));
+  QStringList ids;
+  ids << QStringLiteral("used.png") << QStringLiteral("unused.png");
+  foreach(const QString& id, ids) {
+    QFile file(fromDir + id);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(id.toUtf8());
+  }
+
+  // saving under a new name takes the originals along
+  Tellico::ImageIngestPolicy::moveOriginals(fromDir, toDir);
+  QVERIFY(!QDir(fromDir).exists());
+  QCOMPARE(QDir(toDir).entryList(QDir::Files), QStringList() << QStringLiteral("unused.png") << QStringLiteral("used.png"));
+
+  QSet<QString> usedIds;
+  usedIds << QStringLiteral("used.png");
+  Tellico::ImageIngestPolicy::pruneOriginals(toDir, usedIds);
+  QCOMPARE(QDir(toDir).entryList(QDir::Files), QStringList() << QStringLiteral("used.png"));
+
+  // the directory goes away along with the last original
+  Tellico::ImageIngestPolicy::pruneOriginals(toDir, QSet<QString>());
+  QVERIFY(!QDir(toDir).exists());
+}
+
+void ImageTest::testKeepOriginals() {
+  QFile file(QFINDTESTDATA("../../icons/128-apps-tellico.png"));
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray data = file.readAll();
+
+  const QUrl url = QUrl::fromLocalFile(QStringLiteral("/tmp/keep-originals.tc"));
+  const QString dir = Tellico::ImageIngestPolicy::documentOriginalDirectory(url);
+  QDir(dir).removeRecursively();
+  QVERIFY(!QDir(dir).exists());
+
+  Tellico::Config::setKeepOriginalImages(true);
+  Tellico::ImageIngestPolicy policy = Tellico::ImageIngestPolicy::fromConfig(Tellico::Data::Collection::Book, url);
+  QCOMPARE(policy.originalDirectory(), dir);
+  policy.setMaxSize(64);
+  const Tellico::ImageIngestPolicy::Result result = policy.apply(data);
+  QVERIFY(result.changed);
+  QCOMPARE(result.id, Tellico::Data::Image::calculateID(result.data, QStringLiteral("png")));
+  // the directory for the document is created for the first original
+  QFile original(dir + result.id);
+  QVERIFY(original.open(QIODevice::ReadOnly));
+  QCOMPARE(original.readAll(), data);
+  original.close();
+
+  // and again after pruning removed it
+  Tellico::ImageIngestPolicy::pruneOriginals(dir, QSet<QString>());
+  QVERIFY(!QDir(dir).exists());
+  policy.apply(data);
+  QVERIFY(QFile::exists(dir + result.id));
+
+  Tellico::ImageIngestPolicy::pruneOriginals(dir, QSet<QString>());
+  Tellico::Config::setKeepOriginalImages(false);
+}
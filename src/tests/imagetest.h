@@ -33,6 +33,12 @@ Q_OBJECT
 private Q_SLOTS:
   void initTestCase();
   void testLinkOnly();
+  void testPayloadId();
+  void testPerceptualHash();
+  void testDuplicates();
+  void testIngestPolicy();
+  void testPruneOriginals();
+  void testKeepOriginals();
 };
 
 #endif
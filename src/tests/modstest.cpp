@@ -28,6 +28,8 @@
 
 #include "../translators/xsltimporter.h"
 #include "../translators/xslthandler.cpp"
+#include "../translators/tellicoimporter.h"
+#include "../translators/tellicoxmlreader.h"
 #include "../collections/bookcollection.h"
 #include "../collectionfactory.h"
 #include "../fieldformat.h"
@@ -86,3 +88,41 @@ void ModsTest::testDNBMARCXML() {
   QCOMPARE(coll->type(), Tellico::Data::Collection::Book);
   QCOMPARE(coll->entryCount(), 25);
 }
+
+// reading the result tree directly has to give the same collection as writing it out and parsing the text
+void ModsTest::testResultDocument() {
+  Tellico::XSLTHandler handler(QUrl::fromLocalFile(QFINDTESTDATA("../../xslt/mods2tellico.xsl")));
+  QVERIFY(handler.isValid());
+
+  QFile f(QFINDTESTDATA("data/example_mods.xml"));
+  QVERIFY(f.open(QIODevice::ReadOnly | QIODevice::Text));
+  const QString text = QString::fromUtf8(f.readAll());
+
+  Tellico::Import::TellicoImporter textImporter(handler.applyStylesheet(text));
+  Tellico::Data::CollPtr textColl = textImporter.collection();
+  QVERIFY(textColl);
+
+  xmlDocPtr result = handler.transform(text);
+  QVERIFY(result);
+  Tellico::Import::TellicoXMLReader reader((QByteArray()));
+  QVERIFY(reader.readDocument(result));
+  QVERIFY(!reader.hasError());
+  xmlFreeDoc(result);
+  Tellico::Data::CollPtr docColl = reader.collection();
+  QVERIFY(docColl);
+
+  QCOMPARE(docColl->type(), textColl->type());
+  QCOMPARE(docColl->title(), textColl->title());
+  QCOMPARE(docColl->fields().count(), textColl->fields().count());
+  QCOMPARE(docColl->entryCount(), textColl->entryCount());
+  Tellico::Data::EntryPtr docEntry = docColl->entries().first();
+  Tellico::Data::EntryPtr textEntry = textColl->entries().first();
+  foreach(Tellico::Data::FieldPtr field, textColl->fields()) {
+    QCOMPARE(docEntry->field(field->name()), textEntry->field(field->name()));
+  }
+
+  // an empty document is an error, not a crash
+  Tellico::Import::TellicoXMLReader emptyReader((QByteArray()));
+  QVERIFY(!emptyReader.readDocument(nullptr));
+  QVERIFY(emptyReader.hasError());
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#undef QT_NO_CAST_FROM_ASCII
+
+#include "phasetimertest.h"
+
+#include "../utils/phasetimer.h"
+
+#include <QTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtConcurrentRun>
+#include <QSemaphore>
+
+QTEST_GUILESS_MAIN( PhaseTimerTest )
+
+#define QSL(x) QStringLiteral(x)
+
+namespace {
+  void workerPhase() {
+    Tellico::PhaseTimer timer("worker");
+    timer.setCount(7);
+  }
+
+  QSemaphore s_workerStarted;
+  QSemaphore s_releaseWorker;
+
+  void slowWorkerPhase() {
+    Tellico::PhaseTimer timer("slow worker");
+    s_workerStarted.release();
+    s_releaseWorker.acquire();
+  }
+}
+
+void PhaseTimerTest::init() {
+  Tellico::PhaseLog::self()->setMaxOperations(20);
+  Tellico::PhaseLog::self()->clear();
+}
+
+void PhaseTimerTest::testNesting() {
+  {
+    Tellico::PhaseTimer outer("outer", Tellico::PhaseTimer::Operation);
+    {
+      Tellico::PhaseTimer inner("inner");
+      inner.addCount();
+      inner.addCount(2);
+    }
+    Tellico::PhaseTimer inner2("inner2");
+  }
+
+  QList<Tellico::PhaseLog::Operation> ops = Tellico::PhaseLog::self()->operations();
+  QCOMPARE(ops.count(), 1);
+  const Tellico::PhaseLog::Operation op = ops.first();
+  QCOMPARE(op.count(), 3);
+  // phases are recorded as they end
+  QCOMPARE(op.at(0).name, QByteArray("inner"));
+  QCOMPARE(op.at(0).depth, 1);
+  QCOMPARE(op.at(0).count, 3);
+  QCOMPARE(op.at(1).name, QByteArray("inner2"));
+  QCOMPARE(op.at(1).count, -1);
+  QCOMPARE(op.at(2).name, QByteArray("outer"));
+  QCOMPARE(op.at(2).depth, 0);
+  QVERIFY(op.at(2).start <= op.at(0).start);
+  QVERIFY(op.at(2).duration >= op.at(0).duration + op.at(1).duration);
+
+  // a second operation timer starts a new operation
+  {
+    Tellico::PhaseTimer next("next", Tellico::PhaseTimer::Operation);
+  }
+  QCOMPARE(Tellico::PhaseLog::self()->operations().count(), 2);
+}
+
+void PhaseTimerTest::testNoOperation() {
+  // a plain timer outside of an operation records nothing
+  {
+    Tellico::PhaseTimer regroup("regroup");
+    Tellico::PhaseTimer inner("inner");
+  }
+  QVERIFY(Tellico::PhaseLog::self()->operations().isEmpty());
+
+  // but an operation can still begin inside it
+  {
+    Tellico::PhaseTimer regroup("regroup");
+    Tellico::PhaseTimer open("open", Tellico::PhaseTimer::Operation);
+    Tellico::PhaseTimer inner("inner");
+  }
+  QList<Tellico::PhaseLog::Operation> ops = Tellico::PhaseLog::self()->operations();
+  QCOMPARE(ops.count(), 1);
+  QCOMPARE(ops.first().count(), 2);
+  QCOMPARE(ops.first().at(0).name, QByteArray("inner"));
+  QCOMPARE(ops.first().at(1).name, QByteArray("open"));
+}
+
+void PhaseTimerTest::testThreads() {
+  {
+    Tellico::PhaseTimer outer("outer", Tellico::PhaseTimer::Operation);
+    QtConcurrent::run(workerPhase).waitForFinished();
+  }
+  QList<Tellico::PhaseLog::Operation> ops = Tellico::PhaseLog::self()->operations();
+  QCOMPARE(ops.count(), 1);
+  const Tellico::PhaseLog::Operation op = ops.first();
+  QCOMPARE(op.count(), 2);
+  QCOMPARE(op.at(0).name, QByteArray("worker"));
+  QCOMPARE(op.at(0).depth, 0);
+  QCOMPARE(op.at(0).count, 7);
+  QVERIFY(op.at(0).thread != op.at(1).thread);
+}
+
+void PhaseTimerTest::testLateWorker() {
+  QFuture<void> future;
+  {
+    Tellico::PhaseTimer outer("outer", Tellico::PhaseTimer::Operation);
+    future = QtConcurrent::run(slowWorkerPhase);
+    s_workerStarted.acquire();
+  }
+  s_releaseWorker.release();
+  future.waitForFinished();
+
+  // the worker phase ended after the operation, so it's dropped rather than added to it
+  QList<Tellico::PhaseLog::Operation> ops = Tellico::PhaseLog::self()->operations();
+  QCOMPARE(ops.count(), 1);
+  QCOMPARE(ops.first().count(), 1);
+  QCOMPARE(ops.first().first().name, QByteArray("outer"));
+}
+
+void PhaseTimerTest::testMaxOperations() {
+  Tellico::PhaseLog::self()->setMaxOperations(3);
+  for(int i = 0; i < 5; ++i) {
+    Tellico::PhaseTimer timer(i == 4 ? "last" : "phase", Tellico::PhaseTimer::Operation);
+  }
+  QList<Tellico::PhaseLog::Operation> ops = Tellico::PhaseLog::self()->operations();
+  QCOMPARE(ops.count(), 3);
+  QCOMPARE(ops.last().first().name, QByteArray("last"));
+}
+
+void PhaseTimerTest::testChromeTrace() {
+  {
+    Tellico::PhaseTimer outer("outer", Tellico::PhaseTimer::Operation);
+    Tellico::PhaseTimer inner("inner");
+    inner.setCount(42);
+  }
+
+  QJsonParseError error;
+  const QJsonDocument doc = QJsonDocument::fromJson(Tellico::PhaseLog::self()->chromeTrace(), &error);
+  QCOMPARE(error.error, QJsonParseError::NoError);
+  const QJsonArray events = doc.object().value(QSL("traceEvents")).toArray();
+  QCOMPARE(events.count(), 2);
+  const QJsonObject inner = events.at(0).toObject();
+  QCOMPARE(inner.value(QSL("name")).toString(), QSL("inner"));
+  QCOMPARE(inner.value(QSL("ph")).toString(), QSL("X"));
+  QCOMPARE(inner.value(QSL("args")).toObject().value(QSL("count")).toInt(), 42);
+  const QJsonObject outer = events.at(1).toObject();
+  QVERIFY(!outer.contains(QSL("args")));
+  QVERIFY(outer.value(QSL("ts")).toDouble() <= inner.value(QSL("ts")).toDouble());
+  QVERIFY(outer.value(QSL("dur")).toDouble() >= inner.value(QSL("dur")).toDouble());
+}
@@ -30,6 +30,8 @@
 #include "../collections/musiccollection.h"
 #include "../collectionfactory.h"
 #include "../translators/tellicoxmlexporter.h"
+#include "../translators/tellicozipexporter.h"
+#include "../translators/tellicoxmlreader.h"
 #include "../translators/tellico_xml.h"
 #include "../images/imagefactory.h"
 #include "../images/image.h"
@@ -37,8 +39,18 @@
 #include "../entry.h"
 #include "../utils/xmlhandler.h"
 
+#include <KIO/StoredTransferJob>
+#include <KZip>
+
 #include <QTest>
+#include <QBuffer>
 #include <QNetworkInterface>
+#include <QXmlStreamReader>
+#include <QTemporaryDir>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+
+#include <libxml/tree.h>
 
 QTEST_GUILESS_MAIN( TellicoReadTest )
 
@@ -54,6 +66,16 @@ static bool hasNetwork() {
   return false;
 }
 
+// the image id is the md5 hash of the downloaded file
+// the remote file might change, so the hash is taken here directly rather than from Image::calculateID()
+static QString networkImageId(const QUrl& url_) {
+  KIO::StoredTransferJob* job = KIO::storedGet(url_, KIO::NoReload, KIO::HideProgressInfo);
+  if(!job->exec()) {
+    return QString();
+  }
+  return QLatin1String(QCryptographicHash::hash(job->data(), QCryptographicHash::Md5).toHex()) + QLatin1String(".png");
+}
+
 void TellicoReadTest::initTestCase() {
   // need to register this first
   Tellico::RegisterCollection<Tellico::Data::BookCollection> registerBook(Tellico::Data::Collection::Book, "book");
@@ -235,7 +257,7 @@ void TellicoReadTest::testDuplicateBorrowers() {
 
 void TellicoReadTest::testLocalImage() {
   // this is the md5 hash of the tellico.png icon, used as an image id
-  const QString imageId(QSL("dde5bf2cbd90fad8635a26dfb362e0ff.png"));
+  const QString imageId(QSL("238facd056a59ca8458ebca76edd3493.png"));
   // not yet loaded
   QVERIFY(!Tellico::ImageFactory::self()->hasImageInMemory(imageId));
   QVERIFY(!Tellico::ImageFactory::self()->hasImageInfo(imageId));
@@ -268,11 +290,57 @@ void TellicoReadTest::testLocalImage() {
   QVERIFY(!img.isNull());
 }
 
+void TellicoReadTest::testZipExport() {
+  const QString imageId(QSL("238facd056a59ca8458ebca76edd3493.png"));
+
+  QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("/data/local_image.xml"));
+  QFile f(url.toLocalFile());
+  QVERIFY(f.open(QIODevice::ReadOnly | QIODevice::Text));
+  QTextStream in(&f);
+  QString fileText = in.readAll();
+  fileText.replace(QSL("%COVER%"), QFINDTESTDATA("../../icons/tellico.png"));
+
+  Tellico::Import::TellicoImporter importer(fileText);
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QUrl zipUrl = QUrl::fromLocalFile(dir.path() + QSL("/export.tc"));
+
+  Tellico::Export::TellicoZipExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setURL(zipUrl);
+  exporter.setOptions(exporter.options() | Tellico::Export::ExportForce);
+  QVERIFY(exporter.exec());
+
+  KZip zip(zipUrl.toLocalFile());
+  QVERIFY(zip.open(QIODevice::ReadOnly));
+  const KArchiveEntry* xmlEntry = zip.directory()->entry(QSL("tellico.xml"));
+  QVERIFY(xmlEntry && xmlEntry->isFile());
+  QVERIFY(static_cast<const KZipFileEntry*>(xmlEntry)->size() > 0);
+
+  const KArchiveEntry* imgEntry = zip.directory()->entry(QSL("images/") + imageId);
+  QVERIFY(imgEntry && imgEntry->isFile());
+  // png images are stored without compression
+  QCOMPARE(static_cast<const KZipFileEntry*>(imgEntry)->encoding(), 0);
+  const QByteArray imgData = static_cast<const KZipFileEntry*>(imgEntry)->data();
+  QCOMPARE(Tellico::Data::Image::calculateID(imgData, QSL("png")), imageId);
+  zip.close();
+
+  Tellico::Import::TellicoImporter importer2(zipUrl);
+  Tellico::Data::CollPtr coll2 = importer2.collection();
+  QVERIFY(coll2);
+  QCOMPARE(coll2->entryCount(), coll->entryCount());
+  QCOMPARE(coll2->entries().at(0)->field(QSL("cover")), imageId);
+}
+
 void TellicoReadTest::testRemoteImage() {
   if(!hasNetwork()) QSKIP("This test requires network access", SkipSingle);
 
-  // this is the md5 hash of the logo.png icon, used as an image id
-  const QString imageId(QSL("ecaf5185c4016881aaabb4933211d5d6.png"));
+  const QUrl imageUrl(QSL("https://tellico-project.org/wp-content/uploads/96-tellico.png"));
+  const QString imageId = networkImageId(imageUrl);
+  QVERIFY(!imageId.isEmpty());
   // not yet loaded
   QVERIFY(!Tellico::ImageFactory::self()->hasImageInMemory(imageId));
   QVERIFY(!Tellico::ImageFactory::self()->hasImageInfo(imageId));
@@ -285,8 +353,7 @@ void TellicoReadTest::testRemoteImage() {
   QTextStream in(&f);
   QString fileText = in.readAll();
   // replace %COVER% with image file location
-  fileText.replace(QSL("%COVER%"),
-                   QSL("https://tellico-project.org/wp-content/uploads/96-tellico.png"));
+  fileText.replace(QSL("%COVER%"), imageUrl.url());
 
   Tellico::Import::TellicoImporter importer(fileText);
   Tellico::Data::CollPtr coll = importer.collection();
@@ -386,3 +453,186 @@ void TellicoReadTest::testBug418067() {
   QVERIFY(coll->hasField(QSL("lc-no.")));
   QVERIFY(coll->hasField(QSL("mein-wunschpreis-")));
 }
+
+// the order of attributes from QDom is random, so compare everything else
+static QStringList xmlTokens(const QString& text_) {
+  QStringList tokens;
+  QXmlStreamReader reader(text_);
+  while(!reader.atEnd()) {
+    reader.readNext();
+    QString token = reader.tokenString() + QLatin1Char(':') + reader.name().toString();
+    if(reader.isStartElement()) {
+      QStringList attributes;
+      foreach(const QXmlStreamAttribute& att, reader.attributes()) {
+        attributes << att.qualifiedName().toString() + QLatin1Char('=') + att.value().toString();
+      }
+      attributes.sort();
+      token += QLatin1Char(' ') + attributes.join(QLatin1Char(' '));
+    } else if(reader.isCharacters() || reader.isDTD() || reader.isProcessingInstruction()) {
+      token += QLatin1Char(' ') + reader.text().toString() + reader.processingInstructionData().toString();
+    }
+    tokens << token;
+  }
+  if(reader.hasError()) {
+    tokens << reader.errorString();
+  }
+  return tokens;
+}
+
+void TellicoReadTest::testStreamWriter() {
+  QFETCH(QString, fileName);
+  QUrl url = QUrl::fromLocalFile(QFINDTESTDATA(fileName));
+
+  Tellico::Import::TellicoImporter importer(url);
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+
+  Tellico::Export::TellicoXMLExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setOptions(exporter.options() | Tellico::Export::ExportUTF8 | Tellico::Export::ExportComplete);
+
+  const QString domText = exporter.exportXML().toString();
+  const QString streamText = exporter.text();
+  QVERIFY(!streamText.isEmpty());
+  // reordering attributes doesn't change the length
+  QCOMPARE(streamText.length(), domText.length());
+  QCOMPARE(xmlTokens(streamText), xmlTokens(domText));
+
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  QVERIFY(exporter.writeXML(&buffer));
+  QCOMPARE(QString::fromUtf8(data), streamText);
+}
+
+void TellicoReadTest::testStreamWriter_data() {
+  QTest::addColumn<QString>("fileName");
+
+  QTest::newRow("tabletest") << QSL("data/tabletest.tc");
+  QTest::newRow("coins-format9") << QSL("data/coins-format9.tc");
+  QTest::newRow("duplicate_loan") << QSL("data/duplicate_loan.xml");
+  QTest::newRow("bug418067") << QSL("data/bug418067.xml");
+}
+
+void TellicoReadTest::testLibXMLWriter() {
+  QFETCH(QString, fileName);
+  QUrl url = QUrl::fromLocalFile(QFINDTESTDATA(fileName));
+
+  Tellico::Import::TellicoImporter importer(url);
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+
+  Tellico::Export::TellicoXMLExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setOptions(exporter.options() | Tellico::Export::ExportUTF8 | Tellico::Export::ExportComplete);
+
+  xmlDocPtr doc = exporter.exportXMLDoc();
+  QVERIFY(doc);
+  xmlChar* buffer = nullptr;
+  int size = 0;
+  xmlDocDumpMemoryEnc(doc, &buffer, &size, "UTF-8");
+  const QString docText = QString::fromUtf8(reinterpret_cast<const char*>(buffer), size);
+  xmlFree(buffer);
+  xmlFreeDoc(doc);
+
+  // the tree has no indenting and libxml2 quotes the doctype differently, so skip those
+  QStringList docTokens = xmlTokens(docText);
+  QStringList streamTokens = xmlTokens(exporter.text());
+  const QRegularExpression keepRx(QSL("^(?!Characters:\\s*$|DTD:)"));
+  docTokens = docTokens.filter(keepRx);
+  streamTokens = streamTokens.filter(keepRx);
+  QVERIFY(!docTokens.isEmpty());
+  QCOMPARE(docTokens, streamTokens);
+}
+
+void TellicoReadTest::testLibXMLWriter_data() {
+  testStreamWriter_data();
+}
+
+void TellicoReadTest::testParallelEntries() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < 5000; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QSL("title"), QSL("Title %1 & <more>").arg(i));
+    entry->setField(QSL("author"), QSL("Author %1; Author %2").arg(i % 100).arg(i % 77));
+    entry->setField(QSL("pub_year"), QString::number(1900 + i % 120));
+    entry->setField(QSL("comments"), QString::fromUtf8("Überprüfung %1").arg(i));
+    entries.append(entry);
+  }
+  coll->addEntries(entries);
+
+  Tellico::Export::TellicoXMLExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setOptions(exporter.options() | Tellico::Export::ExportUTF8);
+  const QByteArray data = exporter.text().toUtf8();
+
+  Tellico::Import::TellicoXMLReader reader1(data);
+  QVERIFY(!reader1.read());
+  QVERIFY(!reader1.hasError());
+  Tellico::Data::CollPtr coll1 = reader1.collection();
+  QVERIFY(coll1);
+
+  Tellico::Import::TellicoXMLReader reader2(data);
+  reader2.setThreadCount(4);
+  while(reader2.read(data.size()/10)) {
+    QVERIFY(reader2.bytesRead() <= data.size());
+  }
+  QVERIFY(!reader2.hasError());
+  QCOMPARE(reader2.bytesRead(), qint64(data.size()));
+  Tellico::Data::CollPtr coll2 = reader2.collection();
+  QVERIFY(coll2);
+
+  QCOMPARE(coll2->entryCount(), coll->entryCount());
+  QCOMPARE(coll2->entryCount(), coll1->entryCount());
+  // entries are in document order
+  Tellico::Data::EntryList entries1 = coll1->entries();
+  Tellico::Data::EntryList entries2 = coll2->entries();
+  for(int i = 0; i < entries1.count(); ++i) {
+    QCOMPARE(entries2.at(i)->id(), entries1.at(i)->id());
+    QCOMPARE(entries2.at(i)->title(), entries1.at(i)->title());
+    QCOMPARE(entries2.at(i)->field(QSL("author")), entries1.at(i)->field(QSL("author")));
+    QCOMPARE(entries2.at(i)->field(QSL("comments")), entries1.at(i)->field(QSL("comments")));
+    QVERIFY(entries2.at(i)->collection() == coll2);
+  }
+  QCOMPARE(entries2.last()->title(), QSL("Title 4999 & <more>"));
+}
+
+void TellicoReadTest::testReadBenchmark() {
+  QFETCH(int, count);
+
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < count; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QSL("title"), QSL("Title %1").arg(i));
+    entry->setField(QSL("author"), QSL("Author %1; Author %2").arg(i % 100).arg(i % 77));
+    entry->setField(QSL("pub_year"), QString::number(1900 + i % 120));
+    entry->setField(QSL("keyword"), QSL("one; two; three"));
+    entries.append(entry);
+  }
+  coll->addEntries(entries);
+
+  Tellico::Export::TellicoXMLExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setOptions(exporter.options() | Tellico::Export::ExportUTF8);
+  const QString text = exporter.text();
+
+  QBENCHMARK {
+    Tellico::Import::TellicoImporter importer(text);
+    Tellico::Data::CollPtr coll2 = importer.collection();
+    QVERIFY(coll2);
+    QCOMPARE(coll2->entryCount(), count);
+  }
+}
+
+void TellicoReadTest::testReadBenchmark_data() {
+  QTest::addColumn<int>("count");
+
+  QTest::newRow("10k") << 10000;
+  // the larger documents take a while, only run them when asked to
+  if(!qEnvironmentVariableIsEmpty("TELLICO_LARGE_BENCHMARK")) {
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("500k") << 500000;
+  }
+}
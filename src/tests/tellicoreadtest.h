@@ -45,6 +45,7 @@ private Q_SLOTS:
   void testDuplicateLoans();
   void testDuplicateBorrowers();
   void testLocalImage();
+  void testZipExport();
   void testRemoteImage();
   void testXMLHandler();
   void testXMLHandler_data();
@@ -53,6 +54,13 @@ private Q_SLOTS:
   void testRecoverXmlName();
   void testRecoverXmlName_data();
   void testBug418067();
+  void testStreamWriter();
+  void testStreamWriter_data();
+  void testLibXMLWriter();
+  void testLibXMLWriter_data();
+  void testParallelEntries();
+  void testReadBenchmark();
+  void testReadBenchmark_data();
 
 private:
   QList<Tellico::Data::CollPtr> m_collections;
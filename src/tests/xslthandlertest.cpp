@@ -0,0 +1,94 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#undef QT_NO_CAST_FROM_ASCII
+
+#include "xslthandlertest.h"
+
+#include "../translators/xslthandler.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QUrl>
+
+QTEST_APPLESS_MAIN( XSLTHandlerTest )
+
+static void writeStylesheet(const QString& fileName_, const QString& prefix_) {
+  QFile f(fileName_);
+  QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  f.write("<xsl:stylesheet xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\" version=\"1.0\">"
+          "<xsl:output method=\"text\"/><xsl:param name=\"value\"/>"
+          "<xsl:template match=\"/\">" + prefix_.toUtf8() + "<xsl:value-of select=\"$value\"/></xsl:template>"
+          "</xsl:stylesheet>");
+}
+
+void XSLTHandlerTest::testStylesheetCache() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString fileName = dir.path() + QLatin1String("/test.xsl");
+  writeStylesheet(fileName, QStringLiteral("a"));
+
+  // handlers share the compiled stylesheet but not the params
+  Tellico::XSLTHandler handler1(QUrl::fromLocalFile(fileName));
+  Tellico::XSLTHandler handler2(QUrl::fromLocalFile(fileName));
+  QVERIFY(handler1.isValid());
+  QVERIFY(handler2.isValid());
+  handler1.addStringParam("value", "1");
+  handler2.addStringParam("value", "2");
+  QCOMPARE(handler1.applyStylesheet(QStringLiteral("<x/>")).trimmed(), QStringLiteral("a1"));
+  QCOMPARE(handler2.applyStylesheet(QStringLiteral("<x/>")).trimmed(), QStringLiteral("a2"));
+
+  // a changed file is compiled again, while handlers using the old stylesheet keep it
+  QTest::qSleep(1100);
+  writeStylesheet(fileName, QStringLiteral("b"));
+  Tellico::XSLTHandler handler3(fileName.toLocal8Bit());
+  QVERIFY(handler3.isValid());
+  handler3.addStringParam("value", "3");
+  QCOMPARE(handler3.applyStylesheet(QStringLiteral("<x/>")).trimmed(), QStringLiteral("b3"));
+  QCOMPARE(handler1.applyStylesheet(QStringLiteral("<x/>")).trimmed(), QStringLiteral("a1"));
+
+  Tellico::XSLTHandler::clearCache();
+  QVERIFY(handler3.isValid());
+  QCOMPARE(handler3.applyStylesheet(QStringLiteral("<x/>")).trimmed(), QStringLiteral("b3"));
+
+  // a change to an imported file is noticed, even though the importing file is the same
+  const QString importName = dir.path() + QLatin1String("/import.xsl");
+  QFile f(importName);
+  QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  f.write("<xsl:stylesheet xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\" version=\"1.0\">"
+          "<xsl:import href=\"test.xsl\"/></xsl:stylesheet>");
+  f.close();
+  Tellico::XSLTHandler handler4(QUrl::fromLocalFile(importName));
+  QVERIFY(handler4.isValid());
+  handler4.addStringParam("value", "4");
+  QCOMPARE(handler4.applyStylesheet(QStringLiteral("<x/>")).trimmed(), QStringLiteral("b4"));
+
+  QTest::qSleep(1100);
+  writeStylesheet(fileName, QStringLiteral("c"));
+  Tellico::XSLTHandler handler5(QUrl::fromLocalFile(importName));
+  QVERIFY(handler5.isValid());
+  handler5.addStringParam("value", "5");
+  QCOMPARE(handler5.applyStylesheet(QStringLiteral("<x/>")).trimmed(), QStringLiteral("c5"));
+}
@@ -25,6 +25,8 @@
 #include <config.h>
 
 #include "audiofileimporter.h"
+#include "filelistingcache.h"
+#include "translators.h" // needed for ImportAction
 #include "../collections/musiccollection.h"
 #include "../entry.h"
 #include "../field.h"
@@ -56,6 +58,15 @@
 #include <QTextStream>
 #include <QVBoxLayout>
 #include <QApplication>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSet>
+#include <QtConcurrentMap>
+
+namespace {
+  // files are read by the worker threads in batches, the tracks are added to the albums in between
+  static const int AUDIO_BATCH_SIZE = 200;
+}
 
 using Tellico::Import::AudioFileImporter;
 
@@ -64,7 +75,9 @@ AudioFileImporter::AudioFileImporter(const QUrl& url_) : Tellico::Import::Import
     , m_recursive(nullptr)
     , m_addFilePath(nullptr)
     , m_addBitrate(nullptr)
+    , m_skipUnchanged(nullptr)
     , m_cancelled(false)
+    , m_merging(false)
     , m_options(0){
 }
 
@@ -96,6 +109,140 @@ void AudioFileImporter::setAddBitrate(bool addBitrate_) {
   }
 }
 
+void AudioFileImporter::setSkipUnchanged(bool skipUnchanged_) {
+  if(skipUnchanged_) {
+    m_options |= SkipUnchanged;
+  } else {
+    m_options &= ~SkipUnchanged;
+  }
+}
+
+// everything needed from the file, read in a worker thread so no TagLib object leaves it
+struct AudioFileImporter::TrackInfo {
+  QString file;
+  qint64 size;
+  QDateTime modified;
+  bool valid;
+  QString album;
+  QString albumArtist;
+  bool albumArtistFromId3;
+  QString artist;
+  QString title;
+  bool hasTitle;
+  QString genre;
+  QString comment;
+  int year;
+  int track;
+  int disc;
+  int length;
+  int bitrate;
+};
+
+AudioFileImporter::TrackInfo AudioFileImporter::readTrack(const QString& file_) {
+  TrackInfo info;
+  info.file = file_;
+  const QFileInfo fileInfo(file_);
+  info.size = fileInfo.size();
+  info.modified = fileInfo.lastModified();
+  info.valid = false;
+  info.albumArtistFromId3 = false;
+  info.hasTitle = false;
+  info.year = 0;
+  info.track = 0;
+  info.disc = 1;
+  info.length = 0;
+  info.bitrate = 0;
+#ifdef HAVE_TAGLIB
+  TagLib::FileRef f(QFile::encodeName(file_).data());
+  if(f.isNull() || !f.tag()) {
+    return info;
+  }
+  info.valid = true;
+
+  TagLib::Tag* tag = f.tag();
+  info.album = TStringToQString(tag->album()).trimmed();
+  if(info.album.isEmpty()) {
+    return info;
+  }
+  info.disc = discNumber(f);
+
+/*
+    For MP3 files, get the Album Artist from the ID3v2 TPE2 frame.
+    See http://www.id3.org/id3v2.4.0-frames for a description of this frame.
+    Although this is not standard in ID3, using a specific frame for album
+    artist is a solution to the problem of tagging albums that feature
+    various artists but still have an identified Album Artist, such as
+    Remix and DJ albums. Example:
+    Album title: Some Title; Album artist: Some DJ;
+                 Track 1: Some Track Title - Some Artist(s);
+                 Track 2: Some Other Track Title - Some Other Artist(s), etc.
+    We read the Album Artist from the TPE2 frame to be compatible with
+    Amarok as the most popular music player by KDE, but also Apple (iTunes),
+    Microsoft (Windows Media Player) and others which use this frame to
+    read/write the album artist too.
+    See Amarok source file src/collectionscanner/CollectionScanner.cpp,
+    method AttributeHash CollectionScanner::readTags(...).
+*/
+/*  As mpeg implementation on TagLib uses a Tag class that's not defined on the headers,
+    we have to cast the files, not the tags!
+*/
+  TagLib::MPEG::File* mpegFile = dynamic_cast<TagLib::MPEG::File*>(f.file());
+  if(mpegFile && mpegFile->ID3v2Tag() && !mpegFile->ID3v2Tag()->frameListMap()["TPE2"].isEmpty()) {
+    info.albumArtist = TStringToQString(mpegFile->ID3v2Tag()->frameListMap()["TPE2"].front()->toString()).trimmed();
+    info.albumArtistFromId3 = !info.albumArtist.isEmpty();
+  }
+  if(info.albumArtist.isEmpty()) {
+    const TagLib::StringList albumArtists = f.file()->properties()["ALBUMARTIST"];
+    if(!albumArtists.isEmpty()) {
+      info.albumArtist = TStringToQString(albumArtists.front());
+    }
+  }
+
+  info.artist = TStringToQString(tag->artist()).trimmed();
+  info.year = tag->year();
+  if(!tag->genre().isEmpty()) {
+    info.genre = TStringToQString(tag->genre()).trimmed();
+  }
+  info.hasTitle = !tag->title().isEmpty();
+  info.title = TStringToQString(tag->title()).trimmed();
+  info.comment = TStringToQString(tag->comment().stripWhiteSpace());
+
+  info.track = tag->track();
+  if(info.hasTitle && info.track <= 0) { // try to figure out track number from file name
+    QString fileName = fileInfo.baseName();
+    QString numString;
+    int i = 0;
+    const int len = fileName.length();
+    while(i < len && fileName[i].isNumber()) {
+      i++;
+    }
+    if(i == 0) { // does not start with a number
+      i = len - 1;
+      while(i >= 0 && fileName[i].isNumber()) {
+        i--;
+      }
+      // file name ends with a number
+      if(i != len - 1) {
+        numString = fileName.mid(i + 1);
+      }
+    } else {
+      numString = fileName.mid(0, i);
+    }
+    bool ok;
+    int number = numString.toInt(&ok);
+    if(ok) {
+      info.track = number;
+    }
+  }
+
+  if(f.audioProperties()) {
+    info.length = f.audioProperties()->length();
+    info.bitrate = f.audioProperties()->bitrate();
+  }
+#endif
+  return info;
+}
+
 Tellico::Data::CollPtr AudioFileImporter::collection() {
 #ifndef HAVE_TAGLIB
   return Data::CollPtr();
@@ -108,6 +255,7 @@ Tellico::Data::CollPtr AudioFileImporter::collection() {
   if(m_recursive) setRecursive(m_recursive->isChecked());
   if(m_addFilePath) setAddFilePath(m_addFilePath->isChecked());
   if(m_addBitrate) setAddBitrate(m_addBitrate->isChecked());
+  if(m_skipUnchanged) setSkipUnchanged(m_skipUnchanged->isChecked());
 
   ProgressItem& item = ProgressManager::self()->newProgressItem(this, i18n("Scanning audio files..."), true);
   item.setTotalSteps(100);
@@ -148,8 +296,6 @@ Tellico::Data::CollPtr AudioFileImporter::collection() {
     return Data::CollPtr();
   }
 
-  item.setTotalSteps(files.count());
-
   const QString title    = QStringLiteral("title");
   const QString artist   = QStringLiteral("artist");
   const QString year     = QStringLiteral("year");
@@ -158,11 +304,41 @@ Tellico::Data::CollPtr AudioFileImporter::collection() {
   const QString comments = QStringLiteral("comments");
   const QString file     = QStringLiteral("file");
 
-  m_coll = new Data::MusicCollection(true);
-
   const bool addFile = m_options & AddFilePath;
   const bool addBitrate = m_options & AddBitrate;
 
+  // the sizes and times of the files from the last import are kept, and any file which still
+  // matches and is still in the current collection doesn't need to be read again
+  QStringList directoryFiles;
+  FileListingCache scanCache(FileListingCache::cacheFileName(url(), QStringLiteral("audiofile")));
+  if(addFile && (m_options & SkipUnchanged) && currentCollection() && currentCollection()->hasField(file)) {
+    scanCache.load();
+    QSet<QString> knownFiles;
+    foreach(Data::EntryPtr entry, currentCollection()->entries()) {
+      foreach(const QString& row, FieldFormat::splitTable(entry->field(file))) {
+        knownFiles.insert(FieldFormat::splitRow(row).first());
+      }
+    }
+    QStringList changedFiles;
+    foreach(const QString& path, files) {
+      if(path.endsWith(QLatin1String("/.directory"))) {
+        // directory files are cheap, and the album might need the cover
+        directoryFiles += path;
+        continue;
+      }
+      const QFileInfo fi(path);
+      if(!knownFiles.contains(path) || !scanCache.lookup(path, fi.size(), fi.lastModified(), nullptr)) {
+        changedFiles += path;
+      }
+    }
+    myLog() << "Skipping" << (files.count() - changedFiles.count() - directoryFiles.count()) << "unchanged audio files";
+    files = changedFiles;
+  }
+
+  item.setTotalSteps(files.count());
+
+  m_coll = new Data::MusicCollection(true);
+
   Data::FieldPtr f;
   if(addFile) {
     f = m_coll->fieldByName(file);
@@ -181,197 +357,143 @@ Tellico::Data::CollPtr AudioFileImporter::collection() {
 
   QHash<QString, Data::EntryPtr> albumMap;
 
-  QStringList directoryFiles;
   const uint stepSize = qMax(1, files.count() / 100);
 
   bool changeTrackTitle = true;
   uint j = 0;
-  for(QStringList::ConstIterator it = files.constBegin(); !m_cancelled && it != files.constEnd(); ++it, ++j) {
-    TagLib::FileRef f(QFile::encodeName(*it).data());
-    if(f.isNull() || !f.tag()) {
-      if((*it).endsWith(QLatin1String("/.directory"))) {
-        directoryFiles += *it;
+  // while the tracks in one batch are added to the albums, the workers read the next batch
+  QFuture<TrackInfo> nextBatch = QtConcurrent::mapped(files.mid(0, AUDIO_BATCH_SIZE), readTrack);
+  for(int pos = 0; !m_cancelled && pos < files.count(); pos += AUDIO_BATCH_SIZE) {
+    nextBatch.waitForFinished();
+    const QList<TrackInfo> batch = nextBatch.results();
+    nextBatch = QtConcurrent::mapped(files.mid(pos + AUDIO_BATCH_SIZE, AUDIO_BATCH_SIZE), readTrack);
+
+    for(QList<TrackInfo>::ConstIterator it = batch.constBegin(); !m_cancelled && it != batch.constEnd(); ++it, ++j) {
+      const TrackInfo& info = *it;
+      if(!info.valid) {
+        if(info.file.endsWith(QLatin1String("/.directory"))) {
+          directoryFiles += info.file;
+        }
+        continue;
+      }
+      if(addFile) {
+        scanCache.insert(info.file, info.size, info.modified, QString());
       }
-      continue;
-    }
 
-    TagLib::Tag* tag = f.tag();
-    QString album = TStringToQString(tag->album()).trimmed();
-    if(album.isEmpty()) {
-      // can't do anything since tellico entries are by album
-      myWarning() << "Skipping: no album listed for " << *it;
-      continue;
-    }
-    int disc = discNumber(f);
-    if(disc > 1 && !m_coll->hasField(QStringLiteral("track%1").arg(disc))) {
-      Data::FieldPtr f2(new Data::Field(QStringLiteral("track%1").arg(disc),
-                                        i18n("Tracks (Disc %1)", disc),
-                                        Data::Field::Table));
-      f2->setFormatType(FieldFormat::FormatTitle);
-      f2->setProperty(QStringLiteral("columns"), QStringLiteral("3"));
-      f2->setProperty(QStringLiteral("column1"), i18n("Title"));
-      f2->setProperty(QStringLiteral("column2"), i18n("Artist"));
-      f2->setProperty(QStringLiteral("column3"), i18n("Length"));
-      m_coll->addField(f2);
-      if(changeTrackTitle) {
-        Data::FieldPtr newTrack(new Data::Field(*m_coll->fieldByName(track)));
-        newTrack->setTitle(i18n("Tracks (Disc %1)", 1));
-        m_coll->modifyField(newTrack);
-        changeTrackTitle = false;
+      if(info.album.isEmpty()) {
+        // can't do anything since tellico entries are by album
+        myWarning() << "Skipping: no album listed for " << info.file;
+        continue;
       }
-    }
-    bool exists = true;
-    Data::EntryPtr entry;
+      const int disc = info.disc;
+      if(disc > 1 && !m_coll->hasField(QStringLiteral("track%1").arg(disc))) {
+        Data::FieldPtr f2(new Data::Field(QStringLiteral("track%1").arg(disc),
+                                          i18n("Tracks (Disc %1)", disc),
+                                          Data::Field::Table));
+        f2->setFormatType(FieldFormat::FormatTitle);
+        f2->setProperty(QStringLiteral("columns"), QStringLiteral("3"));
+        f2->setProperty(QStringLiteral("column1"), i18n("Title"));
+        f2->setProperty(QStringLiteral("column2"), i18n("Artist"));
+        f2->setProperty(QStringLiteral("column3"), i18n("Length"));
+        m_coll->addField(f2);
+        if(changeTrackTitle) {
+          Data::FieldPtr newTrack(new Data::Field(*m_coll->fieldByName(track)));
+          newTrack->setTitle(i18n("Tracks (Disc %1)", 1));
+          m_coll->modifyField(newTrack);
+          changeTrackTitle = false;
+        }
+      }
+      bool exists = true;
+      Data::EntryPtr entry;
 /*
-    Let's assume an album already exists (has already been imported) if an
-    album entry with same Album Title and Album Artist is found; indeed,
-    multiple albums can have the same title (but from different artists),
-    but this is very unlikely the same artist release multiple albums with
-    the same title. Therefore, we propose to make an album entry ID as follows:
-    "<album title>::<album artist>" if album artist info is available,
-    "<album title>" if not.
+      Let's assume an album already exists (has already been imported) if an
+      album entry with same Album Title and Album Artist is found; indeed,
+      multiple albums can have the same title (but from different artists),
+      but this is very unlikely the same artist release multiple albums with
+      the same title. Therefore, we propose to make an album entry ID as follows:
+      "<album title>::<album artist>" if album artist info is available,
+      "<album title>" if not.
 */
-    QString albumKey = album.toLower();
-/*
-    For MP3 files, get the Album Artist from the ID3v2 TPE2 frame.
-    See http://www.id3.org/id3v2.4.0-frames for a description of this frame.
-    Although this is not standard in ID3, using a specific frame for album
-    artist is a solution to the problem of tagging albums that feature
-    various artists but still have an identified Album Artist, such as
-    Remix and DJ albums. Example:
-    Album title: Some Title; Album artist: Some DJ;
-                 Track 1: Some Track Title - Some Artist(s);
-                 Track 2: Some Other Track Title - Some Other Artist(s), etc.
-    We read the Album Artist from the TPE2 frame to be compatible with
-    Amarok as the most popular music player by KDE, but also Apple (iTunes),
-    Microsoft (Windows Media Player) and others which use this frame to
-    read/write the album artist too.
-    See Amarok source file src/collectionscanner/CollectionScanner.cpp,
-    method AttributeHash CollectionScanner::readTags(...).
-*/
-    // TODO: find another way for non-MP3 files
-    QString albumArtist;
-/*  As mpeg implementation on TagLib uses a Tag class that's not defined on the headers,
-    we have to cast the files, not the tags!
-*/
-    TagLib::MPEG::File* mpegFile = dynamic_cast<TagLib::MPEG::File*>(f.file());
-    if(mpegFile && mpegFile->ID3v2Tag() && !mpegFile->ID3v2Tag()->frameListMap()["TPE2"].isEmpty()) {
-      albumArtist = TStringToQString(mpegFile->ID3v2Tag()->frameListMap()["TPE2"].front()->toString()).trimmed();
-      if(!albumArtist.isEmpty()) {
-        albumKey += FieldFormat::columnDelimiterString() + albumArtist.toLower();
+      QString albumKey = info.album.toLower();
+      // TODO: find another way for non-MP3 files
+      if(info.albumArtistFromId3) {
+        albumKey += FieldFormat::columnDelimiterString() + info.albumArtist.toLower();
       }
-    }
-    if(albumArtist.isEmpty()) {
-      albumArtist = TStringToQString(f.file()->properties()["ALBUMARTIST"].front());
-    }
 
-    entry = albumMap[albumKey];
-    if(!entry) {
-      entry = Data::EntryPtr(new Data::Entry(m_coll));
-      albumMap.insert(albumKey, entry);
-      exists = false;
-    }
-    // album entries use the album name as the title
-    entry->setField(title, album);
-    QString a = TStringToQString(tag->artist()).trimmed();
-    // If no album artist identified, we use track artist as album artist, or "(Various)" if tracks have various artists.
-    if(!albumArtist.isEmpty()) {
-      entry->setField(artist, albumArtist);
-    } else if(!a.isEmpty()) {
-      if(exists && entry->field(artist).toLower() != a.toLower()) {
-        entry->setField(artist, i18n("(Various)"));
-      } else {
-        entry->setField(artist, a);
+      entry = albumMap[albumKey];
+      if(!entry) {
+        entry = Data::EntryPtr(new Data::Entry(m_coll));
+        albumMap.insert(albumKey, entry);
+        exists = false;
       }
-    }
-    if(tag->year() > 0) {
-      entry->setField(year, QString::number(tag->year()));
-    }
-    if(!tag->genre().isEmpty()) {
-      entry->setField(genre, TStringToQString(tag->genre()).trimmed());
-    }
-
-    if(!tag->title().isEmpty()) {
-      int trackNum = tag->track();
-      if(trackNum <= 0) { // try to figure out track number from file name
-        QFileInfo f(*it);
-        QString fileName = f.baseName();
-        QString numString;
-        int i = 0;
-        const int len = fileName.length();
-        while(fileName[i].isNumber() && i < len) {
-          i++;
+      // album entries use the album name as the title
+      entry->setField(title, info.album);
+      const QString& a = info.artist;
+      // If no album artist identified, we use track artist as album artist, or "(Various)" if tracks have various artists.
+      if(!info.albumArtist.isEmpty()) {
+        entry->setField(artist, info.albumArtist);
+      } else if(!a.isEmpty()) {
+        if(exists && entry->field(artist).toLower() != a.toLower()) {
+          entry->setField(artist, i18n("(Various)"));
+        } else {
+          entry->setField(artist, a);
         }
-        if(i == 0) { // does not start with a number
-          i = len - 1;
-          while(i >= 0 && fileName[i].isNumber()) {
-            i--;
+      }
+      if(info.year > 0) {
+        entry->setField(year, QString::number(info.year));
+      }
+      if(!info.genre.isEmpty()) {
+        entry->setField(genre, info.genre);
+      }
+
+      if(info.hasTitle) {
+        const int trackNum = info.track;
+        if(trackNum > 0) {
+          QString t = info.title;
+          t += FieldFormat::columnDelimiterString() + a;
+          if(info.length > 0) {
+            t += FieldFormat::columnDelimiterString() + Tellico::minutes(info.length);
           }
-          // file name ends with a number
-          if(i != len - 1) {
-            numString = fileName.mid(i + 1);
+          QString realTrack = disc > 1 ? track + QString::number(disc) : track;
+          entry->setField(realTrack, insertValue(entry->field(realTrack), t, trackNum));
+          if(addFile) {
+            QString fileValue = info.file;
+            if(addBitrate) {
+              fileValue += FieldFormat::columnDelimiterString() + QString::number(info.bitrate);
+            }
+            entry->setField(file, insertValue(entry->field(file), fileValue, trackNum));
           }
         } else {
-          numString = fileName.mid(0, i);
-        }
-        bool ok;
-        int number = numString.toInt(&ok);
-        if(ok) {
-          trackNum = number;
+          myDebug() << info.file << " contains no track number and track number cannot be determined, so the track is not imported.";
         }
+      } else {
+        myDebug() << info.file << " has an empty title, so the track is not imported.";
       }
-      if(trackNum > 0) {
-        QString t = TStringToQString(tag->title()).trimmed();
-        t += FieldFormat::columnDelimiterString() + a;
-        const int len = f.audioProperties()->length();
-        if(len > 0) {
-          t += FieldFormat::columnDelimiterString() + Tellico::minutes(len);
+      if(!info.comment.isEmpty()) {
+        QString c = entry->field(comments);
+        if(!c.isEmpty()) {
+          c += QLatin1String("<br/>");
         }
-        QString realTrack = disc > 1 ? track + QString::number(disc) : track;
-        entry->setField(realTrack, insertValue(entry->field(realTrack), t, trackNum));
-        if(addFile) {
-          QString fileValue = *it;
-          if(addBitrate) {
-            fileValue += FieldFormat::columnDelimiterString() + QString::number(f.audioProperties()->bitrate());
-          }
-          entry->setField(file, insertValue(entry->field(file), fileValue, trackNum));
+        if(info.hasTitle) {
+          c += QLatin1String("<em>") + info.title + QLatin1String("</em> - ");
         }
-      } else {
-        myDebug() << *it << " contains no track number and track number cannot be determined, so the track is not imported.";
+        c += info.comment;
+        entry->setField(comments, c);
       }
-    } else {
-      myDebug() << *it << " has an empty title, so the track is not imported.";
-    }
-    if(!tag->comment().stripWhiteSpace().isEmpty()) {
-      QString c = entry->field(comments);
-      if(!c.isEmpty()) {
-        c += QLatin1String("<br/>");
+
+      if(!exists) {
+        m_coll->addEntries(entry);
       }
-      if(!tag->title().isEmpty()) {
-        c += QLatin1String("<em>") + TStringToQString(tag->title()).trimmed() + QLatin1String("</em> - ");
+      if(showProgress && j%stepSize == 0) {
+        ProgressManager::self()->setTotalSteps(this, files.count() + directoryFiles.count());
+        ProgressManager::self()->setProgress(this, j);
+        qApp->processEvents();
       }
-      c += TStringToQString(tag->comment().stripWhiteSpace());
-      entry->setField(comments, c);
-    }
-
-    if(!exists) {
-      m_coll->addEntries(entry);
-    }
-    if(showProgress && j%stepSize == 0) {
-      ProgressManager::self()->setTotalSteps(this, files.count() + directoryFiles.count());
-      ProgressManager::self()->setProgress(this, j);
-      qApp->processEvents();
     }
-
-/*    myDebug() << "-- TAG --";
-    myDebug() << "title   - \"" << tag->title().to8Bit()   << "\"";
-    myDebug() << "artist  - \"" << tag->artist().to8Bit()  << "\"";
-    myDebug() << "album   - \"" << tag->album().to8Bit()   << "\"";
-    myDebug() << "year    - \"" << tag->year()             << "\"";
-    myDebug() << "comment - \"" << tag->comment().to8Bit() << "\"";
-    myDebug() << "track   - \"" << tag->track()            << "\"";
-    myDebug() << "genre   - \"" << tag->genre().to8Bit()   << "\"";*/
   }
+  // the last batch might still be running, if the import was cancelled
+  nextBatch.cancel();
+  nextBatch.waitForFinished();
 
   if(m_cancelled) {
     m_coll = Data::CollPtr();
@@ -414,6 +536,8 @@ Tellico::Data::CollPtr AudioFileImporter::collection() {
 
   if(m_cancelled) {
     m_coll = Data::CollPtr();
+  } else if(addFile) {
+    scanCache.save();
   }
 
   return m_coll;
@@ -446,9 +570,17 @@ QWidget* AudioFileImporter::widget(QWidget* parent_) {
   m_addBitrate->setChecked(false);
   m_addBitrate->setEnabled(false);
 
+  m_skipUnchanged = new QCheckBox(i18n("Only import &changed files"), gbox);
+  m_skipUnchanged->setWhatsThis(i18n("If checked, files which are already in the current collection and have not "
+                                     "changed since the last import are skipped. This is only available when "
+                                     "merging the import into the current collection."));
+  m_skipUnchanged->setChecked(false);
+  m_skipUnchanged->setEnabled(false);
+
   vlay->addWidget(m_recursive);
   vlay->addWidget(m_addFilePath);
   vlay->addWidget(m_addBitrate);
+  vlay->addWidget(m_skipUnchanged);
 
   l->addWidget(gbox);
   l->addStretch(1);
@@ -474,14 +606,32 @@ void AudioFileImporter::slotCancel() {
   m_cancelled = true;
 }
 
+void AudioFileImporter::slotActionChanged(int action_) {
+  // replacing or appending needs every file, the skipped ones would be missing or duplicated
+  m_merging = (action_ == Import::Merge);
+  updateSkipUnchanged();
+}
+
 void AudioFileImporter::slotAddFileToggled(bool on_) {
   m_addBitrate->setEnabled(on_);
   if(!on_) {
     m_addBitrate->setChecked(false);
   }
+  updateSkipUnchanged();
+}
+
+void AudioFileImporter::updateSkipUnchanged() {
+  if(!m_skipUnchanged) {
+    return;
+  }
+  const bool enable = m_merging && m_addFilePath->isChecked();
+  m_skipUnchanged->setEnabled(enable);
+  if(!enable) {
+    m_skipUnchanged->setChecked(false);
+  }
 }
 
-int AudioFileImporter::discNumber(const TagLib::FileRef& ref_) const {
+int AudioFileImporter::discNumber(const TagLib::FileRef& ref_) {
   // default to 1 unless otherwise
   int num = 1;
 #ifdef HAVE_TAGLIB
@@ -40,6 +40,11 @@ namespace Tellico {
 /**
  * The AudioFileImporter class takes care of importing audio files.
  *
+ * The tags of the files are read by worker threads, a batch at a time, and the album entries
+ * are built from the tracks in the order of the files, so the result doesn't depend on which
+ * thread finished first. When only the changed files are imported, any file already in the
+ * current collection whose size and modification time match the last import is not read again.
+ *
  * @author Robby Stephenson
  */
 class AudioFileImporter : public Importer {
@@ -48,7 +53,8 @@ Q_OBJECT
 enum AudioFileImporterOptions {
   Recursive    = 1 << 0,
   AddFilePath  = 1 << 1,
-  AddBitrate   = 1 << 2
+  AddBitrate   = 1 << 2,
+  SkipUnchanged = 1 << 3
 };
 
 public:
@@ -67,22 +73,35 @@ public:
   void setRecursive(bool recursive);
   void setAddFilePath(bool addFilePath);
   void setAddBitrate(bool addBitrate);
+  /**
+   * Only read files which are new or have changed since the last import, which
+   * requires the file location to be included. The unchanged files are left out of the
+   * result entirely, so it is only useful when the import is merged into the current collection.
+   */
+  void setSkipUnchanged(bool skipUnchanged);
 
 public Q_SLOTS:
+  void slotActionChanged(int action) Q_DECL_OVERRIDE;
   void slotCancel() Q_DECL_OVERRIDE;
   void slotAddFileToggled(bool on);
 
 private:
+  struct TrackInfo;
+  // runs in a worker thread
+  static TrackInfo readTrack(const QString& file);
   static QString insertValue(const QString& str, const QString& value, int pos);
 
-  int discNumber(const TagLib::FileRef& file) const;
+  static int discNumber(const TagLib::FileRef& file);
+  void updateSkipUnchanged();
 
   Data::CollPtr m_coll;
   QWidget* m_widget;
   QCheckBox* m_recursive;
   QCheckBox* m_addFilePath;
   QCheckBox* m_addBitrate;
+  QCheckBox* m_skipUnchanged;
   bool m_cancelled;
+  bool m_merging;
   int m_options;
 };
 
@@ -42,6 +42,67 @@
 #include <QButtonGroup>
 #include <QFile>
 #include <QApplication>
+#include <QPair>
+#include <QtConcurrentMap>
+
+namespace {
+  // the nodes are converted to entries in chunks, so progress can be shown in between
+  static const int BIBTEX_CHUNK_SIZE = 1000;
+
+  struct ParsedEntry {
+    QString type;
+    QString key;
+    QVector<QPair<QString, QString> > fields;
+  };
+
+  // reading the values only walks the nodes, which btparse does without any global state,
+  // so the nodes can be read from several threads at once
+  ParsedEntry parseEntry(AST* node_) {
+    ParsedEntry entry;
+    if(bt_entry_metatype(node_) != BTE_REGULAR) {
+      return entry;
+    }
+    entry.type = QString::fromUtf8(bt_entry_type(node_));
+    entry.key = QString::fromUtf8(bt_entry_key(node_));
+
+    const QRegExp andRx(QLatin1String("\\sand\\s"));
+    char* name;
+    AST* field = nullptr;
+    while((field = bt_next_field(node_, field, &name))) {
+//      myDebug() << "\tfound: " << name;
+      QString str;
+      AST* value = nullptr;
+      bt_nodetype type;
+      char* svalue;
+      bool end_macro = false;
+      while((value = bt_next_value(field, value, &type, &svalue))) {
+        switch(type) {
+          case BTAST_STRING:
+          case BTAST_NUMBER:
+            str += Tellico::BibtexHandler::importText(svalue).simplified();
+            end_macro = false;
+            break;
+          case BTAST_MACRO:
+            str += QString::fromUtf8(svalue) + QLatin1Char('#');
+            end_macro = true;
+            break;
+          default:
+            break;
+        }
+      }
+      if(end_macro) {
+        // remove last character '#'
+        str.truncate(str.length() - 1);
+      }
+      QString fieldName = QString::fromUtf8(name);
+      if(fieldName == QLatin1String("author") || fieldName == QLatin1String("editor")) {
+        str.replace(andRx, Tellico::FieldFormat::delimiterString());
+      }
+      entry.fields.append(qMakePair(fieldName, str));
+    }
+    return entry;
+  }
+}
 
 using namespace Tellico;
 using Tellico::Import::BibtexImporter;
@@ -146,7 +207,6 @@ Tellico::Data::CollPtr BibtexImporter::readCollection(const QString& text, int u
     return Data::CollPtr();
   }
 
-  QString str;
   const uint count = m_nodes.count();
   const uint stepSize = qMax(s_stepSize, count/100);
   const bool showProgress = options() & ImportProgress;
@@ -156,92 +216,73 @@ Tellico::Data::CollPtr BibtexImporter::readCollection(const QString& text, int u
     currentColl = ptr;
   }
 
+  // load the translation maps, or record that they are missing, before fanning out
+  // so none of the worker threads ever has to try
+  BibtexHandler::loadTranslationMaps();
+
   uint j = 0;
-  for(int i = 0; !m_cancelled && i < m_nodes.count(); ++i, ++j) {
-    AST* node = m_nodes[i];
-    // if we're parsing a macro string, comment or preamble, skip it for now
-    if(bt_entry_metatype(node) == BTE_PREAMBLE) {
-      char* preamble = bt_get_text(node);
-      if(preamble) {
-        c->setPreamble(QString::fromUtf8(preamble));
+  for(int start = 0; !m_cancelled && start < m_nodes.count(); start += BIBTEX_CHUNK_SIZE) {
+    // the values of the entries are read from the nodes in parallel, but anything
+    // that changes the collection is done here, in the order of the file
+    const QList<AST*> chunk = m_nodes.mid(start, BIBTEX_CHUNK_SIZE);
+    const QList<ParsedEntry> parsed = QtConcurrent::blockingMapped<QList<ParsedEntry> >(chunk, parseEntry);
+
+    Data::EntryList entries;
+    for(int i = 0; !m_cancelled && i < chunk.count(); ++i, ++j) {
+      AST* node = chunk.at(i);
+      // if we're parsing a macro string, comment or preamble, skip it for now
+      if(bt_entry_metatype(node) == BTE_PREAMBLE) {
+        char* preamble = bt_get_text(node);
+        if(preamble) {
+          c->setPreamble(QString::fromUtf8(preamble));
+        }
+        continue;
       }
-      continue;
-    }
-
-    if(bt_entry_metatype(node) == BTE_MACRODEF) {
-      char* macro;
-      (void) bt_next_field(node, nullptr, &macro);
-      // FIXME: replace macros within macro definitions!
-      // lookup lowercase macro in map
-      c->addMacro(m_macros[QString::fromUtf8(macro)], QString::fromUtf8(bt_macro_text(macro, nullptr, 0)));
-      continue;
-    }
-
-    if(bt_entry_metatype(node) == BTE_COMMENT) {
-      continue;
-    }
-
-    // now we're parsing a regular entry
-    Data::EntryPtr entry(new Data::Entry(ptr));
 
-    str = QString::fromUtf8(bt_entry_type(node));
-//    myDebug() << "entry type: " << str;
-    // text is automatically put into lower-case by btparse
-    Data::BibtexCollection::setFieldValue(entry, QStringLiteral("entry-type"), str, currentColl);
+      if(bt_entry_metatype(node) == BTE_MACRODEF) {
+        char* macro;
+        (void) bt_next_field(node, nullptr, &macro);
+        // FIXME: replace macros within macro definitions!
+        // lookup lowercase macro in map
+        c->addMacro(m_macros[QString::fromUtf8(macro)], QString::fromUtf8(bt_macro_text(macro, nullptr, 0)));
+        continue;
+      }
 
-    str = QString::fromUtf8(bt_entry_key(node));
-//    myDebug() << "entry key: " << str;
-    Data::BibtexCollection::setFieldValue(entry, QStringLiteral("key"), str, currentColl);
+      if(bt_entry_metatype(node) == BTE_COMMENT) {
+        continue;
+      }
 
-    char* name;
-    AST* field = nullptr;
-    while((field = bt_next_field(node, field, &name))) {
-//      myDebug() << "\tfound: " << name;
-//      str = QLatin1String(bt_get_text(field));
-      str.clear();
-      AST* value = nullptr;
-      bt_nodetype type;
-      char* svalue;
-      bool end_macro = false;
-      while((value = bt_next_value(field, value, &type, &svalue))) {
-        switch(type) {
-          case BTAST_STRING:
-          case BTAST_NUMBER:
-            str += BibtexHandler::importText(svalue).simplified();
-            end_macro = false;
-            break;
-          case BTAST_MACRO:
-            str += QString::fromUtf8(svalue) + QLatin1Char('#');
-            end_macro = true;
-            break;
-          default:
-            break;
+      // now we're parsing a regular entry
+      const ParsedEntry& parsedEntry = parsed.at(i);
+      Data::EntryPtr entry(new Data::Entry(ptr));
+
+//      myDebug() << "entry type: " << parsedEntry.type;
+      // text is automatically put into lower-case by btparse
+      Data::BibtexCollection::setFieldValue(entry, QStringLiteral("entry-type"), parsedEntry.type, currentColl);
+//      myDebug() << "entry key: " << parsedEntry.key;
+      Data::BibtexCollection::setFieldValue(entry, QStringLiteral("key"), parsedEntry.key, currentColl);
+
+      for(int k = 0; k < parsedEntry.fields.count(); ++k) {
+        const QString& fieldName = parsedEntry.fields.at(k).first;
+        const QString& value = parsedEntry.fields.at(k).second;
+        // there's a 'key' field different from the citation key
+        // https://nwalsh.com/tex/texhelp/bibtx-37.html
+        // TODO account for this later
+        if(fieldName == QLatin1String("key")) {
+          myLog() << "skipping bibtex 'key' field for" << value;
+        } else {
+          Data::BibtexCollection::setFieldValue(entry, fieldName, value, currentColl);
         }
       }
-      if(end_macro) {
-        // remove last character '#'
-        str.truncate(str.length() - 1);
-      }
-      QString fieldName = QString::fromUtf8(name);
-      if(fieldName == QLatin1String("author") || fieldName == QLatin1String("editor")) {
-        str.replace(QRegExp(QLatin1String("\\sand\\s")),FieldFormat::delimiterString());
-      }
-      // there's a 'key' field different from the citation key
-      // https://nwalsh.com/tex/texhelp/bibtx-37.html
-      // TODO account for this later
-      if(fieldName == QLatin1String("key")) {
-        myLog() << "skipping bibtex 'key' field for" << str;
-      } else {
-        Data::BibtexCollection::setFieldValue(entry, fieldName, str, currentColl);
-      }
-    }
 
-    ptr->addEntries(entry);
+      entries += entry;
 
-    if(showProgress && j%stepSize == 0) {
-      emit signalProgress(this, urlCount*100 + 100*j/count);
-      qApp->processEvents();
+      if(showProgress && j%stepSize == 0) {
+        emit signalProgress(this, urlCount*100 + 100*j/count);
+        qApp->processEvents();
+      }
     }
+    ptr->addEntries(entries);
   }
 
   if(m_cancelled) {
@@ -268,32 +309,48 @@ void BibtexImporter::parseText(const QString& text) {
   bt_set_stringopts(BTE_MACRODEF, 0);
 //  bt_set_stringopts(BTE_PREAMBLE, BTO_CONVERT | BTO_EXPAND);
 
-  QString entry;
-  QRegExp rx(QLatin1String("[{}]"));
+  // All the downstream text processing on the AST node will assume utf-8
+  // The text is converted once, and each entry is parsed in place, by ending it
+  // with a null byte only while btparse reads it
+  QByteArray data = text.toUtf8();
+  char* buffer = data.data();
+  const int size = data.size();
+  QByteArray filename = QFile::encodeName(url().fileName());
+
   QRegExp macroName(QLatin1String("@string\\s*\\{\\s*(.*)="), Qt::CaseInsensitive);
   macroName.setMinimal(true);
 
+  // one pass over the bytes finds the end of every entry and keeps track of the line number
   int line = 1;
+  int entryLine = 1;
   bool needsCleanup = false;
   int brace = 0;
   int startpos = 0;
-  int pos = rx.indexIn(text, 0);
-  while(pos > 0 && !m_cancelled) {
-    if(text[pos] == QLatin1Char('{')) {
+  for(int pos = 0; pos < size && !m_cancelled; ++pos) {
+    const char ch = buffer[pos];
+    if(ch == '\n') {
+      ++line;
+      continue;
+    } else if(ch == '{') {
       ++brace;
-    } else if(text[pos] == QLatin1Char('}') && brace > 0) {
-      --brace;
+    } else if(ch == '}') {
+      if(brace > 0) {
+        --brace;
+      }
+    } else {
+      continue;
     }
     if(brace == 0) {
-      entry = text.mid(startpos, pos-startpos+1);
-      // All the downstream text processing on the AST node will assume utf-8
-      QByteArray entryText = entry.toUtf8();
-      QByteArray filename = QFile::encodeName(url().fileName());
-      AST* node = bt_parse_entry_s(entryText.data(),
+      // the byte after the end of the data is always a null, so this is safe for the last entry
+      const char next = buffer[pos+1];
+      buffer[pos+1] = '\0';
+      AST* node = bt_parse_entry_s(buffer + startpos,
                                    filename.data(),
-                                   line, bt_options, &ok);
+                                   entryLine, bt_options, &ok);
+      buffer[pos+1] = next;
       if(ok && node) {
-        if(bt_entry_metatype(node) == BTE_MACRODEF && macroName.indexIn(entry) > -1) {
+        if(bt_entry_metatype(node) == BTE_MACRODEF &&
+           macroName.indexIn(QString::fromUtf8(buffer + startpos, pos-startpos+1)) > -1) {
           char* macro;
           (void) bt_next_field(node, nullptr, &macro);
           m_macros.insert(QString::fromUtf8(macro), macroName.cap(1).trimmed());
@@ -302,9 +359,8 @@ void BibtexImporter::parseText(const QString& text) {
         needsCleanup = true;
       }
       startpos = pos+1;
-      line += entry.count(QLatin1Char('\n'));
+      entryLine = line;
     }
-    pos = rx.indexIn(text, pos+1);
   }
   if(needsCleanup) {
     // clean up some structures
@@ -31,6 +31,7 @@
 #include "../collectionfactory.h"
 #include "../gui/collectiontypecombo.h"
 #include "../utils/stringset.h"
+#include "../utils/string_utils.h"
 
 #include <KComboBox>
 #include <KSharedConfig>
@@ -54,10 +55,133 @@
 #include <QHBoxLayout>
 #include <QButtonGroup>
 #include <QApplication>
+#include <QIODevice>
+#include <QTextCodec>
+#include <QHash>
+#include <QtConcurrentRun>
+#include <QtConcurrentMap>
+
+namespace {
+  // rows are read, converted to entries, and added to the collection in batches
+  static const int CSV_ROW_BATCH_SIZE = 2000;
+}
 
 using Tellico::Import::CSVImporter;
 
-CSVImporter::CSVImporter(const QUrl& url_) : Tellico::Import::TextImporter(url_),
+namespace {
+  enum SpecialValue { NoSpecial, LibraryThingIsbn, LibraryThingKeyword, LibraryThingDate };
+
+  struct ColumnInfo {
+    int col;
+    Tellico::Data::FieldPtr field;
+    SpecialValue special;
+  };
+
+  // a batch of rows from the parser, along with how far into the text the parser got
+  struct RowBatch {
+    QList<QStringList> rows;
+    qint64 position;
+  };
+
+  RowBatch readRows(Tellico::CSVParser* parser_, QIODevice* device_, qint64 position_) {
+    RowBatch batch;
+    batch.position = position_;
+    while(batch.rows.count() < CSV_ROW_BATCH_SIZE && parser_->hasNext()) {
+      batch.rows += parser_->nextTokens();
+      if(!device_) {
+        foreach(const QString& value, batch.rows.last()) {
+          batch.position += value.size();
+        }
+      }
+    }
+    if(device_) {
+      batch.position = device_->pos();
+    }
+    return batch;
+  }
+
+  struct ConvertedRow {
+    Tellico::Data::EntryPtr entry;
+    bool empty;
+    // choice values which are not allowed yet, they get added when the entry is committed
+    QList<Tellico::Data::FieldPtr> rejectedFields;
+    QStringList rejectedValues;
+  };
+
+  // builds an entry from a row of values, which only reads from the collection
+  // so rows can be converted in parallel as long as the fields are not modified
+  class RowConverter {
+  public:
+    typedef ConvertedRow result_type;
+
+    RowConverter(Tellico::Data::CollPtr coll_, const QVector<ColumnInfo>& columns_,
+                 const QString& colDelimiter_, const QString& rowDelimiter_)
+      : m_coll(coll_), m_columns(columns_), m_colDelimiter(colDelimiter_), m_rowDelimiter(rowDelimiter_) {
+      // do we need to replace column or row delimiters
+      m_replaceColDelimiter = (!m_colDelimiter.isEmpty() && m_colDelimiter != Tellico::FieldFormat::columnDelimiterString());
+      m_replaceRowDelimiter = (!m_rowDelimiter.isEmpty() && m_rowDelimiter != Tellico::FieldFormat::rowDelimiterString());
+    }
+
+    ConvertedRow operator()(const QStringList& values_) const;
+
+  private:
+    Tellico::Data::CollPtr m_coll;
+    QVector<ColumnInfo> m_columns;
+    QString m_colDelimiter;
+    QString m_rowDelimiter;
+    bool m_replaceColDelimiter;
+    bool m_replaceRowDelimiter;
+  };
+
+  ConvertedRow RowConverter::operator()(const QStringList& values_) const {
+    ConvertedRow row;
+    row.empty = true;
+    row.entry = Tellico::Data::EntryPtr(new Tellico::Data::Entry(m_coll));
+    foreach(const ColumnInfo& info, m_columns) {
+      if(info.col >= values_.size()) {
+        break;
+      }
+      // remove C0 control characters, since the values are represented in XML later
+      QString value = Tellico::removeControlCodes(values_.at(info.col)).trimmed();
+      // only replace delimiters for tables
+      // see https://forum.kde.org/viewtopic.php?f=200&t=142712
+      if(m_replaceColDelimiter && info.field->type() == Tellico::Data::Field::Table) {
+        value.replace(m_colDelimiter, Tellico::FieldFormat::columnDelimiterString());
+      }
+      if(m_replaceRowDelimiter && info.field->type() == Tellico::Data::Field::Table) {
+        value.replace(m_rowDelimiter, Tellico::FieldFormat::rowDelimiterString());
+      }
+      // special cases for LibraryThing import
+      switch(info.special) {
+        case LibraryThingIsbn:
+          // ISBN values are enclosed by brackets
+          value.remove(QLatin1Char('[')).remove(QLatin1Char(']'));
+          break;
+        case LibraryThingKeyword:
+          // LT values are comma-separated
+          value.replace(QLatin1String(","), Tellico::FieldFormat::delimiterString());
+          break;
+        case LibraryThingDate:
+          // only want date, not time. 10 characters since it's zero-padded
+          value.truncate(10);
+          break;
+        case NoSpecial:
+          break;
+      }
+      const bool success = row.entry->setField(info.field, value);
+      // we might need to add a new allowed value, but that changes the field
+      if(!success && info.field->type() == Tellico::Data::Field::Choice) {
+        row.rejectedFields += info.field;
+        row.rejectedValues += value;
+      } else if(row.empty && success) {
+        row.empty = false;
+      }
+    }
+    return row;
+  }
+}
+
+CSVImporter::CSVImporter(const QUrl& url_) : Tellico::Import::Importer(url_),
     m_existingCollection(nullptr),
     m_firstRowHeader(false),
     m_delimiter(QStringLiteral(",")),
@@ -78,13 +202,30 @@ CSVImporter::CSVImporter(const QUrl& url_) : Tellico::Import::TextImporter(url_)
     m_setColumnBtn(nullptr),
     m_hasAssignedFields(false),
     m_isLibraryThing(false),
-    m_parser(new CSVParser(text())) {
+    m_parser(new CSVParser(QString())),
+    m_fileRef(nullptr) {
   m_parser->setDelimiter(m_delimiter);
+  if(url_.isValid()) {
+    // the file is only opened here, the contents are read as needed
+    m_fileRef = FileHandler::fileRef(url_);
+    m_fileRef->open();
+  }
 }
 
 CSVImporter::~CSVImporter() {
   delete m_parser;
   m_parser = nullptr;
+  delete m_fileRef;
+  m_fileRef = nullptr;
+}
+
+void CSVImporter::resetParser() {
+  if(m_fileRef && m_fileRef->file() && m_fileRef->file()->isOpen()) {
+    // same as reading a text file, use the locale encoding unless there's a byte order mark
+    m_parser->reset(m_fileRef->file(), QTextCodec::codecForLocale());
+  } else {
+    m_parser->reset(text());
+  }
 }
 
 Tellico::Data::CollPtr CSVImporter::collection() {
@@ -97,97 +238,105 @@ Tellico::Data::CollPtr CSVImporter::collection() {
     createCollection();
   }
 
-  const QStringList existingNames = m_coll->fieldNames();
-
-  QList<int> cols;
-  cols.reserve(m_table->columnCount());
-  QStringList names;
-  names.reserve(m_table->columnCount());
+  // resolve the field for each column once, rather than for every value
+  QVector<ColumnInfo> columns;
+  columns.reserve(m_table->columnCount());
   for(int col = 0; col < m_table->columnCount(); ++col) {
     QString t = m_table->horizontalHeaderItem(col)->text();
-    if(m_coll->fieldByTitle(t)) {
-      cols << col;
-      names << m_coll->fieldNameByTitle(t);
+    Data::FieldPtr field = m_coll->fieldByTitle(t);
+    if(field) {
+      ColumnInfo info;
+      info.col = col;
+      info.field = field;
+      info.special = NoSpecial;
+      if(m_isLibraryThing) {
+        if(field->name() == QLatin1String("isbn")) {
+          info.special = LibraryThingIsbn;
+        } else if(field->name() == QLatin1String("keyword")) {
+          info.special = LibraryThingKeyword;
+        } else if(field->name() == QLatin1String("cdate")) {
+          info.special = LibraryThingDate;
+        }
+      }
+      columns << info;
     }
   }
 
-  if(names.isEmpty()) {
+  if(columns.isEmpty()) {
     myDebug() << "no fields assigned";
     return Data::CollPtr();
   }
 
-  m_parser->reset(text());
+  resetParser();
 
   // if the first row are headers, skip it
   if(m_firstRowHeader) {
     m_parser->skipLine();
   }
 
-  const uint numChars = text().size();
-  const uint stepSize = qMax(s_stepSize, numChars/100);
+  QIODevice* device = m_fileRef ? m_fileRef->file() : nullptr;
+  const qint64 totalSize = device ? qMax(Q_INT64_C(1), device->size()) : qMax(1, text().size());
   const bool showProgress = options() & ImportProgress;
 
-  // do we need to replace column or row delimiters
-  const bool replaceColDelimiter = (!m_colDelimiter.isEmpty() && m_colDelimiter != FieldFormat::columnDelimiterString());
-  const bool replaceRowDelimiter = (!m_rowDelimiter.isEmpty() && m_rowDelimiter != FieldFormat::rowDelimiterString());
+  // the import is a pipeline: while one batch of rows is converted to entries by all the
+  // threads, the parser reads the next batch. Adding the entries, and any new allowed
+  // values, is done here, in the order of the rows
+  const RowConverter converter(m_coll, columns, m_colDelimiter, m_rowDelimiter);
+  QFuture<RowBatch> nextBatch = QtConcurrent::run(readRows, m_parser, device, Q_INT64_C(0));
+  int lastProgress = -1;
+  while(!m_cancelled) {
+    const RowBatch batch = nextBatch.result();
+    if(batch.rows.isEmpty()) {
+      break;
+    }
+    nextBatch = QtConcurrent::run(readRows, m_parser, device, batch.position);
 
-  uint j = 0;
-  while(!m_cancelled && m_parser->hasNext()) {
-    bool empty = true;
-    Data::EntryPtr entry(new Data::Entry(m_coll));
-    QStringList values = m_parser->nextTokens();
-    for(int i = 0; i < names.size(); ++i) {
-      if(cols[i] >= values.size()) {
-        break;
-      }
-      QString value = values[cols[i]].trimmed();
-      // only replace delimiters for tables
-      // see https://forum.kde.org/viewtopic.php?f=200&t=142712
-      if(replaceColDelimiter && m_coll->fieldByName(names[i])->type() == Data::Field::Table) {
-        value.replace(m_colDelimiter, FieldFormat::columnDelimiterString());
-      }
-      if(replaceRowDelimiter && m_coll->fieldByName(names[i])->type() == Data::Field::Table) {
-        value.replace(m_rowDelimiter, FieldFormat::rowDelimiterString());
+    const QList<ConvertedRow> converted = QtConcurrent::blockingMapped<QList<ConvertedRow> >(batch.rows, converter);
+
+    // assume that if the user is importing the value, it should be allowed
+    QHash<QString, StringSet> newAllowed;
+    foreach(const ConvertedRow& row, converted) {
+      for(int i = 0; i < row.rejectedFields.count(); ++i) {
+        newAllowed[row.rejectedFields.at(i)->name()].add(row.rejectedValues.at(i));
       }
-      if(m_isLibraryThing) {
-        // special cases for LibraryThing import
-        if(names[i] == QLatin1String("isbn")) {
-          // ISBN values are enclosed by brackets
-          value.remove(QLatin1Char('[')).remove(QLatin1Char(']'));
-        } else if(names[i] == QLatin1String("keyword")) {
-          // LT values are comma-separated
-          value.replace(QLatin1String(","), FieldFormat::delimiterString());
-        } else if(names[i] == QLatin1String("cdate")) {
-          // only want date, not time. 10 characters since it's zero-padded
-          value.truncate(10);
+    }
+    for(QHash<QString, StringSet>::Iterator it = newAllowed.begin(); it != newAllowed.end(); ++it) {
+      Data::FieldPtr f = m_coll->fieldByName(it.key());
+      StringSet allow;
+      allow.add(f->allowed());
+      allow.unite(it.value());
+      f->setAllowed(allow.values());
+      m_coll->modifyField(f);
+    }
+
+    Data::EntryList entries;
+    entries.reserve(converted.count());
+    foreach(const ConvertedRow& row, converted) {
+      bool empty = row.empty;
+      for(int i = 0; i < row.rejectedFields.count(); ++i) {
+        if(row.entry->setField(row.rejectedFields.at(i), row.rejectedValues.at(i)) && empty) {
+          empty = false;
         }
       }
-      bool success = entry->setField(names[i], value);
-      // we might need to add a new allowed value
-      // assume that if the user is importing the value, it should be allowed
-      if(!success && m_coll->fieldByName(names[i])->type() == Data::Field::Choice) {
-        Data::FieldPtr f = m_coll->fieldByName(names[i]);
-        StringSet allow;
-        allow.add(f->allowed());
-        allow.add(value);
-        f->setAllowed(allow.values());
-        m_coll->modifyField(f);
-        success = entry->setField(names[i], value);
-      }
-      if(empty && success) {
-        empty = false;
+      if(!empty) {
+        entries += row.entry;
       }
-      j += value.size();
     }
-    if(!empty) {
-      m_coll->addEntries(entry);
+    if(!entries.isEmpty()) {
+      m_coll->addEntries(entries);
     }
 
-    if(showProgress && j%stepSize == 0) {
-      emit signalProgress(this, 100*j/numChars);
-      qApp->processEvents();
+    if(showProgress) {
+      const int progress = 100 * batch.position / totalSize;
+      if(progress != lastProgress) {
+        lastProgress = progress;
+        emit signalProgress(this, progress);
+        qApp->processEvents();
+      }
     }
   }
+  // the parser might still be reading, if the import was cancelled
+  nextBatch.waitForFinished();
 
   {
     KConfigGroup config(KSharedConfig::openConfig(), QStringLiteral("ImportOptions - CSV"));
@@ -394,7 +543,7 @@ void CSVImporter::fillTable() {
     return;
   }
 
-  m_parser->reset(text());
+  resetParser();
   // not skipping first row since the updateHeader() call depends on it
 
   int maxCols = 0;
@@ -25,7 +25,8 @@
 #ifndef TELLICO_CSVIMPORTER_H
 #define TELLICO_CSVIMPORTER_H
 
-#include "textimporter.h"
+#include "importer.h"
+#include "../core/filehandler.h"
 #include "../datavectors.h"
 
 class CSVImporterWidget;
@@ -47,9 +48,13 @@ namespace Tellico {
   namespace Import {
 
 /**
+ * The CSVImporter reads comma-separated files. The file is read in chunks while the entries
+ * are created, rather than all at once, so even very large files can be imported. Batches of
+ * rows are converted to entries in parallel, while the next batch is read.
+ *
  * @author Robby Stephenson
  */
-class CSVImporter : public TextImporter {
+class CSVImporter : public Importer {
 Q_OBJECT
 
 public:
@@ -91,6 +96,7 @@ private:
   void updateHeader();
   void createCollection();
   void updateFieldCombo();
+  void resetParser();
 
   Data::CollPtr m_coll;
   Data::CollPtr m_existingCollection; // used to grab fields from current collection in window
@@ -118,6 +124,7 @@ private:
   bool m_isLibraryThing;
 
   CSVParser* m_parser;
+  FileHandler::FileRef* m_fileRef;
 };
 
   } // end namespace
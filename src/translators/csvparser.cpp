@@ -25,7 +25,11 @@
 #include "csvparser.h"
 
 #include <QTextStream>
+#include <QTextCodec>
+#include <QTextDecoder>
 #include <QStringList>
+#include <QIODevice>
+#include <QScopedPointer>
 
 #include <config.h>
 
@@ -45,11 +49,16 @@ static int isSpace(unsigned char c);
 static int isSpaceOrTab(unsigned char c);
 static int isTab(unsigned char c);
 
+namespace {
+  // the size of each read from a device, which bounds the memory used for parsing
+  static const qint64 CSV_CHUNK_SIZE = 256 * 1024;
+}
+
 using Tellico::CSVParser;
 
 class CSVParser::Private {
 public:
-  Private() : stream(nullptr), done(false) {
+  Private() : stream(nullptr), device(nullptr), codec(nullptr), deviceDone(true), firstChunk(false), done(false) {
     csv_init(&parser, 0);
   }
   ~Private() {
@@ -57,13 +66,52 @@ public:
     delete stream;
   }
 
+  void readChunk(CSVParser* p);
+
   struct csv_parser parser;
   QString str;
   QTextStream* stream;
+  QIODevice* device;
+  QTextCodec* codec;
+  // data not in UTF-8 gets converted, since libcsv works on bytes
+  QScopedPointer<QTextDecoder> decoder;
+  bool deviceDone;
+  bool firstChunk;
   QStringList tokens;
+  // complete rows read from the device, but not yet returned
+  QList<QStringList> rows;
   bool done;
 };
 
+void CSVParser::Private::readChunk(CSVParser* p) {
+  QByteArray chunk = device->read(CSV_CHUNK_SIZE);
+  if(chunk.isEmpty()) {
+    csv_fini(&parser, &writeToken, &writeRow, p);
+    // a last row without a line end gets finished by csv_fini
+    if(!tokens.isEmpty()) {
+      rows.append(tokens);
+      tokens.clear();
+    }
+    deviceDone = true;
+    return;
+  }
+  if(firstChunk) {
+    firstChunk = false;
+    codec = QTextCodec::codecForUtfText(chunk, codec);
+    if(codec->mibEnum() == 106) { // UTF-8
+      if(chunk.startsWith("\xEF\xBB\xBF")) {
+        chunk.remove(0, 3);
+      }
+    } else {
+      decoder.reset(codec->makeDecoder());
+    }
+  }
+  if(decoder) {
+    chunk = decoder->toUnicode(chunk).toUtf8();
+  }
+  csv_parse(&parser, chunk.constData(), chunk.length(), &writeToken, &writeRow, p);
+}
+
 CSVParser::CSVParser(QString str) : d(new Private()) {
   reset(str);
 }
@@ -84,13 +132,43 @@ void CSVParser::reset(QString str) {
   delete d->stream;
   d->str = str;
   d->stream = new QTextStream(&d->str);
+  d->device = nullptr;
+  d->deviceDone = true;
+  d->tokens.clear();
+  d->rows.clear();
+}
+
+void CSVParser::reset(QIODevice* device_, QTextCodec* codec_) {
+  delete d->stream;
+  d->stream = nullptr;
+  d->str.clear();
+  d->device = device_;
+  d->deviceDone = !device_ || !device_->isOpen();
+  if(!d->deviceDone) {
+    device_->seek(0);
+  }
+  // the byte order mark is checked in the first chunk
+  d->firstChunk = true;
+  d->codec = codec_ ? codec_ : QTextCodec::codecForName("UTF-8");
+  d->decoder.reset();
+  d->tokens.clear();
+  d->rows.clear();
+  // start over, in case a previous read stopped in the middle of a row
+  csv_fini(&d->parser, nullptr, nullptr, nullptr);
 }
 
 bool CSVParser::hasNext() const {
-  return !d->stream->atEnd();
+  if(d->device) {
+    return !d->rows.isEmpty() || !d->deviceDone;
+  }
+  return d->stream && !d->stream->atEnd();
 }
 
 void CSVParser::skipLine() {
+  if(d->device) {
+    nextTokens();
+    return;
+  }
   d->stream->readLine();
 }
 
@@ -100,9 +178,20 @@ void CSVParser::addToken(const QString& t) {
 
 void CSVParser::setRowDone(bool b) {
   d->done = b;
+  if(b && d->device) {
+    d->rows.append(d->tokens);
+    d->tokens.clear();
+  }
 }
 
 QStringList CSVParser::nextTokens() {
+  if(d->device) {
+    while(d->rows.isEmpty() && !d->deviceDone) {
+      d->readChunk(this);
+    }
+    return d->rows.isEmpty() ? QStringList() : d->rows.takeFirst();
+  }
+
   d->tokens.clear();
   d->done = false;
   while(hasNext() && !d->done) {
@@ -27,8 +27,18 @@
 
 #include <QString>
 
+class QIODevice;
+class QTextCodec;
+
 namespace Tellico {
 
+/**
+ * The CSVParser splits comma-separated text into rows of values. The text is either a string,
+ * which is parsed a line at a time, or a device, which is read in fixed-size chunks so
+ * that large files never have to be held in memory.
+ *
+ * @author Robby Stephenson
+ */
 class CSVParser {
 public:
   CSVParser(QString str);
@@ -36,7 +46,18 @@ public:
 
   void setDelimiter(const QString& s);
   void reset(QString str);
+  /**
+   * Resets the parser to read from the beginning of a device, which must be open. The device
+   * is not owned by the parser.
+   *
+   * @param device The device
+   * @param codec The encoding of the data, UTF-8 if null. A byte order mark overrides it.
+   */
+  void reset(QIODevice* device, QTextCodec* codec = nullptr);
   bool hasNext() const;
+  /**
+   * Skips the rest of the current line, or the next row when reading from a device.
+   */
   void skipLine();
 
   void addToken(const QString& t);
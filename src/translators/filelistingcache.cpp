@@ -0,0 +1,154 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "filelistingcache.h"
+#include "../utils/tellico_utils.h"
+#include "../tellico_debug.h"
+
+#include <QUrl>
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QLocale>
+#include <QCryptographicHash>
+
+namespace {
+  static const quint32 FILELISTING_CACHE_MAGIC = 0x54464c43; // "TFLC"
+  static const quint32 FILELISTING_CACHE_VERSION = 1;
+}
+
+using Tellico::FileListingCache;
+
+FileListingCache::FileListingCache(const QString& fileName_) : m_fileName(fileName_), m_usedCount(0), m_changed(false) {
+}
+
+QString FileListingCache::cacheFileName(const QUrl& folder_, const QString& scanner_) {
+  const QString source = scanner_ + QLatin1Char(':') + folder_.adjusted(QUrl::StripTrailingSlash).toString();
+  const QByteArray key = QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Md5);
+  return Tellico::saveLocation(QStringLiteral("filelisting/")) + QLatin1String(key.toHex()) + QLatin1String(".cache");
+}
+
+bool FileListingCache::load() {
+  m_records.clear();
+  m_usedCount = 0;
+  m_changed = false;
+
+  QFile file(m_fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_6);
+
+  quint32 magic, version;
+  QString locale;
+  in >> magic >> version >> locale;
+  // the metadata labels are translated, so the cache is tied to the locale
+  if(magic != FILELISTING_CACHE_MAGIC || version != FILELISTING_CACHE_VERSION || locale != QLocale().name()) {
+    return false;
+  }
+  quint32 count;
+  in >> count;
+  m_records.reserve(count);
+  for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+    QString path;
+    Record record;
+    in >> path >> record.size >> record.modified >> record.metaInfo;
+    record.used = false;
+    m_records.insert(path, record);
+  }
+  if(in.status() != QDataStream::Ok) {
+    myDebug() << "Unable to read file listing cache:" << m_fileName;
+    m_records.clear();
+    return false;
+  }
+  return true;
+}
+
+bool FileListingCache::save() {
+  // nothing to write if no files were added and none were dropped
+  if(!m_changed && m_usedCount == m_records.count()) {
+    return true;
+  }
+
+  QSaveFile file(m_fileName);
+  if(!file.open(QIODevice::WriteOnly)) {
+    myDebug() << "Unable to write file listing cache:" << file.fileName();
+    return false;
+  }
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_6);
+
+  out << FILELISTING_CACHE_MAGIC << FILELISTING_CACHE_VERSION << QLocale().name();
+  out << quint32(m_usedCount);
+  QHash<QString, Record>::ConstIterator it = m_records.constBegin();
+  for( ; it != m_records.constEnd(); ++it) {
+    if(it.value().used) {
+      out << it.key() << it.value().size << it.value().modified << it.value().metaInfo;
+    }
+  }
+  if(!file.commit()) {
+    myDebug() << "Unable to write file listing cache:" << file.fileName();
+    return false;
+  }
+  m_changed = false;
+  return true;
+}
+
+bool FileListingCache::lookup(const QString& path_, qint64 size_, const QDateTime& modified_, QString* metaInfo_) {
+  QHash<QString, Record>::Iterator it = m_records.find(path_);
+  if(it == m_records.end() || !modified_.isValid() ||
+     it.value().size != size_ || it.value().modified != modified_.toMSecsSinceEpoch()) {
+    return false;
+  }
+  if(!it.value().used) {
+    it.value().used = true;
+    ++m_usedCount;
+  }
+  if(metaInfo_) {
+    *metaInfo_ = it.value().metaInfo;
+  }
+  return true;
+}
+
+void FileListingCache::insert(const QString& path_, qint64 size_, const QDateTime& modified_, const QString& metaInfo_) {
+  if(!modified_.isValid()) {
+    return;
+  }
+  QHash<QString, Record>::Iterator it = m_records.find(path_);
+  if(it == m_records.end()) {
+    it = m_records.insert(path_, Record());
+    it.value().used = false;
+  }
+  if(!it.value().used) {
+    it.value().used = true;
+    ++m_usedCount;
+  }
+  it.value().size = size_;
+  it.value().modified = modified_.toMSecsSinceEpoch();
+  it.value().metaInfo = metaInfo_;
+  m_changed = true;
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef TELLICO_FILELISTINGCACHE_H
+#define TELLICO_FILELISTINGCACHE_H
+
+#include <QString>
+#include <QHash>
+
+class QUrl;
+class QDateTime;
+
+namespace Tellico {
+
+/**
+ * The FileListingCache keeps the metadata read from files while scanning a folder for an import,
+ * so that scanning the same folder again only has to read files which have changed.
+ *
+ * Each file is identified by its path, and the cached value is only used as long as the size
+ * and modification time of the file still match. Files which were not looked up since the cache
+ * was loaded are dropped when it is saved, so files removed from the folder don't pile up.
+ *
+ * @author agent
+ */
+class FileListingCache {
+public:
+  /**
+   * @param fileName The file the cache is read from and written to
+   */
+  explicit FileListingCache(const QString& fileName);
+
+  /**
+   * Returns the name of the cache file for a scanned folder.
+   *
+   * @param folder The folder
+   * @param scanner The name of what scanned the folder, since each one keeps its own cache
+   */
+  static QString cacheFileName(const QUrl& folder, const QString& scanner);
+
+  /**
+   * Reads the cache file. A missing or outdated file leaves the cache empty.
+   */
+  bool load();
+  /**
+   * Writes the cache file, if anything changed since it was loaded.
+   */
+  bool save();
+
+  /**
+   * Looks up the cached metadata for a file, which also marks it to be kept when saved.
+   *
+   * @param path The local path of the file
+   * @param size The current size of the file
+   * @param modified The current modification time of the file
+   * @param metaInfo Set to the cached metadata
+   * @return Whether the cached value is still current
+   */
+  bool lookup(const QString& path, qint64 size, const QDateTime& modified, QString* metaInfo);
+  /**
+   * Adds the metadata for a file. Files without a valid modification time are not cached.
+   */
+  void insert(const QString& path, qint64 size, const QDateTime& modified, const QString& metaInfo);
+
+  int count() const { return m_records.count(); }
+
+private:
+  struct Record {
+    qint64 size;
+    qint64 modified;
+    QString metaInfo;
+    bool used;
+  };
+
+  QString m_fileName;
+  QHash<QString, Record> m_records;
+  int m_usedCount;
+  bool m_changed;
+};
+
+} // end namespace
+#endif
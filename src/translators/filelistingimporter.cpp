@@ -25,6 +25,7 @@
 #include <config.h>
 
 #include "filelistingimporter.h"
+#include "filelistingcache.h"
 #include "../collections/filecatalog.h"
 #include "../entry.h"
 #include "../field.h"
@@ -58,15 +59,94 @@
 #include <QFileInfo>
 #include <QVBoxLayout>
 #include <QApplication>
+#include <QThread>
+#include <QThreadStorage>
+#include <QVector>
+#include <QtConcurrentRun>
 
 namespace {
   static const int FILE_PREVIEW_SIZE = 128;
+  // the folder listing is suspended while each batch of files is handled
+  static const int FILE_BATCH_SIZE = 200;
+
+#ifdef HAVE_KFILEMETADATA
+  // the extractor plugins are not meant to be shared between threads, so each worker has its own
+  struct MetaDataExtractor {
+    KFileMetaData::ExtractorCollection extractors;
+    QHash<KFileMetaData::Property::Property, QString> propertyNames;
+  };
+  QThreadStorage<MetaDataExtractor*> s_extractors;
+
+  QString extractMetaInfo(const QAtomicInt* stop_, const QString& path_, const QString& mimeType_) {
+    if(stop_->load()) {
+      return QString();
+    }
+    if(!s_extractors.hasLocalData()) {
+      s_extractors.setLocalData(new MetaDataExtractor);
+    }
+    MetaDataExtractor* ex = s_extractors.localData();
+
+    static const QStringList metaIgnore = QStringList()
+                                        << QStringLiteral("mimeType")
+                                        << QStringLiteral("url")
+                                        << QStringLiteral("fileName")
+                                        << QStringLiteral("lastModified")
+                                        << QStringLiteral("contentSize")
+                                        << QStringLiteral("type");
+
+    KFileMetaData::SimpleExtractionResult result(path_,
+                                                 mimeType_,
+                                                 KFileMetaData::ExtractionResult::ExtractMetaData);
+    QList<KFileMetaData::Extractor*> exList = ex->extractors.fetchExtractors(mimeType_);
+    foreach(KFileMetaData::Extractor* extractor, exList) {
+// initializing exempi can cause a crash in Exiv for files with XMP data
+// crude workaround is to avoid using the exivextractor and the only apparent way is to
+// matach against the mimetypes
+// see https://bugs.kde.org/show_bug.cgi?id=390744
+#ifdef HAVE_EXEMPI
+      if(!extractor->mimetypes().contains(QStringLiteral("image/x-exv"))) {
+#else
+      if(true) {
+#endif
+        extractor->extract(&result);
+      }
+    }
+    QStringList strings;
+    KFileMetaData::PropertyMap properties = result.properties();
+    KFileMetaData::PropertyMap::const_iterator it = properties.constBegin();
+    for( ; it != properties.constEnd(); ++it) {
+      const QString value = it.value().toString();
+      if(!value.isEmpty()) {
+        QString label;
+        if(ex->propertyNames.contains(it.key())) {
+          label = ex->propertyNames.value(it.key());
+        } else {
+          label = KFileMetaData::PropertyInfo(it.key()).displayName();
+          ex->propertyNames.insert(it.key(), label);
+        }
+//        myDebug() << label << value;
+        if(!metaIgnore.contains(label)) {
+          strings << label + Tellico::FieldFormat::columnDelimiterString() + value;
+        }
+      }
+    }
+    return strings.join(Tellico::FieldFormat::rowDelimiterString());
+  }
+#endif
 }
 
 using Tellico::Import::FileListingImporter;
 
 FileListingImporter::FileListingImporter(const QUrl& url_) : Importer(url_), m_coll(nullptr), m_widget(nullptr),
-    m_recursive(nullptr), m_filePreview(nullptr), m_job(nullptr), m_cancelled(false) {
+    m_recursive(nullptr), m_filePreview(nullptr), m_job(nullptr), m_usePreview(false), m_processing(false),
+    m_fileCount(0), m_cancelled(false) {
+  // reading metadata is mostly waiting on the disk, so use a few more threads than cores
+  m_pool.setMaxThreadCount(qMax(2, 2 * QThread::idealThreadCount()));
+}
+
+FileListingImporter::~FileListingImporter() {
+  m_stopWorkers.store(1);
+  m_pool.waitForDone();
 }
 
 bool FileListingImporter::canImport(int type) const {
@@ -84,7 +164,15 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
   ProgressItem::Done done(this);
 
   // going to assume only one volume will ever be imported
-  const QString volume = volumeName();
+  m_volume = volumeName();
+  m_usePreview = m_widget && m_filePreview->isChecked();
+  m_fileCount = 0;
+  m_coll = new Data::FileCatalog(true);
+
+#ifdef HAVE_KFILEMETADATA
+  m_cache.reset(new FileListingCache(FileListingCache::cacheFileName(url(), QStringLiteral("filelisting"))));
+  m_cache->load();
+#endif
 
   // the importer might be running without a gui/widget
   m_job = (m_widget && m_recursive->isChecked())
@@ -95,25 +183,86 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
   connect(static_cast<KIO::ListJob*>(m_job.data()), jobEntries, this, &FileListingImporter::slotEntries);
 
   if(!m_job->exec() || m_cancelled) {
-    myDebug() << "did not run job:" << m_job->errorString();
-    return Data::CollPtr();
+    myDebug() << "did not run job:" << (m_job ? m_job->errorString() : QString());
+    m_pendingFiles.clear();
+    m_coll = Data::CollPtr();
+    return m_coll;
+  }
+
+  // whatever is left from the listing
+  processFiles();
+
+  if(m_cancelled) {
+    m_coll = Data::CollPtr();
+    return m_coll;
+  }
+
+  if(m_cache) {
+    m_cache->save();
+  }
+  return m_coll;
+}
+
+void FileListingImporter::processFiles() {
+  if(m_pendingFiles.isEmpty() || m_processing) {
+    return;
+  }
+  m_processing = true;
+  const KFileItemList files = m_pendingFiles;
+  m_pendingFiles.clear();
+
+  // start reading the metadata of any file not in the cache, then generate the previews
+  // in the meantime, since those have to be done by a job on this thread
+  QVector<QString> metaInfo(files.count());
+#ifdef HAVE_KFILEMETADATA
+  QVector<int> extracted;
+  QList<QFuture<QString> > futures;
+  for(int i = 0; i < files.count(); ++i) {
+    const KFileItem& file = files.at(i);
+    const QString path = file.url().toLocalFile();
+    if(!m_cache || !m_cache->lookup(path, file.size(), file.time(KFileItem::ModificationTime), &metaInfo[i])) {
+      extracted += i;
+      futures += QtConcurrent::run(&m_pool, extractMetaInfo, &m_stopWorkers, path, file.mimetype());
+    }
+  }
+#endif
+
+  QHash<QUrl, QPixmap> previews;
+  if(m_usePreview && !m_cancelled) {
+    previews = Tellico::NetAccess::filePreviews(files, FILE_PREVIEW_SIZE);
   }
 
 #ifdef HAVE_KFILEMETADATA
-  KFileMetaData::ExtractorCollection extractors;
-  QHash<KFileMetaData::Property::Property, QString> propertyNameHash;
+  for(int j = 0; j < extracted.count(); ++j) {
+    const int i = extracted.at(j);
+    metaInfo[i] = futures.at(j).result();
+    if(m_cache && !m_cancelled) {
+      const KFileItem& file = files.at(i);
+      m_cache->insert(file.url().toLocalFile(), file.size(), file.time(KFileItem::ModificationTime), metaInfo.at(i));
+    }
+  }
 #endif
 
-  QStringList metaIgnore = QStringList()
-                         << QStringLiteral("mimeType")
-                         << QStringLiteral("url")
-                         << QStringLiteral("fileName")
-                         << QStringLiteral("lastModified")
-                         << QStringLiteral("contentSize")
-                         << QStringLiteral("type");
+  if(!m_cancelled) {
+    Data::EntryList entries;
+    entries.reserve(files.count());
+    for(int i = 0; i < files.count(); ++i) {
+      entries += createEntry(files.at(i), metaInfo.at(i), previews.value(files.at(i).url()));
+    }
+    m_coll->addEntries(entries);
+    m_fileCount += files.count();
 
-  const bool usePreview = m_widget && m_filePreview->isChecked();
+    if(options() & ImportProgress) {
+      // the total isn't known until the listing is done, so the bar stays just short of the end
+      ProgressManager::self()->setTotalSteps(this, m_fileCount + FILE_BATCH_SIZE);
+      ProgressManager::self()->setProgress(this, m_fileCount);
+      qApp->processEvents();
+    }
+  }
+  m_processing = false;
+}
 
+Tellico::Data::EntryPtr FileListingImporter::createEntry(const KFileItem& item_, const QString& metaInfo_, const QPixmap& preview_) {
   const QString title    = QStringLiteral("title");
   const QString url      = QStringLiteral("url");
   const QString desc     = QStringLiteral("description");
@@ -129,123 +278,56 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
   const QString metainfo = QStringLiteral("metainfo");
   const QString icon     = QStringLiteral("icon");
 
-  // cache the icon image ids to avoid repeated creation of Data::Image objects
-  QHash<QString, QString> iconImageId;
-
-  m_coll = new Data::FileCatalog(true);
-  QString tmp;
-  const uint stepSize = qMax(1, m_files.count()/100);
-  const bool showProgress = options() & ImportProgress;
-
-  item.setTotalSteps(m_files.count());
-  uint j = 0;
-  foreach(const KFileItem& item, m_files) {
-    if(m_cancelled) {
-      break;
-    }
-
-    Data::EntryPtr entry(new Data::Entry(m_coll));
-
-    const QUrl u = item.url();
-    entry->setField(title,  u.fileName());
-    entry->setField(url,    u.url());
-    entry->setField(desc,   item.mimeComment());
-    entry->setField(vol,    volume);
-    tmp = QDir(this->url().toLocalFile()).relativeFilePath(u.adjusted(QUrl::RemoveFilename|QUrl::StripTrailingSlash).path());
-    // use empty string for root folder instead of "."
-    entry->setField(folder, tmp == QLatin1String(".") ? QString() : tmp);
-    entry->setField(type,   item.mimetype());
-    entry->setField(size,   KIO::convertSize(item.size()));
-    entry->setField(perm,   item.permissionsString());
-    entry->setField(owner,  item.user());
-    entry->setField(group,  item.group());
-
-    QDateTime dt(item.time(KFileItem::CreationTime));
-    if(!dt.isNull()) {
-      entry->setField(created, dt.date().toString(Qt::ISODate));
-    }
-    dt = QDateTime(item.time(KFileItem::ModificationTime));
-    if(!dt.isNull()) {
-      entry->setField(modified, dt.date().toString(Qt::ISODate));
-    }
+  Data::EntryPtr entry(new Data::Entry(m_coll));
+
+  const QUrl u = item_.url();
+  entry->setField(title,  u.fileName());
+  entry->setField(url,    u.url());
+  entry->setField(desc,   item_.mimeComment());
+  entry->setField(vol,    m_volume);
+  const QString tmp = QDir(this->url().toLocalFile()).relativeFilePath(u.adjusted(QUrl::RemoveFilename|QUrl::StripTrailingSlash).path());
+  // use empty string for root folder instead of "."
+  entry->setField(folder, tmp == QLatin1String(".") ? QString() : tmp);
+  entry->setField(type,   item_.mimetype());
+  entry->setField(size,   KIO::convertSize(item_.size()));
+  entry->setField(perm,   item_.permissionsString());
+  entry->setField(owner,  item_.user());
+  entry->setField(group,  item_.group());
+
+  QDateTime dt(item_.time(KFileItem::CreationTime));
+  if(!dt.isNull()) {
+    entry->setField(created, dt.date().toString(Qt::ISODate));
+  }
+  dt = QDateTime(item_.time(KFileItem::ModificationTime));
+  if(!dt.isNull()) {
+    entry->setField(modified, dt.date().toString(Qt::ISODate));
+  }
 
 #ifdef HAVE_KFILEMETADATA
-    KFileMetaData::SimpleExtractionResult result(u.toLocalFile(),
-                                                 item.mimetype(),
-                                                 KFileMetaData::ExtractionResult::ExtractMetaData);
-    QList<KFileMetaData::Extractor*> exList = extractors.fetchExtractors(item.mimetype());
-    foreach(KFileMetaData::Extractor* ex, exList) {
-// initializing exempi can cause a crash in Exiv for files with XMP data
-// crude workaround is to avoid using the exivextractor and the only apparent way is to
-// matach against the mimetypes
-// see https://bugs.kde.org/show_bug.cgi?id=390744
-#ifdef HAVE_EXEMPI
-      if(!ex->mimetypes().contains(QStringLiteral("image/x-exv"))) {
+  entry->setField(metainfo, metaInfo_);
 #else
-      if(true) {
-#endif
-        ex->extract(&result);
-      }
-    }
-    QStringList strings;
-    KFileMetaData::PropertyMap properties = result.properties();
-    KFileMetaData::PropertyMap::const_iterator it = properties.constBegin();
-    for( ; it != properties.constEnd(); ++it) {
-      const QString value = it.value().toString();
-      if(!value.isEmpty()) {
-        QString label;
-        if(propertyNameHash.contains(it.key())) {
-          label = propertyNameHash.value(it.key());
-        } else {
-          label = KFileMetaData::PropertyInfo(it.key()).displayName();
-          propertyNameHash.insert(it.key(), label);
-        }
-//        myDebug() << label << value;
-        if(!metaIgnore.contains(label)) {
-          strings << label + FieldFormat::columnDelimiterString() + value;
-        }
-      }
-    }
-    entry->setField(metainfo, strings.join(FieldFormat::rowDelimiterString()));
+  Q_UNUSED(metaInfo_);
 #endif
 
-    QPixmap pixmap;
-    if(!m_cancelled && usePreview) {
-      pixmap = Tellico::NetAccess::filePreview(item, FILE_PREVIEW_SIZE);
-    }
-    if(pixmap.isNull()) {
-      if(iconImageId.contains(item.iconName())) {
-        entry->setField(icon, iconImageId.value(item.iconName()));
-      } else {
-        pixmap = QIcon::fromTheme(item.iconName()).pixmap(QSize(FILE_PREVIEW_SIZE, FILE_PREVIEW_SIZE));
-        const QString id = ImageFactory::addImage(pixmap, QStringLiteral("PNG"));
-        if(!id.isEmpty()) {
-          entry->setField(icon, id);
-          iconImageId.insert(item.iconName(), id);
-        }
-      }
+  if(preview_.isNull()) {
+    // cache the icon image ids to avoid repeated creation of Data::Image objects
+    if(m_iconImageIds.contains(item_.iconName())) {
+      entry->setField(icon, m_iconImageIds.value(item_.iconName()));
     } else {
+      const QPixmap pixmap = QIcon::fromTheme(item_.iconName()).pixmap(QSize(FILE_PREVIEW_SIZE, FILE_PREVIEW_SIZE));
       const QString id = ImageFactory::addImage(pixmap, QStringLiteral("PNG"));
       if(!id.isEmpty()) {
         entry->setField(icon, id);
+        m_iconImageIds.insert(item_.iconName(), id);
       }
     }
-
-    m_coll->addEntries(entry);
-
-    if(showProgress && j%stepSize == 0) {
-      ProgressManager::self()->setProgress(this, j);
-      qApp->processEvents();
+  } else {
+    const QString id = ImageFactory::addImage(preview_, QStringLiteral("PNG"));
+    if(!id.isEmpty()) {
+      entry->setField(icon, id);
     }
-    ++j;
-  }
-
-  if(m_cancelled) {
-    m_coll = Data::CollPtr();
-    return m_coll;
   }
-
-  return m_coll;
+  return entry;
 }
 
 QWidget* FileListingImporter::widget(QWidget* parent_) {
@@ -288,7 +370,19 @@ void FileListingImporter::slotEntries(KIO::Job* job_, const KIO::UDSEntryList& l
   for(KIO::UDSEntryList::ConstIterator it = list_.begin(); it != list_.end(); ++it) {
     KFileItem item(*it, url(), false, true);
     if(item.isFile()) {
-      m_files.append(item);
+      m_pendingFiles.append(item);
+    }
+  }
+
+  // hold the listing back while the files are handled, so it can't get ahead of the workers
+  if(m_pendingFiles.count() >= FILE_BATCH_SIZE && !m_processing) {
+    job_->suspend();
+    processFiles();
+    if(m_cancelled) {
+      job_->kill();
+      m_job = nullptr;
+    } else {
+      job_->resume();
     }
   }
 }
@@ -316,6 +410,7 @@ QString FileListingImporter::volumeName() const {
 
 void FileListingImporter::slotCancel() {
   m_cancelled = true;
+  m_stopWorkers.store(1);
   if(m_job) {
     m_job->kill();
   }
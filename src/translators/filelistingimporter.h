@@ -31,16 +31,30 @@
 #include <KFileItem>
 
 #include <QPointer>
+#include <QHash>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QScopedPointer>
 
 class QCheckBox;
+class QPixmap;
 namespace KIO {
   class Job;
 }
 
 namespace Tellico {
+  class FileListingCache;
+
   namespace Import {
 
 /**
+ * The FileListingImporter creates a file catalog from the files in a folder.
+ *
+ * The files are handled in batches as the folder listing arrives, and the listing is suspended
+ * while a batch is handled. The metadata of the files in each batch is read by a bounded pool of
+ * worker threads, while the previews are generated, and the metadata is cached so that scanning
+ * an unchanged folder again does not read any files.
+ *
  * @author Robby Stephenson
  */
 class FileListingImporter : public Importer {
@@ -48,6 +62,7 @@ Q_OBJECT
 
 public:
   FileListingImporter(const QUrl& url);
+  ~FileListingImporter();
 
   /**
    * @return A pointer to a @ref Data::Collection, or 0 if none can be created.
@@ -66,13 +81,23 @@ private Q_SLOTS:
 
 private:
   QString volumeName() const;
+  void processFiles();
+  Data::EntryPtr createEntry(const KFileItem& item, const QString& metaInfo, const QPixmap& preview);
 
   Data::CollPtr m_coll;
   QWidget* m_widget;
   QCheckBox* m_recursive;
   QCheckBox* m_filePreview;
   QPointer<KIO::Job> m_job;
-  KFileItemList m_files;
+  KFileItemList m_pendingFiles;
+  QScopedPointer<FileListingCache> m_cache;
+  QThreadPool m_pool;
+  QAtomicInt m_stopWorkers;
+  QString m_volume;
+  QHash<QString, QString> m_iconImageIds;
+  bool m_usePreview;
+  bool m_processing;
+  uint m_fileCount;
   bool m_cancelled;
 };
 
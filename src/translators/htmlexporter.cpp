@@ -22,7 +22,10 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <config.h>
+
 #include "htmlexporter.h"
+#include "htmlexportmanifest.h"
 #include "xslthandler.h"
 #include "tellicoxmlexporter.h"
 #include "../collection.h"
@@ -60,6 +63,12 @@
 #include <QFileInfo>
 #include <QApplication>
 #include <QLocale>
+#include <QQueue>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <QCryptographicHash>
+#include <QDateTime>
 
 extern "C" {
 #include <libxml/HTMLparser.h>
@@ -68,6 +77,22 @@ extern "C" {
 
 using Tellico::Export::HTMLExporter;
 
+namespace {
+  // the number of entry files waiting to be written, per worker thread
+  static const int ENTRY_FILE_QUEUE_FACTOR = 2;
+
+  // transforms the XML for a single entry and writes the file, run in a worker thread
+  // each handler is a copy, sharing the compiled stylesheet
+  bool writeEntryFile(Tellico::XSLTHandler handler_, xmlDocPtr doc_, const QUrl& url_, bool encodeUTF8_) {
+    const QString text = handler_.process(doc_);
+    if(!Tellico::FileHandler::writeTextURL(url_, text, encodeUTF8_, true /* force */, true /* quiet */)) {
+      myWarning() << "unable to write entry file:" << url_.toLocalFile();
+      return false;
+    }
+    return true;
+  }
+}
+
 HTMLExporter::HTMLExporter(Tellico::Data::CollPtr coll_) : Tellico::Export::Exporter(coll_),
     m_handler(nullptr),
     m_printHeaders(true),
@@ -77,6 +102,7 @@ HTMLExporter::HTMLExporter(Tellico::Data::CollPtr coll_) : Tellico::Export::Expo
     m_parseDOM(true),
     m_checkCreateDir(true),
     m_checkCommonFile(true),
+    m_incremental(false),
     m_imageWidth(0),
     m_imageHeight(0),
     m_widget(nullptr),
@@ -84,6 +110,7 @@ HTMLExporter::HTMLExporter(Tellico::Data::CollPtr coll_) : Tellico::Export::Expo
     m_checkPrintGrouped(nullptr),
     m_checkExportEntryFiles(nullptr),
     m_checkExportImages(nullptr),
+    m_checkIncremental(nullptr),
     m_xsltFile(QStringLiteral("tellico2html.xsl")) {
 }
 
@@ -123,6 +150,13 @@ bool HTMLExporter::exec() {
   }
 
   m_cancelled = false;
+  // an incremental export keeps a manifest of what was written in the file directory
+  const bool incremental = m_incremental && m_exportEntryFiles && m_parseDOM && url().isLocalFile();
+  if(incremental) {
+    const QDir dir(fileDir().toLocalFile());
+    m_manifest.reset(new HTMLExportManifest(dir.filePath(HTMLExportManifest::manifestFileName())));
+    m_manifest->load(manifestKey());
+  }
   // TODO: maybe need label?
   if(options() & ExportProgress) {
     ProgressItem& item = ProgressManager::self()->newProgressItem(this, QString(), true);
@@ -137,6 +171,14 @@ bool HTMLExporter::exec() {
   if(m_parseDOM && !m_cancelled) {
     success &= copyFiles() && (!m_exportEntryFiles || writeEntryFiles());
   }
+  if(incremental) {
+    // an interrupted export leaves the old manifest, so the next one checks everything again
+    if(success && !m_cancelled) {
+      removeOrphans();
+      m_manifest->save();
+    }
+    m_manifest.clear();
+  }
   return success;
 }
 
@@ -214,43 +256,12 @@ bool HTMLExporter::loadXSLTFile() {
 }
 
 QString HTMLExporter::text() {
-  if((!m_handler || !m_handler->isValid()) && !loadXSLTFile()) {
-    myWarning() << "error loading xslt file:" << m_xsltFile;
+  xmlDocPtr output = exportDocument();
+  if(!output) {
     return QString();
   }
 
-  Data::CollPtr coll = collection();
-  if(!coll) {
-    myDebug() << "no collection pointer!";
-    return QString();
-  }
-
-  if(m_groupBy.isEmpty()) {
-    m_printGrouped = false; // can't group if no groups exist
-  }
-
-  GUI::CursorSaver cs;
-  writeImages(coll);
-
-  // now grab the XML
-  TellicoXMLExporter exporter(coll);
-  exporter.setURL(url());
-  exporter.setEntries(entries());
-  exporter.setFields(fields());
-  exporter.setIncludeGroups(m_printGrouped);
-// yes, this should be in utf8, always
-  exporter.setOptions(options() | Export::ExportUTF8 | Export::ExportImages);
-  QDomDocument output = exporter.exportXML();
-#if 0
-  QFile f(QLatin1String("/tmp/test.xml"));
-  if(f.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f);
-    t << output.toString();
-  }
-  f.close();
-#endif
-
-  const QString outputText = m_handler->applyStylesheet(output.toString());
+  const QString outputText = m_handler->process(output);
 #if 0
   myDebug() << "Remove debug2 from htmlexporter.cpp";
   QFile f2(QLatin1String("/tmp/test.html"));
@@ -286,6 +297,42 @@ QString HTMLExporter::text() {
   return allText;
 }
 
+// builds the XML for the collection and writes the images it refers to
+_xmlDoc* HTMLExporter::exportDocument() {
+  if((!m_handler || !m_handler->isValid()) && !loadXSLTFile()) {
+    myWarning() << "error loading xslt file:" << m_xsltFile;
+    return nullptr;
+  }
+
+  Data::CollPtr coll = collection();
+  if(!coll) {
+    myDebug() << "no collection pointer!";
+    return nullptr;
+  }
+
+  if(m_groupBy.isEmpty()) {
+    m_printGrouped = false; // can't group if no groups exist
+  }
+
+  GUI::CursorSaver cs;
+  writeImages(coll);
+
+  // now grab the XML
+  TellicoXMLExporter exporter(coll);
+  exporter.setURL(url());
+  exporter.setEntries(entries());
+  exporter.setFields(fields());
+  exporter.setIncludeGroups(m_printGrouped);
+// yes, this should be in utf8, always
+  exporter.setOptions(options() | Export::ExportUTF8 | Export::ExportImages);
+  xmlDocPtr output = exporter.exportXMLDoc();
+#if 0
+  xmlSaveFormatFile("/tmp/test.xml", output, 1);
+#endif
+
+  return output;
+}
+
 void HTMLExporter::setFormattingOptions(Tellico::Data::CollPtr coll) {
   QString file = Data::Document::self()->URL().fileName();
   if(file != i18n(Tellico::untitledFilename)) {
@@ -463,11 +510,19 @@ void HTMLExporter::writeImages(Tellico::Data::CollPtr coll_) {
         // for link-only images, no need to write it out
         success = ImageFactory::imageInfo(id).linkOnly || ImageFactory::writeCachedImage(id, ImageFactory::TempDir);
       } else {
-        const Data::Image& img = ImageFactory::imageById(id);
         QUrl target = imgDir;
         target = target.adjusted(QUrl::StripTrailingSlash);
         target.setPath(target.path() + QLatin1Char('/') + (id));
-        success = !img.isNull() && FileHandler::writeDataURL(target, img.byteArray(), true);
+        // the image id depends on the data, so an image written earlier is still current
+        if(m_manifest && m_manifest->hasImage(id) && QFile::exists(target.toLocalFile())) {
+          success = true;
+        } else {
+          const Data::Image& img = ImageFactory::imageById(id);
+          success = !img.isNull() && FileHandler::writeDataURL(target, img.byteArray(), true);
+          if(success && m_manifest) {
+            m_manifest->insertImage(id);
+          }
+        }
       }
       if(!success) {
         myWarning() << "unable to write image file: "
@@ -507,9 +562,17 @@ QWidget* HTMLExporter::widget(QWidget* parent_) {
   m_checkExportEntryFiles->setWhatsThis(i18n("If checked, individual files will be created for each entry."));
   m_checkExportEntryFiles->setChecked(m_exportEntryFiles);
 
+  m_checkIncremental = new QCheckBox(i18n("Only write changed entry files"), gbox);
+  m_checkIncremental->setWhatsThis(i18n("If checked, exporting again to the same location only writes the "
+                                        "entry files and images which changed."));
+  m_checkIncremental->setChecked(m_incremental);
+  m_checkIncremental->setEnabled(m_exportEntryFiles);
+  connect(m_checkExportEntryFiles, &QAbstractButton::toggled, m_checkIncremental, &QWidget::setEnabled);
+
   vlay->addWidget(m_checkPrintHeaders);
   vlay->addWidget(m_checkPrintGrouped);
   vlay->addWidget(m_checkExportEntryFiles);
+  vlay->addWidget(m_checkIncremental);
 
   l->addWidget(gbox);
   l->addStretch(1);
@@ -521,6 +584,7 @@ void HTMLExporter::readOptions(KSharedConfigPtr config_) {
   m_printHeaders = exportConfig.readEntry("Print Field Headers", m_printHeaders);
   m_printGrouped = exportConfig.readEntry("Print Grouped", m_printGrouped);
   m_exportEntryFiles = exportConfig.readEntry("Export Entry Files", m_exportEntryFiles);
+  m_incremental = exportConfig.readEntry("Incremental Export", m_incremental);
 
   // read current entry export template
   m_entryXSLTFile = Config::templateName(collection()->type());
@@ -536,6 +600,8 @@ void HTMLExporter::saveOptions(KSharedConfigPtr config_) {
   cfg.writeEntry("Print Grouped", m_printGrouped);
   m_exportEntryFiles = m_checkExportEntryFiles->isChecked();
   cfg.writeEntry("Export Entry Files", m_exportEntryFiles);
+  m_incremental = m_checkIncremental->isChecked();
+  cfg.writeEntry("Incremental Export", m_incremental);
 }
 
 void HTMLExporter::setXSLTFile(const QString& filename_) {
@@ -754,13 +820,24 @@ bool HTMLExporter::writeEntryFiles() {
   exporter.setOptions(opt);
   exporter.setXSLTFile(m_entryXSLTFile);
   exporter.setCollectionURL(url());
+  exporter.m_manifest = m_manifest;
   bool parseDOM = true;
 
+  // once the first entry file is done, the rest only need the XSLT transform. For local files,
+  // that's done in worker threads, while the XML is built and the images are written here
+  const bool useThreads = outputFile.isLocalFile() && QThread::idealThreadCount() > 1;
+  QThreadPool pool;
+  const int maxPending = ENTRY_FILE_QUEUE_FACTOR * pool.maxThreadCount();
+  QQueue< QFuture<bool> > pending;
+
   const QString title = QStringLiteral("title");
   const QString html = QStringLiteral(".html");
   bool multipleTitles = collection()->fieldByName(title)->hasFlag(Data::Field::AllowMultiple);
   Data::EntryList entries = this->entries(); // not const since the pointer has to be copied
   foreach(Data::EntryPtr entryIt, entries) {
+    if(m_cancelled) {
+      break;
+    }
     QString file = entryIt->formattedField(title, formatted);
 
     // but only use the first title if it has multiple
@@ -772,12 +849,38 @@ bool HTMLExporter::writeEntryFiles() {
     outputFile = outputFile.adjusted(QUrl::RemoveFilename);
     outputFile.setPath(outputFile.path() + file);
 
+    // for an incremental export, an entry file is only written if the entry changed
+    bool isCurrent = false;
+    if(m_manifest) {
+      const QString mdate = entryIt->field(QStringLiteral("mdate"));
+      const QByteArray hash = entryHash(entryIt);
+      isCurrent = m_manifest->isCurrent(file, mdate, hash) && QFile::exists(outputFile.toLocalFile());
+      if(!isCurrent) {
+        m_manifest->insertFile(file, mdate, hash);
+      }
+    }
+
     exporter.setEntries(Data::EntryList() << entryIt);
     exporter.setURL(outputFile);
-    exporter.exec();
+
+    if(isCurrent) {
+      // nothing to write
+    } else if(useThreads && !parseDOM) {
+      // keep the number of pages waiting to be written bounded
+      while(pending.count() >= maxPending) {
+        pending.dequeue().waitForFinished();
+      }
+      xmlDocPtr doc = exporter.exportDocument();
+      if(doc) {
+        pending.enqueue(QtConcurrent::run(&pool, writeEntryFile, *exporter.m_handler, doc, outputFile,
+                                          bool(exporter.options() & Export::ExportUTF8)));
+      }
+    } else {
+      exporter.exec();
+    }
 
     // no longer need to parse DOM
-    if(parseDOM) {
+    if(parseDOM && !isCurrent) {
       parseDOM = false;
       exporter.setParseDOM(false);
       // this is rather stupid, but I'm too lazy to figure out the better way
@@ -795,6 +898,9 @@ bool HTMLExporter::writeEntryFiles() {
     }
     ++j;
   }
+  while(!pending.isEmpty()) {
+    pending.dequeue().waitForFinished();
+  }
   // the images in "pics/" are special data images, copy them always
   // since the entry files may refer to them, but we don't know that
   QStringList dataImages;
@@ -823,6 +929,52 @@ bool HTMLExporter::writeEntryFiles() {
   return true;
 }
 
+// everything besides the entry values which goes into the entry files
+QByteArray HTMLExporter::manifestKey() const {
+  Data::CollPtr coll = collection();
+  QStringList values;
+  values << QLatin1String(TELLICO_VERSION) << QLocale().name() << url().fileName()
+         << m_entryXSLTFile << QString::number(QFileInfo(m_entryXSLTFile).lastModified().toMSecsSinceEpoch())
+         << QString::number(options() & ~(Export::ExportForce | Export::ExportProgress))
+         << QString::number(m_imageWidth) << QString::number(m_imageHeight);
+  if(coll) {
+    const int type = coll->type();
+    values << coll->title()
+           << Config::templateFont(type).toString()
+           << Config::templateBaseColor(type).name()
+           << Config::templateTextColor(type).name()
+           << Config::templateHighlightedTextColor(type).name()
+           << Config::templateHighlightedBaseColor(type).name();
+  }
+  foreach(Data::FieldPtr field, fields()) {
+    values << field->name() << field->title() << field->category()
+           << QString::number(field->type()) << QString::number(field->flags())
+           << QString::number(field->formatType());
+  }
+  return QCryptographicHash::hash(values.join(QLatin1Char('\n')).toUtf8(), QCryptographicHash::Md5);
+}
+
+QByteArray HTMLExporter::entryHash(Tellico::Data::EntryPtr entry_) const {
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  foreach(Data::FieldPtr field, fields()) {
+    hash.addData(field->name().toUtf8());
+    hash.addData("=", 1);
+    hash.addData(entry_->field(field).toUtf8());
+    hash.addData("\n", 1);
+  }
+  return hash.result();
+}
+
+void HTMLExporter::removeOrphans() {
+  const QDir dir(fileDir().toLocalFile());
+  const QStringList orphans = m_manifest->orphanFiles() + m_manifest->orphanImages();
+  foreach(const QString& orphan, orphans) {
+    if(dir.exists(orphan) && !dir.remove(orphan)) {
+      myDebug() << "Unable to remove" << dir.filePath(orphan);
+    }
+  }
+}
+
 void HTMLExporter::slotCancel() {
   m_cancelled = true;
 }
@@ -30,6 +30,7 @@
 
 #include <QStringList>
 #include <QHash>
+#include <QSharedPointer>
 
 #include <libxml/xmlstring.h>
 
@@ -37,6 +38,7 @@ class QCheckBox;
 
 extern "C" {
   struct _xmlNode;
+  struct _xmlDoc;
 }
 
 class HtmlExporterTest;
@@ -48,6 +50,7 @@ namespace Tellico {
   class XSLTHandler;
 
   namespace Export {
+    class HTMLExportManifest;
 
 /**
  * @author Robby Stephenson
@@ -82,6 +85,11 @@ public:
   void setColumns(const QStringList& columns) { m_columns = columns; }
   void setParseDOM(bool parseDOM) { m_parseDOM = parseDOM; reset(); }
   void setExportEntryFiles(bool exportEntryFiles) { m_exportEntryFiles = exportEntryFiles; }
+  /**
+   * Sets whether exporting entry files again to the same local directory only writes the
+   * entry files and images which changed, and removes the ones no longer exported.
+   */
+  void setIncremental(bool incremental) { m_incremental = incremental; }
 
   QString text();
 
@@ -90,8 +98,12 @@ public Q_SLOTS:
 
 private:
   void setFormattingOptions(Data::CollPtr coll);
+  _xmlDoc* exportDocument();
   void writeImages(Data::CollPtr coll);
   bool writeEntryFiles();
+  QByteArray manifestKey() const;
+  QByteArray entryHash(Data::EntryPtr entry) const;
+  void removeOrphans();
   QUrl fileDir() const;
   QString fileDirName() const;
 
@@ -112,6 +124,7 @@ private:
   bool m_parseDOM : 1;
   bool m_checkCreateDir : 1;
   bool m_checkCommonFile : 1;
+  bool m_incremental : 1;
   int m_imageWidth;
   int m_imageHeight;
 
@@ -120,6 +133,7 @@ private:
   QCheckBox* m_checkPrintGrouped;
   QCheckBox* m_checkExportEntryFiles;
   QCheckBox* m_checkExportImages;
+  QCheckBox* m_checkIncremental;
 
   QUrl m_collectionURL;
   QString m_xsltFile;
@@ -135,6 +149,8 @@ private:
   QList<QUrl> m_files;
   QHash<QString, QString> m_links;
   StringSet m_copiedFiles;
+  // shared with the exporter for the entry files
+  QSharedPointer<HTMLExportManifest> m_manifest;
 };
 
   } // end namespace
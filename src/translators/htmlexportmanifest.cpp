@@ -0,0 +1,178 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "htmlexportmanifest.h"
+#include "../tellico_debug.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+namespace {
+  static const quint32 HTML_MANIFEST_MAGIC = 0x5448454d; // "THEM"
+  static const quint32 HTML_MANIFEST_VERSION = 1;
+}
+
+using Tellico::Export::HTMLExportManifest;
+
+HTMLExportManifest::HTMLExportManifest(const QString& fileName_) : m_fileName(fileName_), m_keyChanged(false) {
+}
+
+QString HTMLExportManifest::manifestFileName() {
+  return QStringLiteral(".tellico-export-manifest");
+}
+
+bool HTMLExportManifest::load(const QByteArray& key_) {
+  m_key = key_;
+  m_keyChanged = false;
+  m_files.clear();
+  m_images.clear();
+
+  QFile file(m_fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_6);
+
+  quint32 magic, version;
+  QByteArray key;
+  in >> magic >> version;
+  if(magic != HTML_MANIFEST_MAGIC || version != HTML_MANIFEST_VERSION) {
+    return false;
+  }
+  in >> key;
+  // the records are still read, so that the old files can be found as orphans
+  m_keyChanged = (key != m_key);
+
+  quint32 count;
+  in >> count;
+  m_files.reserve(count);
+  for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+    QString fileName;
+    Record record;
+    in >> fileName >> record.mdate >> record.hash;
+    record.used = false;
+    m_files.insert(fileName, record);
+  }
+  in >> count;
+  m_images.reserve(count);
+  for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+    QString id;
+    in >> id;
+    m_images.insert(id, false);
+  }
+  if(in.status() != QDataStream::Ok) {
+    myDebug() << "Unable to read HTML export manifest:" << m_fileName;
+    m_files.clear();
+    m_images.clear();
+    return false;
+  }
+  return true;
+}
+
+bool HTMLExportManifest::save() {
+  QSaveFile file(m_fileName);
+  if(!file.open(QIODevice::WriteOnly)) {
+    myDebug() << "Unable to write HTML export manifest:" << file.fileName();
+    return false;
+  }
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_6);
+
+  out << HTML_MANIFEST_MAGIC << HTML_MANIFEST_VERSION << m_key;
+
+  quint32 count = 0;
+  QHash<QString, Record>::ConstIterator it = m_files.constBegin();
+  for( ; it != m_files.constEnd(); ++it) {
+    if(it.value().used) {
+      ++count;
+    }
+  }
+  out << count;
+  for(it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+    if(it.value().used) {
+      out << it.key() << it.value().mdate << it.value().hash;
+    }
+  }
+
+  const QStringList images = m_images.keys(true);
+  out << quint32(images.count());
+  foreach(const QString& id, images) {
+    out << id;
+  }
+
+  if(!file.commit()) {
+    myDebug() << "Unable to write HTML export manifest:" << file.fileName();
+    return false;
+  }
+  return true;
+}
+
+bool HTMLExportManifest::isCurrent(const QString& fileName_, const QString& mdate_, const QByteArray& hash_) {
+  QHash<QString, Record>::Iterator it = m_files.find(fileName_);
+  if(it == m_files.end() || m_keyChanged ||
+     it.value().mdate != mdate_ || it.value().hash != hash_) {
+    return false;
+  }
+  it.value().used = true;
+  return true;
+}
+
+void HTMLExportManifest::insertFile(const QString& fileName_, const QString& mdate_, const QByteArray& hash_) {
+  Record record;
+  record.mdate = mdate_;
+  record.hash = hash_;
+  record.used = true;
+  m_files.insert(fileName_, record);
+}
+
+bool HTMLExportManifest::hasImage(const QString& id_) {
+  QHash<QString, bool>::Iterator it = m_images.find(id_);
+  if(it == m_images.end()) {
+    return false;
+  }
+  it.value() = true;
+  return true;
+}
+
+void HTMLExportManifest::insertImage(const QString& id_) {
+  m_images.insert(id_, true);
+}
+
+QStringList HTMLExportManifest::orphanFiles() const {
+  QStringList files;
+  QHash<QString, Record>::ConstIterator it = m_files.constBegin();
+  for( ; it != m_files.constEnd(); ++it) {
+    if(!it.value().used) {
+      files << it.key();
+    }
+  }
+  return files;
+}
+
+QStringList HTMLExportManifest::orphanImages() const {
+  return m_images.keys(false);
+}
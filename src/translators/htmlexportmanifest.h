@@ -0,0 +1,116 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef TELLICO_HTMLEXPORTMANIFEST_H
+#define TELLICO_HTMLEXPORTMANIFEST_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+
+namespace Tellico {
+  namespace Export {
+
+/**
+ * The HTMLExportManifest records what an HTML export wrote to its file directory, so that
+ * exporting again to the same place only has to write the entry files and images which changed.
+ *
+ * Each entry file is recorded with the modified date of the entry and a hash of its values.
+ * The manifest also has a key for everything else which goes into the entry files, like the
+ * template and the export options. If the key changes, every entry file is out of date.
+ * Images are named by their id, which already depends on the image data, so only the id is
+ * recorded. Anything in the manifest which is not used by the current export is an orphan,
+ * left from an entry or image no longer in the collection.
+ *
+ * @author agent
+ */
+class HTMLExportManifest {
+public:
+  /**
+   * @param fileName The file the manifest is read from and written to
+   */
+  explicit HTMLExportManifest(const QString& fileName);
+
+  /**
+   * Returns the name of the manifest file in an export directory.
+   */
+  static QString manifestFileName();
+
+  /**
+   * Reads the manifest file. A missing file leaves the manifest empty.
+   *
+   * @param key The key for the current export, compared to the one in the file
+   */
+  bool load(const QByteArray& key);
+  /**
+   * Writes the manifest file, with only the entry files and images used since it was loaded.
+   */
+  bool save();
+
+  /**
+   * Checks if an entry file is still current, which also marks it to be kept when saved.
+   *
+   * @param fileName The name of the entry file
+   * @param mdate The modified date of the entry
+   * @param hash The hash of the entry values
+   */
+  bool isCurrent(const QString& fileName, const QString& mdate, const QByteArray& hash);
+  /**
+   * Adds an entry file, replacing any earlier record for it.
+   */
+  void insertFile(const QString& fileName, const QString& mdate, const QByteArray& hash);
+  /**
+   * Checks if an image was written by an earlier export, which also marks it to be kept.
+   */
+  bool hasImage(const QString& id);
+  void insertImage(const QString& id);
+
+  /**
+   * Returns the entry files read from the manifest which have not been used since.
+   */
+  QStringList orphanFiles() const;
+  /**
+   * Returns the images read from the manifest which have not been used since.
+   */
+  QStringList orphanImages() const;
+
+private:
+  struct Record {
+    QString mdate;
+    QByteArray hash;
+    bool used;
+  };
+
+  QString m_fileName;
+  QByteArray m_key;
+  bool m_keyChanged;
+  QHash<QString, Record> m_files;
+  QHash<QString, bool> m_images;
+};
+
+  } // end namespace
+} // end namespace
+#endif
@@ -156,16 +156,11 @@ QString ONIXExporter::text() {
   exporter.setIncludeImages(false); // do not include images in XML
 // yes, this should be in utf8, always
   exporter.setOptions(options() | Export::ExportUTF8);
-  QDomDocument output = exporter.exportXML();
+  xmlDocPtr output = exporter.exportXMLDoc();
 #if 0
-  QFile f(QLatin1String("/tmp/test.xml"));
-  if(f.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f);
-    t << output.toString();
-  }
-  f.close();
+  xmlSaveFormatFile("/tmp/test.xml", output, 1);
 #endif
-  return m_handler->applyStylesheet(output.toString());
+  return m_handler->process(output);
 }
 
 QWidget* ONIXExporter::widget(QWidget* parent_) {
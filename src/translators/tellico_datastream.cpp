@@ -0,0 +1,136 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tellico_datastream.h"
+#include "../collection.h"
+#include "../field.h"
+#include "../filter.h"
+#include "../borrower.h"
+
+#include <QDataStream>
+
+void Tellico::DataStream::writeField(QDataStream& out_, Tellico::Data::FieldPtr field_) {
+  out_ << field_->name() << field_->title() << qint32(field_->type()) << field_->category()
+       << qint32(field_->flags()) << qint32(field_->formatType()) << field_->description()
+       << field_->allowed() << field_->propertyList();
+}
+
+Tellico::Data::FieldPtr Tellico::DataStream::readField(QDataStream& in_) {
+  QString name, title, category, description;
+  qint32 type, flags, formatType;
+  QStringList allowed;
+  StringMap properties;
+  in_ >> name >> title >> type >> category >> flags >> formatType >> description
+      >> allowed >> properties;
+  if(in_.status() != QDataStream::Ok) {
+    return Data::FieldPtr();
+  }
+  Data::FieldPtr field;
+  // the choice constructor is the only one that takes the allowed values
+  if(type == Data::Field::Choice) {
+    field = new Data::Field(name, title, allowed);
+  } else {
+    field = new Data::Field(name, title, static_cast<Data::Field::Type>(type));
+  }
+  field->setCategory(category);
+  field->setFlags(flags);
+  field->setFormatType(static_cast<FieldFormat::Type>(formatType));
+  field->setDescription(description);
+  field->setPropertyList(properties);
+  return field;
+}
+
+void Tellico::DataStream::writeFilters(QDataStream& out_, const Tellico::FilterList& filters_) {
+  out_ << quint32(filters_.count());
+  foreach(FilterPtr filter, filters_) {
+    out_ << filter->name() << qint32(filter->op()) << quint32(filter->count());
+    foreach(const FilterRule* rule, *filter) {
+      out_ << rule->fieldName() << rule->pattern() << qint32(rule->function());
+    }
+  }
+}
+
+Tellico::FilterList Tellico::DataStream::readFilters(QDataStream& in_) {
+  FilterList filters;
+  quint32 filterCount;
+  in_ >> filterCount;
+  for(quint32 i = 0; i < filterCount && in_.status() == QDataStream::Ok; ++i) {
+    QString name;
+    qint32 op;
+    quint32 ruleCount;
+    in_ >> name >> op >> ruleCount;
+    FilterPtr filter(new Filter(static_cast<Filter::FilterOp>(op)));
+    filter->setName(name);
+    for(quint32 j = 0; j < ruleCount && in_.status() == QDataStream::Ok; ++j) {
+      QString fieldName, pattern;
+      qint32 function;
+      in_ >> fieldName >> pattern >> function;
+      filter->append(new FilterRule(fieldName, pattern, static_cast<FilterRule::Function>(function)));
+    }
+    filters.append(filter);
+  }
+  return filters;
+}
+
+void Tellico::DataStream::writeBorrowers(QDataStream& out_, const Tellico::Data::BorrowerList& borrowers_) {
+  out_ << quint32(borrowers_.count());
+  foreach(Data::BorrowerPtr borrower, borrowers_) {
+    out_ << borrower->name() << borrower->uid() << quint32(borrower->loans().count());
+    foreach(Data::LoanPtr loan, borrower->loans()) {
+      out_ << loan->uid() << qint32(loan->entry() ? loan->entry()->id() : -1)
+           << loan->loanDate() << loan->dueDate() << loan->note() << loan->inCalendar();
+    }
+  }
+}
+
+Tellico::Data::BorrowerList Tellico::DataStream::readBorrowers(QDataStream& in_, Tellico::Data::CollPtr coll_) {
+  Data::BorrowerList borrowers;
+  quint32 borrowerCount;
+  in_ >> borrowerCount;
+  for(quint32 i = 0; i < borrowerCount && in_.status() == QDataStream::Ok; ++i) {
+    QString name, uid;
+    quint32 loanCount;
+    in_ >> name >> uid >> loanCount;
+    Data::BorrowerPtr borrower(new Data::Borrower(name, uid));
+    for(quint32 j = 0; j < loanCount && in_.status() == QDataStream::Ok; ++j) {
+      QString loanUid, note;
+      qint32 entryId;
+      QDate loanDate, dueDate;
+      bool inCalendar;
+      in_ >> loanUid >> entryId >> loanDate >> dueDate >> note >> inCalendar;
+      Data::EntryPtr entry = coll_->entryById(entryId);
+      if(!entry) {
+        continue;
+      }
+      Data::LoanPtr loan(new Data::Loan(entry, loanDate, dueDate, note));
+      loan->setUID(loanUid);
+      loan->setInCalendar(inCalendar);
+      borrower->addLoan(loan);
+    }
+    if(!borrower->isEmpty()) {
+      borrowers.append(borrower);
+    }
+  }
+  return borrowers;
+}
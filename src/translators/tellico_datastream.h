@@ -1,5 +1,5 @@
 /***************************************************************************
-    Copyright (C) 2008-2009 Robby Stephenson <robby@periapsis.org>
+    Copyright (C) 2026 agent <agent@local>
  ***************************************************************************/
 
 /***************************************************************************
@@ -22,43 +22,28 @@
  *                                                                         *
  ***************************************************************************/
 
-#ifndef TELLICO_IMPORT_TELLICOXMLHANDLER_H
-#define TELLICO_IMPORT_TELLICOXMLHANDLER_H
+#ifndef TELLICO_DATASTREAM_H
+#define TELLICO_DATASTREAM_H
 
-#include "xmlstatehandler.h"
+#include "../datavectors.h"
 
-#include <QStack>
+class QDataStream;
 
 namespace Tellico {
-  namespace Import {
-
-class TellicoXMLHandler : public QXmlDefaultHandler {
-public:
-  TellicoXMLHandler();
-  ~TellicoXMLHandler();
-
-  virtual bool startElement(const QString& namespaceURI, const QString& localName,
-                            const QString& qName, const QXmlAttributes& atts) Q_DECL_OVERRIDE;
-  virtual bool endElement(const QString& namespaceURI, const QString& localName,
-                          const QString& qName) Q_DECL_OVERRIDE;
-  virtual bool characters(const QString& ch) Q_DECL_OVERRIDE;
-
-  virtual QString errorString() const Q_DECL_OVERRIDE;
-
-  Data::CollPtr collection() const;
-  bool hasImages() const;
-
-  void setLoadImages(bool loadImages);
-  void setShowImageLoadErrors(bool showImageErrors);
-
-  bool fatalError(const QXmlParseException& exception) Q_DECL_OVERRIDE;
-
-private:
-  QStack<SAX::StateHandler*> m_handlers;
-  SAX::StateData* m_data;
-  QString m_errorString;
-};
-
+  /**
+   * The binary layout of the collection objects shared by the document snapshot and the journal
+   */
+  namespace DataStream {
+    void writeField(QDataStream& out, Data::FieldPtr field);
+    Data::FieldPtr readField(QDataStream& in);
+
+    void writeFilters(QDataStream& out, const FilterList& filters);
+    FilterList readFilters(QDataStream& in);
+
+    void writeBorrowers(QDataStream& out, const Data::BorrowerList& borrowers);
+    // loans for entries not in the collection are dropped, along with any borrower left without loans
+    Data::BorrowerList readBorrowers(QDataStream& in, Data::CollPtr coll);
   }
 }
+
 #endif
@@ -23,7 +23,7 @@
  ***************************************************************************/
 
 #include "tellicoimporter.h"
-#include "tellicoxmlhandler.h"
+#include "tellicoxmlreader.h"
 #include "tellico_xml.h"
 #include "../collectionfactory.h"
 #include "../entry.h"
@@ -34,6 +34,7 @@
 #include "../core/tellico_strings.h"
 #include "../utils/guiproxy.h"
 #include "../utils/tellico_utils.h"
+#include "../utils/phasetimer.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -44,6 +45,7 @@
 #include <QTimer>
 #include <QApplication>
 #include <QPointer>
+#include <QThread>
 
 using Tellico::Import::TellicoImporter;
 
@@ -92,12 +94,14 @@ Tellico::Data::CollPtr TellicoImporter::collection() {
 
   // hack for processEvents and deletion
   QPointer<TellicoImporter> thisPtr(this);
+  PhaseTimer timer("Read Tellico file", PhaseTimer::Operation);
 
   // need to decide if the data is xml text, or a zip file
   // if the first 5 characters are <?xml then treat it like text
   if(s[0] == '<' && s[1] == '?' && s[2] == 'x' && s[3] == 'm' && s[4] == 'l') {
     m_format = XML;
-    loadXMLData(source() == URL ? fileRef().file()->readAll() : data(), true);
+    // the file is mapped rather than copied, the data is only used while the importer exists
+    loadXMLData(source() == URL ? fileRef().data() : data(), true);
   } else {
     m_format = Zip;
     loadZipData();
@@ -107,44 +111,21 @@ Tellico::Data::CollPtr TellicoImporter::collection() {
 
 void TellicoImporter::loadXMLData(const QByteArray& data_, bool loadImages_) {
   const bool showProgress = options() & ImportProgress;
+  PhaseTimer timer("Parse XML");
 
-  TellicoXMLHandler handler;
-  handler.setLoadImages(loadImages_);
-  handler.setShowImageLoadErrors(options() & ImportShowImageErrors);
-
-  QXmlSimpleReader reader;
-  reader.setContentHandler(&handler);
-  reader.setErrorHandler(&handler);
-
-  QXmlInputSource source;
-  source.setData(QByteArray()); // necessary
-  bool success = reader.parse(&source, true);
+  TellicoXMLReader reader(data_);
+  reader.setLoadImages(loadImages_);
+  reader.setShowImageLoadErrors(options() & ImportShowImageErrors);
+  reader.setThreadCount(QThread::idealThreadCount());
 
   const int blockSize = data_.size()/100 + 1;
-  int pos = 0;
   emit signalTotalSteps(this, data_.size());
 
   // hack to allow processEvents
   QPointer<TellicoImporter> thisPtr(this);
-  while(thisPtr && success && !m_cancelled && pos < data_.size()) {
-    uint size = qMin(blockSize, data_.size() - pos);
-    QByteArray block = QByteArray::fromRawData(data_.data() + pos, size);
-    source.setData(block);
-    success = reader.parseContinue();
-    if(!success) {
-      // could be bug 418067 where version of Tellico < 3.3 could use invalid XML names
-      // try to recover. If it's not a bad field name, this should be a pretty quick check
-      myDebug() << "XML parsing failed. Attempting to recover.";
-      const QByteArray newData = XML::recoverFromBadXMLName(data_);
-      if(newData.length() < data_.length()) {
-        myDebug() << "Reloading the XML data.";
-        loadXMLData(newData, loadImages_);
-        return;
-      }
-    }
-    pos += blockSize;
-    if(thisPtr && showProgress) {
-      emit signalProgress(this, pos);
+  while(thisPtr && !m_cancelled && reader.read(blockSize)) {
+    if(showProgress) {
+      emit signalProgress(this, reader.bytesRead());
       qApp->processEvents();
     }
   }
@@ -152,13 +133,23 @@ void TellicoImporter::loadXMLData(const QByteArray& data_, bool loadImages_) {
     return;
   }
 
-  if(!success) {
+  if(reader.hasError()) {
+    // could be bug 418067 where version of Tellico < 3.3 could use invalid XML names
+    // try to recover. If it's not a bad field name, this should be a pretty quick check
+    myDebug() << "XML parsing failed. Attempting to recover.";
+    const QByteArray newData = XML::recoverFromBadXMLName(data_);
+    if(newData.length() < data_.length()) {
+      myDebug() << "Reloading the XML data.";
+      loadXMLData(newData, loadImages_);
+      return;
+    }
+
     m_format = Error;
     QString error;
     if(!url().isEmpty()) {
       error = i18n(errorLoad).arg(url().fileName());
     }
-    const QString errorString = handler.errorString();
+    const QString errorString = reader.errorString();
     if(!errorString.isEmpty()) {
       error += QStringLiteral("\n") + errorString;
     }
@@ -168,8 +159,11 @@ void TellicoImporter::loadXMLData(const QByteArray& data_, bool loadImages_) {
   }
 
   if(!m_cancelled) {
-    m_hasImages = handler.hasImages();
-    m_coll = handler.collection();
+    m_hasImages = reader.hasImages();
+    m_coll = reader.collection();
+    if(m_coll) {
+      timer.setCount(m_coll->entryCount());
+    }
   }
 }
 
@@ -267,6 +261,7 @@ void TellicoImporter::loadZipData() {
     return;
   }
 
+  PhaseTimer timer("Read images");
   const QStringList images = m_imgDir->entries();
   const uint stepSize = qMax(s_stepSize, static_cast<uint>(images.count())/100);
 
@@ -277,6 +272,7 @@ void TellicoImporter::loadZipData() {
       ImageFactory::addImage(static_cast<const KArchiveFile*>(file)->data(),
                              (*it).section(QLatin1Char('.'), -1).toUpper(), (*it));
       m_images.remove(*it);
+      timer.addCount();
     }
     if(j%stepSize == 0) {
       qApp->processEvents();
@@ -318,6 +314,10 @@ KZip* TellicoImporter::takeImages() {
   return zip;
 }
 
+QString TellicoImporter::zipFileName() const {
+  return source() == URL && m_format == Zip ? fileRef().fileName() : QString();
+}
+
 void TellicoImporter::slotCancel() {
   m_cancelled = true;
   m_format = Cancel;
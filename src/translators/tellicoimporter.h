@@ -76,6 +76,11 @@ public:
 
   // take ownership of zip object with images
   KZip* takeImages();
+  /**
+   * Returns the local zip file the images are in. For a remote file, this is the downloaded
+   * copy, which is only kept as long as the importer.
+   */
+  QString zipFileName() const;
 
   static bool loadAllImages(const QUrl& url);
 
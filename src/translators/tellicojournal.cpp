@@ -0,0 +1,510 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tellicojournal.h"
+#include "tellico_datastream.h"
+#include "../collection.h"
+#include "../collections/bibtexcollection.h"
+#include "../entry.h"
+#include "../field.h"
+#include "../filter.h"
+#include "../borrower.h"
+#include "../tellico_debug.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+
+#include <algorithm>
+#include <unistd.h>
+
+using Tellico::TellicoJournal;
+
+namespace {
+  static const quint32 JOURNAL_MAGIC = 0x54434a4c; // "TCJL"
+  static const quint32 JOURNAL_VERSION = 1;
+
+  // each batch is a list of records, in the order they get applied
+  enum RecordType {
+    TitleRecord = 1,
+    FieldRemoveRecord,
+    FieldRecord,
+    FieldOrderRecord,
+    EntryRemoveRecord,
+    EntryRecord,
+    FilterRecord,
+    BorrowerRecord,
+    BibtexRecord
+  };
+
+  bool applyChanges(Tellico::Data::CollPtr coll_, const QByteArray& data_) {
+    using namespace Tellico;
+    QDataStream in(data_);
+    in.setVersion(QDataStream::Qt_5_6);
+    while(!in.atEnd() && in.status() == QDataStream::Ok) {
+      quint8 type;
+      in >> type;
+      switch(type) {
+        case TitleRecord:
+          {
+            QString title;
+            in >> title;
+            coll_->setTitle(title);
+          }
+          break;
+
+        case FieldRemoveRecord:
+          {
+            QString name;
+            in >> name;
+            if(coll_->hasField(name)) {
+              coll_->removeField(name, true /* force */);
+            }
+          }
+          break;
+
+        case FieldRecord:
+          {
+            Data::FieldPtr field = DataStream::readField(in);
+            if(!field) {
+              break;
+            }
+            if(coll_->hasField(field->name())) {
+              coll_->modifyField(field);
+            } else {
+              coll_->addField(field);
+            }
+          }
+          break;
+
+        case FieldOrderRecord:
+          {
+            QStringList names;
+            in >> names;
+            Data::FieldList fields;
+            foreach(const QString& name, names) {
+              Data::FieldPtr field = coll_->fieldByName(name);
+              if(field) {
+                fields.append(field);
+              }
+            }
+            // reorderFields() takes the full list, so keep any field not in the record
+            foreach(Data::FieldPtr field, coll_->fields()) {
+              if(!fields.contains(field)) {
+                fields.append(field);
+              }
+            }
+            coll_->reorderFields(fields);
+          }
+          break;
+
+        case EntryRemoveRecord:
+          {
+            qint32 id;
+            in >> id;
+            Data::EntryPtr entry = coll_->entryById(id);
+            if(entry) {
+              coll_->removeEntries(Data::EntryList() << entry);
+            }
+          }
+          break;
+
+        case EntryRecord:
+          {
+            qint32 id;
+            StringMap values;
+            in >> id >> values;
+            if(in.status() != QDataStream::Ok) {
+              break;
+            }
+            Data::EntryPtr entry = coll_->entryById(id);
+            const bool isNew = !entry;
+            if(isNew) {
+              entry = new Data::Entry(coll_, id);
+            } else {
+              // the record has every value, so anything missing has been cleared
+              foreach(Data::FieldPtr field, coll_->fields()) {
+                if(!field->hasFlag(Data::Field::Derived) && !values.contains(field->name())) {
+                  entry->setField(field->name(), QString(), false /* no modified date update */);
+                }
+              }
+            }
+            for(StringMap::ConstIterator it = values.constBegin(); it != values.constEnd(); ++it) {
+              entry->setField(it.key(), it.value(), false /* no modified date update */);
+            }
+            if(isNew) {
+              coll_->addEntries(entry);
+            }
+          }
+          break;
+
+        case FilterRecord:
+          {
+            const FilterList filters = DataStream::readFilters(in);
+            foreach(FilterPtr filter, coll_->filters()) {
+              coll_->removeFilter(filter);
+            }
+            foreach(FilterPtr filter, filters) {
+              coll_->addFilter(filter);
+            }
+          }
+          break;
+
+        case BorrowerRecord:
+          {
+            const Data::BorrowerList borrowers = DataStream::readBorrowers(in, coll_);
+            // there's no way to remove a borrower, but one without loans doesn't get saved
+            foreach(Data::BorrowerPtr borrower, coll_->borrowers()) {
+              foreach(Data::LoanPtr loan, borrower->loans()) {
+                borrower->removeLoan(loan);
+              }
+            }
+            foreach(Data::BorrowerPtr borrower, borrowers) {
+              coll_->addBorrower(borrower);
+            }
+          }
+          break;
+
+        case BibtexRecord:
+          {
+            QString preamble;
+            StringMap macros;
+            in >> preamble >> macros;
+            if(coll_->type() == Data::Collection::Bibtex) {
+              Data::BibtexCollection* c = static_cast<Data::BibtexCollection*>(coll_.data());
+              c->setPreamble(preamble);
+              c->setMacroList(macros);
+            }
+          }
+          break;
+
+        default:
+          myDebug() << "Unknown journal record:" << type;
+          return false;
+      }
+    }
+    return in.status() == QDataStream::Ok;
+  }
+}
+
+TellicoJournal::TellicoJournal() : Observer(), m_valid(false), m_baseSize(0), m_baseModified(0), m_size(0),
+    m_filtersModified(false), m_borrowersModified(false) {
+}
+
+QString TellicoJournal::journalFileName(const QUrl& url_) {
+  return url_.toLocalFile() + QLatin1String(".journal");
+}
+
+void TellicoJournal::remove(const QUrl& url_) {
+  if(url_.isLocalFile()) {
+    QFile::remove(journalFileName(url_));
+  }
+}
+
+void TellicoJournal::setCollection(Tellico::Data::CollPtr coll_, const QUrl& url_) {
+  m_coll = coll_;
+  m_url = url_;
+  m_size = 0;
+  m_valid = m_coll && m_url.isLocalFile() && baseInfo(m_baseSize, m_baseModified);
+  markCurrent();
+}
+
+int TellicoJournal::replay(Tellico::Data::CollPtr coll_, const QUrl& url_) {
+  setCollection(coll_, url_);
+  if(!m_valid) {
+    return 0;
+  }
+  QFile file(journalFileName(url_));
+  if(!file.exists() || !file.open(QIODevice::ReadOnly)) {
+    return 0;
+  }
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_6);
+
+  quint32 magic, version;
+  qint64 baseSize, baseModified;
+  in >> magic >> version >> baseSize >> baseModified;
+  if(in.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION) {
+    myDebug() << "Unable to read journal:" << file.fileName();
+    return 0;
+  }
+  // the journal only applies to the file as it was when the journal was started
+  if(baseSize != m_baseSize || baseModified != m_baseModified) {
+    myLog() << "Journal is out of date:" << file.fileName();
+    return 0;
+  }
+
+  int count = 0;
+  qint64 size = file.pos();
+  while(!in.atEnd()) {
+    QByteArray batch;
+    quint16 checksum;
+    in >> batch >> checksum;
+    if(in.status() != QDataStream::Ok || checksum != qChecksum(batch.constData(), batch.size())) {
+      myLog() << "Ignoring incomplete batch at the end of the journal";
+      break;
+    }
+    if(!applyChanges(coll_, batch)) {
+      myDebug() << "Failed to replay journal batch" << count;
+      break;
+    }
+    size = file.pos();
+    ++count;
+  }
+  myLog() << "Replayed" << count << "journal batches";
+  // the replayed changes are now the starting point
+  markCurrent();
+  m_size = size;
+  return count;
+}
+
+bool TellicoJournal::canSave(Tellico::Data::CollPtr coll_, const QUrl& url_) const {
+  if(!m_valid || !m_coll || coll_ != m_coll || url_ != m_url) {
+    return false;
+  }
+  // if the file changed since the journal was started, it has to be written again
+  qint64 size, modified;
+  return baseInfo(size, modified) && size == m_baseSize && modified == m_baseModified;
+}
+
+bool TellicoJournal::save() {
+  if(!canSave(m_coll, m_url)) {
+    return false;
+  }
+  const QByteArray batch = changes();
+  if(batch.isEmpty()) {
+    return true;
+  }
+
+  QFile file(journalFileName(m_url));
+  // a new journal replaces any out of date one
+  QIODevice::OpenMode mode = QIODevice::ReadWrite;
+  if(m_size == 0) {
+    mode = QIODevice::WriteOnly | QIODevice::Truncate;
+  }
+  if(!file.open(mode)) {
+    myDebug() << "Unable to write journal:" << file.fileName();
+    return false;
+  }
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_6);
+  if(m_size > 0) {
+    // anything past the last complete batch is left over from a failed save
+    if(!file.resize(m_size) || !file.seek(m_size)) {
+      return false;
+    }
+  } else {
+    out << JOURNAL_MAGIC << JOURNAL_VERSION << m_baseSize << m_baseModified;
+  }
+  out << batch << qChecksum(batch.constData(), batch.size());
+  // the save isn't complete until the batch is actually on disk
+  if(out.status() != QDataStream::Ok || !file.flush() || ::fsync(file.handle()) != 0) {
+    myDebug() << "Failed to write journal:" << file.fileName();
+    return false;
+  }
+  m_size = file.pos();
+  markCurrent();
+  return true;
+}
+
+Tellico::Data::EntryList TellicoJournal::modifiedEntries() const {
+  Data::EntryList entries;
+  if(!m_coll) {
+    return entries;
+  }
+  foreach(Data::ID id, m_modifiedEntries) {
+    Data::EntryPtr entry = m_coll->entryById(id);
+    if(entry) {
+      entries.append(entry);
+    }
+  }
+  return entries;
+}
+
+void TellicoJournal::addBorrower(Tellico::Data::BorrowerPtr) {
+  m_borrowersModified = true;
+}
+
+void TellicoJournal::modifyBorrower(Tellico::Data::BorrowerPtr) {
+  m_borrowersModified = true;
+}
+
+void TellicoJournal::removeBorrower(Tellico::Data::BorrowerPtr) {
+  m_borrowersModified = true;
+}
+
+void TellicoJournal::addEntries(Tellico::Data::EntryList entries_) {
+  markEntries(entries_);
+}
+
+void TellicoJournal::modifyEntries(Tellico::Data::EntryList entries_) {
+  markEntries(entries_);
+}
+
+void TellicoJournal::removeEntries(Tellico::Data::EntryList entries_) {
+  // whether the entry still exists gets checked when saving
+  markEntries(entries_);
+}
+
+void TellicoJournal::addField(Tellico::Data::CollPtr coll_, Tellico::Data::FieldPtr field_) {
+  if(coll_ == m_coll) {
+    m_modifiedFields.add(field_->name());
+  }
+}
+
+void TellicoJournal::modifyField(Tellico::Data::CollPtr coll_, Tellico::Data::FieldPtr oldField_, Tellico::Data::FieldPtr newField_) {
+  if(coll_ != m_coll) {
+    return;
+  }
+  if(oldField_->name() != newField_->name()) {
+    m_removedFields.add(oldField_->name());
+  }
+  m_modifiedFields.add(newField_->name());
+}
+
+void TellicoJournal::removeField(Tellico::Data::CollPtr coll_, Tellico::Data::FieldPtr field_) {
+  if(coll_ == m_coll) {
+    // removing a field clears the values in every entry, which replaying the removal does too
+    m_removedFields.add(field_->name());
+  }
+}
+
+void TellicoJournal::addFilter(Tellico::FilterPtr) {
+  m_filtersModified = true;
+}
+
+void TellicoJournal::modifyFilter(Tellico::FilterPtr) {
+  m_filtersModified = true;
+}
+
+void TellicoJournal::removeFilter(Tellico::FilterPtr) {
+  m_filtersModified = true;
+}
+
+void TellicoJournal::markEntries(const Tellico::Data::EntryList& entries_) {
+  foreach(Data::EntryPtr entry, entries_) {
+    if(entry && m_coll && entry->collection() == m_coll) {
+      m_modifiedEntries.insert(entry->id());
+    }
+  }
+}
+
+void TellicoJournal::markCurrent() {
+  m_modifiedEntries.clear();
+  m_modifiedFields.clear();
+  m_removedFields.clear();
+  m_filtersModified = false;
+  m_borrowersModified = false;
+  if(!m_coll) {
+    m_title.clear();
+    m_fieldNames.clear();
+    m_preamble.clear();
+    m_macros.clear();
+    return;
+  }
+  m_title = m_coll->title();
+  m_fieldNames = m_coll->fieldNames();
+  if(m_coll->type() == Data::Collection::Bibtex) {
+    const Data::BibtexCollection* c = static_cast<const Data::BibtexCollection*>(m_coll.data());
+    m_preamble = c->preamble();
+    m_macros = c->macroList();
+  }
+}
+
+QByteArray TellicoJournal::changes() const {
+  QByteArray data;
+  QDataStream out(&data, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_6);
+
+  if(m_coll->title() != m_title) {
+    out << quint8(TitleRecord) << m_coll->title();
+  }
+
+  // removals go first, in case a field was removed and then added again
+  foreach(const QString& name, m_removedFields) {
+    out << quint8(FieldRemoveRecord) << name;
+  }
+  const Data::FieldList fields = m_coll->fields();
+  foreach(Data::FieldPtr field, fields) {
+    if(m_modifiedFields.has(field->name())) {
+      out << quint8(FieldRecord);
+      DataStream::writeField(out, field);
+    }
+  }
+  const QStringList fieldNames = m_coll->fieldNames();
+  if(fieldNames != m_fieldNames) {
+    out << quint8(FieldOrderRecord) << fieldNames;
+  }
+
+  QList<Data::ID> ids = m_modifiedEntries.values();
+  std::sort(ids.begin(), ids.end());
+  foreach(Data::ID id, ids) {
+    Data::EntryPtr entry = m_coll->entryById(id);
+    if(!entry) {
+      out << quint8(EntryRemoveRecord) << qint32(id);
+      continue;
+    }
+    StringMap values;
+    foreach(Data::FieldPtr field, fields) {
+      // derived values are never stored in the entry
+      if(field->hasFlag(Data::Field::Derived)) {
+        continue;
+      }
+      const QString value = entry->field(field);
+      if(!value.isEmpty()) {
+        values.insert(field->name(), value);
+      }
+    }
+    out << quint8(EntryRecord) << qint32(id) << values;
+  }
+
+  if(m_filtersModified) {
+    out << quint8(FilterRecord);
+    DataStream::writeFilters(out, m_coll->filters());
+  }
+  // borrowers go after the entries, since the loans refer to them
+  if(m_borrowersModified) {
+    out << quint8(BorrowerRecord);
+    DataStream::writeBorrowers(out, m_coll->borrowers());
+  }
+
+  if(m_coll->type() == Data::Collection::Bibtex) {
+    const Data::BibtexCollection* c = static_cast<const Data::BibtexCollection*>(m_coll.data());
+    if(c->preamble() != m_preamble || c->macroList() != m_macros) {
+      out << quint8(BibtexRecord) << c->preamble() << c->macroList();
+    }
+  }
+  return data;
+}
+
+bool TellicoJournal::baseInfo(qint64& size_, qint64& modified_) const {
+  QFileInfo info(m_url.toLocalFile());
+  if(!info.exists()) {
+    return false;
+  }
+  size_ = info.size();
+  modified_ = info.lastModified().toMSecsSinceEpoch();
+  return true;
+}
@@ -0,0 +1,153 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_TELLICOJOURNAL_H
+#define TELLICO_TELLICOJOURNAL_H
+
+#include "../observer.h"
+#include "../utils/stringset.h"
+
+#include <QUrl>
+#include <QSet>
+#include <QStringList>
+
+namespace Tellico {
+
+/**
+ * A TellicoJournal is an append-only log of the changes made to a document since it was
+ * last written in full. Saving appends a single batch of records for whatever changed, so a
+ * small edit to a large document doesn't require rewriting the whole file. When the document
+ * is opened, the journal is replayed on top of the collection read from the file.
+ *
+ * The journal is kept next to the document, with a .journal suffix. It records the size and
+ * modification time of the document file and is ignored if those no longer match. Each batch
+ * carries a checksum, so a batch only partially written before a crash is dropped, along with
+ * anything after it.
+ *
+ * The changes are tracked through the Observer interface, so the journal must be added to the
+ * Controller. Changes which can't be tracked that way, such as appending or merging another
+ * collection, invalidate the journal and the next save must rewrite the file.
+ *
+ * @author agent
+ */
+class TellicoJournal : public Observer {
+public:
+  TellicoJournal();
+
+  /**
+   * Starts tracking the changes to a collection, forgetting any earlier ones. The journal file
+   * itself is left alone.
+   *
+   * @param coll The collection
+   * @param url The url of the document, if local
+   */
+  void setCollection(Data::CollPtr coll, const QUrl& url);
+  /**
+   * Replays the journal for a document onto the collection read from it, and then
+   * starts tracking the collection.
+   *
+   * @param coll The collection
+   * @param url The url of the document
+   * @return The number of batches replayed
+   */
+  int replay(Data::CollPtr coll, const QUrl& url);
+  /**
+   * Marks the tracked changes as incomplete, so the journal can't be saved.
+   */
+  void invalidate() { m_valid = false; }
+  /**
+   * Returns true if the changes can be appended to the journal for the document at @p url,
+   * rather than writing the whole file.
+   */
+  bool canSave(Data::CollPtr coll, const QUrl& url) const;
+  /**
+   * Appends the changes since the last save to the journal and syncs it to disk.
+   *
+   * @return Whether the changes were all written
+   */
+  bool save();
+  /**
+   * Returns the entries added or modified since the last save.
+   */
+  Data::EntryList modifiedEntries() const;
+  /**
+   * Returns the size of the journal file, in bytes.
+   */
+  qint64 size() const { return m_size; }
+
+  /**
+   * Removes the journal for a document, if there is one.
+   */
+  static void remove(const QUrl& url);
+  /**
+   * Returns the file name of the journal for a document.
+   */
+  static QString journalFileName(const QUrl& url);
+
+  virtual void    addBorrower(Data::BorrowerPtr) Q_DECL_OVERRIDE;
+  virtual void modifyBorrower(Data::BorrowerPtr) Q_DECL_OVERRIDE;
+  virtual void removeBorrower(Data::BorrowerPtr) Q_DECL_OVERRIDE;
+
+  virtual void    addEntries(Data::EntryList entries) Q_DECL_OVERRIDE;
+  virtual void modifyEntries(Data::EntryList entries) Q_DECL_OVERRIDE;
+  virtual void removeEntries(Data::EntryList entries) Q_DECL_OVERRIDE;
+
+  virtual void    addField(Data::CollPtr coll, Data::FieldPtr field) Q_DECL_OVERRIDE;
+  virtual void modifyField(Data::CollPtr coll, Data::FieldPtr oldField, Data::FieldPtr newField) Q_DECL_OVERRIDE;
+  virtual void removeField(Data::CollPtr coll, Data::FieldPtr field) Q_DECL_OVERRIDE;
+
+  virtual void    addFilter(FilterPtr) Q_DECL_OVERRIDE;
+  virtual void modifyFilter(FilterPtr) Q_DECL_OVERRIDE;
+  virtual void removeFilter(FilterPtr) Q_DECL_OVERRIDE;
+
+private:
+  void markEntries(const Data::EntryList& entries);
+  void markCurrent();
+  QByteArray changes() const;
+  bool baseInfo(qint64& size, qint64& modified) const;
+
+  Data::CollPtr m_coll;
+  QUrl m_url;
+  bool m_valid;
+  // the size and modification time of the document file the journal applies to
+  qint64 m_baseSize;
+  qint64 m_baseModified;
+  // the size of the journal up to the end of the last complete batch
+  qint64 m_size;
+
+  QSet<Data::ID> m_modifiedEntries;
+  StringSet m_modifiedFields;
+  StringSet m_removedFields;
+  bool m_filtersModified;
+  bool m_borrowersModified;
+  // renaming the collection, reordering the fields, and the bibtex macros and preamble
+  // aren't passed to the observers, so compare against their values at the last save
+  QString m_title;
+  QStringList m_fieldNames;
+  QString m_preamble;
+  StringMap m_macros;
+};
+
+} // end namespace
+#endif
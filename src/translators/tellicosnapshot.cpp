@@ -0,0 +1,345 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tellicosnapshot.h"
+#include "tellico_datastream.h"
+#include "../collection.h"
+#include "../collectionfactory.h"
+#include "../collections/bibtexcollection.h"
+#include "../entry.h"
+#include "../field.h"
+#include "../filter.h"
+#include "../borrower.h"
+#include "../images/imagefactory.h"
+#include "../images/imageinfo.h"
+#include "../utils/tellico_utils.h"
+#include "../utils/stringset.h"
+#include "../tellico_debug.h"
+
+#include <QUrl>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QDir>
+#include <QBuffer>
+#include <QSaveFile>
+
+using Tellico::TellicoSnapshot;
+
+namespace {
+  static const quint32 SNAPSHOT_MAGIC = 0x54435350; // "TCSP"
+  // increment whenever the layout changes, older snapshots are then ignored
+  static const quint32 SNAPSHOT_VERSION = 3;
+
+  // only the most recently written snapshots are kept
+  static const int SNAPSHOT_MAX_COUNT = 20;
+}
+
+TellicoSnapshot::TellicoSnapshot(Tellico::Data::CollPtr coll_, Import::TellicoImporter::Format format_)
+    : m_format(format_), m_type(coll_->type()), m_title(coll_->title()) {
+  foreach(Data::FieldPtr field, coll_->fields()) {
+    m_fields.append(Data::FieldPtr(new Data::Field(*field)));
+  }
+  const Data::EntryList entries = coll_->entries();
+  m_ids.reserve(entries.count());
+  m_entries.reserve(entries.count());
+  foreach(Data::EntryPtr entry, entries) {
+    m_ids.append(entry->id());
+    // the copy shares the values with the entry until one of them is modified
+    m_entries.append(Data::EntryPtr(new Data::Entry(*entry)));
+  }
+  if(m_type == Data::Collection::Bibtex) {
+    const Data::BibtexCollection* c = static_cast<const Data::BibtexCollection*>(coll_.data());
+    m_preamble = c->preamble();
+    m_macros = c->macroList();
+  }
+
+  // the image info comes from the image factory and the loans refer to the entries
+  // so those are written now, they're small anyway
+  QDataStream out(&m_tail, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_6);
+  // the image info normally comes from the document, so keep it for the image values
+  QList<Data::ImageInfo> infos;
+  StringSet imageIds;
+  foreach(Data::FieldPtr field, coll_->imageFields()) {
+    foreach(Data::EntryPtr entry, entries) {
+      const QString id = entry->field(field);
+      if(!id.isEmpty() && !imageIds.has(id) && ImageFactory::hasImageInfo(id)) {
+        imageIds.add(id);
+        infos.append(ImageFactory::imageInfo(id));
+      }
+    }
+  }
+  out << quint32(infos.count());
+  foreach(const Data::ImageInfo& info, infos) {
+    out << info.id << info.format << qint32(info.width(false)) << qint32(info.height(false)) << bool(info.linkOnly);
+  }
+  DataStream::writeFilters(out, coll_->filters());
+  DataStream::writeBorrowers(out, coll_->borrowers());
+}
+
+TellicoSnapshot::~TellicoSnapshot() {
+}
+
+QString TellicoSnapshot::snapshotFileName(const QUrl& url_) {
+  return Tellico::saveLocation(QStringLiteral("snapshots/")) + Tellico::documentKey(url_) + QLatin1String(".snapshot");
+}
+
+void TellicoSnapshot::remove(const QUrl& url_) {
+  if(url_.isLocalFile()) {
+    QFile::remove(snapshotFileName(url_));
+  }
+}
+
+QByteArray TellicoSnapshot::documentHeader(const QUrl& url_) {
+  // the document is identified by size and modification time, hashing it all would be
+  // as slow as reading it
+  QFileInfo fileInfo(url_.toLocalFile());
+  if(!url_.isLocalFile() || !fileInfo.isFile()) {
+    return QByteArray();
+  }
+  QByteArray header;
+  QDataStream out(&header, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_6);
+  out << fileInfo.size() << fileInfo.lastModified().toMSecsSinceEpoch();
+  return header;
+}
+
+void TellicoSnapshot::prune() {
+  QDir dir(Tellico::saveLocation(QStringLiteral("snapshots/")));
+  const QStringList fileNames = dir.entryList(QStringList() << QStringLiteral("*.snapshot"),
+                                              QDir::Files, QDir::Time);
+  for(int i = SNAPSHOT_MAX_COUNT; i < fileNames.count(); ++i) {
+    dir.remove(fileNames.at(i));
+  }
+}
+
+bool TellicoSnapshot::writeFile(const QString& fileName_, const QByteArray& header_) const {
+  // every value goes in the string table only once
+  QStringList strings;
+  QHash<QString, quint32> stringIndex;
+  QVector<quint32> values;
+  values.reserve(m_entries.count() * m_fields.count());
+  foreach(Data::EntryPtr entry, m_entries) {
+    for(int i = 0; i < m_fields.count(); ++i) {
+      // derived values are never stored in the entry
+      const QString value = m_fields.at(i)->hasFlag(Data::Field::Derived) ? QString() : entry->field(m_fields.at(i));
+      if(value.isEmpty()) {
+        values.append(0);
+        continue;
+      }
+      QHash<QString, quint32>::ConstIterator it = stringIndex.constFind(value);
+      if(it == stringIndex.constEnd()) {
+        strings.append(value);
+        // index 0 means an empty value
+        it = stringIndex.insert(value, strings.count());
+      }
+      values.append(it.value());
+    }
+  }
+
+  QSaveFile file(fileName_);
+  if(!file.open(QIODevice::WriteOnly)) {
+    myDebug() << "Unable to write snapshot:" << file.fileName();
+    return false;
+  }
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_6);
+
+  out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << header_;
+  out << qint32(m_format);
+
+  out << qint32(m_type) << m_title;
+  out << quint32(m_fields.count());
+  foreach(Data::FieldPtr field, m_fields) {
+    DataStream::writeField(out, field);
+  }
+  if(m_type == Data::Collection::Bibtex) {
+    out << m_preamble << m_macros;
+  }
+
+  out << strings;
+  out << quint32(m_entries.count());
+  int pos = 0;
+  for(int i = 0; i < m_ids.count(); ++i) {
+    out << qint32(m_ids.at(i));
+    for(int j = 0; j < m_fields.count(); ++j, ++pos) {
+      out << values.at(pos);
+    }
+  }
+
+  out.writeRawData(m_tail.constData(), m_tail.size());
+
+  if(out.status() != QDataStream::Ok) {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+Tellico::Data::CollPtr TellicoSnapshot::read(const QUrl& url_, Import::TellicoImporter::Format* format_) {
+  if(!url_.isLocalFile()) {
+    return Data::CollPtr();
+  }
+  const QString fileName = snapshotFileName(url_);
+  if(!QFile::exists(fileName)) {
+    return Data::CollPtr();
+  }
+  const QByteArray header = documentHeader(url_);
+  if(header.isEmpty()) {
+    return Data::CollPtr();
+  }
+  return readFile(fileName, nullptr, format_, header);
+}
+
+Tellico::Data::CollPtr TellicoSnapshot::readFile(const QString& fileName_, QByteArray* header_,
+                                                 Import::TellicoImporter::Format* format_,
+                                                 const QByteArray& expectedHeader_) {
+  QFile file(fileName_);
+  if(!file.exists() || !file.open(QIODevice::ReadOnly)) {
+    return Data::CollPtr();
+  }
+  // map the snapshot, rather than reading it all in first
+  uchar* mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+  if(!mapped) {
+    return Data::CollPtr();
+  }
+  QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), file.size());
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  QDataStream in(&buffer);
+  in.setVersion(QDataStream::Qt_5_6);
+
+  quint32 magic, version;
+  in >> magic >> version;
+  if(magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+    return Data::CollPtr();
+  }
+  QByteArray header;
+  in >> header;
+  if(!expectedHeader_.isEmpty() && header != expectedHeader_) {
+    myLog() << "Snapshot is out of date:" << fileName_;
+    return Data::CollPtr();
+  }
+  qint32 format;
+  in >> format;
+
+  qint32 type;
+  QString title;
+  in >> type >> title;
+  Data::CollPtr coll = CollectionFactory::collection(type, false);
+  if(!coll) {
+    return Data::CollPtr();
+  }
+  coll->setTitle(title);
+
+  quint32 fieldCount;
+  in >> fieldCount;
+  Data::FieldList fields;
+  for(quint32 i = 0; i < fieldCount && in.status() == QDataStream::Ok; ++i) {
+    Data::FieldPtr field = DataStream::readField(in);
+    if(!field) {
+      // the entry values are stored by field position, so none of them could be trusted
+      myDebug() << "Failed to read snapshot field:" << fileName_;
+      return Data::CollPtr();
+    }
+    fields.append(field);
+  }
+  coll->addFields(fields);
+  // the fields might be reordered or merged with existing ones, so use the names for the values
+  QStringList fieldNames;
+  foreach(Data::FieldPtr field, fields) {
+    fieldNames << field->name();
+  }
+
+  if(type == Data::Collection::Bibtex) {
+    QString preamble;
+    StringMap macros;
+    in >> preamble >> macros;
+    Data::BibtexCollection* c = static_cast<Data::BibtexCollection*>(coll.data());
+    c->setPreamble(preamble);
+    c->setMacroList(macros);
+  }
+
+  QStringList strings;
+  in >> strings;
+  quint32 entryCount;
+  in >> entryCount;
+  if(in.status() != QDataStream::Ok) {
+    return Data::CollPtr();
+  }
+  Data::EntryList entries;
+  entries.reserve(entryCount);
+  const quint32 stringCount = strings.count();
+  for(quint32 i = 0; i < entryCount && in.status() == QDataStream::Ok; ++i) {
+    qint32 id;
+    in >> id;
+    Data::EntryPtr entry(new Data::Entry(coll, id));
+    for(int j = 0; j < fieldNames.count(); ++j) {
+      quint32 index;
+      in >> index;
+      if(index > 0 && index <= stringCount) {
+        // the values are shared through the string table
+        entry->setField(fieldNames.at(j), strings.at(index-1), false /* no modified date update */);
+      }
+    }
+    entries.append(entry);
+  }
+  if(in.status() != QDataStream::Ok) {
+    myDebug() << "Failed to read snapshot:" << fileName_;
+    return Data::CollPtr();
+  }
+  coll->addEntries(entries);
+
+  quint32 imageCount;
+  in >> imageCount;
+  for(quint32 i = 0; i < imageCount && in.status() == QDataStream::Ok; ++i) {
+    QString id;
+    QByteArray imageFormat;
+    qint32 width, height;
+    bool linkOnly;
+    in >> id >> imageFormat >> width >> height >> linkOnly;
+    ImageFactory::cacheImageInfo(Data::ImageInfo(id, imageFormat, width, height, linkOnly));
+  }
+
+  foreach(FilterPtr filter, DataStream::readFilters(in)) {
+    coll->addFilter(filter);
+  }
+  foreach(Data::BorrowerPtr borrower, DataStream::readBorrowers(in, coll)) {
+    coll->addBorrower(borrower);
+  }
+
+  if(in.status() != QDataStream::Ok) {
+    myDebug() << "Failed to read snapshot:" << fileName_;
+    return Data::CollPtr();
+  }
+  if(header_) {
+    *header_ = header;
+  }
+  if(format_) {
+    *format_ = static_cast<Import::TellicoImporter::Format>(format);
+  }
+  return coll;
+}
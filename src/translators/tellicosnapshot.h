@@ -0,0 +1,133 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_TELLICOSNAPSHOT_H
+#define TELLICO_TELLICOSNAPSHOT_H
+
+#include "tellicoimporter.h"
+#include "../datavectors.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+class QUrl;
+
+namespace Tellico {
+
+/**
+ * A TellicoSnapshot is a binary copy of a collection, kept in the data directory and
+ * tied to the document file it was read from or saved to. Reading the snapshot is much
+ * faster than parsing the XML again, so it is used when reopening a document.
+ *
+ * The snapshot records the size and modification time of the document file and is
+ * only valid as long as those both match. All of the values are kept in a single string
+ * table, so repeated values are only read once and are shared by all the entries.
+ * Documents with images inside the file don't get a snapshot, since the images still
+ * have to be read from the file. Only the most recently written snapshots are kept.
+ *
+ * Creating a TellicoSnapshot object captures the collection without writing anything. The
+ * entries are copied, which is cheap since the copies share the values with the entries until
+ * one of them is modified. The capture can then be written from a worker thread, while the
+ * collection is still being edited.
+ *
+ * @author agent
+ */
+class TellicoSnapshot {
+public:
+  /**
+   * Captures the contents of a collection. Only the image info, filters, and loans are
+   * serialized right away.
+   *
+   * @param coll The collection
+   * @param format The file format of the document
+   */
+  TellicoSnapshot(Data::CollPtr coll, Import::TellicoImporter::Format format);
+  ~TellicoSnapshot();
+
+  /**
+   * Writes the captured collection to a file. The collection itself isn't touched, so this
+   * is safe to call from any thread.
+   *
+   * @param fileName The name of the file
+   * @param header Data identifying the source of the collection, returned by readFile()
+   * @return Whether the file was written
+   */
+  bool writeFile(const QString& fileName, const QByteArray& header) const;
+
+  /**
+   * Returns the header identifying the current version of a local document file, to be
+   * passed to writeFile(), or an empty array if the file doesn't exist.
+   */
+  static QByteArray documentHeader(const QUrl& url);
+  /**
+   * Reads the snapshot for a local document file.
+   *
+   * @param url The url of the document
+   * @param format Set to the file format of the document, if not null
+   * @return The collection, or null if there is no valid snapshot for the document
+   */
+  static Data::CollPtr read(const QUrl& url, Import::TellicoImporter::Format* format = nullptr);
+  /**
+   * Removes the snapshot for a document, if there is one.
+   */
+  static void remove(const QUrl& url);
+  /**
+   * Returns the file name of the snapshot for a document.
+   */
+  static QString snapshotFileName(const QUrl& url);
+  /**
+   * Removes all but the most recently written snapshots.
+   */
+  static void prune();
+  /**
+   * Reads a collection written by writeFile().
+   *
+   * @param fileName The name of the file
+   * @param header Set to the header of the file, if not null
+   * @param format Set to the file format of the document, if not null
+   * @param expectedHeader If not empty, the header of the file must match it
+   * @return The collection, or null if the file could not be read
+   */
+  static Data::CollPtr readFile(const QString& fileName, QByteArray* header,
+                                Import::TellicoImporter::Format* format = nullptr,
+                                const QByteArray& expectedHeader = QByteArray());
+
+private:
+  Q_DISABLE_COPY(TellicoSnapshot)
+
+  Import::TellicoImporter::Format m_format;
+  int m_type;
+  QString m_title;
+  Data::FieldList m_fields;
+  QVector<Data::ID> m_ids;
+  Data::EntryList m_entries;
+  QString m_preamble;
+  StringMap m_macros;
+  // the image info, filters, and borrowers, already serialized
+  QByteArray m_tail;
+};
+
+} // end namespace
+#endif
@@ -24,6 +24,7 @@
 
 #include "tellicoxmlexporter.h"
 #include "tellico_xml.h"
+#include "tellicoxmlwriter.h"
 #include "../utils/bibtexhandler.h" // needed for cleaning text
 #include "../entrygroup.h"
 #include "../collections/bibtexcollection.h"
@@ -44,12 +45,17 @@
 #include <KConfigGroup>
 
 #include <QDir>
+#include <QBuffer>
 #include <QGroupBox>
 #include <QCheckBox>
 #include <QDomDocument>
 #include <QTextCodec>
+#include <QTextStream>
+#include <QSaveFile>
 #include <QVBoxLayout>
 
+#include <libxml/tree.h>
+
 #include <algorithm>
 
 using namespace Tellico;
@@ -72,25 +78,70 @@ QString TellicoXMLExporter::fileFilter() const {
 }
 
 bool TellicoXMLExporter::exec() {
-  QDomDocument doc = exportXML();
-  if(doc.isNull()) {
+  if(url().isLocalFile()) {
+    // stream the XML directly to the file
+    QScopedPointer<QSaveFile> file(FileHandler::openSaveFile(url(), options() & Export::ExportForce));
+    if(!file) {
+      return false;
+    }
+    if(!writeXML(file.data())) {
+      file->cancelWriting();
+      return false;
+    }
+    return file->commit();
+  }
+
+  // a remote file is uploaded from a temporary file by the file handler
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  if(!writeXML(&buffer)) {
     return false;
   }
-  return FileHandler::writeTextURL(url(), doc.toString(),
-                                   options() & ExportUTF8,
-                                   options() & Export::ExportForce);
+  buffer.close();
+  return FileHandler::writeDataURL(url(), data, options() & Export::ExportForce);
 }
 
 QString TellicoXMLExporter::text() const {
-  return exportXML().toString();
+  QString text;
+  QTextStream ts(&text, QIODevice::WriteOnly);
+  writeXML(ts);
+  return text;
 }
 
-QDomDocument TellicoXMLExporter::exportXML() const {
-  int exportVersion = XML::syntaxVersion;
-
-  if(exportVersion == 12 && !version12Needed()) {
-    exportVersion = 11;
+bool TellicoXMLExporter::writeXML(QIODevice* device_) const {
+  Q_ASSERT(device_);
+  QTextStream ts(device_);
+  // same as the file handler, locale encoding unless UTF-8 is requested
+  if(options() & Export::ExportUTF8) {
+    ts.setCodec("UTF-8");
   }
+  writeXML(ts);
+  return ts.status() == QTextStream::Ok;
+}
+
+void TellicoXMLExporter::writeXML(QTextStream& ts_) const {
+  const int version = exportVersion();
+
+  TellicoStreamWriter writer(&ts_, encodingName());
+  writer.writeStartDocument(QStringLiteral("tellico"), XML::pubTellico(version), XML::dtdTellico(version));
+
+  // root tellico element, with the default namespace
+  writer.startElement(QStringLiteral("tellico"));
+  writer.writeAttribute(QStringLiteral("xmlns"), XML::nsTellico);
+  writer.writeAttribute(QStringLiteral("syntaxVersion"), QString::number(version));
+
+  exportCollectionXML(writer, formatRequest());
+
+  writer.endElement();
+  writer.writeEndDocument();
+
+  // clear image list
+  m_images.clear();
+}
+
+QDomDocument TellicoXMLExporter::exportXML() const {
+  const int exportVersion = this->exportVersion();
 
   QDomImplementation impl;
   QDomDocumentType doctype = impl.createDocumentType(QStringLiteral("tellico"),
@@ -104,24 +155,15 @@ QDomDocument TellicoXMLExporter::exportXML() const {
   // root tellico element
   QDomElement root = dom.documentElement();
 
-  QString encodeStr = QStringLiteral("version=\"1.0\" encoding=\"");
-  if(options() & Export::ExportUTF8) {
-    encodeStr += QLatin1String("UTF-8");
-  } else {
-    encodeStr += QLatin1String(QTextCodec::codecForLocale()->name());
-  }
-  encodeStr += QLatin1Char('"');
+  const QString encodeStr = QStringLiteral("version=\"1.0\" encoding=\"%1\"").arg(encodingName());
 
   // createDocument creates a root node, insert the processing instruction before it
   dom.insertBefore(dom.createProcessingInstruction(QStringLiteral("xml"), encodeStr), root);
 
   root.setAttribute(QStringLiteral("syntaxVersion"), exportVersion);
 
-  FieldFormat::Request format = (options() & Export::ExportFormatted ?
-                                                FieldFormat::ForceFormat :
-                                                FieldFormat::AsIsFormat);
-
-  exportCollectionXML(dom, root, format);
+  TellicoDomWriter writer(dom, root);
+  exportCollectionXML(writer, formatRequest());
 
   // clear image list
   m_images.clear();
@@ -129,123 +171,155 @@ QDomDocument TellicoXMLExporter::exportXML() const {
   return dom;
 }
 
-void TellicoXMLExporter::exportCollectionXML(QDomDocument& dom_, QDomElement& parent_, int format_) const {
+_xmlDoc* TellicoXMLExporter::exportXMLDoc() const {
+  const int exportVersion = this->exportVersion();
+
+  xmlDocPtr doc = xmlNewDoc(reinterpret_cast<const xmlChar*>("1.0"));
+  xmlNodePtr root = xmlNewDocNode(doc, nullptr, reinterpret_cast<const xmlChar*>("tellico"), nullptr);
+  xmlDocSetRootElement(doc, root);
+  xmlCreateIntSubset(doc, reinterpret_cast<const xmlChar*>("tellico"),
+                     reinterpret_cast<const xmlChar*>(XML::pubTellico(exportVersion).toUtf8().constData()),
+                     reinterpret_cast<const xmlChar*>(XML::dtdTellico(exportVersion).toUtf8().constData()));
+
+  // root tellico element, with the default namespace, which all the other elements inherit
+  xmlNsPtr ns = xmlNewNs(root, reinterpret_cast<const xmlChar*>(XML::nsTellico.toUtf8().constData()), nullptr);
+  xmlSetNs(root, ns);
+  xmlNewProp(root, reinterpret_cast<const xmlChar*>("syntaxVersion"),
+             reinterpret_cast<const xmlChar*>(QByteArray::number(exportVersion).constData()));
+
+  TellicoLibXMLWriter writer(root);
+  exportCollectionXML(writer, formatRequest());
+
+  // clear image list
+  m_images.clear();
+
+  return doc;
+}
+
+int TellicoXMLExporter::exportVersion() const {
+  int exportVersion = XML::syntaxVersion;
+  if(exportVersion == 12 && !version12Needed()) {
+    exportVersion = 11;
+  }
+  return exportVersion;
+}
+
+QString TellicoXMLExporter::encodingName() const {
+  if(options() & Export::ExportUTF8) {
+    return QStringLiteral("UTF-8");
+  }
+  return QLatin1String(QTextCodec::codecForLocale()->name());
+}
+
+int TellicoXMLExporter::formatRequest() const {
+  return options() & Export::ExportFormatted ? FieldFormat::ForceFormat : FieldFormat::AsIsFormat;
+}
+
+void TellicoXMLExporter::exportCollectionXML(TellicoXMLWriter& writer_, int format_) const {
   Data::CollPtr coll = collection();
   if(!coll) {
     myWarning() << "no collection pointer!";
     return;
   }
 
-  QDomElement collElem = dom_.createElement(QStringLiteral("collection"));
-  collElem.setAttribute(QStringLiteral("type"), coll->type());
-  collElem.setAttribute(QStringLiteral("title"), coll->title());
-
-  QDomElement fieldsElem = dom_.createElement(QStringLiteral("fields"));
-  collElem.appendChild(fieldsElem);
+  writer_.startElement(QStringLiteral("collection"));
+  writer_.writeAttribute(QStringLiteral("type"), QString::number(coll->type()));
+  writer_.writeAttribute(QStringLiteral("title"), coll->title());
 
+  writer_.startElement(QStringLiteral("fields"));
   foreach(Data::FieldPtr field, fields()) {
-    exportFieldXML(dom_, fieldsElem, field);
+    exportFieldXML(writer_, field);
   }
+  writer_.endElement();
 
   if(coll->type() == Data::Collection::Bibtex) {
     const Data::BibtexCollection* c = static_cast<const Data::BibtexCollection*>(coll.data());
     if(!c->preamble().isEmpty()) {
-      QDomElement preElem = dom_.createElement(QStringLiteral("bibtex-preamble"));
-      preElem.appendChild(dom_.createTextNode(c->preamble()));
-      collElem.appendChild(preElem);
+      writer_.writeTextElement(QStringLiteral("bibtex-preamble"), c->preamble());
     }
 
-    QDomElement macrosElem = dom_.createElement(QStringLiteral("macros"));
+    writer_.startElement(QStringLiteral("macros"), true /* omit if empty */);
     for(StringMap::ConstIterator macroIt = c->macroList().constBegin(); macroIt != c->macroList().constEnd(); ++macroIt) {
       if(!macroIt.value().isEmpty()) {
-        QDomElement macroElem = dom_.createElement(QStringLiteral("macro"));
-        macroElem.setAttribute(QStringLiteral("name"), macroIt.key());
-        macroElem.appendChild(dom_.createTextNode(macroIt.value()));
-        macrosElem.appendChild(macroElem);
+        writer_.startElement(QStringLiteral("macro"));
+        writer_.writeAttribute(QStringLiteral("name"), macroIt.key());
+        writer_.writeText(macroIt.value());
+        writer_.endElement();
       }
     }
-    if(macrosElem.childNodes().count() > 0) {
-      collElem.appendChild(macrosElem);
-    }
+    writer_.endElement();
   }
 
   foreach(Data::EntryPtr entry, entries()) {
-    exportEntryXML(dom_, collElem, entry, format_);
+    exportEntryXML(writer_, entry, format_);
   }
 
   if(!m_images.isEmpty() && (options() & Export::ExportImages)) {
-    QDomElement imgsElem = dom_.createElement(QStringLiteral("images"));
-    const QStringList imageIds = m_images.values();
+    writer_.startElement(QStringLiteral("images"), true /* omit if empty */);
     foreach(const QString& id, m_images) {
-      exportImageXML(dom_, imgsElem, id);
-    }
-    if(imgsElem.hasChildNodes()) {
-      collElem.appendChild(imgsElem);
+      exportImageXML(writer_, id);
     }
+    writer_.endElement();
   }
 
   if(m_includeGroups) {
-    exportGroupXML(dom_, collElem);
+    exportGroupXML(writer_);
   }
 
-  parent_.appendChild(collElem);
+  writer_.endElement(); // collection
 
   // the borrowers and filters are in the tellico object, not the collection
   if(options() & Export::ExportComplete) {
-    QDomElement bElem = dom_.createElement(QStringLiteral("borrowers"));
+    writer_.startElement(QStringLiteral("borrowers"), true /* omit if empty */);
     foreach(Data::BorrowerPtr borrower, coll->borrowers()) {
-      exportBorrowerXML(dom_, bElem, borrower);
-    }
-    if(bElem.hasChildNodes()) {
-      parent_.appendChild(bElem);
+      exportBorrowerXML(writer_, borrower);
     }
+    writer_.endElement();
 
-    QDomElement fElem = dom_.createElement(QStringLiteral("filters"));
+    writer_.startElement(QStringLiteral("filters"), true /* omit if empty */);
     foreach(FilterPtr filter, coll->filters()) {
-      exportFilterXML(dom_, fElem, filter);
-    }
-    if(fElem.hasChildNodes()) {
-      parent_.appendChild(fElem);
+      exportFilterXML(writer_, filter);
     }
+    writer_.endElement();
   }
 }
 
-void TellicoXMLExporter::exportFieldXML(QDomDocument& dom_, QDomElement& parent_, Tellico::Data::FieldPtr field_) const {
-  QDomElement elem = dom_.createElement(QStringLiteral("field"));
+void TellicoXMLExporter::exportFieldXML(TellicoXMLWriter& writer_, Tellico::Data::FieldPtr field_) const {
+  writer_.startElement(QStringLiteral("field"));
 
-  elem.setAttribute(QStringLiteral("name"),     field_->name());
-  elem.setAttribute(QStringLiteral("title"),    field_->title());
-  elem.setAttribute(QStringLiteral("category"), field_->category());
-  elem.setAttribute(QStringLiteral("type"),     field_->type());
-  elem.setAttribute(QStringLiteral("flags"),    field_->flags());
-  elem.setAttribute(QStringLiteral("format"),   field_->formatType());
+  writer_.writeAttribute(QStringLiteral("name"),     field_->name());
+  writer_.writeAttribute(QStringLiteral("title"),    field_->title());
+  writer_.writeAttribute(QStringLiteral("category"), field_->category());
+  writer_.writeAttribute(QStringLiteral("type"),     QString::number(field_->type()));
+  writer_.writeAttribute(QStringLiteral("flags"),    QString::number(field_->flags()));
+  writer_.writeAttribute(QStringLiteral("format"),   QString::number(field_->formatType()));
 
   if(field_->type() == Data::Field::Choice) {
-    elem.setAttribute(QStringLiteral("allowed"), field_->allowed().join(QLatin1String(";")));
+    writer_.writeAttribute(QStringLiteral("allowed"), field_->allowed().join(QLatin1String(";")));
   }
 
   // only save description if it's not equal to title, which is the default
   // title is never empty, so this indirectly checks for empty descriptions
   if(field_->description() != field_->title()) {
-    elem.setAttribute(QStringLiteral("description"), field_->description());
+    writer_.writeAttribute(QStringLiteral("description"), field_->description());
   }
 
   for(StringMap::ConstIterator it = field_->propertyList().begin(); it != field_->propertyList().end(); ++it) {
     if(it.value().isEmpty()) {
       continue;
     }
-    QDomElement e = dom_.createElement(QStringLiteral("prop"));
-    e.setAttribute(QStringLiteral("name"), it.key());
-    e.appendChild(dom_.createTextNode(it.value()));
-    elem.appendChild(e);
+    writer_.startElement(QStringLiteral("prop"));
+    writer_.writeAttribute(QStringLiteral("name"), it.key());
+    writer_.writeText(it.value());
+    writer_.endElement();
   }
 
-  parent_.appendChild(elem);
+  writer_.endElement();
 }
 
-void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_, Tellico::Data::EntryPtr entry_, int format_) const {
-  QDomElement entryElem = dom_.createElement(QStringLiteral("entry"));
-  entryElem.setAttribute(QStringLiteral("id"), QString::number(entry_->id()));
+void TellicoXMLExporter::exportEntryXML(TellicoXMLWriter& writer_, Tellico::Data::EntryPtr entry_, int format_) const {
+  writer_.startElement(QStringLiteral("entry"));
+  writer_.writeAttribute(QStringLiteral("id"), QString::number(entry_->id()));
 
   // iterate through every field for the entry
   foreach(Data::FieldPtr fIt, fields()) {
@@ -275,8 +349,7 @@ void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_
 
     if(fIt->type() == Data::Field::Table) {
       // who cares about grammar, just add an 's' to the name
-      QDomElement parElem = dom_.createElement(fieldName + QLatin1Char('s'));
-      entryElem.appendChild(parElem);
+      writer_.startElement(fieldName + QLatin1Char('s'));
 
       bool ok;
       int ncols = Tellico::toUInt(fIt->property(QStringLiteral("columns")), &ok);
@@ -284,8 +357,7 @@ void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_
         ncols = 1;
       }
       foreach(const QString& rowValue, FieldFormat::splitTable(fieldValue)) {
-        QDomElement fieldElem = dom_.createElement(fieldName);
-        parElem.appendChild(fieldElem);
+        writer_.startElement(fieldName);
 
         QStringList columnValues = FieldFormat::splitRow(rowValue);
         if(ncols < columnValues.count()) {
@@ -295,11 +367,11 @@ void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_
           columnValues.replace(ncols-1, lastValue);
         }
         for(int col = 0; col < columnValues.count(); ++col) {
-          QDomElement elem = dom_.createElement(QStringLiteral("column"));
-          elem.appendChild(dom_.createTextNode(columnValues.at(col)));
-          fieldElem.appendChild(elem);
+          writer_.writeTextElement(QStringLiteral("column"), columnValues.at(col));
         }
+        writer_.endElement();
       }
+      writer_.endElement();
       continue;
     }
 
@@ -307,39 +379,30 @@ void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_
       // if multiple versions are allowed, split them into separate elements
       // parent element if field contains multiple values, child of entryElem
       // who cares about grammar, just add an QLatin1Char('s') to the name
-      QDomElement parElem = dom_.createElement(fieldName + QLatin1Char('s'));
-      entryElem.appendChild(parElem);
+      writer_.startElement(fieldName + QLatin1Char('s'));
 
       // the space after the semi-colon is enforced when the field is set for the entry
       QStringList fields = FieldFormat::splitValue(fieldValue);
       for(QStringList::ConstIterator it = fields.constBegin(); it != fields.constEnd(); ++it) {
         // element for field value, child of either entryElem or ParentElem
-        QDomElement fieldElem = dom_.createElement(fieldName);
-        fieldElem.appendChild(dom_.createTextNode(*it));
-        parElem.appendChild(fieldElem);
+        writer_.writeTextElement(fieldName, *it);
       }
+      writer_.endElement();
     } else {
-      QDomElement fieldElem = dom_.createElement(fieldName);
-      entryElem.appendChild(fieldElem);
+      writer_.startElement(fieldName);
       // Date fields get special treatment
       if(fIt->type() == Data::Field::Date) {
         // as of Tellico in KF5 (3.0), just forget about the calendar attribute for the moment, always use gregorian
-        fieldElem.setAttribute(QStringLiteral("calendar"), QStringLiteral("gregorian"));
+        writer_.writeAttribute(QStringLiteral("calendar"), QStringLiteral("gregorian"));
         QStringList s = fieldValue.split(QLatin1Char('-'), QString::KeepEmptyParts);
         if(s.count() > 0 && !s[0].isEmpty()) {
-          QDomElement e = dom_.createElement(QStringLiteral("year"));
-          fieldElem.appendChild(e);
-          e.appendChild(dom_.createTextNode(s[0]));
+          writer_.writeTextElement(QStringLiteral("year"), s[0]);
         }
         if(s.count() > 1 && !s[1].isEmpty()) {
-          QDomElement e = dom_.createElement(QStringLiteral("month"));
-          fieldElem.appendChild(e);
-          e.appendChild(dom_.createTextNode(s[1]));
+          writer_.writeTextElement(QStringLiteral("month"), s[1]);
         }
         if(s.count() > 2 && !s[2].isEmpty()) {
-          QDomElement e = dom_.createElement(QStringLiteral("day"));
-          fieldElem.appendChild(e);
-          e.appendChild(dom_.createTextNode(s[2]));
+          writer_.writeTextElement(QStringLiteral("day"), s[2]);
         }
       } else if(fIt->type() == Data::Field::URL &&
                 fIt->property(QStringLiteral("relative")) == QLatin1String("true") &&
@@ -347,10 +410,11 @@ void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_
         // if a relative URL and url() is not empty, change the value!
         QUrl old_url = Data::Document::self()->URL().resolved(QUrl(fieldValue));
         QString relPath = QDir(url().toLocalFile()).relativeFilePath(old_url.path());
-        fieldElem.appendChild(dom_.createTextNode(relPath));
+        writer_.writeText(relPath);
       } else {
-        fieldElem.appendChild(dom_.createTextNode(fieldValue));
+        writer_.writeText(fieldValue);
       }
+      writer_.endElement();
     }
 
     if(fIt->type() == Data::Field::Image) {
@@ -360,50 +424,51 @@ void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_
     }
   } // end field loop
 
-  parent_.appendChild(entryElem);
+  writer_.endElement();
 }
 
-void TellicoXMLExporter::exportImageXML(QDomDocument& dom_, QDomElement& parent_, const QString& id_) const {
+void TellicoXMLExporter::exportImageXML(TellicoXMLWriter& writer_, const QString& id_) const {
   if(id_.isEmpty()) {
     myDebug() << "empty image!";
     return;
   }
 //  myLog() << "id = " << id_;
 
-  QDomElement imgElem = dom_.createElement(QStringLiteral("image"));
   if(m_includeImages) {
     const Data::Image& img = ImageFactory::imageById(id_);
     if(img.isNull()) {
       return;
     }
-    imgElem.setAttribute(QStringLiteral("format"), QLatin1String(img.format()));
-    imgElem.setAttribute(QStringLiteral("id"),     QString(img.id()));
-    imgElem.setAttribute(QStringLiteral("width"),  img.width());
-    imgElem.setAttribute(QStringLiteral("height"), img.height());
+    writer_.startElement(QStringLiteral("image"));
+    writer_.writeAttribute(QStringLiteral("format"), QLatin1String(img.format()));
+    writer_.writeAttribute(QStringLiteral("id"),     QString(img.id()));
+    writer_.writeAttribute(QStringLiteral("width"),  QString::number(img.width()));
+    writer_.writeAttribute(QStringLiteral("height"), QString::number(img.height()));
     if(img.linkOnly()) {
-      imgElem.setAttribute(QStringLiteral("link"), QStringLiteral("true"));
+      writer_.writeAttribute(QStringLiteral("link"), QStringLiteral("true"));
     }
     QByteArray imgText = img.byteArray().toBase64();
-    imgElem.appendChild(dom_.createTextNode(QLatin1String(imgText)));
+    writer_.writeText(QLatin1String(imgText));
   } else {
     const Data::ImageInfo& info = ImageFactory::imageInfo(id_);
     if(info.isNull()) {
       return;
     }
-    imgElem.setAttribute(QStringLiteral("format"), QLatin1String(info.format));
-    imgElem.setAttribute(QStringLiteral("id"),     QString(info.id));
+    writer_.startElement(QStringLiteral("image"));
+    writer_.writeAttribute(QStringLiteral("format"), QLatin1String(info.format));
+    writer_.writeAttribute(QStringLiteral("id"),     QString(info.id));
     // only load the images to read the size if necessary
     const bool loadImageIfNecessary = options() & Export::ExportImageSize;
-    imgElem.setAttribute(QStringLiteral("width"),  info.width(loadImageIfNecessary));
-    imgElem.setAttribute(QStringLiteral("height"), info.height(loadImageIfNecessary));
+    writer_.writeAttribute(QStringLiteral("width"),  QString::number(info.width(loadImageIfNecessary)));
+    writer_.writeAttribute(QStringLiteral("height"), QString::number(info.height(loadImageIfNecessary)));
     if(info.linkOnly) {
-      imgElem.setAttribute(QStringLiteral("link"), QStringLiteral("true"));
+      writer_.writeAttribute(QStringLiteral("link"), QStringLiteral("true"));
     }
   }
-  parent_.appendChild(imgElem);
+  writer_.endElement();
 }
 
-void TellicoXMLExporter::exportGroupXML(QDomDocument& dom_, QDomElement& parent_) const {
+void TellicoXMLExporter::exportGroupXML(TellicoXMLWriter& writer_) const {
   Data::EntryList vec = entries();
   bool exportAll = collection()->entries().count() == vec.count();
   // iterate over each group, which are the first children
@@ -411,100 +476,95 @@ void TellicoXMLExporter::exportGroupXML(QDomDocument& dom_, QDomElement& parent_
     if(gIt.group()->isEmpty()) {
       continue;
     }
-    QDomElement groupElem = dom_.createElement(QStringLiteral("group"));
-    groupElem.setAttribute(QStringLiteral("title"), gIt.group()->groupName());
+    writer_.startElement(QStringLiteral("group"), true /* omit if empty */);
+    writer_.writeAttribute(QStringLiteral("title"), gIt.group()->groupName());
     // now iterate over all entry items in the group
     Data::EntryList sorted = sortEntries(*gIt.group());
     foreach(Data::EntryPtr eIt, sorted) {
       if(!exportAll && vec.indexOf(eIt) == -1) {
         continue;
       }
-      QDomElement entryRefElem = dom_.createElement(QStringLiteral("entryRef"));
-      entryRefElem.setAttribute(QStringLiteral("id"), QString::number(eIt->id()));
-      groupElem.appendChild(entryRefElem);
-    }
-    if(groupElem.hasChildNodes()) {
-      parent_.appendChild(groupElem);
+      writer_.startElement(QStringLiteral("entryRef"));
+      writer_.writeAttribute(QStringLiteral("id"), QString::number(eIt->id()));
+      writer_.endElement();
     }
+    writer_.endElement();
   }
 }
 
-void TellicoXMLExporter::exportFilterXML(QDomDocument& dom_, QDomElement& parent_, Tellico::FilterPtr filter_) const {
-  QDomElement filterElem = dom_.createElement(QStringLiteral("filter"));
-  filterElem.setAttribute(QStringLiteral("name"), filter_->name());
+void TellicoXMLExporter::exportFilterXML(TellicoXMLWriter& writer_, Tellico::FilterPtr filter_) const {
+  writer_.startElement(QStringLiteral("filter"));
+  writer_.writeAttribute(QStringLiteral("name"), filter_->name());
 
   QString match = (filter_->op() == Filter::MatchAll) ? QStringLiteral("all") : QStringLiteral("any");
-  filterElem.setAttribute(QStringLiteral("match"), match);
+  writer_.writeAttribute(QStringLiteral("match"), match);
 
   foreach(FilterRule* rule, *filter_) {
-    QDomElement ruleElem = dom_.createElement(QStringLiteral("rule"));
-    ruleElem.setAttribute(QStringLiteral("field"), rule->fieldName());
-    ruleElem.setAttribute(QStringLiteral("pattern"), rule->pattern());
+    writer_.startElement(QStringLiteral("rule"));
+    writer_.writeAttribute(QStringLiteral("field"), rule->fieldName());
+    writer_.writeAttribute(QStringLiteral("pattern"), rule->pattern());
     switch(rule->function()) {
       case FilterRule::FuncContains:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("contains"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("contains"));
         break;
       case FilterRule::FuncNotContains:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("notcontains"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("notcontains"));
         break;
       case FilterRule::FuncEquals:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("equals"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("equals"));
         break;
       case FilterRule::FuncNotEquals:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("notequals"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("notequals"));
         break;
       case FilterRule::FuncRegExp:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("regexp"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("regexp"));
         break;
       case FilterRule::FuncNotRegExp:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("notregexp"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("notregexp"));
         break;
       case FilterRule::FuncBefore:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("before"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("before"));
         break;
       case FilterRule::FuncAfter:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("after"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("after"));
         break;
       case FilterRule::FuncGreater:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("greaterthan"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("greaterthan"));
         break;
       case FilterRule::FuncLess:
-        ruleElem.setAttribute(QStringLiteral("function"), QStringLiteral("lessthan"));
+        writer_.writeAttribute(QStringLiteral("function"), QStringLiteral("lessthan"));
         break;
-      /* If anything is updated here, be sure to update xmlstatehandler */
+      /* If anything is updated here, be sure to update tellicoxmlreader */
     }
-    filterElem.appendChild(ruleElem);
+    writer_.endElement();
   }
 
-  parent_.appendChild(filterElem);
+  writer_.endElement();
 }
 
-void TellicoXMLExporter::exportBorrowerXML(QDomDocument& dom_, QDomElement& parent_,
-                                           Tellico::Data::BorrowerPtr borrower_) const {
+void TellicoXMLExporter::exportBorrowerXML(TellicoXMLWriter& writer_, Tellico::Data::BorrowerPtr borrower_) const {
   if(borrower_->isEmpty()) {
     return;
   }
 
-  QDomElement bElem = dom_.createElement(QStringLiteral("borrower"));
-  parent_.appendChild(bElem);
-
-  bElem.setAttribute(QStringLiteral("name"), borrower_->name());
-  bElem.setAttribute(QStringLiteral("uid"), borrower_->uid());
+  writer_.startElement(QStringLiteral("borrower"));
+  writer_.writeAttribute(QStringLiteral("name"), borrower_->name());
+  writer_.writeAttribute(QStringLiteral("uid"), borrower_->uid());
 
   foreach(Data::LoanPtr it, borrower_->loans()) {
-    QDomElement lElem = dom_.createElement(QStringLiteral("loan"));
-    bElem.appendChild(lElem);
-
-    lElem.setAttribute(QStringLiteral("uid"), it->uid());
-    lElem.setAttribute(QStringLiteral("entryRef"), QString::number(it->entry()->id()));
-    lElem.setAttribute(QStringLiteral("loanDate"), it->loanDate().toString(Qt::ISODate));
-    lElem.setAttribute(QStringLiteral("dueDate"), it->dueDate().toString(Qt::ISODate));
+    writer_.startElement(QStringLiteral("loan"));
+    writer_.writeAttribute(QStringLiteral("uid"), it->uid());
+    writer_.writeAttribute(QStringLiteral("entryRef"), QString::number(it->entry()->id()));
+    writer_.writeAttribute(QStringLiteral("loanDate"), it->loanDate().toString(Qt::ISODate));
+    writer_.writeAttribute(QStringLiteral("dueDate"), it->dueDate().toString(Qt::ISODate));
     if(it->inCalendar()) {
-      lElem.setAttribute(QStringLiteral("calendar"), QStringLiteral("true"));
+      writer_.writeAttribute(QStringLiteral("calendar"), QStringLiteral("true"));
     }
-
-    lElem.appendChild(dom_.createTextNode(it->note()));
+    writer_.writeText(it->note());
+    writer_.endElement();
   }
+
+  writer_.endElement();
 }
 
 QWidget* TellicoXMLExporter::widget(QWidget* parent_) {
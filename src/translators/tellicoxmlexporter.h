@@ -33,11 +33,14 @@ namespace Tellico {
 }
 
 class QDomDocument;
-class QDomElement;
 class QCheckBox;
+struct _xmlDoc;
+class QIODevice;
+class QTextStream;
 
 namespace Tellico {
   namespace Export {
+    class TellicoXMLWriter;
 
 /**
  * @author Robby Stephenson
@@ -54,7 +57,25 @@ public:
   virtual QString fileFilter() const Q_DECL_OVERRIDE;
 
   QString text() const;
+  /**
+   * Builds the XML as a DOM document, which should only be used when a DOM is really
+   * needed, like for XSLT. Otherwise, @ref writeXML uses much less memory.
+   */
   QDomDocument exportXML() const;
+  /**
+   * Builds the XML as a libxml2 document, for XSLT processing. The content is the same
+   * as the document from @ref exportXML, without the whitespace used for indenting.
+   *
+   * @return The document, which the caller must free with xmlFreeDoc()
+   */
+  _xmlDoc* exportXMLDoc() const;
+  /**
+   * Writes the XML directly to an output device, without building a document in memory.
+   * The output is the same as the text of the document from @ref exportXML.
+   *
+   * @return Whether the data was written successfully
+   */
+  bool writeXML(QIODevice* device) const;
 
   void setIncludeImages(bool b) { m_includeImages = b; }
   void setIncludeGroups(bool b) { m_includeGroups = b; }
@@ -69,13 +90,18 @@ public:
   static const unsigned syntaxVersion;
 
 private:
-  void exportCollectionXML(QDomDocument& doc, QDomElement& parent, int format) const;
-  void exportFieldXML(QDomDocument& doc, QDomElement& parent, Data::FieldPtr field) const;
-  void exportEntryXML(QDomDocument& doc, QDomElement& parent, Data::EntryPtr entry, int format) const;
-  void exportImageXML(QDomDocument& doc, QDomElement& parent, const QString& imageID) const;
-  void exportGroupXML(QDomDocument& doc, QDomElement& parent) const;
-  void exportFilterXML(QDomDocument& doc, QDomElement& parent, FilterPtr filter) const;
-  void exportBorrowerXML(QDomDocument& doc, QDomElement& parent, Data::BorrowerPtr borrower) const;
+  void writeXML(QTextStream& ts) const;
+  void exportCollectionXML(TellicoXMLWriter& writer, int format) const;
+  void exportFieldXML(TellicoXMLWriter& writer, Data::FieldPtr field) const;
+  void exportEntryXML(TellicoXMLWriter& writer, Data::EntryPtr entry, int format) const;
+  void exportImageXML(TellicoXMLWriter& writer, const QString& imageID) const;
+  void exportGroupXML(TellicoXMLWriter& writer) const;
+  void exportFilterXML(TellicoXMLWriter& writer, FilterPtr filter) const;
+  void exportBorrowerXML(TellicoXMLWriter& writer, Data::BorrowerPtr borrower) const;
+
+  int exportVersion() const;
+  QString encodingName() const;
+  int formatRequest() const;
 
   Data::EntryList sortEntries(const Data::EntryList& entries) const;
   bool version12Needed() const;
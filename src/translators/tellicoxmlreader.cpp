@@ -0,0 +1,1252 @@
+/***************************************************************************
+    Copyright (C) 2008-2009 Robby Stephenson <robby@periapsis.org>
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tellicoxmlreader.h"
+#include "tellico_xml.h"
+#include "../collection.h"
+#include "../collectionfactory.h"
+#include "../collections/bibtexcollection.h"
+#include "../fieldformat.h"
+#include "../images/image.h"
+#include "../images/imageinfo.h"
+#include "../images/imagefactory.h"
+#include "../utils/isbnvalidator.h"
+#include "../utils/string_utils.h"
+#include "../tellico_debug.h"
+
+#include <KLocalizedString>
+
+#include <QtConcurrentRun>
+
+#include <libxml/tree.h>
+
+namespace {
+
+inline
+QString attValue(const QXmlStreamAttributes& atts, const char* name, const QString& defaultValue=QString()) {
+  const QLatin1String attName(name);
+  return atts.hasAttribute(attName) ? atts.value(attName).toString() : defaultValue;
+}
+
+inline
+QString attValue(const QXmlStreamAttributes& atts, const char* name, const char* defaultValue) {
+  Q_ASSERT(defaultValue);
+  return attValue(atts, name, QLatin1String(defaultValue));
+}
+
+// smaller chunks of entries aren't worth a separate thread
+static const int MIN_CHUNK_SIZE = 64 * 1024;
+
+bool isEntryStart(const QByteArray& data, int pos) {
+  // pos is the position of "<entry", check that the element name doesn't continue
+  if(pos + 6 >= data.size()) {
+    return false;
+  }
+  const char c = data.at(pos + 6);
+  return c == ' ' || c == '>' || c == '/' || c == '\n' || c == '\r' || c == '\t';
+}
+
+int findEntryStart(const QByteArray& data, int from) {
+  int pos = data.indexOf("<entry", from);
+  while(pos > -1 && !isEntryStart(data, pos)) {
+    pos = data.indexOf("<entry", pos + 1);
+  }
+  return pos;
+}
+
+int skipWhiteSpace(const QByteArray& data, int pos) {
+  while(pos < data.size() && (data.at(pos) == ' ' || data.at(pos) == '\n' ||
+                              data.at(pos) == '\r' || data.at(pos) == '\t')) {
+    ++pos;
+  }
+  return pos;
+}
+
+/**
+ * Finds the entries in the raw data and splits them into chunks at element boundaries.
+ * The scan depends on '<' only being used for markup, which is true for Tellico files
+ * without comments or CDATA sections, so the split isn't done if there are any.
+ *
+ * @return The offset of each chunk, followed by the end of the last one, or an empty
+ *         vector if the entries can't be split
+ */
+QVector<int> splitEntries(const QByteArray& data, int maxChunks) {
+  QVector<int> offsets;
+  // the fields must be known before the entries can be read, and older syntax versions
+  // used a different element name
+  const int fieldsEnd = data.indexOf("</fields>");
+  if(fieldsEnd < 0) {
+    return offsets;
+  }
+  const int begin = findEntryStart(data, 0);
+  if(begin < fieldsEnd) {
+    return offsets;
+  }
+  const QByteArray prefix = QByteArray::fromRawData(data.constData(), fieldsEnd);
+  // an internal DTD subset could declare entities the chunks don't know about
+  const int doctype = prefix.indexOf("<!DOCTYPE");
+  if(doctype > -1) {
+    const int subset = prefix.indexOf('[', doctype);
+    if(subset > -1 && subset < prefix.indexOf('>', doctype)) {
+      return offsets;
+    }
+  }
+  // a field named "entry" would confuse the scan for the element ends
+  if(prefix.contains("name=\"entry\"")) {
+    return offsets;
+  }
+
+  // entries don't nest, so the next end tag always closes the current entry
+  int end = begin;
+  forever {
+    const int close = data.indexOf("</entry>", end);
+    if(close < 0) {
+      return offsets;
+    }
+    end = close + 8;
+    const int next = skipWhiteSpace(data, end);
+    if(next >= data.size() || data.at(next) != '<' || !isEntryStart(data, next)) {
+      break;
+    }
+    end = next;
+  }
+
+  const int length = end - begin;
+  const int chunkCount = qMin(maxChunks, length / MIN_CHUNK_SIZE);
+  if(chunkCount < 2) {
+    return offsets;
+  }
+  const QByteArray section = QByteArray::fromRawData(data.constData() + begin, length);
+  if(section.contains("<!") || section.contains("<?")) {
+    return offsets;
+  }
+
+  offsets.append(begin);
+  for(int i = 1; i < chunkCount; ++i) {
+    const int pos = begin + static_cast<int>(qint64(length) * i / chunkCount);
+    // the chunk boundary goes after the entry which includes pos
+    const int cut = skipWhiteSpace(data, data.indexOf("</entry>", pos) + 8);
+    if(cut >= end) {
+      break;
+    }
+    if(cut > offsets.last()) {
+      offsets.append(cut);
+    }
+  }
+  offsets.append(end);
+  if(offsets.size() < 3) {
+    offsets.clear();
+  }
+  return offsets;
+}
+
+}
+
+using Tellico::Import::TellicoXMLReader;
+
+// reads the data with a range of it left out, without copying either part
+class TellicoXMLReader::SplicedBuffer : public QIODevice {
+public:
+  SplicedBuffer(const QByteArray& data_, qint64 skipBegin_, qint64 skipEnd_)
+      : m_data(data_), m_skipBegin(skipBegin_), m_skipLength(skipEnd_ - skipBegin_), m_readPos(0) {}
+
+  bool open(OpenMode mode_) Q_DECL_OVERRIDE {
+    // the data is already in memory, buffering it again is pointless
+    return QIODevice::open(mode_ | QIODevice::Unbuffered);
+  }
+  qint64 size() const Q_DECL_OVERRIDE {
+    return m_data.size() - m_skipLength;
+  }
+  bool seek(qint64 pos_) Q_DECL_OVERRIDE {
+    if(pos_ < 0 || pos_ > size() || !QIODevice::seek(pos_)) {
+      return false;
+    }
+    m_readPos = pos_;
+    return true;
+  }
+
+protected:
+  qint64 readData(char* data_, qint64 maxSize_) Q_DECL_OVERRIDE {
+    qint64 count = 0;
+    while(count < maxSize_ && m_readPos < size()) {
+      // the position in the data, and how much can be read before the skipped range or the end
+      const bool beforeSkip = m_readPos < m_skipBegin;
+      const qint64 from = beforeSkip ? m_readPos : m_readPos + m_skipLength;
+      const qint64 n = qMin(maxSize_ - count, (beforeSkip ? m_skipBegin : m_data.size()) - from);
+      memcpy(data_ + count, m_data.constData() + from, n);
+      count += n;
+      m_readPos += n;
+    }
+    return count;
+  }
+  qint64 writeData(const char*, qint64) Q_DECL_OVERRIDE {
+    return -1;
+  }
+
+private:
+  const QByteArray m_data;
+  const qint64 m_skipBegin;
+  const qint64 m_skipLength;
+  qint64 m_readPos;
+};
+
+TellicoXMLReader::TellicoXMLReader(const QByteArray& data_) : m_data(data_), m_documentError(false)
+    , m_syntaxVersion(0), m_collType(0)
+    , m_defaultFields(false), m_loadImages(false), m_hasImages(false), m_showImageLoadErrors(true)
+    , m_threadCount(1), m_i18n(false), m_validateISBN(false), m_imageLink(false), m_imageWidth(0)
+    , m_imageHeight(0), m_loanEntryId(-1), m_loanInCalendar(false) {
+  m_states.reserve(8);
+  m_states.append(RootState);
+}
+
+TellicoXMLReader::TellicoXMLReader(const QByteArray& data_, Data::CollPtr coll_, uint syntaxVersion_,
+                                   const QString& entryName_) : m_data(data_), m_documentError(false)
+    , m_syntaxVersion(syntaxVersion_), m_collType(coll_->type()), m_entryName(entryName_), m_coll(coll_)
+    , m_defaultFields(false), m_loadImages(false), m_hasImages(false), m_showImageLoadErrors(true)
+    , m_threadCount(1), m_i18n(false), m_validateISBN(false), m_imageLink(false), m_imageWidth(0)
+    , m_imageHeight(0), m_loanEntryId(-1), m_loanInCalendar(false) {
+  m_states.reserve(8);
+  m_states.append(ChunkState);
+}
+
+TellicoXMLReader::~TellicoXMLReader() {
+  // the chunks only use copies of the data, but don't leave them running
+  for(int i = 0; i < m_chunkJobs.size(); ++i) {
+    m_chunkJobs[i].waitForFinished();
+  }
+}
+
+void TellicoXMLReader::setLoadImages(bool loadImages_) {
+  m_loadImages = loadImages_;
+}
+
+void TellicoXMLReader::setShowImageLoadErrors(bool showImageErrors_) {
+  m_showImageLoadErrors = showImageErrors_;
+}
+
+void TellicoXMLReader::setThreadCount(int threadCount_) {
+  Q_ASSERT(!m_xml.device());
+  m_threadCount = qMax(1, threadCount_);
+}
+
+void TellicoXMLReader::startReading() {
+  if(m_threadCount > 1) {
+    m_chunkOffsets = splitEntries(m_data, 2 * m_threadCount);
+  }
+  // the buffer shares the data, there's no copy
+  if(m_chunkOffsets.isEmpty()) {
+    m_buffer.reset(new SplicedBuffer(m_data, m_data.size(), m_data.size()));
+  } else {
+    // the entries are read separately, so leave them out here
+    m_buffer.reset(new SplicedBuffer(m_data, m_chunkOffsets.first(), m_chunkOffsets.last()));
+  }
+  m_buffer->open(QIODevice::ReadOnly);
+  m_xml.setDevice(m_buffer.data());
+}
+
+bool TellicoXMLReader::read(qint64 bytes_) {
+  if(!m_xml.device()) {
+    startReading();
+  }
+  const qint64 stopPos = bytes_ < 0 ? -1 : m_buffer->pos() + bytes_;
+  while(!m_xml.atEnd()) {
+    switch(m_xml.readNext()) {
+      case QXmlStreamReader::StartElement:
+        {
+          const QStringRef localName = m_xml.name();
+          const State state = nextState(m_states.last(), localName);
+          m_states.append(state);
+          if(!startElement(state, localName, m_xml.attributes())) {
+            m_xml.raiseError(m_error.isEmpty() ? QStringLiteral("error triggered by consumer") : m_error);
+          }
+        }
+        break;
+
+      case QXmlStreamReader::EndElement:
+        {
+          m_text = m_text.trimmed();
+          const State state = m_states.takeLast();
+          const bool success = endElement(state, m_xml.name());
+          // need to reset character data, too
+          m_text.clear();
+          if(!success) {
+            m_xml.raiseError(m_error.isEmpty() ? QStringLiteral("error triggered by consumer") : m_error);
+          }
+        }
+        break;
+
+      case QXmlStreamReader::Characters:
+        // leading white space gets trimmed anyway, so skip all the indentation
+        if(!m_text.isEmpty() || !m_xml.isWhitespace()) {
+          m_text += m_xml.text();
+        }
+        break;
+
+      default:
+        break;
+    }
+    if(stopPos > -1 && m_buffer->pos() >= stopPos) {
+      break;
+    }
+  }
+  return !m_xml.atEnd();
+}
+
+qint64 TellicoXMLReader::bytesRead() const {
+  if(!m_buffer) {
+    return 0;
+  }
+  const qint64 pos = m_buffer->pos();
+  // account for the entries which were left out of the buffer
+  if(!m_chunkOffsets.isEmpty() && pos > m_chunkOffsets.first()) {
+    return pos + m_chunkOffsets.last() - m_chunkOffsets.first();
+  }
+  return pos;
+}
+
+bool TellicoXMLReader::readDocument(_xmlDoc* doc_) {
+  Q_ASSERT(!m_xml.device());
+  xmlNodePtr root = doc_ ? xmlDocGetRootElement(doc_) : nullptr;
+  if(!root) {
+    m_error = QStringLiteral("empty document");
+    m_documentError = true;
+    return false;
+  }
+  if(!readNode(root)) {
+    if(m_error.isEmpty()) {
+      m_error = QStringLiteral("error triggered by consumer");
+    }
+    m_documentError = true;
+    return false;
+  }
+  return true;
+}
+
+bool TellicoXMLReader::readNode(_xmlNode* node_) {
+  // the same steps as read(), for an element from the tree
+  const QString localName = QString::fromUtf8(reinterpret_cast<const char*>(node_->name));
+  QXmlStreamAttributes atts;
+  for(xmlAttrPtr attr = node_->properties; attr; attr = attr->next) {
+    xmlChar* value = xmlNodeListGetString(node_->doc, attr->children, 1);
+    atts.append(QString::fromUtf8(reinterpret_cast<const char*>(attr->name)),
+                QString::fromUtf8(reinterpret_cast<const char*>(value)));
+    xmlFree(value);
+  }
+
+  const QStringRef name(&localName);
+  const State state = nextState(m_states.last(), name);
+  m_states.append(state);
+  if(!startElement(state, name, atts)) {
+    return false;
+  }
+
+  for(xmlNodePtr child = node_->children; child; child = child->next) {
+    switch(child->type) {
+      case XML_ELEMENT_NODE:
+        if(!readNode(child)) {
+          return false;
+        }
+        break;
+
+      case XML_TEXT_NODE:
+      case XML_CDATA_SECTION_NODE:
+        {
+          const QString text = QString::fromUtf8(reinterpret_cast<const char*>(child->content));
+          // leading white space gets trimmed anyway, so skip all the indentation
+          if(!m_text.isEmpty() || !text.trimmed().isEmpty()) {
+            m_text += text;
+          }
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  m_text = m_text.trimmed();
+  m_states.removeLast();
+  const bool success = endElement(state, name);
+  // need to reset character data, too
+  m_text.clear();
+  return success;
+}
+
+bool TellicoXMLReader::hasError() const {
+  return m_xml.hasError() || m_documentError;
+}
+
+QString TellicoXMLReader::errorString() const {
+  if(!m_xml.hasError()) {
+    return m_error;
+  }
+  return QString::fromLatin1("Fatal parsing error: %1 in line %2, column %3")
+         .arg(m_xml.errorString())
+         .arg(m_xml.lineNumber())
+         .arg(m_xml.columnNumber());
+}
+
+Tellico::Data::CollPtr TellicoXMLReader::collection() const {
+  return m_coll;
+}
+
+bool TellicoXMLReader::hasImages() const {
+  return m_hasImages;
+}
+
+QString TellicoXMLReader::realFieldName(const QStringRef& localName_) const {
+  if(m_syntaxVersion < 2 && localName_ == QLatin1String("keywords")) {
+    // in version 2, "keywords" changed to "keyword"
+    return QStringLiteral("keyword");
+  }
+  return localName_.toString();
+}
+
+TellicoXMLReader::State TellicoXMLReader::nextState(State state_, const QStringRef& localName_) const {
+  State next = NullState;
+  switch(state_) {
+    case RootState:
+      if(localName_ == QLatin1String("tellico") || localName_ == QLatin1String("bookcase")) {
+        return DocumentState;
+      }
+      return RootState;
+
+    case DocumentState:
+      if(localName_ == QLatin1String("collection")) {
+        next = CollectionState;
+      } else if(localName_ == QLatin1String("filters")) {
+        next = FiltersState;
+      } else if(localName_ == QLatin1String("borrowers")) {
+        next = BorrowersState;
+      }
+      break;
+
+    case CollectionState:
+      if((m_syntaxVersion > 3 && localName_ == QLatin1String("fields")) ||
+         (m_syntaxVersion < 4 && localName_ == QLatin1String("attributes"))) {
+        next = FieldsState;
+      } else if(localName_ == QLatin1String("bibtex-preamble")) {
+        next = BibtexPreambleState;
+      } else if(localName_ == QLatin1String("macros")) {
+        next = BibtexMacrosState;
+      } else if(localName_ == m_entryName) {
+        next = EntryState;
+      } else if(localName_ == QLatin1String("images")) {
+        next = ImagesState;
+      }
+      break;
+
+    case FieldsState:
+      if((m_syntaxVersion > 3 && localName_ == QLatin1String("field")) ||
+         (m_syntaxVersion < 4 && localName_ == QLatin1String("attribute"))) {
+        next = FieldState;
+      }
+      break;
+
+    case FieldState:
+      if(localName_ == QLatin1String("prop")) {
+        next = FieldPropertyState;
+      }
+      break;
+
+    case BibtexMacrosState:
+      if(localName_ == QLatin1String("macro")) {
+        next = BibtexMacroState;
+      }
+      break;
+
+    case EntryState:
+    case FieldValueContainerState:
+      if(m_coll->hasField(realFieldName(localName_))) {
+        return FieldValueState;
+      }
+      return FieldValueContainerState;
+
+    case FieldValueState:
+      if(localName_ == QLatin1String("year") ||
+         localName_ == QLatin1String("month") ||
+         localName_ == QLatin1String("day")) {
+        next = DateValueState;
+      } else if(localName_ == QLatin1String("column")) {
+        next = TableColumnState;
+      }
+      break;
+
+    case ImagesState:
+      if(localName_ == QLatin1String("image")) {
+        next = ImageState;
+      }
+      break;
+
+    case FiltersState:
+      if(localName_ == QLatin1String("filter")) {
+        next = FilterState;
+      }
+      break;
+
+    case FilterState:
+      if(localName_ == QLatin1String("rule")) {
+        next = FilterRuleState;
+      }
+      break;
+
+    case BorrowersState:
+      if(localName_ == QLatin1String("borrower")) {
+        next = BorrowerState;
+      }
+      break;
+
+    case BorrowerState:
+      if(localName_ == QLatin1String("loan")) {
+        next = LoanState;
+      }
+      break;
+
+    case ChunkState:
+      // the element which wraps a chunk of entries
+      return ChunkEntriesState;
+
+    case ChunkEntriesState:
+      if(localName_ == m_entryName) {
+        next = EntryState;
+      }
+      break;
+
+    default:
+      break;
+  }
+  if(next == NullState) {
+    myWarning() << "no handler for" << localName_;
+  }
+  return next;
+}
+
+bool TellicoXMLReader::startElement(State state_, const QStringRef& localName_, const QXmlStreamAttributes& atts_) {
+  switch(state_) {
+    case DocumentState:    return startDocument(localName_, atts_);
+    case CollectionState:  return startCollection(atts_);
+    case FieldsState:
+      m_defaultFields = false;
+      return true;
+    case FieldState:         return startField(atts_);
+    case FieldPropertyState: return startFieldProperty(atts_);
+    case BibtexMacroState:
+      m_macroName = attValue(atts_, "name");
+      return true;
+    case EntryState:         return startEntry(atts_);
+    case FieldValueState:    return startFieldValue(localName_, atts_);
+    case ImagesState:
+      // reset variable that gets updated in the image state
+      m_hasImages = false;
+      return true;
+    case ImageState:         return startImage(atts_);
+    case FilterState:        return startFilter(atts_);
+    case FilterRuleState:    return startFilterRule(atts_);
+    case BorrowerState:      return startBorrower(atts_);
+    case LoanState:          return startLoan(atts_);
+    default:
+      return true;
+  }
+}
+
+bool TellicoXMLReader::endElement(State state_, const QStringRef& localName_) {
+  switch(state_) {
+    case CollectionState:     return endCollection();
+    case FieldsState:         return endFields();
+    case FieldState:          return endField();
+    case FieldPropertyState:  return endFieldProperty();
+    case BibtexPreambleState: return endBibtexPreamble();
+    case BibtexMacroState:    return endBibtexMacro();
+    case EntryState:          return endEntry();
+    case FieldValueState:     return endFieldValue(localName_);
+    case DateValueState:      return endDateValue(localName_);
+    case TableColumnState:    return endTableColumn();
+    case ImageState:          return endImage();
+    case FilterState:         return endFilter();
+    case BorrowerState:       return endBorrower();
+    case LoanState:           return endLoan();
+    default:
+      return true;
+  }
+}
+
+bool TellicoXMLReader::startDocument(const QStringRef& localName_, const QXmlStreamAttributes& atts_) {
+  // the syntax version field name changed from "version" to "syntaxVersion" in version 3
+  QStringRef version = atts_.value(QLatin1String("syntaxVersion"));
+  if(version.isNull()) {
+    version = atts_.value(QLatin1String("version"));
+  }
+  if(version.isNull()) {
+    myWarning() << "no syntax version";
+    return false;
+  }
+  m_syntaxVersion = version.toUInt();
+  if(m_syntaxVersion > Tellico::XML::syntaxVersion) {
+    m_error = i18n("It is from a future version of Tellico.");
+    return false;
+  }
+  if((m_syntaxVersion > 6 && localName_ != QLatin1String("tellico")) ||
+     (m_syntaxVersion < 7 && localName_ != QLatin1String("bookcase"))) {
+    // no error message
+    myWarning() << "bad root element name";
+    return false;
+  }
+  return true;
+}
+
+bool TellicoXMLReader::startCollection(const QXmlStreamAttributes& atts_) {
+  m_collTitle = attValue(atts_, "title");
+  m_collType = attValue(atts_, "type").toInt();
+  m_entryName = attValue(atts_, "unit");
+  // for error recovery, assume entry name is default if empty for now
+  if(m_entryName.isEmpty()) {
+    m_entryName = QStringLiteral("entry");
+  }
+  return true;
+}
+
+bool TellicoXMLReader::endCollection() {
+  if(!m_coll) {
+    myWarning() << "no collection created";
+    return false;
+  }
+  if(!finishEntryChunks()) {
+    return false;
+  }
+  m_coll->addEntries(m_entries);
+
+  // a little hidden capability was to just have a local path as an image file name
+  // and on reading the xml file, Tellico would load the image file, too
+  // here, we need to scan all the image values in all the entries and check
+  // maybe this is too costly, especially since the capability wasn't advertised?
+
+  const bool hasMDate = m_coll->hasField(QStringLiteral("mdate"));
+  const int maxImageWarnings = 3;
+  int imageWarnings = 0;
+
+  Data::FieldList fields = m_coll->imageFields();
+  foreach(Data::EntryPtr entry, m_entries) {
+    foreach(Data::FieldPtr field, fields) {
+      QString value = entry->field(field);
+      if(value.isEmpty()) {
+        continue;
+      }
+      // image info should have already been loaded
+      // if not, then there was no <image> in the XML
+      // so it's a url, but maybe link only
+      if(!ImageFactory::hasImageInfo(value)) {
+        const QUrl u = QUrl::fromUserInput(value);
+        // the image file name is a valid URL, but I want it to be a local URL or non empty remote one
+        if(u.isValid() && (u.isLocalFile() || !u.host().isEmpty())) {
+          const QString result = ImageFactory::addImage(u, !m_showImageLoadErrors || imageWarnings >= maxImageWarnings /* quiet */);
+          if(result.isEmpty()) {
+            // clear value for the field in this case
+            value.clear();
+            ++imageWarnings;
+          } else {
+            value = result;
+          }
+        } else {
+          value = Data::Image::idClean(value);
+        }
+        if(hasMDate) {
+          // since the modified date gets reset, keep a copy
+          const QString mdate = entry->field(QStringLiteral("mdate"));
+          entry->setField(field->name(), value);
+          entry->setField(QStringLiteral("mdate"), mdate);
+        } else {
+          // reset the image id to be whatever was loaded
+          entry->setField(field->name(), value);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool TellicoXMLReader::endFields() {
+  // add default fields if there was a default field name, or no names at all
+  const bool addFields = m_defaultFields || m_fields.isEmpty();
+  // in syntax 4, the element name was changed to "entry", always, rather than depending on
+  // on the entryName of the collection.
+  if(m_syntaxVersion > 3) {
+    m_entryName = QStringLiteral("entry");
+    Data::Collection::Type type = static_cast<Data::Collection::Type>(m_collType);
+    m_coll = CollectionFactory::collection(type, addFields);
+  } else {
+    m_coll = CollectionFactory::collection(m_entryName, addFields);
+  }
+
+  if(!m_collTitle.isEmpty()) {
+    m_coll->setTitle(m_collTitle);
+  }
+
+  // add a default field for ID
+  // checking the defaultFields bool since if it is true, we already added these default fields
+  // even for old syntax versions
+  if(m_syntaxVersion < 11 && !m_defaultFields) {
+    m_coll->addField(Data::Field::createDefaultField(Data::Field::IDField));
+  }
+  // now add all the new fields
+  m_coll->addFields(m_fields);
+  if(m_syntaxVersion < 11 && !m_defaultFields) {
+    m_coll->addField(Data::Field::createDefaultField(Data::Field::CreatedDateField));
+    m_coll->addField(Data::Field::createDefaultField(Data::Field::ModifiedDateField));
+  }
+
+//  as a special case, for old book collections with a bibtex-id field, convert to Bibtex
+  if(m_syntaxVersion < 4 && m_collType == Data::Collection::Book
+     && m_coll->hasField(QStringLiteral("bibtex-id"))) {
+    m_coll = Data::BibtexCollection::convertBookCollection(m_coll);
+  }
+
+  startEntryChunks();
+  return true;
+}
+
+void TellicoXMLReader::startEntryChunks() {
+  if(m_chunkOffsets.isEmpty() || !m_chunkJobs.isEmpty()) {
+    return;
+  }
+  for(int i = 1; i < m_chunkOffsets.size(); ++i) {
+    m_chunkJobs.append(QtConcurrent::run(&TellicoXMLReader::readEntryChunk,
+                                         entryChunkData(m_chunkOffsets.at(i-1), m_chunkOffsets.at(i)),
+                                         m_coll, m_syntaxVersion, m_entryName));
+  }
+}
+
+bool TellicoXMLReader::finishEntryChunks() {
+  if(m_chunkJobs.isEmpty()) {
+    return true;
+  }
+  Data::EntryList entries;
+  bool success = true;
+  for(int i = 0; i < m_chunkJobs.size(); ++i) {
+    const EntryChunk chunk = m_chunkJobs.at(i).result();
+    if(!chunk.error.isEmpty()) {
+      myDebug() << "Failed to read entry chunk:" << chunk.error;
+      success = false;
+    }
+    entries += chunk.entries;
+  }
+  m_chunkJobs.clear();
+  if(!success) {
+    // maybe the split was wrong, try again with all the entries at once
+    const EntryChunk chunk = readEntryChunk(entryChunkData(m_chunkOffsets.first(), m_chunkOffsets.last()),
+                                            m_coll, m_syntaxVersion, m_entryName);
+    if(!chunk.error.isEmpty()) {
+      m_error = chunk.error;
+      return false;
+    }
+    entries = chunk.entries;
+  }
+  // any entries read in this thread come later in the document
+  m_entries = entries + m_entries;
+  return true;
+}
+
+QByteArray TellicoXMLReader::entryChunkData(int begin_, int end_) const {
+  QByteArray chunk;
+  chunk.reserve(end_ - begin_ + 64);
+  // keep the XML declaration, for the encoding
+  const int decl = m_data.indexOf("<?xml");
+  if(decl > -1 && decl < 4) {
+    const int declEnd = m_data.indexOf("?>", decl);
+    if(declEnd > -1) {
+      chunk.append(m_data.constData(), declEnd + 2);
+    }
+  }
+  chunk.append("<entries>");
+  chunk.append(m_data.constData() + begin_, end_ - begin_);
+  chunk.append("</entries>");
+  return chunk;
+}
+
+TellicoXMLReader::EntryChunk TellicoXMLReader::readEntryChunk(const QByteArray& data_, Data::CollPtr coll_,
+                                                              uint syntaxVersion_, const QString& entryName_) {
+  TellicoXMLReader reader(data_, coll_, syntaxVersion_, entryName_);
+  reader.read();
+  EntryChunk chunk;
+  if(reader.hasError()) {
+    chunk.error = reader.errorString();
+  } else {
+    chunk.entries = reader.m_entries;
+  }
+  return chunk;
+}
+
+bool TellicoXMLReader::startField(const QXmlStreamAttributes& atts_) {
+  // special case: if the i18n attribute equals true, then translate the title, description, category, and allowed
+  const bool isI18n = atts_.value(QLatin1String("i18n")) == QLatin1String("true");
+
+  QString name = attValue(atts_, "name", "unknown");
+  if(name == QLatin1String("_default")) {
+    m_defaultFields = true;
+    return true;
+  }
+
+  QString title  = attValue(atts_, "title", i18n("Unknown"));
+  if(isI18n) {
+    title = i18n(title.toUtf8().constData());
+  }
+
+  QString typeStr = attValue(atts_, "type", QString::number(Data::Field::Line));
+  Data::Field::Type type = static_cast<Data::Field::Type>(typeStr.toInt());
+
+  Data::FieldPtr field;
+  if(type == Data::Field::Choice) {
+    QStringList allowed = attValue(atts_, "allowed").split(QRegExp(QLatin1String("\\s*;\\s*")), QString::SkipEmptyParts);
+    if(isI18n) {
+      for(QStringList::Iterator word = allowed.begin(); word != allowed.end(); ++word) {
+        (*word) = i18n((*word).toUtf8().constData());
+      }
+    }
+    field = new Data::Field(name, title, allowed);
+  } else {
+    field = new Data::Field(name, title, type);
+  }
+
+  if(atts_.hasAttribute(QLatin1String("category"))) {
+    // at one point, the categories had keyboard accels
+    QString cat = atts_.value(QLatin1String("category")).toString();
+    if(m_syntaxVersion < 9) {
+      cat.remove(QLatin1Char('&'));
+    }
+    if(isI18n) {
+      cat = i18n(cat.toUtf8().constData());
+    }
+    field->setCategory(cat);
+  }
+
+  if(atts_.hasAttribute(QLatin1String("flags"))) {
+    int flags = atts_.value(QLatin1String("flags")).toInt();
+    // I also changed the enum values for syntax 3, but the only custom field
+    // would have been bibtex-id
+    if(m_syntaxVersion < 3 && name == QLatin1String("bibtex-id")) {
+      flags = 0;
+    }
+
+    // in syntax version 4, added a flag to disallow deleting attributes
+    // if it's a version before that and is the title, then add the flag
+    if(m_syntaxVersion < 4 && name == QLatin1String("title")) {
+      flags |= Data::Field::NoDelete;
+    }
+    // some of the flags may have been set in the constructor
+    // in the case of old Dependent fields changing, for example
+    // so combine with the existing flags
+    field->setFlags(field->flags() | flags);
+  }
+
+  QString formatStr = attValue(atts_, "format", QString::number(FieldFormat::FormatNone));
+  FieldFormat::Type formatType = static_cast<FieldFormat::Type>(formatStr.toInt());
+  field->setFormatType(formatType);
+
+  if(atts_.hasAttribute(QLatin1String("description"))) {
+    QString desc = atts_.value(QLatin1String("description")).toString();
+    if(isI18n) {
+      desc = i18n(desc.toUtf8().constData());
+    }
+    field->setDescription(desc);
+  }
+
+  if(m_syntaxVersion < 5 && atts_.hasAttribute(QLatin1String("bibtex-field"))) {
+    field->setProperty(QStringLiteral("bibtex"), attValue(atts_, "bibtex-field"));
+  }
+
+  // for syntax 8, rating fields got their own type
+  if(m_syntaxVersion < 8) {
+    Data::Field::convertOldRating(field); // does all its own checking
+  }
+  m_fields.append(field);
+
+  return true;
+}
+
+bool TellicoXMLReader::endField() {
+  // the value template for derived values used to be the field description
+  // now it is the 'template' property
+  // for derived value fields, if there is no property and the description has a '%'
+  // move it to the property
+  //
+  // might be empty is we're only adding default fields
+  if(!m_fields.isEmpty()) {
+    Data::FieldPtr field = m_fields.back();
+    if(field->hasFlag(Data::Field::Derived) &&
+       field->property(QStringLiteral("template")).isEmpty() &&
+       field->description().contains(QLatin1Char('%'))) {
+      field->setProperty(QStringLiteral("template"), field->description());
+      field->setDescription(QString());
+    }
+  }
+
+  return true;
+}
+
+bool TellicoXMLReader::startFieldProperty(const QXmlStreamAttributes& atts_) {
+  // there should be at least one field already so we can add properties to it
+  Q_ASSERT(!m_fields.isEmpty());
+  Data::FieldPtr field = m_fields.back();
+
+  m_propertyName = attValue(atts_, "name");
+
+  // all track fields in music collections prior to version 9 get converted to three columns
+  if(m_syntaxVersion < 9) {
+    if(m_collType == Data::Collection::Album && field->name() == QLatin1String("track")) {
+      field->setProperty(QStringLiteral("columns"), QStringLiteral("3"));
+      field->setProperty(QStringLiteral("column1"), i18n("Title"));
+      field->setProperty(QStringLiteral("column2"), i18n("Artist"));
+      field->setProperty(QStringLiteral("column3"), i18n("Length"));
+    } else if(m_collType == Data::Collection::Video && field->name() == QLatin1String("cast")) {
+      field->setProperty(QStringLiteral("column1"), i18n("Actor/Actress"));
+      field->setProperty(QStringLiteral("column2"), i18n("Role"));
+    }
+  }
+
+  return true;
+}
+
+bool TellicoXMLReader::endFieldProperty() {
+  Q_ASSERT(!m_propertyName.isEmpty());
+  // add the previous property
+  Data::FieldPtr field = m_fields.back();
+  field->setProperty(m_propertyName, m_text);
+  return true;
+}
+
+bool TellicoXMLReader::endBibtexPreamble() {
+  Q_ASSERT(m_coll);
+  if(m_coll && m_collType == Data::Collection::Bibtex && !m_text.isEmpty()) {
+    Data::BibtexCollection* c = static_cast<Data::BibtexCollection*>(m_coll.data());
+    c->setPreamble(m_text);
+  }
+  return true;
+}
+
+bool TellicoXMLReader::endBibtexMacro() {
+  if(m_coll && m_collType == Data::Collection::Bibtex && !m_macroName.isEmpty() && !m_text.isEmpty()) {
+    Data::BibtexCollection* c = static_cast<Data::BibtexCollection*>(m_coll.data());
+    c->addMacro(m_macroName, m_text);
+  }
+  return true;
+}
+
+bool TellicoXMLReader::startEntry(const QXmlStreamAttributes& atts_) {
+  // the entries must come after the fields
+  if(!m_coll || m_coll->fields().isEmpty()) {
+    // special case for very old versions which did not have user-editable fields
+    // also maybe a new version has bad formatting, try to recover by assuming default fields
+    m_defaultFields = true;
+    // fake the end of a fields element, which will add the default fields
+    endFields();
+
+    myWarning() << "entries should come after fields are defined, attempting to recover";
+  }
+  bool ok;
+  const int id = atts_.value(QLatin1String("id")).toInt(&ok);
+  Data::EntryPtr entry;
+  if(ok && id > -1) {
+    entry = new Data::Entry(m_coll, id);
+  } else {
+    entry = new Data::Entry(m_coll);
+  }
+  m_entries.append(entry);
+  return true;
+}
+
+bool TellicoXMLReader::endEntry() {
+  Data::EntryPtr entry = m_entries.back();
+  Q_ASSERT(entry);
+  if(!m_modifiedDate.isEmpty() && m_coll->hasField(QStringLiteral("mdate"))) {
+    entry->setField(QStringLiteral("mdate"), m_modifiedDate);
+    m_modifiedDate.clear();
+  }
+  return true;
+}
+
+bool TellicoXMLReader::startFieldValue(const QStringRef& localName_, const QXmlStreamAttributes& atts_) {
+  m_currentField = m_coll->fieldByName(realFieldName(localName_));
+  m_i18n = atts_.value(QLatin1String("i18n")) == QLatin1String("true");
+  m_validateISBN = (localName_ == QLatin1String("isbn")) &&
+                   (atts_.value(QLatin1String("validate")) != QLatin1String("no"));
+  return true;
+}
+
+bool TellicoXMLReader::endFieldValue(const QStringRef& localName_) {
+  Data::EntryPtr entry = m_entries.back();
+  Q_ASSERT(entry);
+  QString fieldName = realFieldName(localName_);
+  QString fieldValue = m_text;
+
+  Data::FieldPtr f = m_coll->fieldByName(fieldName);
+  if(!f) {
+    myWarning() << "no field named " << fieldName;
+    return true;
+  }
+  // if it's a derived value, no field value is added
+  if(f->hasFlag(Data::Field::Derived)) {
+    return true;
+  }
+
+  if(m_syntaxVersion < 4 && f->type() == Data::Field::Bool) {
+    // in version 3 and prior, checkbox attributes had no text(), set it to "true"
+    fieldValue = QStringLiteral("true");
+  } else if(m_syntaxVersion < 8 && f->type() == Data::Field::Rating) {
+    // in version 8, old rating fields get changed
+    bool ok;
+    uint i = Tellico::toUInt(fieldValue, &ok);
+    if(ok) {
+      fieldValue = QString::number(i);
+    }
+  } else if(!m_textBuffer.isEmpty()) {
+    // for dates and tables, the value is built up from child elements
+#ifndef NDEBUG
+    if(!m_text.isEmpty()) {
+      myWarning() << "ignoring value for field" << localName_ << ":" << m_text;
+    }
+#endif
+    fieldValue = m_textBuffer;
+    // the text buffer has the column delimiter at the end, remove it
+    if(f->type() == Data::Field::Table) {
+      fieldValue.chop(FieldFormat::columnDelimiterString().length());
+    }
+    m_textBuffer.clear();
+  }
+  // this is not an else branch, the data may be in the textBuffer
+  if(m_syntaxVersion < 9 && m_coll->type() == Data::Collection::Album && fieldName == QLatin1String("track")) {
+    // yes, this assumes the artist has already been set
+    fieldValue += FieldFormat::columnDelimiterString();
+    fieldValue += entry->field(QStringLiteral("artist"));
+  }
+  if(fieldValue.isEmpty()) {
+    return true;
+  }
+  // special case: if the i18n attribute equals true, then translate the title, description, and category
+  if(m_i18n) {
+    fieldValue = i18n(fieldValue.toUtf8().constData());
+  }
+  // special case for isbn fields, go ahead and validate
+  if(m_validateISBN) {
+    ISBNValidator val(nullptr);
+    val.fixup(fieldValue);
+  }
+  // for fields with multiple values, we need to add on the new value
+  QString oldValue = entry->field(fieldName);
+  if(!oldValue.isEmpty()) {
+    if(f->type() == Data::Field::Table) {
+      fieldValue = oldValue + FieldFormat::rowDelimiterString() + fieldValue;
+    } else if(f->hasFlag(Data::Field::AllowMultiple)) {
+      fieldValue = oldValue + FieldFormat::delimiterString() + fieldValue;
+    }
+  }
+  // since the modified date value in the entry gets changed every time we set a new value
+  // we have to save it and set it after changing all the others
+  if(fieldName == QLatin1String("mdate")) {
+    m_modifiedDate = fieldValue;
+  } else {
+    // no need to update the modified date when setting the entry's field value
+    entry->setField(fieldName, fieldValue, false /* no modified date update */);
+  }
+  return true;
+}
+
+bool TellicoXMLReader::endDateValue(const QStringRef& localName_) {
+  // the data value is y-m-d even if there are no date values
+  if(m_textBuffer.isEmpty()) {
+    m_textBuffer = QStringLiteral("--");
+  }
+  QStringList tokens = m_textBuffer.split(QLatin1Char('-'), QString::KeepEmptyParts);
+  Q_ASSERT(tokens.size() == 3);
+  if(localName_ == QLatin1String("year")) {
+    tokens[0] = m_text;
+  } else if(localName_ == QLatin1String("month")) {
+    // enforce two digits for month
+    while(m_text.length() < 2) {
+      m_text.prepend(QLatin1Char('0'));
+    }
+    tokens[1] = m_text;
+  } else if(localName_ == QLatin1String("day")) {
+    // enforce two digits for day
+    while(m_text.length() < 2) {
+      m_text.prepend(QLatin1Char('0'));
+    }
+    tokens[2] = m_text;
+  }
+  m_textBuffer = tokens.join(QLatin1String("-"));
+  return true;
+}
+
+bool TellicoXMLReader::endTableColumn() {
+  // for old collections, if the second column holds the track length, bump it to next column
+  if(m_syntaxVersion < 9 &&
+     m_coll->type() == Data::Collection::Album &&
+     m_currentField->name() == QLatin1String("track") &&
+     !m_textBuffer.isEmpty() &&
+     m_textBuffer.contains(FieldFormat::columnDelimiterString()) == 0) {
+    QRegExp rx(QLatin1String("\\d+:\\d\\d"));
+    if(rx.exactMatch(m_text)) {
+      m_text += FieldFormat::columnDelimiterString();
+      m_text += m_entries.back()->field(QStringLiteral("artist"));
+    }
+  }
+
+  m_textBuffer += m_text + FieldFormat::columnDelimiterString();
+  return true;
+}
+
+bool TellicoXMLReader::startImage(const QXmlStreamAttributes& atts_) {
+  m_imageFormat = attValue(atts_, "format");
+  m_imageLink = atts_.value(QLatin1String("link")) == QLatin1String("true");
+  // idClean() already calls shareString()
+  m_imageId = m_imageLink ? shareString(attValue(atts_, "id"))
+                          : Data::Image::idClean(attValue(atts_, "id"));
+  m_imageWidth = atts_.value(QLatin1String("width")).toInt();
+  m_imageHeight = atts_.value(QLatin1String("height")).toInt();
+  return true;
+}
+
+bool TellicoXMLReader::endImage() {
+  bool needToAddInfo = true;
+  if(m_loadImages && !m_text.isEmpty()) {
+    QByteArray ba = QByteArray::fromBase64(m_text.toLatin1());
+    if(!ba.isEmpty()) {
+      QString result = ImageFactory::addImage(ba, m_imageFormat, m_imageId);
+      if(result.isEmpty()) {
+        myDebug() << "null image for" << m_imageId;
+      }
+      m_hasImages = true;
+      needToAddInfo = false;
+    }
+  }
+  if(needToAddInfo) {
+    // a width or height of 0 is ok here
+    Data::ImageInfo info(m_imageId, m_imageFormat.toLatin1(), m_imageWidth, m_imageHeight, m_imageLink);
+    ImageFactory::cacheImageInfo(info);
+  }
+  return true;
+}
+
+bool TellicoXMLReader::startFilter(const QXmlStreamAttributes& atts_) {
+  m_filter = new Filter(Filter::MatchAny);
+  m_filter->setName(attValue(atts_, "name"));
+
+  if(atts_.value(QLatin1String("match")) == QLatin1String("all")) {
+    m_filter->setMatch(Filter::MatchAll);
+  }
+  return true;
+}
+
+bool TellicoXMLReader::endFilter() {
+  if(m_coll && !m_filter->isEmpty()) {
+    m_coll->addFilter(m_filter);
+  }
+  m_filter = FilterPtr();
+  return true;
+}
+
+bool TellicoXMLReader::startFilterRule(const QXmlStreamAttributes& atts_) {
+  QString field = attValue(atts_, "field");
+  // empty field means match any of them
+  QString pattern = attValue(atts_, "pattern");
+  // empty pattern is bad
+  if(pattern.isEmpty()) {
+    myWarning() << "empty rule!";
+    return true;
+  }
+  /* If anything is updated here, be sure to update tellicoxmlexporter */
+  QString function = attValue(atts_, "function").toLower();
+  FilterRule::Function func;
+  if(function == QLatin1String("contains")) {
+    func = FilterRule::FuncContains;
+  } else if(function == QLatin1String("notcontains")) {
+    func = FilterRule::FuncNotContains;
+  } else if(function == QLatin1String("equals")) {
+    func = FilterRule::FuncEquals;
+  } else if(function == QLatin1String("notequals")) {
+    func = FilterRule::FuncNotEquals;
+  } else if(function == QLatin1String("regexp")) {
+    func = FilterRule::FuncRegExp;
+  } else if(function == QLatin1String("notregexp")) {
+    func = FilterRule::FuncNotRegExp;
+  } else if(function == QLatin1String("before")) {
+    func = FilterRule::FuncBefore;
+  } else if(function == QLatin1String("after")) {
+    func = FilterRule::FuncAfter;
+  } else if(function == QLatin1String("greaterthan")) {
+    func = FilterRule::FuncGreater;
+  } else if(function == QLatin1String("lessthan")) {
+    func = FilterRule::FuncLess;
+  } else {
+    myWarning() << "invalid rule function:" << function;
+    return true;
+  }
+  m_filter->append(new FilterRule(field, pattern, func));
+  return true;
+}
+
+bool TellicoXMLReader::startBorrower(const QXmlStreamAttributes& atts_) {
+  QString name = attValue(atts_, "name");
+  QString uid = attValue(atts_, "uid");
+  m_borrower = new Data::Borrower(name, uid);
+
+  return true;
+}
+
+bool TellicoXMLReader::endBorrower() {
+  if(m_coll && !m_borrower->isEmpty()) {
+    m_coll->addBorrower(m_borrower);
+  }
+  m_borrower = Data::BorrowerPtr();
+  return true;
+}
+
+bool TellicoXMLReader::startLoan(const QXmlStreamAttributes& atts_) {
+  m_loanEntryId = atts_.value(QLatin1String("entryRef")).toInt();
+  m_loanUid = attValue(atts_, "uid");
+  m_loanDate = attValue(atts_, "loanDate");
+  m_dueDate = attValue(atts_, "dueDate");
+  m_loanInCalendar = atts_.value(QLatin1String("calendar")) == QLatin1String("true");
+  return true;
+}
+
+bool TellicoXMLReader::endLoan() {
+  Data::EntryPtr entry = m_coll->entryById(m_loanEntryId);
+  if(!entry) {
+    myWarning() << "no entry with id = " << m_loanEntryId;
+    return true;
+  }
+  QDate loanDate, dueDate;
+  if(!m_loanDate.isEmpty()) {
+    loanDate = QDate::fromString(m_loanDate, Qt::ISODate);
+  }
+  if(!m_dueDate.isEmpty()) {
+    dueDate = QDate::fromString(m_dueDate, Qt::ISODate);
+  }
+
+  Data::LoanPtr loan(new Data::Loan(entry, loanDate, dueDate, m_text));
+  loan->setUID(m_loanUid);
+  loan->setInCalendar(m_loanInCalendar);
+  m_borrower->addLoan(loan);
+  return true;
+}
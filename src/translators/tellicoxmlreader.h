@@ -0,0 +1,226 @@
+/***************************************************************************
+    Copyright (C) 2008-2009 Robby Stephenson <robby@periapsis.org>
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_IMPORT_TELLICOXMLREADER_H
+#define TELLICO_IMPORT_TELLICOXMLREADER_H
+
+#include "../datavectors.h"
+
+#include <QXmlStreamReader>
+#include <QScopedPointer>
+#include <QVector>
+#include <QFuture>
+
+// the libxml2 tree types, for reading a document which is already parsed
+struct _xmlDoc;
+struct _xmlNode;
+
+namespace Tellico {
+  namespace Import {
+
+/**
+ * The TellicoXMLReader reads a Tellico XML document into a collection.
+ *
+ * The document is read in a single pass with a QXmlStreamReader. The state of the parse is
+ * kept as a stack of element states, rather than a handler object for every element.
+ * Reading can be done in steps, so the caller can show progress in between. Older syntax
+ * versions are upgraded while reading.
+ *
+ * The entries are independent of each other, so once the fields are known, the entry section
+ * of a large document can be split at element boundaries and read by several threads. The
+ * entries are put back in document order before being added to the collection.
+ *
+ * @author Robby Stephenson
+ * @author agent
+ */
+class TellicoXMLReader {
+public:
+  explicit TellicoXMLReader(const QByteArray& data);
+  ~TellicoXMLReader();
+
+  void setLoadImages(bool loadImages);
+  void setShowImageLoadErrors(bool showImageErrors);
+  /**
+   * Sets the number of threads used to read the entries. The default of 1 reads
+   * everything in the calling thread. Must be called before reading.
+   */
+  void setThreadCount(int threadCount);
+
+  /**
+   * Continues reading the document until at least a number of bytes has been read,
+   * or until the end of the document.
+   *
+   * @param bytes The number of bytes to read, or a negative value to read everything
+   * @return Whether there is more to read
+   */
+  bool read(qint64 bytes = -1);
+  /**
+   * Reads a document which was already parsed by libxml2, such as the result of an XSLT
+   * transformation, rather than the data. The tree is read with the same element handling
+   * as the text, so there's no need to write it out and parse it again.
+   *
+   * @param doc The document
+   * @return Whether the document was read without error
+   */
+  bool readDocument(_xmlDoc* doc);
+  /**
+   * Returns the number of bytes read so far
+   */
+  qint64 bytesRead() const;
+  bool hasError() const;
+  QString errorString() const;
+
+  Data::CollPtr collection() const;
+  bool hasImages() const;
+
+private:
+  Q_DISABLE_COPY(TellicoXMLReader)
+
+  struct EntryChunk {
+    Data::EntryList entries;
+    QString error;
+  };
+
+  class SplicedBuffer;
+
+  // used by the threads which read a chunk of entries
+  TellicoXMLReader(const QByteArray& data, Data::CollPtr coll, uint syntaxVersion, const QString& entryName);
+  static EntryChunk readEntryChunk(const QByteArray& data, Data::CollPtr coll, uint syntaxVersion, const QString& entryName);
+
+  enum State {
+    NullState,
+    RootState,
+    DocumentState,
+    CollectionState,
+    FieldsState,
+    FieldState,
+    FieldPropertyState,
+    BibtexPreambleState,
+    BibtexMacrosState,
+    BibtexMacroState,
+    EntryState,
+    FieldValueContainerState,
+    FieldValueState,
+    DateValueState,
+    TableColumnState,
+    ImagesState,
+    ImageState,
+    FiltersState,
+    FilterState,
+    FilterRuleState,
+    BorrowersState,
+    BorrowerState,
+    LoanState,
+    ChunkState,
+    ChunkEntriesState
+  };
+
+  void startReading();
+  void startEntryChunks();
+  bool finishEntryChunks();
+  QByteArray entryChunkData(int begin, int end) const;
+  bool readNode(_xmlNode* node);
+
+  State nextState(State state, const QStringRef& localName) const;
+  bool startElement(State state, const QStringRef& localName, const QXmlStreamAttributes& atts);
+  bool endElement(State state, const QStringRef& localName);
+
+  bool startDocument(const QStringRef& localName, const QXmlStreamAttributes& atts);
+  bool startCollection(const QXmlStreamAttributes& atts);
+  bool endCollection();
+  bool endFields();
+  bool startField(const QXmlStreamAttributes& atts);
+  bool endField();
+  bool startFieldProperty(const QXmlStreamAttributes& atts);
+  bool endFieldProperty();
+  bool endBibtexPreamble();
+  bool endBibtexMacro();
+  bool startEntry(const QXmlStreamAttributes& atts);
+  bool endEntry();
+  bool startFieldValue(const QStringRef& localName, const QXmlStreamAttributes& atts);
+  bool endFieldValue(const QStringRef& localName);
+  bool endDateValue(const QStringRef& localName);
+  bool endTableColumn();
+  bool startImage(const QXmlStreamAttributes& atts);
+  bool endImage();
+  bool startFilter(const QXmlStreamAttributes& atts);
+  bool endFilter();
+  bool startFilterRule(const QXmlStreamAttributes& atts);
+  bool startBorrower(const QXmlStreamAttributes& atts);
+  bool endBorrower();
+  bool startLoan(const QXmlStreamAttributes& atts);
+  bool endLoan();
+
+  QString realFieldName(const QStringRef& localName) const;
+
+  QByteArray m_data;
+  QScopedPointer<SplicedBuffer> m_buffer;
+  QXmlStreamReader m_xml;
+  QVector<State> m_states;
+  QString m_text;
+  QString m_textBuffer;
+  QString m_error;
+  bool m_documentError;
+
+  uint m_syntaxVersion;
+  QString m_collTitle;
+  int m_collType;
+  QString m_entryName;
+  Data::CollPtr m_coll;
+  Data::FieldList m_fields;
+  Data::FieldPtr m_currentField;
+  Data::EntryList m_entries;
+  QString m_modifiedDate;
+  FilterPtr m_filter;
+  Data::BorrowerPtr m_borrower;
+  bool m_defaultFields;
+  bool m_loadImages;
+  bool m_hasImages;
+  bool m_showImageLoadErrors;
+  int m_threadCount;
+  // the byte offsets of the entry chunks, from the start of the first to the end of the last
+  QVector<int> m_chunkOffsets;
+  QVector<QFuture<EntryChunk> > m_chunkJobs;
+
+  // values from the start of the current element, used at the end of it
+  QString m_propertyName;
+  QString m_macroName;
+  bool m_i18n;
+  bool m_validateISBN;
+  QString m_imageFormat;
+  bool m_imageLink;
+  QString m_imageId;
+  int m_imageWidth;
+  int m_imageHeight;
+  int m_loanEntryId;
+  QString m_loanUid;
+  QString m_loanDate;
+  QString m_dueDate;
+  bool m_loanInCalendar;
+};
+
+  }
+}
+#endif
@@ -0,0 +1,301 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tellicoxmlwriter.h"
+#include "../tellico_debug.h"
+
+#include <QDomDocument>
+#include <QTextStream>
+#include <QTextCodec>
+
+#include <libxml/tree.h>
+
+using Tellico::Export::TellicoXMLWriter;
+using Tellico::Export::TellicoDomWriter;
+using Tellico::Export::TellicoLibXMLWriter;
+using Tellico::Export::TellicoStreamWriter;
+
+namespace {
+  // same as the default indentation used by QDomDocument::toString()
+  static const int XML_INDENT = 1;
+}
+
+void TellicoXMLWriter::writeTextElement(const QString& name_, const QString& text_) {
+  startElement(name_);
+  writeText(text_);
+  endElement();
+}
+
+TellicoDomWriter::TellicoDomWriter(QDomDocument& dom_, const QDomElement& parent_) : m_dom(dom_) {
+  m_elements.append(parent_);
+  m_omitIfEmpty.append(false);
+}
+
+void TellicoDomWriter::startElement(const QString& name_, bool omitIfEmpty_) {
+  QDomElement elem = m_dom.createElement(name_);
+  m_elements.last().appendChild(elem);
+  m_elements.append(elem);
+  m_omitIfEmpty.append(omitIfEmpty_);
+}
+
+void TellicoDomWriter::writeAttribute(const QString& name_, const QString& value_) {
+  m_elements.last().setAttribute(name_, value_);
+}
+
+void TellicoDomWriter::writeText(const QString& text_) {
+  m_elements.last().appendChild(m_dom.createTextNode(text_));
+}
+
+void TellicoDomWriter::endElement() {
+  // never remove the parent element passed in the constructor
+  Q_ASSERT(m_elements.count() > 1);
+  if(m_elements.count() < 2) {
+    return;
+  }
+  QDomElement elem = m_elements.takeLast();
+  if(m_omitIfEmpty.takeLast() && !elem.hasChildNodes()) {
+    m_elements.last().removeChild(elem);
+  }
+}
+
+TellicoLibXMLWriter::TellicoLibXMLWriter(_xmlNode* parent_) {
+  Q_ASSERT(parent_);
+  m_elements.append(parent_);
+  m_omitIfEmpty.append(false);
+}
+
+void TellicoLibXMLWriter::startElement(const QString& name_, bool omitIfEmpty_) {
+  // with a null namespace, the new element inherits the one from the parent
+  xmlNodePtr elem = xmlNewChild(m_elements.last(), nullptr,
+                                reinterpret_cast<const xmlChar*>(name_.toUtf8().constData()), nullptr);
+  m_elements.append(elem);
+  m_omitIfEmpty.append(omitIfEmpty_);
+}
+
+void TellicoLibXMLWriter::writeAttribute(const QString& name_, const QString& value_) {
+  // the values in the tree are not escaped
+  xmlNewProp(m_elements.last(),
+             reinterpret_cast<const xmlChar*>(name_.toUtf8().constData()),
+             reinterpret_cast<const xmlChar*>(value_.toUtf8().constData()));
+}
+
+void TellicoLibXMLWriter::writeText(const QString& text_) {
+  xmlAddChild(m_elements.last(), xmlNewText(reinterpret_cast<const xmlChar*>(text_.toUtf8().constData())));
+}
+
+void TellicoLibXMLWriter::endElement() {
+  // never remove the parent element passed in the constructor
+  Q_ASSERT(m_elements.count() > 1);
+  if(m_elements.count() < 2) {
+    return;
+  }
+  xmlNodePtr elem = m_elements.takeLast();
+  if(m_omitIfEmpty.takeLast() && !elem->children) {
+    xmlUnlinkNode(elem);
+    xmlFreeNode(elem);
+  }
+}
+
+TellicoStreamWriter::TellicoStreamWriter(QTextStream* stream_, const QString& encoding_) : m_stream(stream_)
+    , m_encoding(encoding_), m_codec(nullptr), m_pendingNewline(false) {
+  Q_ASSERT(m_stream);
+  QTextCodec* codec = QTextCodec::codecForName(m_encoding.toLatin1());
+  // UTF-8 can encode everything, so only other codecs need to be checked
+  if(codec && codec->mibEnum() != 106) {
+    m_codec = codec;
+  }
+}
+
+void TellicoStreamWriter::writeStartDocument(const QString& doctype_, const QString& publicId_, const QString& systemId_) {
+  *m_stream << QLatin1String("<?xml version=\"1.0\" encoding=\"") << m_encoding << QLatin1String("\"?>\n");
+  // QDom uses single quotes unless the value includes one
+  const QChar pubQuote = publicId_.contains(QLatin1Char('\'')) ? QLatin1Char('"') : QLatin1Char('\'');
+  const QChar sysQuote = systemId_.contains(QLatin1Char('\'')) ? QLatin1Char('"') : QLatin1Char('\'');
+  *m_stream << QLatin1String("<!DOCTYPE ") << doctype_
+            << QLatin1String(" PUBLIC ") << pubQuote << publicId_ << pubQuote
+            << QLatin1Char(' ') << sysQuote << systemId_ << sysQuote
+            << QLatin1String(">\n");
+}
+
+void TellicoStreamWriter::writeEndDocument() {
+  Q_ASSERT(m_elements.isEmpty());
+  if(m_pendingNewline) {
+    *m_stream << QLatin1Char('\n');
+    m_pendingNewline = false;
+  }
+  m_stream->flush();
+}
+
+void TellicoStreamWriter::startElement(const QString& name_, bool omitIfEmpty_) {
+  Element elem;
+  elem.name = name_;
+  elem.omitIfEmpty = omitIfEmpty_;
+  elem.tagWritten = false;
+  elem.hasChildren = false;
+  elem.lastChildIsText = false;
+  m_elements.append(elem);
+}
+
+void TellicoStreamWriter::writeAttribute(const QString& name_, const QString& value_) {
+  Q_ASSERT(!m_elements.isEmpty());
+  Element& elem = m_elements.last();
+  // attributes can't be added once the start tag is written
+  Q_ASSERT(!elem.tagWritten);
+  elem.attributes += QLatin1Char(' ') + name_ + QLatin1String("=\"") + encodeText(value_, true) + QLatin1Char('"');
+}
+
+void TellicoStreamWriter::writeText(const QString& text_) {
+  Q_ASSERT(!m_elements.isEmpty());
+  const int index = m_elements.count() - 1;
+  writeStartTag(index);
+  beginChild(m_elements[index], true);
+  *m_stream << encodeText(text_, false);
+}
+
+void TellicoStreamWriter::endElement() {
+  Q_ASSERT(!m_elements.isEmpty());
+  const int index = m_elements.count() - 1;
+  if(!m_elements.at(index).tagWritten && m_elements.at(index).omitIfEmpty) {
+    // nothing was ever written for an empty element
+    m_elements.removeLast();
+    return;
+  }
+  writeStartTag(index);
+  const Element& elem = m_elements.at(index);
+  if(elem.hasChildren) {
+    if(m_pendingNewline) {
+      *m_stream << QLatin1Char('\n');
+      m_pendingNewline = false;
+    }
+    if(!elem.lastChildIsText) {
+      writeIndent(index);
+    }
+    *m_stream << QLatin1String("</") << elem.name << QLatin1Char('>');
+  } else {
+    *m_stream << QLatin1String("/>");
+  }
+  m_elements.removeLast();
+  // the newline after an element is skipped when the next sibling is text
+  m_pendingNewline = true;
+}
+
+void TellicoStreamWriter::writeStartTag(int index_) {
+  Element& elem = m_elements[index_];
+  if(elem.tagWritten) {
+    return;
+  }
+  bool prevIsText = false;
+  if(index_ > 0) {
+    writeStartTag(index_ - 1);
+    prevIsText = beginChild(m_elements[index_ - 1], false);
+  }
+  if(!prevIsText) {
+    writeIndent(index_);
+  }
+  *m_stream << QLatin1Char('<') << elem.name << elem.attributes;
+  elem.attributes.clear();
+  elem.tagWritten = true;
+}
+
+// returns whether the previous sibling was text
+bool TellicoStreamWriter::beginChild(Element& parent_, bool isText_) {
+  bool prevIsText = false;
+  if(!parent_.hasChildren) {
+    // finish the parent start tag
+    *m_stream << QLatin1Char('>');
+    if(!isText_) {
+      *m_stream << QLatin1Char('\n');
+    }
+    parent_.hasChildren = true;
+  } else {
+    if(m_pendingNewline && !isText_) {
+      *m_stream << QLatin1Char('\n');
+    }
+    prevIsText = parent_.lastChildIsText;
+  }
+  m_pendingNewline = false;
+  parent_.lastChildIsText = isText_;
+  return prevIsText;
+}
+
+void TellicoStreamWriter::writeIndent(int depth_) {
+  for(int i = 0; i < depth_ * XML_INDENT; ++i) {
+    *m_stream << QLatin1Char(' ');
+  }
+}
+
+// follows the escaping rules of QDom, including encoding end-of-lines in attributes
+QString TellicoStreamWriter::encodeText(const QString& text_, bool isAttribute_) const {
+  const int len = text_.length();
+  int i = 0;
+  // most text needs no escaping at all, so avoid the copy
+  for( ; i < len; ++i) {
+    const ushort c = text_.at(i).unicode();
+    if(c == '<' || c == '&' || c == '>' || c == '\r' || (m_codec && c > 0x7f) ||
+       (isAttribute_ && (c == '"' || c == '\n' || c == '\t'))) {
+      break;
+    }
+  }
+  if(i == len) {
+    return text_;
+  }
+
+  QString result;
+  result.reserve(len + 16);
+  result += text_.leftRef(i);
+  for( ; i < len; ++i) {
+    const QChar ch = text_.at(i);
+    const ushort c = ch.unicode();
+    if(c == '<') {
+      result += QLatin1String("&lt;");
+    } else if(c == '&') {
+      result += QLatin1String("&amp;");
+    } else if(c == '>' && i >= 2 && text_.at(i-1) == QLatin1Char(']') && text_.at(i-2) == QLatin1Char(']')) {
+      result += QLatin1String("&gt;");
+    } else if(isAttribute_ && c == '"') {
+      result += QLatin1String("&quot;");
+    } else if(c == '\r' || (isAttribute_ && (c == '\n' || c == '\t'))) {
+      result += QLatin1String("&#x") + QString::number(c, 16) + QLatin1Char(';');
+    } else if(m_codec && c > 0x7f) {
+      // keep surrogate pairs together, so the character reference is for the full code point
+      if(ch.isHighSurrogate() && i+1 < len && text_.at(i+1).isLowSurrogate()) {
+        const QString pair = text_.mid(i, 2);
+        if(m_codec->canEncode(pair)) {
+          result += pair;
+        } else {
+          const uint ucs4 = QChar::surrogateToUcs4(ch, text_.at(i+1));
+          result += QLatin1String("&#x") + QString::number(ucs4, 16) + QLatin1Char(';');
+        }
+        ++i;
+      } else if(m_codec->canEncode(ch)) {
+        result += ch;
+      } else {
+        result += QLatin1String("&#x") + QString::number(c, 16) + QLatin1Char(';');
+      }
+    } else {
+      result += ch;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,157 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_XMLWRITER_H
+#define TELLICO_XMLWRITER_H
+
+#include <QDomElement>
+#include <QString>
+#include <QVector>
+
+class QDomDocument;
+class QTextStream;
+class QTextCodec;
+struct _xmlNode;
+
+namespace Tellico {
+  namespace Export {
+
+/**
+ * The TellicoXMLWriter is the interface used by the @ref TellicoXMLExporter to write
+ * the elements of a Tellico document. All attributes of an element must be written
+ * before any of its children.
+ *
+ * @author agent
+ */
+class TellicoXMLWriter {
+public:
+  virtual ~TellicoXMLWriter() {}
+
+  /**
+   * Starts a new element, as a child of the current one.
+   *
+   * @param name The element name
+   * @param omitIfEmpty Whether the element is left out entirely if it has no children
+   */
+  virtual void startElement(const QString& name, bool omitIfEmpty = false) = 0;
+  virtual void writeAttribute(const QString& name, const QString& value) = 0;
+  virtual void writeText(const QString& text) = 0;
+  virtual void endElement() = 0;
+
+  void writeTextElement(const QString& name, const QString& text);
+};
+
+/**
+ * Writes the elements into an existing DOM document.
+ */
+class TellicoDomWriter : public TellicoXMLWriter {
+public:
+  TellicoDomWriter(QDomDocument& dom, const QDomElement& parent);
+
+  virtual void startElement(const QString& name, bool omitIfEmpty = false) Q_DECL_OVERRIDE;
+  virtual void writeAttribute(const QString& name, const QString& value) Q_DECL_OVERRIDE;
+  virtual void writeText(const QString& text) Q_DECL_OVERRIDE;
+  virtual void endElement() Q_DECL_OVERRIDE;
+
+private:
+  QDomDocument& m_dom;
+  QVector<QDomElement> m_elements;
+  QVector<bool> m_omitIfEmpty;
+};
+
+/**
+ * Builds the elements as a libxml2 tree, so that a document for XSLT processing does not
+ * have to be written out as text and parsed again. New elements are in the same namespace
+ * as the parent element passed to the constructor.
+ */
+class TellicoLibXMLWriter : public TellicoXMLWriter {
+public:
+  TellicoLibXMLWriter(_xmlNode* parent);
+
+  virtual void startElement(const QString& name, bool omitIfEmpty = false) Q_DECL_OVERRIDE;
+  virtual void writeAttribute(const QString& name, const QString& value) Q_DECL_OVERRIDE;
+  virtual void writeText(const QString& text) Q_DECL_OVERRIDE;
+  virtual void endElement() Q_DECL_OVERRIDE;
+
+private:
+  QVector<_xmlNode*> m_elements;
+  QVector<bool> m_omitIfEmpty;
+};
+
+/**
+ * Writes the elements directly to a text stream, without building a document in memory.
+ *
+ * The output is formatted and escaped the same way as QDomDocument::toString() with the
+ * default indentation, so files look the same whichever writer is used. Start tags are
+ * only written once the first child or the end of the element is reached, so that
+ * an empty element can still be left out.
+ */
+class TellicoStreamWriter : public TellicoXMLWriter {
+public:
+  /**
+   * @param stream The output stream, which should already use the proper codec
+   * @param encoding The encoding name used in the XML declaration. Any characters which
+   *                 can't be encoded are written as character references.
+   */
+  TellicoStreamWriter(QTextStream* stream, const QString& encoding);
+
+  /**
+   * Writes the XML declaration and the document type
+   */
+  void writeStartDocument(const QString& doctype, const QString& publicId, const QString& systemId);
+  /**
+   * Finishes the document, which must have no open elements, and flushes the stream
+   */
+  void writeEndDocument();
+
+  virtual void startElement(const QString& name, bool omitIfEmpty = false) Q_DECL_OVERRIDE;
+  virtual void writeAttribute(const QString& name, const QString& value) Q_DECL_OVERRIDE;
+  virtual void writeText(const QString& text) Q_DECL_OVERRIDE;
+  virtual void endElement() Q_DECL_OVERRIDE;
+
+private:
+  struct Element {
+    QString name;
+    QString attributes;
+    bool omitIfEmpty;
+    bool tagWritten;
+    bool hasChildren;
+    bool lastChildIsText;
+  };
+
+  void writeStartTag(int index);
+  bool beginChild(Element& parent, bool isText);
+  void writeIndent(int depth);
+  QString encodeText(const QString& text, bool isAttribute) const;
+
+  QTextStream* m_stream;
+  QString m_encoding;
+  QTextCodec* m_codec;
+  QVector<Element> m_elements;
+  bool m_pendingNewline;
+};
+
+  } // end namespace
+} // end namespace
+#endif
@@ -35,13 +35,82 @@
 #include <KLocalizedString>
 #include <KZip>
 
-#include <QDomDocument>
-#include <QBuffer>
+#include <QtConcurrentRun>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QQueue>
+#include <QFile>
+#include <QThread>
 #include <QApplication>
 
 using namespace Tellico;
 using Tellico::Export::TellicoZipExporter;
 
+namespace {
+  // KArchive closes its device when the archive is closed, which isn't allowed for a QSaveFile,
+  // so the archive writes through this instead and the save file is committed separately
+  class SaveFileDevice : public QIODevice {
+  public:
+    explicit SaveFileDevice(QSaveFile* file_) : m_file(file_) {}
+    virtual bool isSequential() const Q_DECL_OVERRIDE { return false; }
+    virtual qint64 size() const Q_DECL_OVERRIDE { return m_file->size(); }
+    virtual bool seek(qint64 pos_) Q_DECL_OVERRIDE { return QIODevice::seek(pos_) && m_file->seek(pos_); }
+
+  protected:
+    virtual qint64 readData(char* data_, qint64 maxSize_) Q_DECL_OVERRIDE { return m_file->read(data_, maxSize_); }
+    virtual qint64 writeData(const char* data_, qint64 size_) Q_DECL_OVERRIDE { return m_file->write(data_, size_); }
+
+  private:
+    QSaveFile* m_file;
+  };
+
+  // forwards everything written to the file currently being written in the archive
+  class ArchiveFileDevice : public QIODevice {
+  public:
+    explicit ArchiveFileDevice(KArchive* archive_) : m_archive(archive_), m_written(0) {}
+    qint64 written() const { return m_written; }
+
+  protected:
+    virtual qint64 readData(char*, qint64) Q_DECL_OVERRIDE { return -1; }
+    virtual qint64 writeData(const char* data_, qint64 size_) Q_DECL_OVERRIDE {
+      if(!m_archive->writeData(data_, size_)) {
+        return -1;
+      }
+      m_written += size_;
+      return size_;
+    }
+
+  private:
+    KArchive* m_archive;
+    qint64 m_written;
+  };
+
+  // these run outside the GUI thread, so they can't touch the ImageFactory
+  QByteArray readImageFile(const QString& fileName_) {
+    QFile file(fileName_);
+    if(!file.open(QIODevice::ReadOnly)) {
+      myDebug() << "unable to read" << fileName_;
+      return QByteArray();
+    }
+    return file.readAll();
+  }
+
+  QByteArray encodeImage(const QImage& image_, const QByteArray& format_) {
+    return Tellico::Data::Image::byteArray(image_, format_);
+  }
+
+  // jpeg and png data is already compressed, deflating it again only costs time
+  bool isCompressedImage(const QString& id_) {
+    const QString suffix = id_.section(QLatin1Char('.'), -1).toLower();
+    return suffix == QLatin1String("jpeg") || suffix == QLatin1String("jpg") || suffix == QLatin1String("png");
+  }
+}
+
+struct TellicoZipExporter::PendingImage {
+  QString id;
+  QFuture<QByteArray> data;
+};
+
 TellicoZipExporter::TellicoZipExporter(Data::CollPtr coll) : Exporter(coll)
     , m_includeImages(true), m_cancelled(false) {
 }
@@ -61,89 +130,162 @@ bool TellicoZipExporter::exec() {
     return false;
   }
 
+  // the archive is written directly to the file, nothing is held in memory
+  // a remote file is written to a temporary file first, and then uploaded
+  const bool force = options() & Export::ExportForce;
+  QTemporaryFile tempFile;
+  QScopedPointer<QSaveFile> file;
+  if(url().isLocalFile()) {
+    file.reset(FileHandler::openSaveFile(url(), force));
+  } else if((force || FileHandler::queryExists(url())) && tempFile.open()) {
+    file.reset(FileHandler::openSaveFile(QUrl::fromLocalFile(tempFile.fileName()), true /* force */));
+  }
+  if(!file) {
+    return false;
+  }
+
   // TODO: maybe need label?
   ProgressItem& item = ProgressManager::self()->newProgressItem(this, QString(), true);
   item.setTotalSteps(100);
   connect(&item, &Tellico::ProgressItem::signalCancelled, this, &Tellico::Export::TellicoZipExporter::slotCancel);
   ProgressItem::Done done(this);
 
-  TellicoXMLExporter exp(coll);
-  exp.setEntries(entries());
-  exp.setFields(fields());
-  exp.setURL(url()); // needed in case of relative URL values
-  long opt = options();
-  opt |= Export::ExportUTF8; // always export to UTF-8
-  opt |= Export::ExportImages; // always list the images in the xml
-  opt &= ~Export::ExportProgress; // don't show progress for xml export
-  exp.setOptions(opt);
-  exp.setIncludeImages(false); // do not include the images themselves in XML
-  QByteArray xml = exp.exportXML().toByteArray(); // encoded in utf-8
-  ProgressManager::self()->setProgress(this, 5);
-
-  QByteArray data;
-  QBuffer buf(&data);
-
-  if(m_cancelled) {
-    return true; // intentionally cancelled
+  QQueue<PendingImage> pending;
+  QStringList imageIds;
+  if(m_includeImages) {
+    imageIds = exportedImages();
+    // start reading and encoding images in the background while the xml is written
+    const int maxPending = qMax(4, 2*QThread::idealThreadCount());
+    while(pending.count() < maxPending && !imageIds.isEmpty()) {
+      enqueueImage(imageIds.takeFirst(), pending);
+    }
   }
 
-  KZip zip(&buf);
-  zip.open(QIODevice::WriteOnly);
-  zip.writeFile(QStringLiteral("tellico.xml"), xml);
+  SaveFileDevice device(file.data());
+  device.open(QIODevice::WriteOnly);
+  KZip zip(&device);
+  if(!zip.open(QIODevice::WriteOnly) || !writeXML(zip)) {
+    file->cancelWriting();
+    return false;
+  }
+  ProgressManager::self()->setProgress(this, 10);
 
   if(m_includeImages) {
-    ProgressManager::self()->setProgress(this, 10);
     // gonna be lazy and just increment progress every 3 images
     // it might be less, might be more
     int j = 0;
     const QString imagesDir = QStringLiteral("images/");
-    StringSet imageSet;
-    // take intersection with the fields to be exported
-    Data::FieldList imageFields = Tellico::listIntersection(coll->imageFields(), fields());
     // already took 10%, only 90% left
-    const int stepSize = qMax(1, (coll->entryCount() * imageFields.count()) / 90);
-    foreach(Data::EntryPtr entry, entries()) {
-      if(m_cancelled) {
-        break;
+    const int stepSize = qMax(1, (pending.count() + imageIds.count()) / 90);
+    while(!pending.isEmpty() && !m_cancelled) {
+      PendingImage image = pending.dequeue();
+      // keep the window full, skipping over any missing images
+      while(!imageIds.isEmpty() && !enqueueImage(imageIds.takeFirst(), pending)) {
+      }
+      const QByteArray ba = image.data.result();
+      if(ba.isEmpty()) {
+        myWarning() << "no image data for" << image.id;
+        continue;
       }
-      foreach(Data::FieldPtr imageField, imageFields) {
-        const QString id = entry->field(imageField);
-        if(id.isEmpty() || imageSet.has(id)) {
-          continue;
-        }
-        const Data::ImageInfo& info = ImageFactory::imageInfo(id);
-        if(info.linkOnly) {
-          myLog() << "not copying linked image: " << id;
-          continue;
-        }
-        const Data::Image& img = ImageFactory::imageById(id);
-        // if no image, continue
-        if(img.isNull()) {
-          myWarning() << "no image found for " << imageField->title() << " field";
-          myWarning() << "...for the entry titled " << entry->title();
-          continue;
-        }
-        QByteArray ba = img.byteArray();
-//        myDebug() << "adding image id = " << it->field(fIt);
-        zip.writeFile(imagesDir + id, ba);
-        imageSet.add(id);
-        if(j%stepSize == 0) {
-          ProgressManager::self()->setProgress(this, qMin(10+j/stepSize, 99));
-          qApp->processEvents();
-        }
-        ++j;
+      zip.setCompression(isCompressedImage(image.id) ? KZip::NoCompression : KZip::DeflateCompression);
+      zip.writeFile(imagesDir + image.id, ba);
+      if(j%stepSize == 0) {
+        ProgressManager::self()->setProgress(this, qMin(10+j/stepSize, 99));
+        qApp->processEvents();
       }
+      ++j;
     }
   } else {
     ProgressManager::self()->setProgress(this, 80);
   }
 
-  zip.close();
-  if(m_cancelled) {
-    return true;
+  // the images still being read are not used, but don't leave the threads running
+  while(!pending.isEmpty()) {
+    pending.dequeue().data.waitForFinished();
+  }
+
+  const bool closed = zip.close();
+  if(m_cancelled || !closed) {
+    // nothing gets written to the target file
+    file->cancelWriting();
+    return m_cancelled; // true if intentionally cancelled
   }
 
-  return FileHandler::writeDataURL(url(), data, options() & Export::ExportForce);
+  if(!file->commit()) {
+    myDebug() << "error = " << file->error();
+    return false;
+  }
+  if(!url().isLocalFile()) {
+    return FileHandler::uploadFile(tempFile.fileName(), url());
+  }
+  return true;
+}
+
+bool TellicoZipExporter::writeXML(KZip& zip_) {
+  TellicoXMLExporter exp(collection());
+  exp.setEntries(entries());
+  exp.setFields(fields());
+  exp.setURL(url()); // needed in case of relative URL values
+  long opt = options();
+  opt |= Export::ExportUTF8; // always export to UTF-8
+  opt |= Export::ExportImages; // always list the images in the xml
+  opt &= ~Export::ExportProgress; // don't show progress for xml export
+  exp.setOptions(opt);
+  exp.setIncludeImages(false); // do not include the images themselves in XML
+
+  // stream the xml straight into the archive
+  zip_.setCompression(KZip::DeflateCompression);
+  if(!zip_.prepareWriting(QStringLiteral("tellico.xml"), QString(), QString(), 0)) {
+    return false;
+  }
+  ArchiveFileDevice xmlDevice(&zip_);
+  xmlDevice.open(QIODevice::WriteOnly);
+  const bool success = exp.writeXML(&xmlDevice);
+  return zip_.finishWriting(xmlDevice.written()) && success;
+}
+
+QStringList TellicoZipExporter::exportedImages() const {
+  QStringList imageIds;
+  StringSet imageSet;
+  // take intersection with the fields to be exported
+  Data::FieldList imageFields = Tellico::listIntersection(collection()->imageFields(), fields());
+  foreach(Data::EntryPtr entry, entries()) {
+    foreach(Data::FieldPtr imageField, imageFields) {
+      const QString id = entry->field(imageField);
+      if(id.isEmpty() || imageSet.has(id)) {
+        continue;
+      }
+      imageSet.add(id);
+      const Data::ImageInfo& info = ImageFactory::imageInfo(id);
+      if(info.linkOnly) {
+        myLog() << "not copying linked image: " << id;
+        continue;
+      }
+      imageIds += id;
+    }
+  }
+  return imageIds;
+}
+
+bool TellicoZipExporter::enqueueImage(const QString& id_, QQueue<PendingImage>& pending_) const {
+  PendingImage pending;
+  pending.id = id_;
+  // if the image was already written somewhere else, the file can be copied without encoding
+  const QString fileName = ImageFactory::imageFileName(id_);
+  if(!fileName.isEmpty()) {
+    pending.data = QtConcurrent::run(readImageFile, fileName);
+  } else {
+    const Data::Image& img = ImageFactory::imageById(id_);
+    // if no image, continue
+    if(img.isNull()) {
+      myWarning() << "no image found for" << id_;
+      return false;
+    }
+    // the QImage copy is implicitly shared, so it stays valid even if the cache deletes the image
+    pending.data = QtConcurrent::run(encodeImage, QImage(img), Data::Image::outputFormat(img.format()));
+  }
+  pending_.enqueue(pending);
+  return true;
 }
 
 void TellicoZipExporter::slotCancel() {
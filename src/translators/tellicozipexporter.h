@@ -27,10 +27,22 @@
 
 #include "exporter.h"
 
+#include <QFuture>
+#include <QQueue>
+
+class KZip;
+
 namespace Tellico {
   namespace Export {
 
 /**
+ * The TellicoZipExporter writes the Tellico XML and the images to a zip file.
+ *
+ * The archive is written directly to the output file, and the target file is only replaced
+ * once the archive is complete. The images are read or encoded in worker threads, starting
+ * while the XML is still being compressed. Images which are already compressed are stored
+ * in the archive without compression.
+ *
  * @author Robby Stephenson
  */
 class TellicoZipExporter : public Exporter {
@@ -52,6 +64,13 @@ public Q_SLOTS:
   void slotCancel();
 
 private:
+  struct PendingImage;
+
+  bool writeXML(KZip& zip);
+  QStringList exportedImages() const;
+  // returns false if the image could not be found, in which case nothing is queued
+  bool enqueueImage(const QString& id, QQueue<PendingImage>& pending) const;
+
   bool m_includeImages : 1;
   bool m_cancelled : 1;
 };
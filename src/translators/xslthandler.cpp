@@ -31,9 +31,16 @@
 #include <QDomDocument>
 #include <QTextCodec>
 #include <QVector>
+#include <QCache>
+#include <QMutex>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QLocale>
+#include <QCryptographicHash>
 
 extern "C" {
 #include <libxslt/xslt.h>
+#include <libxslt/xsltInternals.h>
 #include <libxslt/transform.h>
 #include <libxslt/xsltutils.h>
 #include <libxslt/extensions.h>
@@ -80,37 +87,99 @@ XSLTHandler::XMLOutputBuffer::~XMLOutputBuffer() {
 
 int XSLTHandler::s_initCount = 0;
 
-XSLTHandler::XSLTHandler(const QByteArray& xsltFile_) :
-    m_stylesheet(nullptr) {
+namespace {
+  // the number of compiled stylesheets to keep around when they're not in use
+  static const int XSLT_CACHE_SIZE = 20;
+  // guards the library initialization count, handlers may be created in any thread
+  static QBasicMutex s_initMutex;
+
+  qint64 modificationTime(const QString& fileName_) {
+    return QFileInfo(fileName_).lastModified().toMSecsSinceEpoch();
+  }
+
+  // libxml2 keeps the location of a document as a possibly percent-encoded file name or url
+  QString localFileName(const xmlChar* url_) {
+    const QString url = QUrl::fromPercentEncoding(QByteArray(reinterpret_cast<const char*>(url_)));
+    return url.startsWith(QLatin1String("file:")) ? QUrl(url).toLocalFile() : url;
+  }
+
+  // the files pulled in by xsl:import and xsl:include, with their modification times
+  void addDependencies(xsltStylesheetPtr stylesheet_, QHash<QString, qint64>& files_) {
+    for(xsltStylesheetPtr import = stylesheet_->imports; import; import = import->next) {
+      if(import->doc && import->doc->URL) {
+        const QString fileName = localFileName(import->doc->URL);
+        files_.insert(fileName, modificationTime(fileName));
+      }
+      addDependencies(import, files_);
+    }
+    // the included documents are all kept in the document list
+    for(xsltDocumentPtr include = stylesheet_->docList; include; include = include->next) {
+      if(include->doc && include->doc->URL) {
+        const QString fileName = localFileName(include->doc->URL);
+        files_.insert(fileName, modificationTime(fileName));
+      }
+    }
+  }
+}
+
+// a compiled stylesheet, shared by all the handlers using it
+class XSLTHandler::Stylesheet {
+public:
+  Stylesheet(xsltStylesheetPtr stylesheet_) : stylesheet(stylesheet_) {
+    // the libraries can't be cleaned up as long as the stylesheet is around
+    XSLTHandler::init();
+    addDependencies(stylesheet, dependencies);
+  }
+  ~Stylesheet() {
+    xsltFreeStylesheet(stylesheet);
+    XSLTHandler::cleanup();
+  }
+
+  // the top file is part of the cache key, but the imported files have to be checked
+  bool isCurrent() const {
+    for(QHash<QString, qint64>::ConstIterator it = dependencies.constBegin(); it != dependencies.constEnd(); ++it) {
+      if(modificationTime(it.key()) != it.value()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  xsltStylesheetPtr stylesheet;
+  QHash<QString, qint64> dependencies;
+
+private:
+  Q_DISABLE_COPY(Stylesheet)
+};
+
+// the most recently used stylesheets, kept even after the last handler using them is gone
+class XSLTHandler::StylesheetCache {
+public:
+  StylesheetCache() : cache(XSLT_CACHE_SIZE) {}
+  QMutex mutex;
+  QCache<QString, StylesheetPtr> cache;
+};
+
+XSLTHandler::XSLTHandler(const QByteArray& xsltFile_) {
   init();
   QByteArray file = QUrl::toPercentEncoding(QString::fromLocal8Bit(xsltFile_));
   if(!file.isEmpty()) {
-    xmlDocPtr xsltDoc = xmlReadFile(file.constData(), nullptr, xslt_options);
-    m_stylesheet = xsltParseStylesheetDoc(xsltDoc);
-    if(!m_stylesheet) {
-      myDebug() << "null stylesheet pointer for " << xsltFile_;
-    }
+    loadFile(QString::fromLocal8Bit(xsltFile_), file);
   } else {
     myDebug() << "XSLTHandler(QByteArray) - empty file name";
   }
 }
 
-XSLTHandler::XSLTHandler(const QUrl& xsltURL_) :
-    m_stylesheet(nullptr) {
+XSLTHandler::XSLTHandler(const QUrl& xsltURL_) {
   init();
   if(xsltURL_.isValid() && xsltURL_.isLocalFile()) {
-    xmlDocPtr xsltDoc = xmlReadFile(xsltURL_.toLocalFile().toUtf8().constData(), nullptr, xslt_options);
-    m_stylesheet = xsltParseStylesheetDoc(xsltDoc);
-    if(!m_stylesheet) {
-      myDebug() << "null stylesheet pointer for " << xsltURL_.path();
-    }
+    loadFile(xsltURL_.toLocalFile(), xsltURL_.toLocalFile().toUtf8());
   } else {
     myDebug() << "XSLTHandler(QUrl) - invalid: " << xsltURL_;
   }
 }
 
-XSLTHandler::XSLTHandler(const QDomDocument& xsltDoc_, const QByteArray& xsltFile_, bool translate_) :
-    m_stylesheet(nullptr) {
+XSLTHandler::XSLTHandler(const QDomDocument& xsltDoc_, const QByteArray& xsltFile_, bool translate_) {
   init();
   QByteArray file = QUrl::toPercentEncoding(QString::fromLocal8Bit(xsltFile_));
   if(!xsltDoc_.isNull() && !file.isEmpty()) {
@@ -118,21 +187,23 @@ XSLTHandler::XSLTHandler(const QDomDocument& xsltDoc_, const QByteArray& xsltFil
   }
 }
 
-XSLTHandler::~XSLTHandler() {
-  if(m_stylesheet) {
-    xsltFreeStylesheet(m_stylesheet);
-  }
+XSLTHandler::XSLTHandler(const XSLTHandler& other_) : m_stylesheet(other_.m_stylesheet), m_params(other_.m_params) {
+  init();
+}
 
-  --s_initCount;
-  if(s_initCount == 0) {
-    xsltUnregisterExtModule(EXSLT_STRINGS_NAMESPACE);
-    xsltUnregisterExtModule(EXSLT_DYNAMIC_NAMESPACE);
-    xsltCleanupGlobals();
-    xmlCleanupParser();
-  }
+XSLTHandler& XSLTHandler::operator=(const XSLTHandler& other_) {
+  m_stylesheet = other_.m_stylesheet;
+  m_params = other_.m_params;
+  return *this;
+}
+
+XSLTHandler::~XSLTHandler() {
+  m_stylesheet.clear();
+  cleanup();
 }
 
 void XSLTHandler::init() {
+  QMutexLocker lock(&s_initMutex);
   if(s_initCount == 0) {
     xmlSubstituteEntitiesDefault(1);
     xmlLoadExtDtdDefaultValue = 0;
@@ -141,12 +212,36 @@ void XSLTHandler::init() {
     exsltRegisterAll();
   }
   ++s_initCount;
+}
 
-  m_params.clear();
+void XSLTHandler::cleanup() {
+  QMutexLocker lock(&s_initMutex);
+  --s_initCount;
+  if(s_initCount == 0) {
+    xsltUnregisterExtModule(EXSLT_STRINGS_NAMESPACE);
+    xsltUnregisterExtModule(EXSLT_DYNAMIC_NAMESPACE);
+    xsltCleanupGlobals();
+    xmlCleanupParser();
+  }
 }
 
 bool XSLTHandler::isValid() const {
-  return (m_stylesheet != nullptr);
+  return !m_stylesheet.isNull();
+}
+
+void XSLTHandler::loadFile(const QString& fileName_, const QByteArray& xmlFile_) {
+  const QString key = cacheKey(fileName_, false);
+  m_stylesheet = cachedStylesheet(key);
+  if(m_stylesheet) {
+    return;
+  }
+  xmlDocPtr xsltDoc = xmlReadFile(xmlFile_.constData(), nullptr, xslt_options);
+  xsltStylesheetPtr stylesheet = xsltParseStylesheetDoc(xsltDoc);
+  if(!stylesheet) {
+    myDebug() << "null stylesheet pointer for " << fileName_;
+    return;
+  }
+  m_stylesheet = cacheStylesheet(key, stylesheet);
 }
 
 void XSLTHandler::setXSLTDoc(const QDomDocument& dom_, const QByteArray& xsltFile_, bool translate_) {
@@ -168,13 +263,16 @@ void XSLTHandler::setXSLTDoc(const QDomDocument& dom_, const QByteArray& xsltFil
     }
   }
 
-  QString s;
-  if(translate_) {
-    s = Tellico::i18nReplace(dom_.toString(0 /* indent */));
-  } else {
-    s = dom_.toString();
+  // the translated text depends on the locale, so the dom text is hashed before translating
+  const QString text = translate_ ? dom_.toString(0 /* indent */) : dom_.toString();
+  const QString key = cacheKey(QUrl::fromPercentEncoding(xsltFile_), translate_, text);
+  m_stylesheet = cachedStylesheet(key);
+  if(m_stylesheet) {
+    return;
   }
 
+  const QString s = translate_ ? Tellico::i18nReplace(text) : text;
+
   xmlDocPtr xsltDoc;
   if(utf8) {
     xsltDoc = xmlReadDoc(reinterpret_cast<xmlChar*>(s.toUtf8().data()), xsltFile_.data(), nullptr, xslt_options);
@@ -182,16 +280,69 @@ void XSLTHandler::setXSLTDoc(const QDomDocument& dom_, const QByteArray& xsltFil
     xsltDoc = xmlReadDoc(reinterpret_cast<xmlChar*>(s.toLocal8Bit().data()), xsltFile_.data(), nullptr, xslt_options);
   }
 
-  if(m_stylesheet) {
-    xsltFreeStylesheet(m_stylesheet);
-  }
-  m_stylesheet = xsltParseStylesheetDoc(xsltDoc);
-  if(!m_stylesheet) {
+  xsltStylesheetPtr stylesheet = xsltParseStylesheetDoc(xsltDoc);
+  if(!stylesheet) {
     myDebug() << "null stylesheet pointer for " << xsltFile_;
+    return;
   }
+  m_stylesheet = cacheStylesheet(key, stylesheet);
 //  xmlFreeDoc(xsltDoc); // this causes a crash for some reason
 }
 
+//static
+QString XSLTHandler::cacheKey(const QString& fileName_, bool translate_, const QString& text_) {
+  const QFileInfo info(fileName_);
+  QString key = info.absoluteFilePath() + QLatin1Char('|')
+              + QString::number(modificationTime(fileName_)) + QLatin1Char('|');
+  if(translate_) {
+    key += QLatin1String("i18n:") + QLocale().name();
+  }
+  // stylesheets read from a dom might have been changed from what is in the file
+  if(!text_.isEmpty()) {
+    key += QLatin1Char('|') + QLatin1String(QCryptographicHash::hash(text_.toUtf8(), QCryptographicHash::Md5).toHex());
+  }
+  return key;
+}
+
+//static
+XSLTHandler::StylesheetCache* XSLTHandler::stylesheetCache() {
+  static StylesheetCache cache;
+  return &cache;
+}
+
+//static
+XSLTHandler::StylesheetPtr XSLTHandler::cachedStylesheet(const QString& key_) {
+  StylesheetCache* cache = stylesheetCache();
+  QMutexLocker lock(&cache->mutex);
+  StylesheetPtr* stylesheet = cache->cache.object(key_);
+  if(!stylesheet) {
+    return StylesheetPtr();
+  }
+  // an imported or included file changed, so the stylesheet has to be compiled again
+  if(!(*stylesheet)->isCurrent()) {
+    cache->cache.remove(key_);
+    return StylesheetPtr();
+  }
+  return *stylesheet;
+}
+
+//static
+XSLTHandler::StylesheetPtr XSLTHandler::cacheStylesheet(const QString& key_, xsltStylesheetPtr stylesheet_) {
+  StylesheetPtr stylesheet(new Stylesheet(stylesheet_));
+  StylesheetCache* cache = stylesheetCache();
+  QMutexLocker lock(&cache->mutex);
+  // if another handler compiled the same stylesheet in the meantime, the newer one replaces it
+  cache->cache.insert(key_, new StylesheetPtr(stylesheet));
+  return stylesheet;
+}
+
+//static
+void XSLTHandler::clearCache() {
+  StylesheetCache* cache = stylesheetCache();
+  QMutexLocker lock(&cache->mutex);
+  cache->cache.clear();
+}
+
 void XSLTHandler::addStringParam(const QByteArray& name_, const QByteArray& value_) {
   QByteArray value = value_;
   if(value.contains('\'')) {
@@ -234,10 +385,39 @@ QString XSLTHandler::applyStylesheet(const QString& text_) {
   return process(docIn);
 }
 
+xmlDocPtr XSLTHandler::transform(const QString& text_) {
+  if(!m_stylesheet) {
+    myDebug() << "null stylesheet pointer!";
+    return nullptr;
+  }
+  if(text_.isEmpty()) {
+    myDebug() << "XSLTHandler::transform() - empty input";
+    return nullptr;
+  }
+
+  xmlDocPtr docIn;
+  docIn = xmlReadDoc(reinterpret_cast<xmlChar*>(text_.toUtf8().data()), nullptr, nullptr, xml_options);
+
+  return transformDoc(docIn);
+}
+
 QString XSLTHandler::process(xmlDocPtr docIn) {
+  xmlDocPtr docOut = transformDoc(docIn);
+  if(!docOut) {
+    return QString();
+  }
+
+  const QString result = resultText(docOut);
+  xmlFreeDoc(docOut);
+  docOut = nullptr;
+
+  return result;
+}
+
+xmlDocPtr XSLTHandler::transformDoc(xmlDocPtr docIn) {
   if(!docIn) {
     myDebug() << "XSLTHandler::applyStylesheet() - error parsing input string!";
-    return QString();
+    return nullptr;
   }
 
   QVector<const char*> params(2*m_params.count() + 1);
@@ -252,7 +432,7 @@ QString XSLTHandler::process(xmlDocPtr docIn) {
   }
   // returns NULL on error
   xmlDocPtr docOut;
-  docOut = xsltApplyStylesheet(m_stylesheet, docIn, params.data());
+  docOut = xsltApplyStylesheet(m_stylesheet->stylesheet, docIn, params.data());
   for(int i = 0; i < 2*m_params.count(); ++i) {
     delete[] params[i];
   }
@@ -262,20 +442,18 @@ QString XSLTHandler::process(xmlDocPtr docIn) {
 
   if(!docOut) {
     myDebug() << "error applying stylesheet!";
-    return QString();
   }
+  return docOut;
+}
 
+QString XSLTHandler::resultText(xmlDocPtr docOut) {
   XMLOutputBuffer output;
-  if(output.isValid()) {
-    int num_bytes = xsltSaveResultTo(output.buffer(), docOut, m_stylesheet);
+  if(output.isValid() && m_stylesheet && docOut) {
+    int num_bytes = xsltSaveResultTo(output.buffer(), docOut, m_stylesheet->stylesheet);
     if(num_bytes == -1) {
       myDebug() << "error saving output buffer!";
     }
   }
-
-  xmlFreeDoc(docOut);
-  docOut = nullptr;
-
   return output.result();
 }
 
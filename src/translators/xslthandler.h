@@ -28,6 +28,7 @@
 #include <QByteArray>
 #include <QHash>
 #include <QString>
+#include <QSharedPointer>
 
 // for xmlDocPtr
 #include <libxml/tree.h>
@@ -46,6 +47,11 @@ namespace Tellico {
  * The XSLTHandler contains all the code which uses XSLT processing to generate HTML or to
  * translate to other formats.
  *
+ * Compiled stylesheets are shared by all the handlers in the process. They are cached by
+ * the file name and modification time of the stylesheet, along with the translation flag
+ * and the locale, so creating a handler for a stylesheet which was used before does not
+ * parse and compile it again. Each handler keeps its own set of parameters.
+ *
  * @author Robby Stephenson
  */
 class XSLTHandler {
@@ -76,10 +82,17 @@ public:
    * @param xsltFile The XSLT file, should be a url?
    */
   XSLTHandler(const QDomDocument& xsltDoc, const QByteArray& xsltFile, bool translate=false);
+  /**
+   * Creates a handler sharing the compiled stylesheet, with a copy of the params. Copies of
+   * a handler can be used from different threads at the same time.
+   */
+  XSLTHandler(const XSLTHandler& other);
   /**
    */
   ~XSLTHandler();
 
+  XSLTHandler& operator=(const XSLTHandler& other);
+
   bool isValid() const;
 
   /**
@@ -106,14 +119,49 @@ public:
    * @return The transformed text
    */
   QString applyStylesheet(const QString& text);
+  /**
+   * Processes a document through the XSLT transformation. Building the input document
+   * directly, like with TellicoXMLExporter::exportXMLDoc(), avoids parsing any text.
+   *
+   * @param docIn The document to be transformed, which is freed
+   * @return The transformed text
+   */
+  QString process(xmlDocPtr docIn);
+  /**
+   * Processes text through the XSLT transformation, without writing the result out as text.
+   *
+   * @param text The text to be transformed
+   * @return The result document, or null on error. The caller must free it with xmlFreeDoc()
+   */
+  xmlDocPtr transform(const QString& text);
+  /**
+   * Writes a result document out as text, the same way as applyStylesheet().
+   */
+  QString resultText(xmlDocPtr docOut);
 
   static QDomDocument& setLocaleEncoding(QDomDocument& dom);
+  /**
+   * Removes all the compiled stylesheets from the cache. Handlers which are still in use
+   * keep their own stylesheet.
+   */
+  static void clearCache();
 
 private:
-  void init();
-  QString process(xmlDocPtr docIn);
+  class Stylesheet;
+  class StylesheetCache;
+  typedef QSharedPointer<Stylesheet> StylesheetPtr;
+
+  static void init();
+  static void cleanup();
+  static QString cacheKey(const QString& fileName, bool translate, const QString& text = QString());
+  static StylesheetPtr cachedStylesheet(const QString& key);
+  static StylesheetPtr cacheStylesheet(const QString& key, xsltStylesheetPtr stylesheet);
+  static StylesheetCache* stylesheetCache();
+
+  void loadFile(const QString& fileName, const QByteArray& xmlFile);
+  xmlDocPtr transformDoc(xmlDocPtr docIn);
 
-  xsltStylesheetPtr m_stylesheet;
+  StylesheetPtr m_stylesheet;
 
   QHash<QByteArray, QByteArray> m_params;
 
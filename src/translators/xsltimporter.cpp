@@ -25,6 +25,7 @@
 #include "xsltimporter.h"
 #include "xslthandler.h"
 #include "tellicoimporter.h"
+#include "tellicoxmlreader.h"
 #include "../core/filehandler.h"
 #include "../collection.h"
 #include "../tellico_debug.h"
@@ -34,7 +35,6 @@
 
 #include <QLabel>
 #include <QGroupBox>
-#include <QTextStream>
 #include <QHBoxLayout>
 #include <QScopedPointer>
 
@@ -49,10 +49,27 @@ static bool isUTF8(const QUrl& url_) {
     return false;
   }
 
-  ref->open();
-  QTextStream stream(ref->file());
-  QString line = stream.readLine().toLower();
-  return line.indexOf(QLatin1String("utf-8")) > 0;
+  if(!ref->open()) {
+    return false;
+  }
+  // only the first line is needed, and the mapped file avoids reading anything more
+  const QByteArray data = ref->data();
+  const int eol = data.indexOf('\n');
+  const QByteArray line = (eol > -1 ? data.left(eol) : data).toLower();
+  return line.indexOf("utf-8") > 0;
+}
+
+// text with disable-output-escaping is only markup once it's written out
+static bool hasUnescapedText(xmlNodePtr node_) {
+  for(xmlNodePtr child = node_->children; child; child = child->next) {
+    if(child->type == XML_TEXT_NODE && child->name == xmlStringTextNoenc) {
+      return true;
+    }
+    if(child->type == XML_ELEMENT_NODE && hasUnescapedText(child)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 }
@@ -94,13 +111,35 @@ Tellico::Data::CollPtr XSLTImporter::collection() {
   }
   beginXSLTHandler(&handler);
 //  myDebug() << text();
-  const QString str = handler.applyStylesheet(text());
-//  myDebug() << str;
+  xmlDocPtr result = handler.transform(text());
+  if(!result) {
+    setStatusMessage(i18n("Tellico encountered an error in XSLT processing."));
+    return Data::CollPtr();
+  }
 
-  Import::TellicoImporter imp(str);
-  imp.setOptions(options());
-  m_coll = imp.collection();
-  setStatusMessage(imp.statusMessage());
+  if(hasUnescapedText(reinterpret_cast<xmlNodePtr>(result))) {
+    // the unescaped text is meant to be parsed as markup, so write it out first
+    const QString str = handler.resultText(result);
+    xmlFreeDoc(result);
+//    myDebug() << str;
+    Import::TellicoImporter imp(str);
+    imp.setOptions(options());
+    m_coll = imp.collection();
+    setStatusMessage(imp.statusMessage());
+    return m_coll;
+  }
+
+  // the collection is read straight from the result tree
+  TellicoXMLReader reader((QByteArray()));
+  reader.setLoadImages(true);
+  reader.setShowImageLoadErrors(options() & ImportShowImageErrors);
+  if(reader.readDocument(result)) {
+    m_coll = reader.collection();
+  } else {
+    myDebug() << reader.errorString();
+    setStatusMessage(reader.errorString());
+  }
+  xmlFreeDoc(result);
   return m_coll;
 }
 
@@ -40,6 +40,7 @@
 using Tellico::BibtexHandler;
 
 BibtexHandler::StringListHash BibtexHandler::s_utf8LatexMap;
+bool BibtexHandler::s_translationMapsLoaded = false;
 BibtexHandler::QuoteStyle BibtexHandler::s_quoteStyle = BibtexHandler::BRACES;
 const QRegExp BibtexHandler::s_badKeyChars(QLatin1String("[^0-9a-zA-Z-]"));
 
@@ -123,13 +124,15 @@ QString BibtexHandler::bibtexKey(const QString& author_, const QString& title_,
 }
 
 void BibtexHandler::loadTranslationMaps() {
+  // only try once, even if the file is missing, so the maps are never written again
+  if(s_translationMapsLoaded) {
+    return;
+  }
+  s_translationMapsLoaded = true;
+
   QString mapfile = DataFileRegistry::self()->locate(QStringLiteral("bibtex-translation.xml"));
   if(mapfile.isEmpty()) {
-    static bool showMsg = true;
-    if(showMsg) {
-      myWarning() << "bibtex-translation.xml not found";
-      showMsg = false;
-    }
+    myWarning() << "bibtex-translation.xml not found";
     return;
   }
 
@@ -154,7 +157,7 @@ void BibtexHandler::loadTranslationMaps() {
 QString BibtexHandler::importText(char* text_) {
   QString str = QString::fromUtf8(text_);
 
-  if(s_utf8LatexMap.isEmpty()) {
+  if(!s_translationMapsLoaded) {
     loadTranslationMaps();
   }
 
@@ -177,7 +180,7 @@ QString BibtexHandler::importText(char* text_) {
 }
 
 QString BibtexHandler::exportText(const QString& text_, const QStringList& macros_) {
-  if(s_utf8LatexMap.isEmpty()) {
+  if(!s_translationMapsLoaded) {
     loadTranslationMaps();
   }
 
@@ -50,6 +50,12 @@ public:
    * @return A reference to the text
    */
   static QString& cleanText(QString& text);
+  /**
+   * Loads the maps between LaTeX and Unicode, if not already tried. Loading is only attempted
+   * once, even if the file is missing, and the maps are only read afterwards, so importText()
+   * can then be called from other threads.
+   */
+  static void loadTranslationMaps();
 
   static QuoteStyle s_quoteStyle;
 
@@ -57,10 +63,10 @@ private:
   typedef QHash<QString, QStringList> StringListHash;
 
   static QString bibtexKey(const QString& author, const QString& title, const QString& year);
-  static void loadTranslationMaps();
   static QString addBraces(const QString& string);
 
   static StringListHash s_utf8LatexMap;
+  static bool s_translationMapsLoaded;
   static const QRegExp s_badKeyChars;
 };
 
@@ -0,0 +1,220 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "phasetimer.h"
+#include "../tellico_debug.h"
+
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include <algorithm>
+
+using Tellico::PhaseTimer;
+using Tellico::PhaseLog;
+
+namespace {
+  // some phases run once per image, so don't let a single operation grow without bound
+  static const int MAX_PHASES_PER_OPERATION = 10000;
+
+  QAtomicInt s_threadCount;
+  thread_local int s_threadId = 0;
+  thread_local int s_depth = 0;
+
+  int threadId() {
+    if(s_threadId == 0) {
+      s_threadId = s_threadCount.fetchAndAddRelaxed(1) + 1;
+    }
+    return s_threadId;
+  }
+
+  bool phaseLessThan(const PhaseLog::Phase& p1, const PhaseLog::Phase& p2) {
+    return p1.start < p2.start;
+  }
+}
+
+PhaseTimer::PhaseTimer(const char* name_, Type type_) : m_name(name_), m_start(0), m_count(-1), m_depth(s_depth++) {
+  m_operation = PhaseLog::self()->beginPhase(type_ == Operation, &m_endsOperation);
+  if(m_operation > 0) {
+    m_start = PhaseLog::self()->now();
+  }
+}
+
+PhaseTimer::~PhaseTimer() {
+  --s_depth;
+  if(m_operation == 0) {
+    return;
+  }
+  PhaseLog::Phase phase;
+  phase.name = QByteArray::fromRawData(m_name, qstrlen(m_name));
+  phase.start = m_start;
+  phase.duration = PhaseLog::self()->now() - m_start;
+  phase.count = m_count;
+  phase.depth = m_depth;
+  phase.thread = threadId();
+  PhaseLog::self()->endPhase(phase, m_operation, m_endsOperation);
+}
+
+void PhaseTimer::setCount(int count_) {
+  m_count = count_;
+}
+
+void PhaseTimer::addCount(int count_) {
+  m_count = qMax(m_count, 0) + count_;
+}
+
+PhaseLog* PhaseLog::self() {
+  static PhaseLog log;
+  return &log;
+}
+
+PhaseLog::PhaseLog() : m_maxOperations(20), m_operation(0), m_operationThread(0), m_lastOperation(0) {
+  m_clock.start();
+}
+
+qint64 PhaseLog::now() const {
+  return m_clock.nsecsElapsed();
+}
+
+void PhaseLog::setMaxOperations(int max_) {
+  QMutexLocker lock(&m_mutex);
+  m_maxOperations = qMax(1, max_);
+  while(m_operations.count() > m_maxOperations) {
+    m_operations.removeFirst();
+  }
+}
+
+QList<PhaseLog::Operation> PhaseLog::operations() const {
+  QMutexLocker lock(&m_mutex);
+  return m_operations;
+}
+
+void PhaseLog::clear() {
+  QMutexLocker lock(&m_mutex);
+  m_operations.clear();
+}
+
+int PhaseLog::beginPhase(bool beginOperation_, bool* beginsOperation_) {
+  *beginsOperation_ = false;
+  // regrouping or showing an image outside of any operation is not worth the lock
+  if(!beginOperation_ && m_operation.loadAcquire() == 0) {
+    return 0;
+  }
+  QMutexLocker lock(&m_mutex);
+  const int operation = m_operation.loadAcquire();
+  if(operation > 0 || !beginOperation_) {
+    return operation;
+  }
+  m_operation.storeRelease(++m_lastOperation);
+  m_operationThread = threadId();
+  *beginsOperation_ = true;
+  m_operations.append(Operation());
+  while(m_operations.count() > m_maxOperations) {
+    m_operations.removeFirst();
+  }
+  return m_lastOperation;
+}
+
+void PhaseLog::endPhase(const Phase& phase_, int operation_, bool endOperation_) {
+  QMutexLocker lock(&m_mutex);
+  // the phase started before the operation, or the operation ended before the phase did
+  if(operation_ == 0 || operation_ != m_operation.loadAcquire()) {
+    return;
+  }
+  if(m_operations.isEmpty()) {
+    // the log was cleared while the operation was running
+    m_operations.append(Operation());
+  }
+  Operation& operation = m_operations.last();
+  if(operation.count() < MAX_PHASES_PER_OPERATION) {
+    operation.append(phase_);
+  }
+  if(endOperation_) {
+    // only the timer which began the operation ends it
+    Q_ASSERT(phase_.thread == m_operationThread);
+    m_operation.storeRelease(0);
+    m_operationThread = 0;
+    logOperation(operation);
+  }
+}
+
+void PhaseLog::logOperation(const Operation& operation_) const {
+#ifdef TELLICO_LOG
+  // phases are added as they end, so the outer ones are last
+  Operation phases = operation_;
+  std::stable_sort(phases.begin(), phases.end(), phaseLessThan);
+  foreach(const Phase& phase, phases) {
+    QString line = QString(phase.depth * 2, QLatin1Char(' ')) + QLatin1String(phase.name);
+    line += QStringLiteral(": %1 ms").arg(phase.duration / 1000000.0, 0, 'f', 2);
+    if(phase.count > -1) {
+      line += QStringLiteral(" (%1)").arg(phase.count);
+    }
+    if(phase.thread != phases.first().thread) {
+      line += QStringLiteral(" [thread %1]").arg(phase.thread);
+    }
+    myLog() << "PHASE:" << qPrintable(line);
+  }
+#else
+  Q_UNUSED(operation_);
+#endif
+}
+
+QByteArray PhaseLog::chromeTrace() const {
+  QJsonArray events;
+  foreach(const Operation& operation, operations()) {
+    foreach(const Phase& phase, operation) {
+      // complete events, with times in microseconds
+      QJsonObject event;
+      event.insert(QStringLiteral("name"), QString::fromLatin1(phase.name));
+      event.insert(QStringLiteral("cat"), QStringLiteral("tellico"));
+      event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+      event.insert(QStringLiteral("ts"), phase.start / 1000.0);
+      event.insert(QStringLiteral("dur"), phase.duration / 1000.0);
+      event.insert(QStringLiteral("pid"), 1);
+      event.insert(QStringLiteral("tid"), phase.thread);
+      if(phase.count > -1) {
+        QJsonObject args;
+        args.insert(QStringLiteral("count"), phase.count);
+        event.insert(QStringLiteral("args"), args);
+      }
+      events.append(event);
+    }
+  }
+  QJsonObject trace;
+  trace.insert(QStringLiteral("traceEvents"), events);
+  trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+  return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+bool PhaseLog::writeChromeTrace(const QString& fileName_) const {
+  QSaveFile file(fileName_);
+  if(!file.open(QIODevice::WriteOnly)) {
+    myDebug() << "Unable to write trace to" << fileName_;
+    return false;
+  }
+  file.write(chromeTrace());
+  return file.commit();
+}
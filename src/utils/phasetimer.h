@@ -0,0 +1,139 @@
+/***************************************************************************
+    Copyright (C) 2026 agent <agent@local>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef TELLICO_PHASETIMER_H
+#define TELLICO_PHASETIMER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+namespace Tellico {
+
+/**
+ * A PhaseTimer measures how long a phase of some larger operation takes, like parsing
+ * the XML of a document or writing the images. The phase starts when the timer is
+ * created and ends when it goes out of scope.
+ *
+ * Timers can be nested. Only an operation timer, for something like opening or saving a document,
+ * begins a new operation when none is open, and only that timer ends it. Any other timer started
+ * when no operation is open records nothing. Phases timed in other threads are recorded as part
+ * of the operation if it is open for their whole duration, and dropped otherwise. When the
+ * operation ends, all its phases are written to the debug log.
+ *
+ * @author agent
+ */
+class PhaseTimer {
+public:
+  enum Type { Phase, Operation };
+
+  /**
+   * @param name The name of the phase, which must be a string literal
+   * @param type Whether the timer can begin an operation
+   */
+  explicit PhaseTimer(const char* name, Type type = Phase);
+  ~PhaseTimer();
+
+  /**
+   * Sets a count for the phase, such as the number of entries which were read.
+   */
+  void setCount(int count);
+  void addCount(int count = 1);
+
+private:
+  Q_DISABLE_COPY(PhaseTimer)
+
+  const char* m_name;
+  qint64 m_start;
+  int m_count;
+  int m_depth;
+  // the operation the phase is part of, zero for none
+  int m_operation;
+  bool m_endsOperation;
+};
+
+/**
+ * The PhaseLog keeps the phases of the most recent operations, so they can be exported
+ * in the trace event format used by Chrome's about:tracing and by Perfetto.
+ *
+ * @author agent
+ */
+class PhaseLog {
+public:
+  struct Phase {
+    QByteArray name;
+    qint64 start; // nanoseconds
+    qint64 duration; // nanoseconds
+    int count;
+    int depth;
+    int thread;
+  };
+  typedef QVector<Phase> Operation;
+
+  static PhaseLog* self();
+
+  /**
+   * Sets how many operations are kept. The default is 20.
+   */
+  void setMaxOperations(int max);
+  /**
+   * Returns the phases of the kept operations, oldest first. An operation which is still
+   * running is included.
+   */
+  QList<Operation> operations() const;
+  void clear();
+
+  /**
+   * Returns the kept operations as trace event JSON.
+   */
+  QByteArray chromeTrace() const;
+  bool writeChromeTrace(const QString& fileName) const;
+
+private:
+  friend class PhaseTimer;
+
+  PhaseLog();
+  qint64 now() const;
+  int beginPhase(bool beginOperation, bool* beginsOperation);
+  void endPhase(const Phase& phase, int operation, bool endOperation);
+  void logOperation(const Operation& operation) const;
+
+  mutable QMutex m_mutex;
+  QElapsedTimer m_clock;
+  QList<Operation> m_operations;
+  int m_maxOperations;
+  // the open operation, zero for none, and the thread which began it
+  // the operation is checked without the mutex first, so phases outside one cost nothing
+  QAtomicInt m_operation;
+  int m_operationThread;
+  int m_lastOperation;
+};
+
+} // end namespace
+#endif
@@ -107,7 +107,8 @@ int Tellico::stringHash(const QString& str) {
 }
 
 QString Tellico::shareString(const QString& str) {
-  static QString stringStore[STRING_STORE_SIZE];
+  // each thread keeps its own store, so entries can be created in worker threads
+  static thread_local QString stringStore[STRING_STORE_SIZE];
 
   const int hash = stringHash(str) % STRING_STORE_SIZE;
   if(stringStore[hash] != str) {
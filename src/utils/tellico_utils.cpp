@@ -34,6 +34,7 @@
 #include <QDateTime>
 #include <QUrl>
 #include <QSet>
+#include <QCryptographicHash>
 
 QStringList Tellico::findAllSubDirs(const QString& dir_) {
   if(dir_.isEmpty()) {
@@ -96,6 +97,10 @@ QString Tellico::saveLocation(const QString& dir_) {
   return path;
 }
 
+QString Tellico::documentKey(const QUrl& url_) {
+  return QLatin1String(QCryptographicHash::hash(url_.url().toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
 const QPixmap& Tellico::pixmap(const QString& value_) {
   static QHash<int, QPixmap*> pixmaps;
   if(pixmaps.isEmpty()) {
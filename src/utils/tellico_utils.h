@@ -30,6 +30,7 @@
 class QString;
 class QStringList;
 class QPixmap;
+class QUrl;
 
 /**
  * This file contains utility functions.
@@ -52,6 +53,11 @@ namespace Tellico {
   QString installationDir();
 
   QString saveLocation(const QString& dir);
+  /**
+   * Returns the name used for anything kept in a save location for a document,
+   * like its snapshot or its recovery file
+   */
+  QString documentKey(const QUrl& url);
 
   const QPixmap& pixmap(const QString& value);
 